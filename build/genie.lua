@@ -186,6 +186,7 @@ project "ETEngine"
 		path.join(SOURCE_DIR, "Engine/**.cpp"), 
 		path.join(SOURCE_DIR, "Engine/**.hpp"), 
 		path.join(SOURCE_DIR, "Engine/**.h"), 
+		path.join(SOURCE_DIR, "Engine/**.inl"), 
 		path.join(SOURCE_DIR, "Engine/**.glsl"), 
 
 		path.join(SOURCE_DIR, "Engine/**.c"),									--for glad and stb vorbis
@@ -222,6 +223,27 @@ project "Testing"
 	staticPlatformLibraries()
 	windowsPlatformPostBuild()
 
-    links{ "ETEngine", "SDL2", "FreeImage", "assimp", "rttr_core" }
+    links{ "ETEngine", "SDL2", "FreeImage", "assimp", "BulletDynamics", "BulletCollision", "LinearMath", "rttr_core" }
 
-    files { path.join(SOURCE_DIR, "Testing/**.cpp") }
\ No newline at end of file
+    files { path.join(SOURCE_DIR, "Testing/**.cpp") }
+
+project "Benchmark"
+	kind "ConsoleApp"
+
+	location "../source/Benchmark"
+
+    defines { "_CONSOLE" }
+
+	outputDirectories("Benchmark")
+
+	configuration "vs*"
+		debugdir(PROJECT_DIR)
+		links { "opengl32", "SDL2main" } 
+		
+	platformLibraries()
+	staticPlatformLibraries()
+	windowsPlatformPostBuild()
+
+    links{ "ETEngine", "SDL2", "FreeImage", "assimp", "BulletDynamics", "BulletCollision", "LinearMath", "rttr_core" }
+
+    files { path.join(SOURCE_DIR, "Benchmark/**.cpp"), path.join(SOURCE_DIR, "Benchmark/**.hpp") }
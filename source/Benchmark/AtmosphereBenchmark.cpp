@@ -0,0 +1,56 @@
+#include "../Engine/stdafx.hpp"
+#include "AtmosphereBenchmark.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "../Engine/PlanetTech/AtmosphereModel.hpp"
+#include "../Engine/Graphics/CIE.h"
+#include "../Engine/FileSystem/Entry.h"
+
+int32 RunAtmosphereBenchmark(const AtmosphereBenchmarkSettings &settings)
+{
+	//the parameters don't tell if their file was missing
+	File* pParamFile = new File(settings.paramFile, nullptr);
+	FILE_ACCESS_FLAGS flags;
+	flags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Exists);
+	bool isFound = pParamFile->Open(FILE_ACCESS_MODE::Read, flags);
+	SafeDelete(pParamFile);
+	if (!isFound)
+	{
+		std::cerr << "Couldn't load atmosphere parameters " << settings.paramFile << std::endl;
+		return 1;
+	}
+
+	CIE::GetInstance()->LoadData();
+	dvec3 skyColor;
+	dvec3 sunColor;
+	AtmosphereParameters params(settings.paramFile, skyColor, sunColor);
+	AtmosphereSettings atmosphereSettings;
+	atmosphereSettings.SCATTERING_ORDERS = settings.scatteringOrders;
+
+	AtmosphereModel model(params, atmosphereSettings);
+	auto start = std::chrono::steady_clock::now();
+	model.Precalculate(settings.workerCount);
+	auto end = std::chrono::steady_clock::now();
+
+	const AtmosphereTables &tables = model.GetTables();
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Atmosphere benchmark: " << settings.scatteringOrders << " scattering orders, "
+		<< (settings.workerCount == 0 ? std::string("all") : std::to_string(settings.workerCount)) << " workers" << std::endl;
+	std::cout << "  tables:  transmittance " << tables.transmittanceSize.x << 'x' << tables.transmittanceSize.y
+		<< ", irradiance " << tables.irradianceSize.x << 'x' << tables.irradianceSize.y
+		<< ", scattering " << tables.scatteringSize.x << 'x' << tables.scatteringSize.y << 'x' << tables.scatteringSize.z << std::endl;
+	std::cout << "  seconds: " << std::chrono::duration<double>(end - start).count() << std::endl;
+
+	if (!settings.writeCache) return 0;
+	std::string cacheFile = settings.cacheFile.empty() ? AtmosphereTables::GetCacheFileName(settings.paramFile) : settings.cacheFile;
+	if (!tables.Save(cacheFile, AtmosphereTables::GetHash(params, atmosphereSettings)))
+	{
+		std::cerr << "Couldn't write " << cacheFile << std::endl;
+		return 1;
+	}
+	std::cout << "  written to " << cacheFile << std::endl;
+	return 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+
+//Atmosphere Benchmark
+//********************
+
+// Computes the atmosphere look up tables on the CPU without a window or graphics context, times it and writes them to the cache the engine loads them from.
+
+struct AtmosphereBenchmarkSettings
+{
+	std::string paramFile = "Resources/atmo_earth.json";
+	//the cache next to the parameter file if empty
+	std::string cacheFile;
+	bool writeCache = true;
+
+	//0 uses every hardware thread
+	uint32 workerCount = 0;
+	int32 scatteringOrders = 4;
+};
+
+int32 RunAtmosphereBenchmark(const AtmosphereBenchmarkSettings &settings);
@@ -0,0 +1,122 @@
+#include "../Engine/stdafx.hpp"
+#include "FrustumBenchmark.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+#include "../Engine/Graphics/BatchFrustum.hpp"
+
+namespace
+{
+	//runs the function for every iteration and returns nanoseconds per volume, the visible count keeps the work from being optimized out
+	template<typename TFunc>
+	double Measure(const FrustumBenchmarkSettings &settings, size_t &visibleCount, TFunc func)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (uint32 iteration = 0; iteration < settings.iterations; ++iteration)
+		{
+			visibleCount = func();
+		}
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / ((double)settings.iterations * settings.volumeCount);
+	}
+
+	void PrintResult(const char* name, double nanoseconds, size_t visibleCount)
+	{
+		std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(8) << nanoseconds << " ns per volume, "
+			<< visibleCount << " visible" << std::endl;
+	}
+}
+
+int32 RunFrustumBenchmark(const FrustumBenchmarkSettings &settings)
+{
+	//a camera in the middle of the volumes, about a quarter of them are in view
+	Frustum frustum;
+	frustum.SetCullTransform(mat4(), mat4());
+	frustum.SetCamera(vec3(0.f), vec3(0.f, 0.f, 1.f), vec3(0.f, 1.f, 0.f), 45.f, 0.1f, 2000.f, 16.f / 9.f);
+	frustum.Update();
+	BatchFrustum batch(frustum.GetPlanes());
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-1000.f, 1000.f);
+	std::uniform_real_distribution<float> size(0.5f, 20.f);
+	std::vector<Sphere> spheres;
+	vec3soa centers(settings.volumeCount);
+	std::vector<float> radii;
+	vec3soa mins(settings.volumeCount);
+	vec3soa maxs(settings.volumeCount);
+	for (uint32 i = 0; i < settings.volumeCount; ++i)
+	{
+		vec3 center(position(random), position(random), position(random));
+		float radius = size(random);
+		spheres.push_back(Sphere(center, radius));
+		centers.set(i, center);
+		radii.push_back(radius);
+		mins.set(i, center - vec3(radius));
+		maxs.set(i, center + vec3(radius));
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Frustum benchmark: " << settings.volumeCount << " volumes, " << settings.iterations << " iterations" << std::endl;
+	size_t visibleCount = 0;
+
+	double nanoseconds = Measure(settings, visibleCount, [&]()
+	{
+		size_t visible = 0;
+		for (const Sphere &sphere : spheres)
+		{
+			if (frustum.ContainsSphere(sphere) != VolumeCheck::OUTSIDE) ++visible;
+		}
+		return visible;
+	});
+	PrintResult("Frustum::ContainsSphere", nanoseconds, visibleCount);
+
+	nanoseconds = Measure(settings, visibleCount, [&]()
+	{
+		size_t visible = 0;
+		for (const Sphere &sphere : spheres)
+		{
+			if (batch.ContainsSphere(sphere) != VolumeCheck::OUTSIDE) ++visible;
+		}
+		return visible;
+	});
+	PrintResult("BatchFrustum::ContainsSphere", nanoseconds, visibleCount);
+
+	std::vector<uint32> visibleMask;
+	nanoseconds = Measure(settings, visibleCount, [&]()
+	{
+		batch.CullSpheres(centers, radii, visibleMask);
+		return visibleMask.size();
+	});
+	std::vector<uint32> visibleIndices;
+	BatchFrustum::MaskToIndices(visibleMask, settings.volumeCount, visibleIndices);
+	PrintResult("BatchFrustum::CullSpheres", nanoseconds, visibleIndices.size());
+
+	nanoseconds = Measure(settings, visibleCount, [&]()
+	{
+		batch.CollectVisibleSpheres(centers, radii, visibleIndices);
+		return visibleIndices.size();
+	});
+	PrintResult("  with compacted indices", nanoseconds, visibleCount);
+
+	nanoseconds = Measure(settings, visibleCount, [&]()
+	{
+		size_t visible = 0;
+		for (uint32 i = 0; i < settings.volumeCount; ++i)
+		{
+			if (batch.ContainsAABB(mins.get(i), maxs.get(i)) != VolumeCheck::OUTSIDE) ++visible;
+		}
+		return visible;
+	});
+	PrintResult("BatchFrustum::ContainsAABB", nanoseconds, visibleCount);
+
+	nanoseconds = Measure(settings, visibleCount, [&]()
+	{
+		batch.CollectVisibleAABBs(mins, maxs, visibleIndices);
+		return visibleIndices.size();
+	});
+	PrintResult("BatchFrustum::CullAABBs", nanoseconds, visibleCount);
+	return 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+//Frustum Benchmark
+//*****************
+
+// Culls the same random spheres and boxes with Frustum one by one and with BatchFrustum, and reports the time per volume of each.
+
+struct FrustumBenchmarkSettings
+{
+	uint32 volumeCount = 100000;
+	uint32 iterations = 100;
+};
+
+int32 RunFrustumBenchmark(const FrustumBenchmarkSettings &settings);
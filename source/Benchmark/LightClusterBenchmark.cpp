@@ -0,0 +1,59 @@
+#include "../Engine/stdafx.hpp"
+#include "LightClusterBenchmark.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+#include "../Engine/Graphics/LightClusters.hpp"
+#include "../Engine/Helper/TaskScheduler.hpp"
+
+int32 RunLightClusterBenchmark(const LightClusterBenchmarkSettings &settings)
+{
+	//lights spread through a volume a bit larger than the view frustum
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> lateral(-300.f, 300.f);
+	std::uniform_real_distribution<float> depth(-20.f, 520.f);
+	std::uniform_real_distribution<float> size(0.5f, 1.5f);
+	std::vector<LightClusters::PointLight> lights;
+	for (uint32 i = 0; i < settings.lightCount; ++i)
+	{
+		lights.push_back(LightClusters::PointLight(vec3(lateral(random), lateral(random) * 0.5f, depth(random)),
+			settings.lightRadius * size(random), vec3(1.f)));
+	}
+
+	TaskScheduler scheduler(settings.workerCount);
+	LightClusters clusters(ivec3(16, 9, 24), &scheduler);
+	clusters.SetProjection(etm::perspective(etm::radians(60.f), 16.f / 9.f, 0.5f, 500.f), 0.5f, 500.f);
+	const mat4 view = etm::lookAt(vec3(0.f), vec3(0.f, 0.f, 1.f), vec3(0.f, 1.f, 0.f));
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Light cluster benchmark: up to " << settings.lightCount << " lights, " << settings.frames << " frames" << std::endl;
+	for (uint32 count = std::min(256u, settings.lightCount); count <= settings.lightCount; count *= 2)
+	{
+		std::vector<LightClusters::PointLight> frameLights(lights.begin(), lights.begin() + count);
+		auto start = std::chrono::steady_clock::now();
+		for (uint32 frame = 0; frame < settings.frames; ++frame)
+		{
+			clusters.Build(view, frameLights);
+		}
+		auto end = std::chrono::steady_clock::now();
+		double ms = std::chrono::duration<double, std::milli>(end - start).count() / settings.frames;
+
+		size_t usedClusters = 0;
+		size_t maxLights = 0;
+		for (const LightClusters::Cluster &cluster : clusters.GetClusters())
+		{
+			if (cluster.count > 0) ++usedClusters;
+			maxLights = std::max(maxLights, (size_t)cluster.count);
+		}
+		std::cout << "  " << std::setw(6) << count << " lights: " << std::setw(8) << ms << " ms per frame, "
+			<< clusters.GetLights().size() << " in view, " << clusters.GetLightIndices().size() << " assignments, "
+			<< (usedClusters > 0 ? (double)clusters.GetLightIndices().size() / usedClusters : 0.0) << " average and "
+			<< maxLights << " most lights per cluster" << std::endl;
+		if (count == settings.lightCount) break;
+		if (count * 2 > settings.lightCount) count = settings.lightCount / 2;
+	}
+	return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+//Light Cluster Benchmark
+//***********************
+
+// Random point lights in front of a camera, binned into LightClusters every frame.
+// Reports the time per frame and how many lights each shaded pixel has to evaluate, for doubling light counts up to the set amount.
+
+struct LightClusterBenchmarkSettings
+{
+	uint32 lightCount = 8192;
+	uint32 frames = 100;
+	uint32 workerCount = 0;
+	float lightRadius = 10.f;
+};
+
+int32 RunLightClusterBenchmark(const LightClusterBenchmarkSettings &settings);
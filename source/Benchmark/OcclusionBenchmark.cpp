@@ -0,0 +1,95 @@
+#include "../Engine/stdafx.hpp"
+#include "OcclusionBenchmark.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+#include "../Engine/Graphics/OcclusionBuffer.hpp"
+#include "../Engine/Helper/TaskScheduler.hpp"
+
+namespace
+{
+	//unit cube around the origin
+	const std::vector<vec3> cubePositions =
+	{
+		vec3(-1.f, -1.f, -1.f), vec3(1.f, -1.f, -1.f), vec3(1.f, 1.f, -1.f), vec3(-1.f, 1.f, -1.f),
+		vec3(-1.f, -1.f, 1.f), vec3(1.f, -1.f, 1.f), vec3(1.f, 1.f, 1.f), vec3(-1.f, 1.f, 1.f)
+	};
+	const std::vector<uint32> cubeIndices =
+	{
+		0, 1, 2, 0, 2, 3,
+		4, 6, 5, 4, 7, 6,
+		0, 4, 5, 0, 5, 1,
+		3, 2, 6, 3, 6, 7,
+		0, 3, 7, 0, 7, 4,
+		1, 5, 6, 1, 6, 2
+	};
+}
+
+int32 RunOcclusionBenchmark(const OcclusionBenchmarkSettings &settings)
+{
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> side(-1.f, 1.f);
+	std::uniform_real_distribution<float> depth(5.f, 1000.f);
+	std::uniform_real_distribution<float> buildingSize(5.f, 30.f);
+
+	//buildings along both sides of the view direction
+	std::vector<mat4> occluders;
+	for (uint32 i = 0; i < settings.occluderCount; ++i)
+	{
+		float width = buildingSize(random);
+		float height = buildingSize(random) * 2.f;
+		float x = (side(random) > 0.f ? 1.f : -1.f) * (width + 8.f);
+		occluders.push_back(etm::scale(vec3(width, height, width)) * etm::translate(vec3(x, height - 2.f, depth(random))));
+	}
+	std::vector<AABB> bounds;
+	for (uint32 i = 0; i < settings.boundsCount; ++i)
+	{
+		vec3 center(side(random) * 60.f, side(random) * 5.f + 3.f, depth(random));
+		bounds.push_back(AABB(center - vec3(1.f), center + vec3(1.f)));
+	}
+
+	mat4 viewProjection = etm::lookAt(vec3(0.f, 2.f, 0.f), vec3(0.f, 2.f, 1.f), vec3(0.f, 1.f, 0.f))
+		* etm::perspective(etm::radians(60.f), 16.f / 9.f, 0.5f, 1000.f);
+	TaskScheduler scheduler(settings.workerCount);
+	OcclusionBuffer buffer(settings.resolution, &scheduler);
+	ivec2 resolution = buffer.GetResolution();
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Occlusion benchmark: " << settings.occluderCount << " occluders, " << settings.boundsCount << " bounds, "
+		<< resolution.x << "x" << resolution.y << " pixels, " << settings.frames << " frames" << std::endl;
+
+	double rasterizeMs = 0.0;
+	double testMs = 0.0;
+	uint32 occludedCount = 0;
+	for (uint32 frame = 0; frame < settings.frames; ++frame)
+	{
+		auto start = std::chrono::steady_clock::now();
+		buffer.Begin(viewProjection);
+		for (const mat4 &world : occluders)
+		{
+			buffer.AddOccluder(cubePositions, cubeIndices, world);
+		}
+		buffer.Rasterize();
+		auto rasterized = std::chrono::steady_clock::now();
+
+		occludedCount = 0;
+		for (const AABB &box : bounds)
+		{
+			if (buffer.IsOccluded(box)) ++occludedCount;
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		rasterizeMs += std::chrono::duration<double, std::milli>(rasterized - start).count();
+		testMs += std::chrono::duration<double, std::milli>(end - rasterized).count();
+	}
+
+	std::cout << "  rasterize occluders  " << rasterizeMs / settings.frames << " ms per frame, "
+		<< buffer.GetTriangleCount() << " triangles" << std::endl;
+	std::cout << "  test bounds          " << testMs / settings.frames << " ms per frame, "
+		<< testMs * 1000000.0 / ((double)settings.frames * settings.boundsCount) << " ns per box" << std::endl;
+	std::cout << "  occluded             " << occludedCount << " of " << settings.boundsCount << std::endl;
+	return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+//Occlusion Benchmark
+//*******************
+
+// A street of box shaped buildings as occluders, with small boxes scattered between and behind them.
+// Reports the time to rasterize the occluders and to test the boxes, and how many of them are hidden.
+
+struct OcclusionBenchmarkSettings
+{
+	uint32 occluderCount = 200;
+	uint32 boundsCount = 20000;
+	uint32 frames = 100;
+	uint32 workerCount = 0;
+	ivec2 resolution = ivec2(256, 128);
+};
+
+int32 RunOcclusionBenchmark(const OcclusionBenchmarkSettings &settings);
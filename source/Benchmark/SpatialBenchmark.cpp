@@ -0,0 +1,228 @@
+#include "../Engine/stdafx.hpp"
+#include "SpatialBenchmark.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <algorithm>
+
+#include "../Engine/SceneGraph/BoundingVolumeTree.hpp"
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double MicrosecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+	}
+
+	float DistanceSquared(const AABB &box, const vec3 &point)
+	{
+		vec3 delta(std::max(std::max(box.min.x - point.x, point.x - box.max.x), 0.f),
+			std::max(std::max(box.min.y - point.y, point.y - box.max.y), 0.f),
+			std::max(std::max(box.min.z - point.z, point.z - box.max.z), 0.f));
+		return etm::dot(delta, delta);
+	}
+
+	//the flat scan the tree is compared against
+	struct FlatScan
+	{
+		std::vector<AABB> boxes;
+
+		void QueryFrustum(const BatchFrustum &frustum, std::vector<int32> &result) const
+		{
+			result.clear();
+			for (size_t i = 0; i < boxes.size(); ++i)
+			{
+				if (frustum.ContainsAABB(boxes[i].min, boxes[i].max) != VolumeCheck::OUTSIDE) result.push_back((int32)i);
+			}
+		}
+		void QuerySphere(const Sphere &sphere, std::vector<int32> &result) const
+		{
+			result.clear();
+			float radiusSquared = sphere.radius * sphere.radius;
+			for (size_t i = 0; i < boxes.size(); ++i)
+			{
+				if (DistanceSquared(boxes[i], sphere.pos) <= radiusSquared) result.push_back((int32)i);
+			}
+		}
+		void RayCast(const vec3 &origin, const vec3 &direction, float maxDistance, std::vector<int32> &result) const
+		{
+			vec3 invDirection(1.f / direction.x, 1.f / direction.y, 1.f / direction.z);
+			std::vector<std::pair<float, int32>> hits;
+			for (size_t i = 0; i < boxes.size(); ++i)
+			{
+				float entry = 0.f;
+				float exit = maxDistance;
+				for (uint8 axis = 0; axis < 3; ++axis)
+				{
+					float t1 = (boxes[i].min[axis] - origin[axis]) * invDirection[axis];
+					float t2 = (boxes[i].max[axis] - origin[axis]) * invDirection[axis];
+					entry = std::max(entry, std::min(t1, t2));
+					exit = std::min(exit, std::max(t1, t2));
+				}
+				if (entry <= exit) hits.push_back(std::make_pair(entry, (int32)i));
+			}
+			std::sort(hits.begin(), hits.end());
+			result.clear();
+			for (const auto &hit : hits)
+			{
+				result.push_back(hit.second);
+			}
+		}
+		void QueryNearest(const vec3 &point, size_t count, std::vector<int32> &result) const
+		{
+			std::vector<std::pair<float, int32>> distances;
+			for (size_t i = 0; i < boxes.size(); ++i)
+			{
+				distances.push_back(std::make_pair(DistanceSquared(boxes[i], point), (int32)i));
+			}
+			count = std::min(count, distances.size());
+			std::partial_sort(distances.begin(), distances.begin() + count, distances.end());
+			result.clear();
+			for (size_t i = 0; i < count; ++i)
+			{
+				result.push_back(distances[i].second);
+			}
+		}
+	};
+
+	struct QueryTimes
+	{
+		double frustum = 0.0;
+		double sphere = 0.0;
+		double ray = 0.0;
+		double nearest = 0.0;
+		size_t results = 0;
+	};
+
+	template<typename TIndex>
+	void RunQueries(const TIndex &index, const std::vector<vec3> &points, const std::vector<vec3> &directions, float worldSize, QueryTimes &times)
+	{
+		std::vector<int32> result;
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			const vec3 &point = points[i];
+
+			BatchFrustum frustum(etm::lookAt(point, point + directions[i], vec3(0.f, 1.f, 0.f))
+				* etm::perspective(etm::radians(60.f), 16.f / 9.f, 0.1f, worldSize * 0.1f));
+			auto start = Clock::now();
+			index.QueryFrustum(frustum, result);
+			times.frustum += MicrosecondsSince(start);
+			times.results += result.size();
+
+			start = Clock::now();
+			index.QuerySphere(Sphere(point, worldSize * 0.02f), result);
+			times.sphere += MicrosecondsSince(start);
+			times.results += result.size();
+
+			start = Clock::now();
+			index.RayCast(point, directions[i], worldSize * 0.2f, result);
+			times.ray += MicrosecondsSince(start);
+			times.results += result.size();
+
+			start = Clock::now();
+			index.QueryNearest(point, 16, result);
+			times.nearest += MicrosecondsSince(start);
+			times.results += result.size();
+		}
+	}
+
+	void PrintQueries(const char* name, const QueryTimes &times, size_t queryCount)
+	{
+		double count = (double)std::max(queryCount, (size_t)1);
+		std::cout << "  " << std::left << std::setw(6) << name << std::right
+			<< " frustum " << std::setw(10) << times.frustum / count << " us"
+			<< "  sphere " << std::setw(10) << times.sphere / count << " us"
+			<< "  ray " << std::setw(10) << times.ray / count << " us"
+			<< "  nearest " << std::setw(10) << times.nearest / count << " us"
+			<< "  (" << times.results << " results)" << std::endl;
+	}
+}
+
+int32 RunSpatialBenchmark(const SpatialBenchmarkSettings &settings)
+{
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> position(-settings.worldSize * 0.5f, settings.worldSize * 0.5f);
+	std::uniform_real_distribution<float> size(0.25f, 4.f);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+	uint32 totalCount = settings.staticCount + settings.movingCount;
+	FlatScan flat;
+	std::vector<vec3> velocities;
+	for (uint32 i = 0; i < totalCount; ++i)
+	{
+		vec3 center(position(random), position(random), position(random));
+		vec3 extents(size(random), size(random), size(random));
+		flat.boxes.push_back(AABB(center - extents, center + extents));
+		if (i >= settings.staticCount)
+		{
+			velocities.push_back(vec3(unit(random), unit(random), unit(random)) * 0.3f);
+		}
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Spatial benchmark: " << settings.staticCount << " static and " << settings.movingCount << " moving boxes, "
+		<< settings.frames << " frames with " << settings.queriesPerFrame << " queries of each kind" << std::endl;
+
+	BoundingVolumeTree tree(0.5f);
+	std::vector<int32> proxies;
+	auto start = Clock::now();
+	for (uint32 i = 0; i < totalCount; ++i)
+	{
+		proxies.push_back(tree.CreateProxy(flat.boxes[i], nullptr));
+	}
+	std::cout << "  build  " << MicrosecondsSince(start) / 1000.0 << " ms, height " << tree.GetHeight() << std::endl;
+
+	double treeUpdate = 0.0;
+	double flatUpdate = 0.0;
+	size_t reinserted = 0;
+	QueryTimes treeTimes;
+	QueryTimes flatTimes;
+	std::vector<vec3> points;
+	std::vector<vec3> directions;
+	for (uint32 frame = 0; frame < settings.frames; ++frame)
+	{
+		//the flat array only needs the new boxes
+		start = Clock::now();
+		for (uint32 i = 0; i < settings.movingCount; ++i)
+		{
+			AABB &box = flat.boxes[settings.staticCount + i];
+			box = AABB(box.min + velocities[i], box.max + velocities[i]);
+		}
+		flatUpdate += MicrosecondsSince(start);
+
+		start = Clock::now();
+		for (uint32 i = 0; i < settings.movingCount; ++i)
+		{
+			uint32 index = settings.staticCount + i;
+			if (tree.MoveProxy(proxies[index], flat.boxes[index], velocities[i])) ++reinserted;
+		}
+		treeUpdate += MicrosecondsSince(start);
+
+		points.clear();
+		directions.clear();
+		for (uint32 query = 0; query < settings.queriesPerFrame; ++query)
+		{
+			points.push_back(vec3(position(random), position(random), position(random)));
+			directions.push_back(etm::normalize(vec3(unit(random), unit(random), unit(random)) + vec3(0.f, 0.f, 0.01f)));
+		}
+		RunQueries(tree, points, directions, settings.worldSize, treeTimes);
+		RunQueries(flat, points, directions, settings.worldSize, flatTimes);
+	}
+
+	double frames = (double)std::max(settings.frames, 1u);
+	std::cout << "  update tree " << treeUpdate / frames << " us per frame (" << reinserted / frames << " reinserted), flat "
+		<< flatUpdate / frames << " us per frame" << std::endl;
+	size_t queryCount = (size_t)settings.frames * settings.queriesPerFrame;
+	PrintQueries("tree", treeTimes, queryCount);
+	PrintQueries("flat", flatTimes, queryCount);
+	if (treeTimes.results != flatTimes.results)
+	{
+		std::cerr << "tree and flat scan disagree" << std::endl;
+		return 1;
+	}
+	return 0;
+}
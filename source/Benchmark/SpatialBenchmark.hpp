@@ -0,0 +1,18 @@
+#pragma once
+
+//Spatial Benchmark
+//*****************
+
+// Static and moving boxes in a BoundingVolumeTree against the same boxes in a flat array.
+// Reports the cost of moving the dynamic boxes every frame and of frustum, sphere, ray and nearest neighbour queries.
+
+struct SpatialBenchmarkSettings
+{
+	uint32 staticCount = 100000;
+	uint32 movingCount = 10000;
+	uint32 frames = 100;
+	uint32 queriesPerFrame = 10;
+	float worldSize = 5000.f;
+};
+
+int32 RunSpatialBenchmark(const SpatialBenchmarkSettings &settings);
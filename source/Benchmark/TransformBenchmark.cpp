@@ -0,0 +1,92 @@
+#include "../Engine/stdafx.hpp"
+#include "TransformBenchmark.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+#include "../Engine/SceneGraph/TransformHierarchy.hpp"
+#include "../Engine/Helper/TaskScheduler.hpp"
+
+namespace
+{
+	//breadth first below the first nodes, which are roots, so their subtrees are interleaved in creation order
+	void BuildWide(TransformHierarchy &hierarchy, std::vector<int32> &nodes, uint32 nodeCount, uint32 branching)
+	{
+		const uint32 rootCount = std::max(nodeCount / 64, 1u);
+		for (uint32 i = 0; i < nodeCount; ++i)
+		{
+			int32 parent = TransformHierarchy::NULL_NODE;
+			if (i >= rootCount)
+			{
+				parent = nodes[(i - rootCount) / branching];
+			}
+			nodes.push_back(hierarchy.CreateNode(parent, nullptr));
+		}
+	}
+
+	void BuildChain(TransformHierarchy &hierarchy, std::vector<int32> &nodes, uint32 nodeCount)
+	{
+		int32 parent = TransformHierarchy::NULL_NODE;
+		for (uint32 i = 0; i < nodeCount; ++i)
+		{
+			parent = hierarchy.CreateNode(parent, nullptr);
+			nodes.push_back(parent);
+		}
+	}
+
+	void RunHierarchy(const std::string &name, const TransformBenchmarkSettings &settings, bool isChain)
+	{
+		TaskScheduler scheduler(settings.workerCount);
+		TransformHierarchy hierarchy(settings.workerCount == 1 ? nullptr : &scheduler);
+		std::vector<int32> nodes;
+		if (isChain)
+		{
+			BuildChain(hierarchy, nodes, settings.nodeCount);
+		}
+		else
+		{
+			BuildWide(hierarchy, nodes, settings.nodeCount, settings.branching);
+		}
+		hierarchy.Update();
+
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> offset(-1.f, 1.f);
+		std::uniform_int_distribution<size_t> pick(0, nodes.size() - 1);
+		std::cout << "  " << name << std::endl;
+		for (float fraction : { 0.f, 0.001f, 0.01f, 0.1f, 1.f })
+		{
+			const uint32 moved = (uint32)(fraction * settings.nodeCount);
+			double ms = 0.0;
+			size_t recomputed = 0;
+			for (uint32 frame = 0; frame < settings.frames; ++frame)
+			{
+				//the deep chain moves its tail, otherwise every change would update the whole chain
+				for (uint32 i = 0; i < moved; ++i)
+				{
+					int32 node = nodes[pick(random)];
+					if (isChain) node = nodes[nodes.size() - 1 - i];
+					hierarchy.SetLocal(node, vec3(offset(random), offset(random), offset(random)), quat(vec3(0.f, offset(random), 0.f)), vec3(1.f));
+				}
+				auto start = std::chrono::steady_clock::now();
+				hierarchy.Update();
+				auto end = std::chrono::steady_clock::now();
+				ms += std::chrono::duration<double, std::milli>(end - start).count();
+				recomputed += hierarchy.GetChangedNodes().size();
+			}
+			std::cout << "    " << std::setw(6) << moved << " moved: " << std::setw(8) << ms / settings.frames << " ms per frame, "
+				<< recomputed / settings.frames << " of " << hierarchy.GetNodeCount() << " world transforms recomputed" << std::endl;
+		}
+	}
+}
+
+int32 RunTransformBenchmark(const TransformBenchmarkSettings &settings)
+{
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Transform benchmark: " << settings.nodeCount << " nodes, " << settings.frames << " frames, "
+		<< settings.workerCount << " workers" << std::endl;
+	RunHierarchy("wide hierarchy", settings, false);
+	RunHierarchy("deep chain", settings, true);
+	return 0;
+}
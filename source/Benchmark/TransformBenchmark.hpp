@@ -0,0 +1,19 @@
+#pragma once
+
+//Transform Benchmark
+//*******************
+
+// Hierarchies of entity transforms, a wide one with many shallow trees and a deep chain, updated through a TransformHierarchy.
+// Each frame moves a fraction of the nodes and reports the time per frame against the number of world transforms recomputed,
+// which grows with the changed subtrees rather than with the size of the scene.
+
+struct TransformBenchmarkSettings
+{
+	uint32 nodeCount = 65536;
+	uint32 frames = 100;
+	uint32 workerCount = 1;
+	//children per node in the wide hierarchy
+	uint32 branching = 4;
+};
+
+int32 RunTransformBenchmark(const TransformBenchmarkSettings &settings);
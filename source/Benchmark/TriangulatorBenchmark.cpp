@@ -0,0 +1,205 @@
+#include "../Engine/stdafx.hpp"
+#include "TriangulatorBenchmark.hpp"
+
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+#include "../Engine/PlanetTech/Triangulator.hpp"
+#include "../Engine/Graphics/Frustum.hpp"
+#include "../Engine/Helper/CameraPath.hpp"
+
+namespace
+{
+	struct FrameResult
+	{
+		double milliseconds = 0.0;
+		uint32 heuristicCount = 0;
+		size_t instanceCount = 0;
+		//what Patch::BindInstances would upload
+		size_t uploadBytes = 0;
+		std::vector<uint32> levelHistogram;
+	};
+
+	//camera descending from 200 units above the surface to 2 while flying around the planet and turning its head
+	CameraPath GenerateDescent(const TriangulatorBenchmarkSettings &settings)
+	{
+		CameraPath path;
+		for (uint32 frame = 0; frame < settings.generatedFrames; ++frame)
+		{
+			float t = frame / (float)settings.generatedFrames;
+			float altitude = 200.f * powf(0.01f, t);
+			float orbitAngle = t * 0.05f;
+			float headAngle = sinf(t * etm::PI * 2.f) * 0.2f;
+
+			vec3 radial = etm::normalize(vec3(sinf(orbitAngle), 0.2f, cosf(orbitAngle)));
+			vec3 tangent = etm::normalize(etm::cross(radial, vec3::UP));
+			vec3 bitangent = etm::cross(tangent, radial);
+
+			CameraPathFrame pathFrame;
+			pathFrame.position = radial * (settings.radius + altitude);
+			pathFrame.forward = etm::normalize(tangent * cosf(headAngle) + bitangent * sinf(headAngle) - radial * 0.5f);
+			path.AddFrame(pathFrame);
+		}
+		return path;
+	}
+
+	//same clipping planes the planet test scene uses
+	void SetCamera(Triangulator &triangulator, const CameraPathFrame &frame, const TriangulatorBenchmarkSettings &settings)
+	{
+		float distance = etm::length(frame.position);
+		float altitude = std::max(distance - settings.radius, 0.f);
+		float farPlane = (sqrtf(powf(settings.radius + altitude, 2) - powf(settings.radius, 2))
+			+ sqrtf(powf(settings.radius + settings.maxHeight, 2) - powf(settings.radius, 2))) * 10;
+
+		//keep the planets up direction unless the camera looks straight at it
+		vec3 forward = etm::normalize(frame.forward);
+		vec3 up = frame.position / distance;
+		if (std::abs(etm::dot(up, forward)) > 0.999f) up = std::abs(forward.y) < 0.9f ? vec3::UP : vec3(1, 0, 0);
+		vec3 right = etm::normalize(etm::cross(up, forward));
+		up = etm::cross(forward, right);
+
+		Frustum* pFrustum = triangulator.GetFrustum();
+		pFrustum->SetCullTransform(mat4(), mat4());
+		pFrustum->SetCamera(frame.position, forward, up, frame.fov, farPlane * 0.000003f, farPlane, frame.aspectRatio);
+		pFrustum->Update();
+		triangulator.SetViewportWidth(settings.viewportWidth);
+	}
+
+	double GetPercentile(std::vector<double> values, double percentile)
+	{
+		if (values.empty()) return 0.0;
+		size_t index = std::min((size_t)(percentile * values.size()), values.size() - 1);
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+}
+
+int32 RunTriangulatorBenchmark(const TriangulatorBenchmarkSettings &settings)
+{
+	CameraPath path;
+	if (settings.cameraPathFile.empty())
+	{
+		path = GenerateDescent(settings);
+	}
+	else if (!path.Load(settings.cameraPathFile))
+	{
+		std::cerr << "Couldn't load camera path " << settings.cameraPathFile << std::endl;
+		return 1;
+	}
+	if (path.GetFrames().empty())
+	{
+		std::cerr << "Camera path has no frames" << std::endl;
+		return 1;
+	}
+
+	Triangulator triangulator(settings.radius, settings.maxHeight);
+	triangulator.SetIncremental(settings.incremental);
+	triangulator.Init();
+	triangulator.SetMultithreaded(settings.multithreaded);
+	triangulator.SetAsync(settings.async);
+
+	std::vector<FrameResult> results;
+	for (const CameraPathFrame &frame : path.GetFrames())
+	{
+		SetCamera(triangulator, frame, settings);
+
+		auto start = std::chrono::steady_clock::now();
+		triangulator.GenerateGeometry();
+		auto end = std::chrono::steady_clock::now();
+		//stands in for rendering the frame, the results below describe the geometry published one frame behind the camera
+		if (settings.async) triangulator.WaitForGeneration();
+
+		FrameResult result;
+		result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+		result.heuristicCount = triangulator.GetHeuristicCount();
+		result.instanceCount = triangulator.GetPositions().size();
+		if (triangulator.IsGeometryChanged())
+		{
+			result.uploadBytes = (result.instanceCount - std::min(triangulator.GetFirstChangedInstance(), result.instanceCount)) * sizeof(PatchInstance);
+		}
+		for (const PatchInstance &instance : triangulator.GetPositions())
+		{
+			int32 level = instance.GetLevel();
+			if ((size_t)level >= result.levelHistogram.size()) result.levelHistogram.resize(level + 1, 0);
+			++result.levelHistogram[level];
+		}
+		results.push_back(result);
+	}
+
+	//Per frame results
+	size_t levelCount = 0;
+	for (const FrameResult &result : results)
+	{
+		levelCount = std::max(levelCount, result.levelHistogram.size());
+	}
+	if (!settings.csvFile.empty())
+	{
+		std::ofstream csv(settings.csvFile);
+		if (!csv)
+		{
+			std::cerr << "Couldn't write " << settings.csvFile << std::endl;
+			return 1;
+		}
+		csv << "frame,ms,heuristics,instances,uploadBytes";
+		for (size_t level = 0; level < levelCount; ++level)
+		{
+			csv << ",level" << level;
+		}
+		csv << '\n';
+		for (size_t frame = 0; frame < results.size(); ++frame)
+		{
+			const FrameResult &result = results[frame];
+			csv << frame << ',' << result.milliseconds << ',' << result.heuristicCount << ',' << result.instanceCount << ',' << result.uploadBytes;
+			for (size_t level = 0; level < levelCount; ++level)
+			{
+				csv << ',' << (level < result.levelHistogram.size() ? result.levelHistogram[level] : 0);
+			}
+			csv << '\n';
+		}
+	}
+
+	//Summary
+	std::vector<double> milliseconds;
+	uint64 totalHeuristics = 0;
+	uint64 totalInstances = 0;
+	uint64 totalUploadBytes = 0;
+	std::vector<uint64> levelHistogram(levelCount, 0);
+	for (const FrameResult &result : results)
+	{
+		milliseconds.push_back(result.milliseconds);
+		totalHeuristics += result.heuristicCount;
+		totalInstances += result.instanceCount;
+		totalUploadBytes += result.uploadBytes;
+		for (size_t level = 0; level < result.levelHistogram.size(); ++level)
+		{
+			levelHistogram[level] += result.levelHistogram[level];
+		}
+	}
+	double totalMilliseconds = 0.0;
+	for (double value : milliseconds)
+	{
+		totalMilliseconds += value;
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Triangulator benchmark: " << results.size() << " frames"
+		<< (settings.incremental ? ", incremental" : ", full rebuild")
+		<< (settings.multithreaded ? ", multithreaded" : ", single threaded")
+		<< (settings.async ? ", async (main thread time only)" : "") << std::endl;
+	std::cout << "  ms per frame:     mean " << totalMilliseconds / results.size()
+		<< ", median " << GetPercentile(milliseconds, 0.5)
+		<< ", 95% " << GetPercentile(milliseconds, 0.95)
+		<< ", max " << *std::max_element(milliseconds.begin(), milliseconds.end()) << std::endl;
+	std::cout << "  heuristics/frame: " << totalHeuristics / (double)results.size() << std::endl;
+	std::cout << "  instances/frame:  " << totalInstances / (double)results.size() << std::endl;
+	std::cout << "  upload KB/frame:  " << totalUploadBytes / 1024.0 / results.size() << std::endl;
+	std::cout << "  instances per level, averaged over all frames:" << std::endl;
+	for (size_t level = 0; level < levelCount; ++level)
+	{
+		std::cout << "    " << std::setw(2) << level << ": " << levelHistogram[level] / (double)results.size() << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+
+//Triangulator Benchmark
+//**********************
+
+// Replays a camera path over a planet without a window or graphics context and reports what the triangulation costs per frame.
+
+struct TriangulatorBenchmarkSettings
+{
+	//recorded with the planet test scene, a descent to the surface is generated if this is empty
+	std::string cameraPathFile;
+	uint32 generatedFrames = 1000;
+
+	float radius = 1737.1f;
+	float maxHeight = 10.7f;
+	int32 viewportWidth = 1920;
+
+	bool incremental = true;
+	bool multithreaded = true;
+	//generate on the worker thread and only time what the main thread waits for, the way the planet runs it
+	bool async = false;
+
+	//per frame results as comma separated values, skipped if empty
+	std::string csvFile;
+};
+
+int32 RunTriangulatorBenchmark(const TriangulatorBenchmarkSettings &settings);
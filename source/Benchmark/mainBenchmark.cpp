@@ -0,0 +1,187 @@
+#include "../Engine/stdafx.hpp"
+
+#include <iostream>
+#include <cstring>
+
+#include "TriangulatorBenchmark.hpp"
+#include "AtmosphereBenchmark.hpp"
+#include "FrustumBenchmark.hpp"
+#include "SpatialBenchmark.hpp"
+#include "OcclusionBenchmark.hpp"
+#include "LightClusterBenchmark.hpp"
+#include "TransformBenchmark.hpp"
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cout << "usage: Benchmark triangulator [--path file] [--frames count] [--radius r] [--height h] [--width px] "
+			"[--rebuild] [--serial] [--async] [--csv file]" << std::endl;
+		std::cout << "       Benchmark atmosphere [--params file] [--cache file] [--no-cache] [--workers count] [--orders count]" << std::endl;
+		std::cout << "       Benchmark frustum [--count volumes] [--iterations count]" << std::endl;
+		std::cout << "       Benchmark spatial [--static count] [--moving count] [--frames count] [--queries count]" << std::endl;
+		std::cout << "       Benchmark occlusion [--occluders count] [--bounds count] [--frames count] [--workers count] [--width px] [--height px]" << std::endl;
+		std::cout << "       Benchmark lights [--count lights] [--frames count] [--workers count] [--radius r]" << std::endl;
+		std::cout << "       Benchmark transforms [--count nodes] [--frames count] [--workers count] [--branching children]" << std::endl;
+	}
+
+	int32 RunTriangulator(int argc, char* argv[])
+	{
+		TriangulatorBenchmarkSettings settings;
+		for (int32 i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--rebuild") settings.incremental = false;
+			else if (arg == "--serial") settings.multithreaded = false;
+			else if (arg == "--async") settings.async = true;
+			else if (arg == "--path" && hasValue) settings.cameraPathFile = argv[++i];
+			else if (arg == "--frames" && hasValue) settings.generatedFrames = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--radius" && hasValue) settings.radius = std::stof(argv[++i]);
+			else if (arg == "--height" && hasValue) settings.maxHeight = std::stof(argv[++i]);
+			else if (arg == "--width" && hasValue) settings.viewportWidth = std::stoi(argv[++i]);
+			else if (arg == "--csv" && hasValue) settings.csvFile = argv[++i];
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return 1;
+			}
+		}
+		return RunTriangulatorBenchmark(settings);
+	}
+
+	int32 RunAtmosphere(int argc, char* argv[])
+	{
+		AtmosphereBenchmarkSettings settings;
+		for (int32 i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--no-cache") settings.writeCache = false;
+			else if (arg == "--params" && hasValue) settings.paramFile = argv[++i];
+			else if (arg == "--cache" && hasValue) settings.cacheFile = argv[++i];
+			else if (arg == "--workers" && hasValue) settings.workerCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--orders" && hasValue) settings.scatteringOrders = std::stoi(argv[++i]);
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return 1;
+			}
+		}
+		return RunAtmosphereBenchmark(settings);
+	}
+
+	int32 RunFrustum(int argc, char* argv[])
+	{
+		FrustumBenchmarkSettings settings;
+		for (int32 i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--count" && hasValue) settings.volumeCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--iterations" && hasValue) settings.iterations = (uint32)std::stoul(argv[++i]);
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return 1;
+			}
+		}
+		return RunFrustumBenchmark(settings);
+	}
+
+	int32 RunSpatial(int argc, char* argv[])
+	{
+		SpatialBenchmarkSettings settings;
+		for (int32 i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--static" && hasValue) settings.staticCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--moving" && hasValue) settings.movingCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--frames" && hasValue) settings.frames = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--queries" && hasValue) settings.queriesPerFrame = (uint32)std::stoul(argv[++i]);
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return 1;
+			}
+		}
+		return RunSpatialBenchmark(settings);
+	}
+
+	int32 RunOcclusion(int argc, char* argv[])
+	{
+		OcclusionBenchmarkSettings settings;
+		for (int32 i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--occluders" && hasValue) settings.occluderCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--bounds" && hasValue) settings.boundsCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--frames" && hasValue) settings.frames = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--workers" && hasValue) settings.workerCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--width" && hasValue) settings.resolution.x = std::stoi(argv[++i]);
+			else if (arg == "--height" && hasValue) settings.resolution.y = std::stoi(argv[++i]);
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return 1;
+			}
+		}
+		return RunOcclusionBenchmark(settings);
+	}
+
+	int32 RunLightClusters(int argc, char* argv[])
+	{
+		LightClusterBenchmarkSettings settings;
+		for (int32 i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--count" && hasValue) settings.lightCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--frames" && hasValue) settings.frames = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--workers" && hasValue) settings.workerCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--radius" && hasValue) settings.lightRadius = std::stof(argv[++i]);
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return 1;
+			}
+		}
+		return RunLightClusterBenchmark(settings);
+	}
+
+	int32 RunTransforms(int argc, char* argv[])
+	{
+		TransformBenchmarkSettings settings;
+		for (int32 i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--count" && hasValue) settings.nodeCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--frames" && hasValue) settings.frames = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--workers" && hasValue) settings.workerCount = (uint32)std::stoul(argv[++i]);
+			else if (arg == "--branching" && hasValue) settings.branching = std::max((uint32)std::stoul(argv[++i]), 1u);
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return 1;
+			}
+		}
+		return RunTransformBenchmark(settings);
+	}
+}
+
+//Benchmarks that run without a window or graphics context
+int main(int argc, char* argv[])
+{
+	if (argc >= 2 && strcmp(argv[1], "triangulator") == 0) return RunTriangulator(argc, argv);
+	if (argc >= 2 && strcmp(argv[1], "atmosphere") == 0) return RunAtmosphere(argc, argv);
+	if (argc >= 2 && strcmp(argv[1], "frustum") == 0) return RunFrustum(argc, argv);
+	if (argc >= 2 && strcmp(argv[1], "spatial") == 0) return RunSpatial(argc, argv);
+	if (argc >= 2 && strcmp(argv[1], "occlusion") == 0) return RunOcclusion(argc, argv);
+	if (argc >= 2 && strcmp(argv[1], "lights") == 0) return RunLightClusters(argc, argv);
+	if (argc >= 2 && strcmp(argv[1], "transforms") == 0) return RunTransforms(argc, argv);
+	PrintUsage();
+	return 1;
+}
@@ -77,6 +77,7 @@ void PhysicsTestScene::Initialize()
 	{
 		auto pModelComp = new ModelComponent("Resources/Models/cube.dae");
 		pModelComp->SetMaterial(m_pFloorMat);
+		pModelComp->SetOccluder(true);
 		auto pFloor = new Entity();
 		pFloor->AddComponent(pModelComp);
 		pFloor->GetTransform()->SetPosition(vec3(0));
@@ -103,6 +104,8 @@ void PhysicsTestScene::Initialize()
 		{
 			auto pModelComp = new ModelComponent("Resources/Models/cube.dae");
 			pModelComp->SetMaterial(m_pBlockMat);
+			//the tower blocks hide each other from most angles
+			pModelComp->SetOccluder(true);
 			auto pBlock = new Entity();
 			pBlock->AddComponent(pModelComp);
 			if (level % 2 < 1)
@@ -228,6 +231,8 @@ void PhysicsTestScene::Draw()
 	TextRenderer::GetInstance()->SetColor(vec4(1, 1, 1, 1));
 	outString = "Frame ms: " + std::to_string(PERFORMANCE->GetFrameMS());
 	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 20 + (m_pDebugFont->GetFontSize()*1.1f) * 2));
+	outString = "Visible Models: " + std::to_string(PERFORMANCE->m_VisibleModels) + " Occluded: " + std::to_string(PERFORMANCE->m_OccludedModels);
+	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 20 + (m_pDebugFont->GetFontSize()*1.1f) * 3));
 	outString = "Draw Calls: " + std::to_string(PERFORMANCE->m_PrevDrawCalls);
 	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 100 + (m_pDebugFont->GetFontSize()*1.1f) * 3), 128);
 	outString = "VAWAVMVoV.";
@@ -38,6 +38,8 @@ void PlanetTestScene::Initialize()
 
 	//Camera
 	//**************************
+	//the camera moves across the whole planet, so positions are kept relative to it
+	GetFloatingOrigin().SetEnabled(true);
 
 	//Materials
 	//**************************
@@ -104,6 +106,31 @@ void PlanetTestScene::Update()
 		ScreenshotCapture::GetInstance()->Take();
 	}
 
+	//Record the camera path until P is pressed again
+	if (INPUT->IsKeyboardKeyPressed('P'))
+	{
+		m_IsRecordingPath = !m_IsRecordingPath;
+		if (m_IsRecordingPath)
+		{
+			m_CameraPath.Clear();
+			LOG("Recording camera path");
+		}
+		else if (m_CameraPath.Save("planet_camera_path.txt"))
+		{
+			LOG("Saved " + std::to_string(m_CameraPath.GetFrames().size()) + " frames to planet_camera_path.txt");
+		}
+	}
+	if (m_IsRecordingPath)
+	{
+		const mat4 &planetInverse = m_pPlanet->GetTransform()->GetWorldInverse();
+		CameraPathFrame frame;
+		frame.position = (planetInverse * vec4(CAMERA->GetTransform()->GetPosition(), 1)).xyz;
+		frame.forward = etm::normalize((planetInverse * vec4(CAMERA->GetTransform()->GetForward(), 0)).xyz);
+		frame.fov = CAMERA->GetFOV();
+		frame.aspectRatio = WINDOW.GetAspectRatio();
+		m_CameraPath.AddFrame(frame);
+	}
+
 	//Change light settings
 	if (INPUT->IsKeyboardKeyDown(SDL_SCANCODE_KP_3))
 	{
@@ -1,5 +1,6 @@
 #pragma once
 #include "../../Engine/SceneGraph/AbstractScene.hpp"
+#include "../../Engine/Helper/CameraPath.hpp"
 
 class Planet;
 class Entity;
@@ -24,5 +25,9 @@ private:
 	Planet* m_pPlanet = nullptr;
 
 	SpriteFont* m_pDebugFont = nullptr;
+
+	//camera flight in the planets object space, for replaying in the triangulator benchmark
+	bool m_IsRecordingPath = false;
+	CameraPath m_CameraPath;
 };
 
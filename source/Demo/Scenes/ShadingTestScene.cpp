@@ -70,6 +70,7 @@ void ShadingTestScene::Initialize()
 	{
 		auto pModelComp = new ModelComponent("Resources/Models/HelmetStand.dae");
 		pModelComp->SetMaterial(m_pStandMat);
+		pModelComp->SetOccluder(true);
 		auto pHelmet = new Entity();
 		pHelmet->AddComponent(pModelComp);
 		pHelmet->GetTransform()->SetPosition(vec3(0, 0, 0));
@@ -78,6 +79,7 @@ void ShadingTestScene::Initialize()
 	{
 		auto pModelComp = new ModelComponent("Resources/Models/Env.dae");
 		pModelComp->SetMaterial(m_pEnvMat);
+		pModelComp->SetOccluder(true);
 		auto pHelmet = new Entity();
 		pHelmet->AddComponent(pModelComp);
 		pHelmet->GetTransform()->SetPosition(vec3(0, 0, 0));
@@ -169,6 +171,8 @@ void ShadingTestScene::Draw()
 	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 50));
 	outString = "Draw Calls: " + std::to_string( PERFORMANCE->m_PrevDrawCalls );
 	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 80));
+	outString = "Visible Models: " + std::to_string( PERFORMANCE->m_VisibleModels ) + " Occluded: " + std::to_string( PERFORMANCE->m_OccludedModels );
+	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 110));
 }
 
 void ShadingTestScene::DrawForward()
@@ -228,6 +228,8 @@ void TestScene::Draw()
 	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 80));
 	outString = "Lights: " + std::to_string( (int32)m_Lights.size() );
 	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 110));
+	outString = "Visible Models: " + std::to_string( PERFORMANCE->m_VisibleModels ) + " Occluded: " + std::to_string( PERFORMANCE->m_OccludedModels );
+	TextRenderer::GetInstance()->DrawText(outString, vec2(20, 140));
 }
 
 void TestScene::DrawForward()
@@ -10,6 +10,7 @@
 #include "../Helper/PerformanceInfo.hpp"
 #include "../GraphicsHelper/PrimitiveRenderer.hpp"
 #include "../GraphicsHelper/RenderPipeline.hpp"
+#include "../Helper/TaskScheduler.hpp"
 
 
 #ifdef EDITOR
@@ -75,6 +76,9 @@ AbstractFramework::~AbstractFramework()
 	
 	RenderPipeline::GetInstance()->DestroyInstance();
 	Settings::GetInstance()->DestroyInstance();
+
+	//after everything that runs tasks on it
+	TaskScheduler::GetInstance()->DestroyInstance();
 }
 
 void AbstractFramework::Run()
@@ -23,7 +23,8 @@ Settings::GraphicsSettings::GraphicsSettings() :
 	PbrBrdfLutSize( 512 ),
 	TextureScaleFactor( 0.25f ),
 	NumBlurPasses( 5 ),
-	UseFXAA(true)
+	UseFXAA(true),
+	UseClusteredLighting(true)
 {
 }
 Settings::GraphicsSettings::~GraphicsSettings()
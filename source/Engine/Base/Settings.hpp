@@ -25,6 +25,9 @@ public:
 
 		int32 PbrBrdfLutSize;
 
+		//Shade all point lights in one pass over the light clusters of the camera instead of drawing a volume for each
+		bool UseClusteredLighting;
+
 		float TextureScaleFactor;
 
 		//Bloom Quality
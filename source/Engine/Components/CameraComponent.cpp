@@ -73,7 +73,7 @@ void CameraComponent::Update()
 		m_FreezeTimer = 1;
 		m_IsFrustumFrozen = !m_IsFrustumFrozen;
 	}
-	m_pFrustum->SetCullTransform(mat4());//Frustum will be in world space and objects need to transform themselves
+	m_pFrustum->SetCullTransform(mat4(), mat4());//Frustum will be in world space and objects need to transform themselves
 	if(!m_IsFrustumFrozen)m_pFrustum->SetToCamera(this);
 	m_pFrustum->Update();
 }
@@ -13,7 +13,6 @@
 #include <iostream>
 #include "../GraphicsHelper/ShadowRenderer.hpp"
 #include "../Materials/NullMaterial.hpp"
-#include "../Graphics/Frustum.hpp"
 #include "../GraphicsHelper/RenderPipeline.hpp"
 #include "../GraphicsHelper/RenderState.hpp"
 
@@ -29,6 +28,7 @@ void ModelComponent::Initialize()
 {
 	m_pMeshFilter = ContentManager::Load<MeshFilter>(m_AssetFile);
 	UpdateMaterial();
+	GetTransform()->OnBoundsChanged();
 }
 
 void ModelComponent::UpdateMaterial()
@@ -51,8 +51,10 @@ void ModelComponent::Update()
 	UpdateMaterial();
 }
 
+//Culled models are drawn from the visible lists of SceneVisibility, only the ones that are always drawn are drawn with their entity
 void ModelComponent::Draw()
 {
+	if (m_CullMode != CullMode::DISABLED) return;
 	if (m_pMaterial == nullptr)
 	{
 		LOG("ModelComponent::Draw> material is null\n", LogLevel::Warning);
@@ -62,6 +64,7 @@ void ModelComponent::Draw()
 }
 void ModelComponent::DrawForward()
 {
+	if (m_CullMode != CullMode::DISABLED) return;
 	if (m_pMaterial == nullptr)
 	{
 		LOG("ModelComponent::Draw> material is null\n", LogLevel::Warning);
@@ -71,23 +74,6 @@ void ModelComponent::DrawForward()
 }
 void ModelComponent::DrawCall()
 {
-	//Frustum culling
-	switch (m_CullMode)
-	{
-	case CullMode::SPHERE:
-	{
-		auto filterSphere = m_pMeshFilter->GetBoundingSphere();
-		vec3 scale = TRANSFORM->GetScale();
-		float maxScale = std::max(scale.x, std::max(scale.y, scale.z));
-		Sphere objSphere = Sphere(GetTransform()->GetPosition() + filterSphere->pos, filterSphere->radius*maxScale);
-		if (CAMERA->GetFrustum()->ContainsSphere(objSphere) == VolumeCheck::OUTSIDE)
-			return;
-	}
-	case CullMode::DISABLED:
-		break;
-	default:
-		break;
-	}
 	//Get Vertex Object
 	auto vO = m_pMeshFilter->GetVertexObject(m_pMaterial);
 	STATE->BindVertexArray(vO.array);
@@ -98,6 +84,11 @@ void ModelComponent::DrawCall()
 }
 
 void ModelComponent::DrawShadow()
+{
+	if (m_CullMode != CullMode::DISABLED) return;
+	DrawShadowCall();
+}
+void ModelComponent::DrawShadowCall()
 {
 	auto nullMat = ShadowRenderer::GetInstance()->GetNullMaterial();
 	mat4 matWVP = ShadowRenderer::GetInstance()->GetLightVP();
@@ -107,8 +98,23 @@ void ModelComponent::DrawShadow()
 	STATE->DrawElements(GL_TRIANGLES, (uint32)m_pMeshFilter->m_IndexCount, GL_UNSIGNED_INT, 0);
 }
 
+bool ModelComponent::IsForwardRendered() const
+{
+	return m_pMaterial != nullptr && m_pMaterial->IsForwardRendered();
+}
+
+Sphere ModelComponent::GetWorldBoundingSphere() const
+{
+	const Sphere* pFilterSphere = m_pMeshFilter->GetBoundingSphere();
+	const mat4 &world = GetTransform()->GetWorld();
+	//the world matrix already holds the parents rotation and scale, so the length of its axes is the scale in world space
+	float maxScale = std::max(etm::length(world[0].xyz), std::max(etm::length(world[1].xyz), etm::length(world[2].xyz)));
+	return Sphere((world * vec4(pFilterSphere->pos, 1)).xyz, pFilterSphere->radius * maxScale);
+}
+
 void ModelComponent::SetMaterial(Material* pMaterial)
 {
 	m_MaterialSet = true;
 	m_pMaterial = pMaterial;
+	if (m_pEntity) GetTransform()->OnBoundsChanged();
 }
\ No newline at end of file
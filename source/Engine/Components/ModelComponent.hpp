@@ -17,7 +17,16 @@ public:
 		DISABLED
 	};
 	void SetCullMode(CullMode mode) { m_CullMode = mode; }
+	CullMode GetCullMode() const { return m_CullMode; }
+	//Occluders are rasterized on the CPU and hide the models behind them, best for large and simple opaque meshes
+	void SetOccluder(bool isOccluder) { m_IsOccluder = isOccluder; }
+	bool IsOccluder() const { return m_IsOccluder; }
 
+	//Models that have a mesh and material can be drawn by the render pipelines visibility lists
+	bool IsDrawable() const { return m_pMeshFilter != nullptr && m_pMaterial != nullptr; }
+	bool IsForwardRendered() const;
+	//Mesh bounds in world space, including parent transforms and the largest axis scale
+	Sphere GetWorldBoundingSphere() const;
 
 protected:
 
@@ -28,15 +37,18 @@ protected:
 	virtual void DrawShadow();
 
 private:
+	friend class SceneVisibility;
 
 	void UpdateMaterial();
 	void DrawCall();
+	void DrawShadowCall();
 
 	std::string m_AssetFile;
 	MeshFilter* m_pMeshFilter = nullptr;
 	Material* m_pMaterial = nullptr;
 	bool m_MaterialSet = false;
 	CullMode m_CullMode = CullMode::SPHERE;
+	bool m_IsOccluder = false;
 
 private:
 	// -------------------------
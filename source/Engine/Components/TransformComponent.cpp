@@ -1,9 +1,16 @@
 #include "stdafx.hpp"
 
 #include "TransformComponent.hpp"
+
+#include <algorithm>
+
 #include "LightComponent.hpp"
+#include "ModelComponent.hpp"
 #include "../SceneGraph/Entity.hpp"
 #include "RigidBodyComponent.h"
+#include "../SceneGraph/AbstractScene.hpp"
+#include "../SceneGraph/BoundingVolumeTree.hpp"
+#include "../SceneGraph/TransformHierarchy.hpp"
 
 
 TransformComponent::TransformComponent()
@@ -14,73 +21,299 @@ TransformComponent::TransformComponent()
 
 TransformComponent::~TransformComponent()
 {
+	RemoveFromScene();
 }
 
 void TransformComponent::Initialize()
 {
+	OnComponentsChanged();
+	AttachToHierarchy();
 	UpdateTransforms();
 }
 
 void TransformComponent::Update()
 {
+	m_IsWorldChanged = false;
+	if (!m_pHierarchy)
+	{
+		AttachToHierarchy();
+	}
 	UpdateTransforms();
 }
 
+void TransformComponent::OnComponentsChanged()
+{
+	m_pRigidBody = m_pEntity->GetComponent<RigidBodyComponent>();
+	m_pLight = m_pEntity->GetComponent<LightComponent>();
+	m_pModels = m_pEntity->GetComponents<ModelComponent>();
+}
+
+void TransformComponent::AttachToHierarchy()
+{
+	AbstractScene* pScene = m_pEntity->GetScene();
+	if (!pScene) return;
+
+	//the parent has to be in the hierarchy first, until then the world transform is computed here
+	int32 parentNode = TransformHierarchy::NULL_NODE;
+	Entity* parent = m_pEntity->GetParent();
+	if (parent)
+	{
+		TransformComponent* pParentTransform = parent->GetTransform();
+		if (pParentTransform->m_pScene != pScene) return;
+		parentNode = pParentTransform->m_Node;
+	}
+
+	m_pScene = pScene;
+	m_pHierarchy = pScene->GetTransformHierarchy();
+	m_Node = m_pHierarchy->CreateNode(parentNode, this);
+	m_pHierarchy->SetLocal(m_Node, m_Position, m_Rotation, m_Scale);
+}
+
 void TransformComponent::UpdateTransforms()
 {
-	//Rigid body handling
-	auto rigidbody = m_pEntity->GetComponent<RigidBodyComponent>();
-	if (rigidbody)
+	Entity* parent = m_pEntity->GetParent();
+	dvec3 origin = GetOrigin();
+
+	//Absolute positions are converted to be relative to the floating origin
+	bool absoluteChanged = !parent && (m_IsTransformChanged & TransformChanged::ABSOLUTE_TRANSLATION);
+	if (absoluteChanged)
+	{
+		m_Position = etm::vecCast<float>(m_AbsolutePosition - origin);
+		m_IsTransformChanged |= TransformChanged::TRANSLATION;
+	}
+
+	//Rigid body handling, only a body that moved changes the transform
+	if (m_pRigidBody)
 	{
 		if (m_IsTransformChanged & TransformChanged::TRANSLATION)
-			rigidbody->SetPosition(m_Position);
+		{
+			m_pRigidBody->SetPosition(m_Position);
+		}
 		else
-			m_Position = rigidbody->GetPosition();
+		{
+			vec3 position = m_pRigidBody->GetPosition();
+			if (!(position == m_Position))
+			{
+				m_Position = position;
+				m_IsTransformChanged |= TransformChanged::TRANSLATION;
+			}
+		}
 
 		if (m_IsTransformChanged & TransformChanged::ROTATION)
-			rigidbody->SetRotation(m_Rotation);
+		{
+			m_pRigidBody->SetRotation(m_Rotation);
+		}
 		else
-			m_Rotation = rigidbody->GetRotation();
+		{
+			quat rotation = m_pRigidBody->GetRotation();
+			if (!(rotation.v4 == m_Rotation.v4))
+			{
+				m_Rotation = rotation;
+				m_IsTransformChanged |= TransformChanged::ROTATION;
+			}
+		}
 	}
-	else if (m_IsTransformChanged & TransformChanged::NONE)
-		return;
 
-	//Light handling
-	if (m_IsTransformChanged & TransformChanged::TRANSLATION | TransformChanged::ROTATION)
+	//outside of a hierarchy children move with their parents here
+	bool parentChanged = !m_pHierarchy && parent && parent->GetTransform()->m_IsWorldChanged;
+	if (m_IsTransformChanged == TransformChanged::NONE && !parentChanged)
 	{
-		auto ligComp = m_pEntity->GetComponent<LightComponent>();
-		if (!(ligComp == nullptr))
+		if (m_IsBoundsChanged)
 		{
-			ligComp->m_PositionUpdated = true;
+			UpdateSpatialProxy();
 		}
+		return;
+	}
+
+	//keep the double precision position unless the single precision one was changed
+	if (!parent && !absoluteChanged && (m_IsTransformChanged & TransformChanged::TRANSLATION))
+	{
+		m_AbsolutePosition = origin + etm::vecCast<double>(m_Position);
+	}
+
+	m_IsTransformChanged = TransformChanged::NONE;
+
+	//the scene recomputes the world transform of this entity and everything attached to it in one pass
+	if (m_pHierarchy)
+	{
+		m_pHierarchy->SetLocal(m_Node, m_Position, m_Rotation, m_Scale);
+		return;
 	}
 
 	//Calculate World Matrix
 	//**********************
-	m_World = etm::scale(m_Scale)*etm::rotate(m_Rotation)*etm::translate(m_Position);
-
-	Entity* parent = m_pEntity->GetParent();
+	TransformHierarchy::ComposeWorld(m_Position, m_Rotation, m_Scale, m_World, m_WorldInverse);
 	if (parent)
 	{
-		mat4 parentWorld = parent->GetTransform()->m_World;
-		m_World = m_World * parentWorld;
-
-		m_WorldPosition = (parentWorld * vec4(m_Position, 0)).xyz;
-		m_WorldRotation = parent->GetTransform()->GetWorldRotation() * m_WorldRotation; //maybe flip
-		m_WorldScale = m_Scale * parent->GetTransform()->GetWorldScale();
+		TransformComponent* pParentTransform = parent->GetTransform();
+		m_World = m_World * pParentTransform->m_World;
+		m_WorldInverse = pParentTransform->m_WorldInverse * m_WorldInverse;
+		m_WorldRotation = pParentTransform->m_WorldRotation * m_Rotation;
+		m_WorldScale = m_Scale * pParentTransform->m_WorldScale;
 	}
 	else
 	{
-		m_WorldPosition = m_Position;
 		m_WorldRotation = m_Rotation;
 		m_WorldScale = m_Scale;
 	}
+	OnWorldChanged();
+}
+
+void TransformComponent::OnWorldChanged()
+{
+	if (m_pHierarchy)
+	{
+		m_World = m_pHierarchy->GetWorld(m_Node);
+		m_WorldInverse = m_pHierarchy->GetWorldInverse(m_Node);
+		m_WorldRotation = m_pHierarchy->GetWorldRotation(m_Node);
+		m_WorldScale = m_pHierarchy->GetWorldScale(m_Node);
+	}
+
+	m_WorldPosition = m_World[3].xyz;
+	if (m_pEntity->GetParent())
+	{
+		m_AbsolutePosition = GetOrigin() + etm::vecCast<double>(m_WorldPosition);
+	}
 
 	m_Forward = m_WorldRotation*vec3::FORWARD;
 	m_Right = m_WorldRotation*vec3::RIGHT;
 	m_Up = etm::cross(m_Forward, m_Right);
 
-	m_IsTransformChanged = TransformChanged::NONE;
+	m_IsWorldChanged = true;
+	if (m_pLight)
+	{
+		m_pLight->m_PositionUpdated = true;
+	}
+	UpdateSpatialProxy();
+}
+
+//Changes pushed to the hierarchy earlier in the frame are applied before world state is read, like they were when every transform updated in place
+void TransformComponent::SyncWorld() const
+{
+	if (m_pHierarchy && m_pHierarchy->IsUpdatePending())
+	{
+		m_pScene->UpdateTransforms();
+	}
+}
+
+void TransformComponent::UpdateSpatialProxy()
+{
+	m_IsBoundsChanged = false;
+	AbstractScene* pScene = m_pEntity->GetScene();
+	BoundingVolumeTree* pTree = pScene ? pScene->GetEntityTree() : nullptr;
+	if (pTree != m_pSpatialTree)
+	{
+		RemoveSpatialProxy();
+		m_pSpatialTree = pTree;
+	}
+	if (!m_pSpatialTree) return;
+
+	//entities without a drawable model are a point at their position, otherwise the bounds hold every drawable model
+	vec3 worldPosition = m_World[3].xyz;
+	AABB bounds(worldPosition, worldPosition);
+	bool hasModel = false;
+	for (ModelComponent* pModel : m_pModels)
+	{
+		if (!pModel->IsDrawable()) continue;
+		AABB modelBounds(pModel->GetWorldBoundingSphere());
+		if (hasModel)
+		{
+			bounds.min = vec3(std::min(bounds.min.x, modelBounds.min.x), std::min(bounds.min.y, modelBounds.min.y), std::min(bounds.min.z, modelBounds.min.z));
+			bounds.max = vec3(std::max(bounds.max.x, modelBounds.max.x), std::max(bounds.max.y, modelBounds.max.y), std::max(bounds.max.z, modelBounds.max.z));
+		}
+		else
+		{
+			bounds = modelBounds;
+			hasModel = true;
+		}
+	}
+
+	if (m_SpatialProxy == BoundingVolumeTree::NULL_NODE)
+	{
+		m_SpatialProxy = m_pSpatialTree->CreateProxy(bounds, m_pEntity);
+	}
+	else
+	{
+		//the movement since the last update predicts where the entity goes next
+		const AABB &previous = m_pSpatialTree->GetBounds(m_SpatialProxy);
+		vec3 displacement = (bounds.min + bounds.max - previous.min - previous.max) * 0.5f;
+		m_pSpatialTree->MoveProxy(m_SpatialProxy, bounds, displacement);
+	}
+}
+
+void TransformComponent::RemoveSpatialProxy()
+{
+	if (m_pSpatialTree && m_SpatialProxy != BoundingVolumeTree::NULL_NODE)
+	{
+		m_pSpatialTree->DestroyProxy(m_SpatialProxy);
+	}
+	m_SpatialProxy = BoundingVolumeTree::NULL_NODE;
+	m_pSpatialTree = nullptr;
+	m_IsBoundsChanged = true;
+}
+
+void TransformComponent::RemoveFromScene()
+{
+	RemoveSpatialProxy();
+	if (m_pHierarchy)
+	{
+		m_pHierarchy->DestroyNode(m_Node);
+	}
+	m_pHierarchy = nullptr;
+	m_Node = TransformHierarchy::NULL_NODE;
+	m_pScene = nullptr;
+}
+
+dvec3 TransformComponent::GetOrigin() const
+{
+	AbstractScene* pScene = m_pEntity->GetScene();
+	if (pScene)
+	{
+		return pScene->GetFloatingOrigin().GetOrigin();
+	}
+	return dvec3();
+}
+
+mat4 TransformComponent::GetCameraRelativeWorld(const dvec3& cameraPosition) const
+{
+	SyncWorld();
+	if (m_pEntity->GetParent())
+	{
+		mat4 ret = m_World;
+		ret[3] = vec4(etm::vecCast<float>(etm::vecCast<double>(m_World[3].xyz) + GetOrigin() - cameraPosition), 1);
+		return ret;
+	}
+	return FloatingOrigin::GetCameraRelativeWorld(m_Scale, m_Rotation, m_AbsolutePosition, cameraPosition);
+}
+
+void TransformComponent::OnOriginShifted(const dvec3& shift)
+{
+	if (m_pEntity->GetParent())
+	{
+		//children follow their parents on the next update, until then only the cached translation is moved
+		vec3 shiftF = etm::vecCast<float>(shift);
+		m_World[3] = vec4(m_World[3].xyz - shiftF, 1);
+		m_WorldInverse = etm::translate(shiftF) * m_WorldInverse;
+		return;
+	}
+
+	//a pending single precision position is still relative to the previous origin
+	dvec3 origin = GetOrigin();
+	if ((m_IsTransformChanged & TransformChanged::TRANSLATION) && !(m_IsTransformChanged & TransformChanged::ABSOLUTE_TRANSLATION))
+	{
+		m_AbsolutePosition = origin - shift + etm::vecCast<double>(m_Position);
+	}
+	m_IsTransformChanged |= TransformChanged::ABSOLUTE_TRANSLATION;
+
+	//update the cached world state right away, so the camera doesn't use stale positions this frame
+	m_Position = etm::vecCast<float>(m_AbsolutePosition - origin);
+	m_WorldPosition = m_Position;
+	TransformHierarchy::ComposeWorld(m_Position, m_Rotation, m_Scale, m_World, m_WorldInverse);
+	//children are recomputed from the new position as soon as anything reads them
+	if (m_pHierarchy)
+	{
+		m_pHierarchy->SetLocal(m_Node, m_Position, m_Rotation, m_Scale);
+	}
 }
 
 void TransformComponent::Draw()
@@ -96,6 +329,11 @@ void TransformComponent::Translate(float x, float y, float z)
 }
 void TransformComponent::Translate(const vec3& translation )
 {
+	if (m_IsTransformChanged & TransformChanged::ABSOLUTE_TRANSLATION)
+	{
+		m_AbsolutePosition = m_AbsolutePosition + etm::vecCast<double>(translation);
+		return;
+	}
 	m_IsTransformChanged |= TransformChanged::TRANSLATION;
 	m_Position = m_Position + translation;
 }
@@ -106,8 +344,14 @@ void TransformComponent::SetPosition(float x, float y, float z)
 void TransformComponent::SetPosition(const vec3& position)
 {
 	m_IsTransformChanged |= TransformChanged::TRANSLATION;
+	m_IsTransformChanged &= ~TransformChanged::ABSOLUTE_TRANSLATION;
 	m_Position = position;
 }
+void TransformComponent::SetAbsolutePosition(const dvec3& position)
+{
+	m_IsTransformChanged |= TransformChanged::ABSOLUTE_TRANSLATION;
+	m_AbsolutePosition = position;
+}
 
 void TransformComponent::RotateEuler(float x, float y, float z)
 {
@@ -126,6 +370,12 @@ void TransformComponent::Rotate(const quat& rotation)
 	m_Rotation = m_Rotation * rotation;
 }
 
+void TransformComponent::SetRotation(const quat& rotation)
+{
+	m_IsTransformChanged |= TransformChanged::ROTATION;
+	m_Rotation = rotation;
+}
+
 void TransformComponent::Scale(float x, float y, float z)
 {
 	Scale( vec3( x, y, z ) );
@@ -1,6 +1,13 @@
 #pragma once
 #include "AbstractComponent.hpp"
 
+class BoundingVolumeTree;
+class TransformHierarchy;
+class AbstractScene;
+class RigidBodyComponent;
+class LightComponent;
+class ModelComponent;
+
 class TransformComponent : public AbstractComponent
 {
 public:
@@ -11,27 +18,49 @@ public:
 	void Translate(const vec3& translation );
 	void SetPosition(float x, float y, float z);
 	void SetPosition(const vec3& position);
+	//double precision position that is independent of the floating origin, only used for root entities
+	void SetAbsolutePosition(const dvec3& position);
 
 	void RotateEuler(float x, float y, float z);
 	void RotateEuler(const vec3& eulerAngles );
 	void Rotate(const quat& rotation);
-	void SetRotation(const quat& rotation) { m_Rotation = rotation; }
+	void SetRotation(const quat& rotation);
 
 	void Scale(float x, float y, float z);
 	void Scale(const vec3& scale);
 
+	//World state includes every change an earlier update in the same frame pushed to the scenes transform hierarchy,
+	//reading it from another thread is only safe while no transform in the scene changed since the scene last updated them
 	const vec3& GetPosition() const { return m_Position; }
-	const vec3& GetWorldPosition() const { return m_WorldPosition; }
+	const vec3& GetWorldPosition() const { SyncWorld(); return m_WorldPosition; }
+	const dvec3& GetAbsolutePosition() const { SyncWorld(); return m_AbsolutePosition; }
 	const vec3& GetScale() const { return m_Scale; }
-	const vec3& GetWorldScale() const { return m_WorldScale; }
+	const vec3& GetWorldScale() const { SyncWorld(); return m_WorldScale; }
 	const quat& GetRotation() const { return m_Rotation; }
 	const vec3& GetEuler() const { return m_Rotation.ToEuler(); }
-	const quat& GetWorldRotation() const { return m_WorldRotation; }
-	const mat4& GetWorld() const { return m_World; }
+	const quat& GetWorldRotation() const { SyncWorld(); return m_WorldRotation; }
+	const mat4& GetWorld() const { SyncWorld(); return m_World; }
+	const mat4& GetWorldInverse() const { SyncWorld(); return m_WorldInverse; }
+	mat4 GetCameraRelativeWorld(const dvec3& cameraPosition) const;
+
+	const vec3& GetForward() const { SyncWorld(); return m_Forward; }
+	const vec3& GetUp() const { SyncWorld(); return m_Up; }
+	const vec3& GetRight() const { SyncWorld(); return m_Right; }
 
-	const vec3& GetForward() const { return m_Forward; }
-	const vec3& GetUp() const { return m_Up; }
-	const vec3& GetRight() const { return m_Right; }
+	//Called by the scene when the floating origin moves
+	void OnOriginShifted(const dvec3& shift);
+	//Called by components that change the bounds of the entity, like models once their mesh is loaded
+	void OnBoundsChanged() { m_IsBoundsChanged = true; }
+	//true if the world matrix changed in the last update
+	bool HasWorldChanged() const { return m_IsWorldChanged; }
+	//Removes the entity from the spatial index of its scene, the next update adds it to the index of the scene it is in then
+	void RemoveSpatialProxy();
+	//Removes the entity from the spatial index and the transform hierarchy of its scene
+	void RemoveFromScene();
+	//Called by the entity when components are added or removed
+	void OnComponentsChanged();
+	//Called by the scene after its transform hierarchy recomputed the world transform
+	void OnWorldChanged();
 
 protected:
 
@@ -42,6 +71,10 @@ protected:
 
 
 	void UpdateTransforms();
+	void UpdateSpatialProxy();
+	void AttachToHierarchy();
+	void SyncWorld() const;
+	dvec3 GetOrigin() const;
 
 private:
 	enum TransformChanged {
@@ -49,6 +82,7 @@ private:
 		TRANSLATION = 0x01,
 		ROTATION = 0x02,
 		SCALE = 0x04,
+		ABSOLUTE_TRANSLATION = 0x08
 	};
 
 	uint8 m_IsTransformChanged;
@@ -62,7 +96,27 @@ private:
 		m_Right = vec3::RIGHT;
 	quat m_Rotation = quat(),
 		m_WorldRotation = quat();
-	mat4 m_World;
+	mat4 m_World,
+		m_WorldInverse;
+
+	//position of the world transform in double precision, so it isn't affected by the floating origin
+	dvec3 m_AbsolutePosition = dvec3();
+
+	//bounds of the entity in the spatial index of its scene, updated when the world matrix changes
+	BoundingVolumeTree* m_pSpatialTree = nullptr;
+	int32 m_SpatialProxy = -1;
+	bool m_IsWorldChanged = true;
+	bool m_IsBoundsChanged = true;
+
+	//node in the transform hierarchy of the scene, which computes the world transform of entities in a scene
+	AbstractScene* m_pScene = nullptr;
+	TransformHierarchy* m_pHierarchy = nullptr;
+	int32 m_Node = -1;
+
+	//components the transform is synchronized with, so they aren't looked up every update
+	RigidBodyComponent* m_pRigidBody = nullptr;
+	LightComponent* m_pLight = nullptr;
+	std::vector<ModelComponent*> m_pModels;
 
 private:
 	// -------------------------
@@ -38,6 +38,7 @@ File::File(std::string name, Directory* pParent)
 File::~File()
 {
 	if(m_IsOpen)Close();
+	Unmap();
 }
 bool File::Open(FILE_ACCESS_MODE mode, FILE_ACCESS_FLAGS flags)
 {
@@ -77,6 +78,24 @@ bool File::Write(const std::vector<uint8> &lhs)
     }
 	return true;
 }
+const uint8* File::Map(uint64 &size)
+{
+	if (!m_pMapped && !FILE_BASE::MapFile(m_Handle, m_pMapped, m_MappedSize))
+	{
+		LOG("Mapping File failed", Warning);
+		m_pMapped = nullptr;
+		return nullptr;
+	}
+	size = m_MappedSize;
+	return m_pMapped;
+}
+void File::Unmap()
+{
+	if (!m_pMapped) return;
+	FILE_BASE::UnmapFile(m_pMapped, m_MappedSize);
+	m_pMapped = nullptr;
+	m_MappedSize = 0;
+}
 void File::Close()
 {
 	if(FILE_BASE::Close( m_Handle ))
@@ -49,6 +49,10 @@ public:
 
 	std::vector<uint8> Read();
 	bool Write(const std::vector<uint8> &lhs);
+	//Maps the open file into memory instead of copying it, nullptr if that fails
+	//the memory stays valid after closing, until Unmap or the file is destroyed
+	const uint8* Map(uint64 &size);
+	void Unmap();
 	Entry::EntryType GetType()
     	{
             return Entry::EntryType::ENTRY_FILE;
@@ -62,6 +66,9 @@ private:
 	bool m_IsOpen;
 
 	FILE_HANDLE m_Handle;
+
+	const uint8* m_pMapped = nullptr;
+	uint64 m_MappedSize = 0;
 };
 
 class Directory : public Entry
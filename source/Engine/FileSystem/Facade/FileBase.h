@@ -22,6 +22,11 @@ public:
 
 	static bool DeleteFile( const char * pathName );
 
+	//Maps the whole file read only, the memory stays valid after the handle is closed until it is unmapped
+	static bool MapFile( FILE_HANDLE handle, const uint8* & data, uint64 & size );
+
+	static bool UnmapFile( const uint8* data, uint64 size );
+
 private:
 #if defined(PLATFORM_Linux)
     #include "FileBaseLinuxMembers.h"
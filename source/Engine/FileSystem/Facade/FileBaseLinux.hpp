@@ -31,6 +31,29 @@ bool FILE_BASE::DeleteFile( const char * pathName )
 	return result != -1;
 }
 
+bool FILE_BASE::MapFile( FILE_HANDLE handle, const uint8* & data, uint64 & size )
+{
+    struct stat info;
+    if ( fstat( handle, &info ) == -1 || info.st_size == 0 )
+    {
+        return false;
+    }
+    void* result = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, handle, 0 );
+    if ( result == MAP_FAILED )
+    {
+        return false;
+    }
+    data = static_cast<const uint8*>( result );
+    size = (uint64)info.st_size;
+    return true;
+}
+
+bool FILE_BASE::UnmapFile( const uint8* data, uint64 size )
+{
+    int32 result = munmap( const_cast<uint8*>( data ), size );
+    return result != -1;
+}
+
 int32 FILE_BASE::GetLinuxFileFlags( FILE_ACCESS_FLAGS flags, FILE_ACCESS_MODE mode )
 {
     int32 result = 0;
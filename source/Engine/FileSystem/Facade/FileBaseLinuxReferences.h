@@ -2,5 +2,7 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define LINUX_FILE_BUFFER_SIZE 8192
@@ -110,4 +110,44 @@ bool FILE_BASE::DeleteFile( const char * pathName )
 		return false;
 	}
 	return true;
+}
+
+bool FILE_BASE::MapFile( FILE_HANDLE handle, const uint8* & data, uint64 & size )
+{
+	LARGE_INTEGER fileSize;
+	if (FALSE == GetFileSizeEx(handle, &fileSize))
+	{
+		DisplayError(TEXT("MapFile->GetFileSizeEx"));
+		return false;
+	}
+	//empty files can't be mapped
+	if (fileSize.QuadPart == 0) return false;
+
+	HANDLE mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		DisplayError(TEXT("MapFile->CreateFileMapping"));
+		return false;
+	}
+	//the view keeps the mapping alive on its own
+	LPVOID view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == NULL)
+	{
+		DisplayError(TEXT("MapFile->MapViewOfFile"));
+		return false;
+	}
+	data = static_cast<const uint8*>(view);
+	size = (uint64)fileSize.QuadPart;
+	return true;
+}
+
+bool FILE_BASE::UnmapFile( const uint8* data, uint64 /*size*/ )
+{
+	if (FALSE == UnmapViewOfFile(data))
+	{
+		DisplayError(TEXT("UnmapFile"));
+		return false;
+	}
+	return true;
 }
\ No newline at end of file
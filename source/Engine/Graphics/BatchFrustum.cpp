@@ -0,0 +1,326 @@
+#include "stdafx.hpp"
+#include "BatchFrustum.hpp"
+
+//All paths compute distances with the same operations in the same order, so SIMD and scalar results agree exactly
+
+namespace
+{
+	void SetVisibleBits(std::vector<uint32> &visibleMask, size_t index, uint32 bits)
+	{
+		visibleMask[index >> 5] |= bits << (index & 31);
+	}
+}
+
+BatchFrustum::BatchFrustum()
+{
+	//everything is visible until planes are set
+	for (uint8 i = 0; i < PLANE_COUNT; ++i)
+	{
+		SetPlane(i, vec4(0.f, 0.f, 0.f, 1.f));
+	}
+}
+BatchFrustum::BatchFrustum(const mat4 &viewProjection)
+{
+	SetViewProjection(viewProjection);
+}
+BatchFrustum::BatchFrustum(const std::vector<Plane> &planes)
+{
+	SetPlanes(planes);
+}
+
+//Clip coordinates are the columns of the matrix dotted with the position, every plane of the clip volume is a sum of two of them
+void BatchFrustum::SetViewProjection(const mat4 &viewProjection)
+{
+	vec4 clip[4];
+	for (uint8 axis = 0; axis < 4; ++axis)
+	{
+		clip[axis] = vec4(viewProjection.data[0][axis], viewProjection.data[1][axis], viewProjection.data[2][axis], viewProjection.data[3][axis]);
+	}
+	//same order as Frustum
+	SetPlane(0, clip[3] + clip[2]);//Near
+	SetPlane(1, clip[3] - clip[2]);//Far
+	SetPlane(2, clip[3] + clip[0]);//Left
+	SetPlane(3, clip[3] - clip[0]);//Right
+	SetPlane(4, clip[3] - clip[1]);//Top
+	SetPlane(5, clip[3] + clip[1]);//Bottom
+}
+void BatchFrustum::SetPlanes(const std::vector<Plane> &planes)
+{
+	assert(planes.size() == PLANE_COUNT);
+	for (uint8 i = 0; i < PLANE_COUNT; ++i)
+	{
+		const Plane &plane = planes[i];
+		m_NormalX[i] = plane.n.x;
+		m_NormalY[i] = plane.n.y;
+		m_NormalZ[i] = plane.n.z;
+		m_W[i] = -etm::dot(plane.n, plane.d);
+	}
+}
+void BatchFrustum::SetPlane(uint8 index, const vec4 &plane)
+{
+	float length = etm::length(plane.xyz);
+	vec4 normalized = length > 0.f ? plane / length : plane;
+	m_NormalX[index] = normalized.x;
+	m_NormalY[index] = normalized.y;
+	m_NormalZ[index] = normalized.z;
+	m_W[index] = normalized.w;
+}
+
+vec4 BatchFrustum::GetPlane(uint8 index) const
+{
+	return vec4(m_NormalX[index], m_NormalY[index], m_NormalZ[index], m_W[index]);
+}
+
+VolumeCheck BatchFrustum::ContainsSphere(const Sphere &sphere) const
+{
+	VolumeCheck ret = VolumeCheck::CONTAINS;
+	for (uint8 i = 0; i < PLANE_COUNT; ++i)
+	{
+		float dist = m_NormalX[i] * sphere.pos.x + m_NormalY[i] * sphere.pos.y + m_NormalZ[i] * sphere.pos.z + m_W[i];
+		if (dist < -sphere.radius) return VolumeCheck::OUTSIDE;
+		else if (dist < sphere.radius) ret = VolumeCheck::INTERSECT;
+	}
+	return ret;
+}
+//the corner furthest along the normal decides, its distance is the one of the center plus the projected extents
+VolumeCheck BatchFrustum::ContainsAABB(const vec3 &min, const vec3 &max) const
+{
+	vec3 center = (min + max) * 0.5f;
+	vec3 extents = (max - min) * 0.5f;
+	VolumeCheck ret = VolumeCheck::CONTAINS;
+	for (uint8 i = 0; i < PLANE_COUNT; ++i)
+	{
+		float dist = m_NormalX[i] * center.x + m_NormalY[i] * center.y + m_NormalZ[i] * center.z + m_W[i];
+		float reach = extents.x * std::abs(m_NormalX[i]) + extents.y * std::abs(m_NormalY[i]) + extents.z * std::abs(m_NormalZ[i]);
+		if (dist < -reach) return VolumeCheck::OUTSIDE;
+		else if (dist < reach) ret = VolumeCheck::INTERSECT;
+	}
+	return ret;
+}
+
+void BatchFrustum::CullSpheres(const vec3soa &centers, const std::vector<float> &radii, std::vector<uint32> &visibleMask) const
+{
+	assert(centers.size() == radii.size());
+	const size_t count = radii.size();
+	visibleMask.assign((count + 31) / 32, 0u);
+	const float* pX = centers[0];
+	const float* pY = centers[1];
+	const float* pZ = centers[2];
+	const float* pRadius = radii.data();
+
+	size_t i = 0;
+#ifdef ETM_SIMD_AVX
+	{
+		__m256 nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], w[PLANE_COUNT];
+		for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+		{
+			nx[plane] = _mm256_set1_ps(m_NormalX[plane]);
+			ny[plane] = _mm256_set1_ps(m_NormalY[plane]);
+			nz[plane] = _mm256_set1_ps(m_NormalZ[plane]);
+			w[plane] = _mm256_set1_ps(m_W[plane]);
+		}
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(pX + i);
+			__m256 y = _mm256_loadu_ps(pY + i);
+			__m256 z = _mm256_loadu_ps(pZ + i);
+			__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(pRadius + i));
+			__m256 outside = _mm256_setzero_ps();
+			for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+			{
+				__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[plane], x), _mm256_mul_ps(ny[plane], y)),
+					_mm256_mul_ps(nz[plane], z)), w[plane]);
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, negRadius, _CMP_LT_OQ));
+			}
+			SetVisibleBits(visibleMask, i, ~(uint32)_mm256_movemask_ps(outside) & 0xFFu);
+		}
+	}
+#endif
+#ifdef ETM_SIMD_SSE
+	{
+		__m128 nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], w[PLANE_COUNT];
+		for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+		{
+			nx[plane] = _mm_set1_ps(m_NormalX[plane]);
+			ny[plane] = _mm_set1_ps(m_NormalY[plane]);
+			nz[plane] = _mm_set1_ps(m_NormalZ[plane]);
+			w[plane] = _mm_set1_ps(m_W[plane]);
+		}
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(pX + i);
+			__m128 y = _mm_loadu_ps(pY + i);
+			__m128 z = _mm_loadu_ps(pZ + i);
+			__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(pRadius + i));
+			__m128 outside = _mm_setzero_ps();
+			for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+			{
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[plane], x), _mm_mul_ps(ny[plane], y)),
+					_mm_mul_ps(nz[plane], z)), w[plane]);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negRadius));
+			}
+			SetVisibleBits(visibleMask, i, ~(uint32)_mm_movemask_ps(outside) & 0xFu);
+		}
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		bool isOutside = false;
+		for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+		{
+			float dist = m_NormalX[plane] * pX[i] + m_NormalY[plane] * pY[i] + m_NormalZ[plane] * pZ[i] + m_W[plane];
+			isOutside |= dist < -pRadius[i];
+		}
+		if (!isOutside) SetVisibleBits(visibleMask, i, 1u);
+	}
+}
+
+void BatchFrustum::CullAABBs(const vec3soa &mins, const vec3soa &maxs, std::vector<uint32> &visibleMask) const
+{
+	assert(mins.size() == maxs.size());
+	const size_t count = mins.size();
+	visibleMask.assign((count + 31) / 32, 0u);
+	const float* pMinX = mins[0];
+	const float* pMinY = mins[1];
+	const float* pMinZ = mins[2];
+	const float* pMaxX = maxs[0];
+	const float* pMaxY = maxs[1];
+	const float* pMaxZ = maxs[2];
+
+	float absX[PLANE_COUNT], absY[PLANE_COUNT], absZ[PLANE_COUNT];
+	for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+	{
+		absX[plane] = std::abs(m_NormalX[plane]);
+		absY[plane] = std::abs(m_NormalY[plane]);
+		absZ[plane] = std::abs(m_NormalZ[plane]);
+	}
+
+	size_t i = 0;
+#ifdef ETM_SIMD_AVX
+	{
+		__m256 nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], w[PLANE_COUNT], ax[PLANE_COUNT], ay[PLANE_COUNT], az[PLANE_COUNT];
+		for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+		{
+			nx[plane] = _mm256_set1_ps(m_NormalX[plane]);
+			ny[plane] = _mm256_set1_ps(m_NormalY[plane]);
+			nz[plane] = _mm256_set1_ps(m_NormalZ[plane]);
+			w[plane] = _mm256_set1_ps(m_W[plane]);
+			ax[plane] = _mm256_set1_ps(absX[plane]);
+			ay[plane] = _mm256_set1_ps(absY[plane]);
+			az[plane] = _mm256_set1_ps(absZ[plane]);
+		}
+		const __m256 half = _mm256_set1_ps(0.5f);
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 minX = _mm256_loadu_ps(pMinX + i);
+			__m256 minY = _mm256_loadu_ps(pMinY + i);
+			__m256 minZ = _mm256_loadu_ps(pMinZ + i);
+			__m256 maxX = _mm256_loadu_ps(pMaxX + i);
+			__m256 maxY = _mm256_loadu_ps(pMaxY + i);
+			__m256 maxZ = _mm256_loadu_ps(pMaxZ + i);
+			__m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+			__m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+			__m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+			__m256 ex = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+			__m256 ey = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+			__m256 ez = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+			__m256 outside = _mm256_setzero_ps();
+			for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+			{
+				__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[plane], cx), _mm256_mul_ps(ny[plane], cy)),
+					_mm256_mul_ps(nz[plane], cz)), w[plane]);
+				__m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ax[plane]), _mm256_mul_ps(ey, ay[plane])), _mm256_mul_ps(ez, az[plane]));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, _mm256_sub_ps(_mm256_setzero_ps(), reach), _CMP_LT_OQ));
+			}
+			SetVisibleBits(visibleMask, i, ~(uint32)_mm256_movemask_ps(outside) & 0xFFu);
+		}
+	}
+#endif
+#ifdef ETM_SIMD_SSE
+	{
+		__m128 nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], w[PLANE_COUNT], ax[PLANE_COUNT], ay[PLANE_COUNT], az[PLANE_COUNT];
+		for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+		{
+			nx[plane] = _mm_set1_ps(m_NormalX[plane]);
+			ny[plane] = _mm_set1_ps(m_NormalY[plane]);
+			nz[plane] = _mm_set1_ps(m_NormalZ[plane]);
+			w[plane] = _mm_set1_ps(m_W[plane]);
+			ax[plane] = _mm_set1_ps(absX[plane]);
+			ay[plane] = _mm_set1_ps(absY[plane]);
+			az[plane] = _mm_set1_ps(absZ[plane]);
+		}
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 minX = _mm_loadu_ps(pMinX + i);
+			__m128 minY = _mm_loadu_ps(pMinY + i);
+			__m128 minZ = _mm_loadu_ps(pMinZ + i);
+			__m128 maxX = _mm_loadu_ps(pMaxX + i);
+			__m128 maxY = _mm_loadu_ps(pMaxY + i);
+			__m128 maxZ = _mm_loadu_ps(pMaxZ + i);
+			__m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+			__m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+			__m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+			__m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+			__m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+			__m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+			__m128 outside = _mm_setzero_ps();
+			for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+			{
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[plane], cx), _mm_mul_ps(ny[plane], cy)),
+					_mm_mul_ps(nz[plane], cz)), w[plane]);
+				__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[plane]), _mm_mul_ps(ey, ay[plane])), _mm_mul_ps(ez, az[plane]));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(_mm_setzero_ps(), reach)));
+			}
+			SetVisibleBits(visibleMask, i, ~(uint32)_mm_movemask_ps(outside) & 0xFu);
+		}
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		float cx = (pMinX[i] + pMaxX[i]) * 0.5f;
+		float cy = (pMinY[i] + pMaxY[i]) * 0.5f;
+		float cz = (pMinZ[i] + pMaxZ[i]) * 0.5f;
+		float ex = (pMaxX[i] - pMinX[i]) * 0.5f;
+		float ey = (pMaxY[i] - pMinY[i]) * 0.5f;
+		float ez = (pMaxZ[i] - pMinZ[i]) * 0.5f;
+		bool isOutside = false;
+		for (uint8 plane = 0; plane < PLANE_COUNT; ++plane)
+		{
+			float dist = m_NormalX[plane] * cx + m_NormalY[plane] * cy + m_NormalZ[plane] * cz + m_W[plane];
+			float reach = ex * absX[plane] + ey * absY[plane] + ez * absZ[plane];
+			isOutside |= dist < -reach;
+		}
+		if (!isOutside) SetVisibleBits(visibleMask, i, 1u);
+	}
+}
+
+void BatchFrustum::CollectVisibleSpheres(const vec3soa &centers, const std::vector<float> &radii, std::vector<uint32> &visibleIndices) const
+{
+	std::vector<uint32> visibleMask;
+	CullSpheres(centers, radii, visibleMask);
+	MaskToIndices(visibleMask, radii.size(), visibleIndices);
+}
+void BatchFrustum::CollectVisibleAABBs(const vec3soa &mins, const vec3soa &maxs, std::vector<uint32> &visibleIndices) const
+{
+	std::vector<uint32> visibleMask;
+	CullAABBs(mins, maxs, visibleMask);
+	MaskToIndices(visibleMask, mins.size(), visibleIndices);
+}
+
+void BatchFrustum::MaskToIndices(const std::vector<uint32> &visibleMask, size_t count, std::vector<uint32> &visibleIndices)
+{
+	visibleIndices.clear();
+	for (size_t word = 0; word < visibleMask.size(); ++word)
+	{
+		uint32 bits = visibleMask[word];
+		for (uint32 bit = 0; bits != 0; ++bit, bits >>= 1)
+		{
+			if (bits & 1u)
+			{
+				size_t index = word * 32 + bit;
+				if (index < count) visibleIndices.push_back((uint32)index);
+			}
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Frustum.hpp"
+
+//Batch Frustum
+//*************
+
+// Frustum planes as structure of arrays, in the form dot(n, p) + w, for culling thousands of bounding volumes per call.
+// Volumes are processed 4 (SSE) or 8 (AVX) at a time against all planes, without branching on the planes of each one.
+// Results are either bit masks - bit (i % 32) of word (i / 32) is set if volume i is at least partially inside - or the compacted indices of those volumes.
+
+class BatchFrustum
+{
+public:
+	static const uint8 PLANE_COUNT = Frustum::PLANE_COUNT;
+	//planes are in the order near, far, left, right, top, bottom
+	static const uint8 NEAR_PLANE = 0;
+
+	BatchFrustum();
+	//Gribb / Hartmann extraction, for the [-w, w] clip space of etm::perspective and etm::orthographic
+	explicit BatchFrustum(const mat4 &viewProjection);
+	//the planes of a Frustum, in the same space they are in there
+	explicit BatchFrustum(const std::vector<Plane> &planes);
+
+	void SetViewProjection(const mat4 &viewProjection);
+	void SetPlanes(const std::vector<Plane> &planes);
+	//moves a plane outward, so volumes up to that distance beyond it are kept
+	void ExtendPlane(uint8 index, float distance) { m_W[index] += distance; }
+
+	//plane i as (normal, w), normals point inward
+	vec4 GetPlane(uint8 index) const;
+
+	VolumeCheck ContainsSphere(const Sphere &sphere) const;
+	VolumeCheck ContainsAABB(const vec3 &min, const vec3 &max) const;
+
+	void CullSpheres(const vec3soa &centers, const std::vector<float> &radii, std::vector<uint32> &visibleMask) const;
+	void CullAABBs(const vec3soa &mins, const vec3soa &maxs, std::vector<uint32> &visibleMask) const;
+	void CollectVisibleSpheres(const vec3soa &centers, const std::vector<float> &radii, std::vector<uint32> &visibleIndices) const;
+	void CollectVisibleAABBs(const vec3soa &mins, const vec3soa &maxs, std::vector<uint32> &visibleIndices) const;
+
+	static bool IsVisible(const std::vector<uint32> &visibleMask, size_t index) { return (visibleMask[index >> 5] >> (index & 31)) & 1; }
+	static void MaskToIndices(const std::vector<uint32> &visibleMask, size_t count, std::vector<uint32> &visibleIndices);
+
+private:
+	void SetPlane(uint8 index, const vec4 &plane);
+
+	float m_NormalX[PLANE_COUNT];
+	float m_NormalY[PLANE_COUNT];
+	float m_NormalZ[PLANE_COUNT];
+	float m_W[PLANE_COUNT];
+};
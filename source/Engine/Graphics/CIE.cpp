@@ -3,69 +3,139 @@
 #include "FileSystem\JSONparser.h"
 #include "FileSystem\Entry.h"
 #include "FileSystem\FileUtil.h"
+#include "../Helper/Hash.h"
+
+const double CIE::LAMBDA_STEP = 1.0;
+
+static const char CIE_JSON_FILE[] = "./cie.json";
+static const char CIE_BINARY_FILE[] = "./cie.bin";
+static const char CIE_MAGIC[4] = { 'E', 'T', 'C', 'M' };
+static const uint32 CIE_VERSION = 1;
+
+namespace
+{
+	struct CieHeader
+	{
+		char magic[4];
+		uint32 version;
+		uint32 hash;
+		uint32 count;
+		double lambdaMin;
+		double lambdaStep;
+	};
+}
 
 void CIE::LoadData()
 {
-	File* jsonFile = new File("./cie.json", nullptr);
+	File* jsonFile = new File(CIE_JSON_FILE, nullptr);
 	if (!jsonFile->Open(FILE_ACCESS_MODE::Read))
+	{
+		SafeDelete(jsonFile);
 		return;
+	}
+	std::string text = FileUtil::AsText(jsonFile->Read());
+	SafeDelete(jsonFile);
+	uint32 hash = FnvHash(text);
 
-	JSON::Parser parser = JSON::Parser(FileUtil::AsText(jsonFile->Read()));
-	delete jsonFile;
-	jsonFile = nullptr;
+	FILE_ACCESS_FLAGS readFlags;
+	readFlags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Exists);
+	File* binaryFile = new File(CIE_BINARY_FILE, nullptr);
+	bool isLoaded = binaryFile->Open(FILE_ACCESS_MODE::Read, readFlags) && Deserialize(binaryFile->Read(), hash);
+	SafeDelete(binaryFile);
+	if (isLoaded || !LoadJson(text)) return;
 
-	JSON::Object* root = parser.GetRoot();
-	m_Table = (*root)["2 deg color matching"]->arr()->NumArr();
-	auto jxyz = (*root)["xyz to rgb"];
-	JSON::ArrayMatrix(jxyz, m_CieToRgb);
+	FILE_ACCESS_FLAGS writeFlags;
+	writeFlags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Create | FILE_ACCESS_FLAGS::FLAGS::Truncate);
+	binaryFile = new File(CIE_BINARY_FILE, nullptr);
+	if (!binaryFile->Open(FILE_ACCESS_MODE::Write, writeFlags) || !binaryFile->Write(Serialize(hash)))
+	{
+		LOG(std::string("Couldn't write ") + CIE_BINARY_FILE + ", the color matching functions will be parsed again next time", Warning);
+	}
+	SafeDelete(binaryFile);
 }
 
-dvec3 CIE::GetValue(double wavelength, double lambdaMin, double lambdaMax)
+bool CIE::LoadJson(const std::string &text)
 {
-	dvec3 ret;
-	for (uint8 column = 1; column < 4; ++column)
+	JSON::Parser parser = JSON::Parser(text);
+	JSON::Object* root = parser.GetRoot();
+	if (!root) return false;
+
+	//rows of wavelength, x, y and z
+	std::vector<double> table = (*root)["2 deg color matching"]->arr()->NumArr();
+	size_t rowCount = table.size() / 4;
+	if (rowCount < 2) return false;
+	std::vector<double> wavelengths(rowCount);
+	std::vector<double> values[3];
+	for (size_t row = 0; row < rowCount; ++row)
 	{
-		if (wavelength <= lambdaMin || wavelength >= lambdaMax)
+		wavelengths[row] = table[row * 4];
+		for (uint8 component = 0; component < 3; ++component)
 		{
-			return 0.0;
+			values[component].push_back(table[row * 4 + 1 + component]);
 		}
-		double u = (wavelength - lambdaMin) / 5.0;
-		int row = static_cast<int>(std::floor(u));
-		assert(row >= 0 && row + 1 < 95);
-		assert(m_Table[4 * row] <= wavelength && m_Table[4 * (row + 1)] >= wavelength);
-		u -= row;
-		ret[column-1] = m_Table[4 * row + column] * (1.0 - u) + m_Table[4 * (row + 1) + column] * u;
 	}
-	return ret;
+	for (uint8 component = 0; component < 3; ++component)
+	{
+		m_MatchingFunctions[component] = Spectrum::Resample(wavelengths, values[component], wavelengths.front(), wavelengths.back(), LAMBDA_STEP);
+	}
+	return JSON::ArrayMatrix((*root)["xyz to rgb"], m_CieToRgb);
 }
 
-dvec3 CIE::GetRGB(const dvec3 &xyz)
+std::vector<uint8> CIE::Serialize(uint32 hash) const
 {
-	return m_CieToRgb * xyz;
+	CieHeader header;
+	std::copy(CIE_MAGIC, CIE_MAGIC + 4, header.magic);
+	header.version = CIE_VERSION;
+	header.hash = hash;
+	header.count = (uint32)m_MatchingFunctions[0].Size();
+	header.lambdaMin = m_MatchingFunctions[0].GetLambdaMin();
+	header.lambdaStep = m_MatchingFunctions[0].GetLambdaStep();
+
+	std::vector<uint8> data(sizeof(CieHeader) + (3 * header.count + 9) * sizeof(double));
+	memcpy(data.data(), &header, sizeof(CieHeader));
+	double* pValues = reinterpret_cast<double*>(data.data() + sizeof(CieHeader));
+	for (const Spectrum &matchingFunction : m_MatchingFunctions)
+	{
+		pValues = std::copy(matchingFunction.GetValues().begin(), matchingFunction.GetValues().end(), pValues);
+	}
+	memcpy(pValues, etm::valuePtr(m_CieToRgb), 9 * sizeof(double));
+	return data;
 }
 
-double CIE::Interpolate(const std::vector<double>& wavelengths, const std::vector<double>& wavelength_function, double wavelength)
+bool CIE::Deserialize(const std::vector<uint8> &data, uint32 hash)
 {
-	assert(wavelength_function.size() == wavelengths.size());
-	if (wavelength < wavelengths[0])
+	if (data.size() < sizeof(CieHeader)) return false;
+	CieHeader header;
+	memcpy(&header, data.data(), sizeof(CieHeader));
+	if (!std::equal(CIE_MAGIC, CIE_MAGIC + 4, header.magic) || header.version != CIE_VERSION || header.hash != hash) return false;
+	if (header.count < 2 || header.lambdaStep <= 0.0 || data.size() != sizeof(CieHeader) + (3 * (size_t)header.count + 9) * sizeof(double)) return false;
+
+	const double* pValues = reinterpret_cast<const double*>(data.data() + sizeof(CieHeader));
+	for (Spectrum &matchingFunction : m_MatchingFunctions)
 	{
-		return wavelength_function[0];
+		matchingFunction = Spectrum(header.lambdaMin, header.lambdaStep, std::vector<double>(pValues, pValues + header.count));
+		pValues += header.count;
 	}
-	for (unsigned int i = 0; i < wavelengths.size() - 1; ++i)
+	memcpy(etm::valuePtr(m_CieToRgb), pValues, 9 * sizeof(double));
+	return true;
+}
+
+dvec3 CIE::GetValue(double wavelength) const
+{
+	if (wavelength < GetLambdaMin() || wavelength > GetLambdaMax())
 	{
-		if (wavelength < wavelengths[i + 1])
-		{
-			double u = (wavelength - wavelengths[i]) / (wavelengths[i + 1] - wavelengths[i]);
-			return wavelength_function[i] * (1.0 - u) + wavelength_function[i + 1] * u;
-		}
+		return dvec3(0.0);
 	}
-	return wavelength_function[wavelength_function.size() - 1];
+	return dvec3(m_MatchingFunctions[0].Sample(wavelength), m_MatchingFunctions[1].Sample(wavelength), m_MatchingFunctions[2].Sample(wavelength));
 }
 
-dvec3 CIE::Interpolate(const std::vector<double>& wavelengths, const std::vector<double>& wavelength_function, const dvec3 &xyz)
+dvec3 CIE::GetXYZ(const Spectrum &spectrum) const
 {
-	dvec3 ret = dvec3();
-	for (uint8 i = 0; i < 3; ++i)
-		ret[i] = Interpolate(wavelengths, wavelength_function, xyz[i]);
-	return ret;
-}
\ No newline at end of file
+	Spectrum resampled = spectrum.Resample(GetLambdaMin(), GetLambdaMax(), LAMBDA_STEP);
+	return dvec3(resampled.Integrate(m_MatchingFunctions[0]), resampled.Integrate(m_MatchingFunctions[1]), resampled.Integrate(m_MatchingFunctions[2]));
+}
+
+dvec3 CIE::GetRGB(const dvec3 &xyz) const
+{
+	return m_CieToRgb * xyz;
+}
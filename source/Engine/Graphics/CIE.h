@@ -1,19 +1,34 @@
 #pragma once
 #include "Singleton.hpp"
+#include "Spectrum.hpp"
 
+//CIE 1931 2 degree color matching functions, resampled at every nanometer so spectra can be integrated against them directly
 class CIE : public Singleton<CIE>
 {
 public:
+	//Reads the binary form of cie.json next to it, and creates it from the json when it's missing or the json changed
 	void LoadData();
-	dvec3 GetValue(double wavelength, double lambdaMin, double lambdaMax);
-	dvec3 GetRGB(const dvec3 &xyz);
-	double Interpolate(const std::vector<double>& wavelengths, const std::vector<double>& wavelength_function, double wavelength);
-	dvec3 Interpolate(const std::vector<double>& wavelengths, const std::vector<double>& wavelength_function, const dvec3 &xyz);
+
+	//Zero outside the range of the table
+	dvec3 GetValue(double wavelength) const;
+	const Spectrum& GetMatchingFunction(uint8 component) const { return m_MatchingFunctions[component]; }
+	double GetLambdaMin() const { return m_MatchingFunctions[0].GetLambdaMin(); }
+	double GetLambdaMax() const { return m_MatchingFunctions[0].GetLambdaMax(); }
+
+	dvec3 GetXYZ(const Spectrum &spectrum) const;
+	dvec3 GetRGB(const dvec3 &xyz) const;
+	dvec3 GetRGB(const Spectrum &spectrum) const { return GetRGB(GetXYZ(spectrum)); }
+
+	static const double LAMBDA_STEP;
 private:
 	friend class Singleton<CIE>;
 	CIE() {}
 	virtual ~CIE() {}
 
-	std::vector<double> m_Table;
+	bool LoadJson(const std::string &text);
+	std::vector<uint8> Serialize(uint32 hash) const;
+	bool Deserialize(const std::vector<uint8> &data, uint32 hash);
+
+	Spectrum m_MatchingFunctions[3];
 	dmat3 m_CieToRgb;
-};
\ No newline at end of file
+};
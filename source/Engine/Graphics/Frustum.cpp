@@ -1,6 +1,8 @@
 #include "stdafx.hpp"
 #include "Frustum.hpp"
 
+#include <limits>
+
 #include "../Components/TransformComponent.hpp"
 #include "../Components/CameraComponent.hpp"
 
@@ -32,6 +34,12 @@ void Frustum::SetCullTransform(mat4 objectWorld)
 	m_CullWorld = objectWorld;
 	m_CullInverse = etm::inverse(objectWorld);
 }
+//for objects that already know their inverse, like transform components
+void Frustum::SetCullTransform(const mat4 &objectWorld, const mat4 &objectWorldInverse)
+{
+	m_CullWorld = objectWorld;
+	m_CullInverse = objectWorldInverse;
+}
 
 void Frustum::SetToCamera(CameraComponent* pCamera)
 {
@@ -42,13 +50,25 @@ void Frustum::SetToCamera(CameraComponent* pCamera)
 	m_NearPlane = pCamera->GetNearPlane();
 	m_FarPlane = pCamera->GetFarPlane();
 	m_FOV = pCamera->GetFOV();
+	m_AspectRatio = WINDOW.GetAspectRatio();
+}
+void Frustum::SetCamera(const vec3 &position, const vec3 &forward, const vec3 &up, float fov, float nearPlane, float farPlane, float aspectRatio)
+{
+	m_Position = position;
+	m_Forward = forward;
+	m_Up = up;
+	m_Right = etm::cross(up, forward);
+	m_NearPlane = nearPlane;
+	m_FarPlane = farPlane;
+	m_FOV = fov;
+	m_AspectRatio = aspectRatio;
 }
 
 void Frustum::Update()
 {
 	//calculate generalized relative width and aspect ratio
 	float normHalfWidth = tan(etm::radians(m_FOV));
-	float aspectRatio = WINDOW.GetAspectRatio();
+	float aspectRatio = m_AspectRatio;
 
 	//calculate width and height for near and far plane
 	float nearHW = normHalfWidth*m_NearPlane;
@@ -57,8 +77,10 @@ void Frustum::Update()
 	float farHH = farHW / aspectRatio;
 
 	//calculate near and far plane centers
-	auto nCenter = m_Position + m_Forward*m_NearPlane;
-	auto fCenter = m_Position + m_Forward*m_FarPlane *0.5f;
+	//relative to the culled objects position, so the object space transform below only needs to rotate and scale
+	vec3 position = m_Position - m_CullWorld[3].xyz;
+	auto nCenter = position + m_Forward*m_NearPlane;
+	auto fCenter = position + m_Forward*m_FarPlane *0.5f;
 
 	//construct corners of the near plane in the culled objects world space
 	m_Corners.na = nCenter + m_Up*nearHH - m_Right*nearHW;
@@ -92,7 +114,7 @@ void Frustum::Update()
 	//m_Corners.fd = fCenter - farHH + farHW;
 	m_Corners.Transform(m_CullInverse);
 
-	m_PositionObject = (m_CullInverse*vec4(m_Position, 0)).xyz;
+	m_PositionObject = (m_CullInverse*vec4(position, 0)).xyz;
 	m_RadInvFOV = 1 / etm::radians(m_FOV);
 
 	//construct planes
@@ -108,7 +130,7 @@ void Frustum::Update()
 
 VolumeCheck Frustum::ContainsPoint(const vec3 &point) const
 {
-	for (auto plane : m_Planes)
+	for (const Plane &plane : m_Planes)
 	{
 		if (etm::dot(plane.n, point - plane.d) < 0)return VolumeCheck::OUTSIDE;
 	}
@@ -117,7 +139,7 @@ VolumeCheck Frustum::ContainsPoint(const vec3 &point) const
 VolumeCheck Frustum::ContainsSphere(const Sphere &sphere) const
 {
 	VolumeCheck ret = VolumeCheck::CONTAINS;
-	for (auto plane : m_Planes)
+	for (const Plane &plane : m_Planes)
 	{
 		float dist = etm::dot(plane.n, sphere.pos - plane.d);
 		if (dist < -sphere.radius)return VolumeCheck::OUTSIDE;
@@ -131,7 +153,7 @@ VolumeCheck Frustum::ContainsSphere(const Sphere &sphere) const
 VolumeCheck Frustum::ContainsTriangle(vec3 &a, vec3 &b, vec3 &c)
 {
 	VolumeCheck ret = VolumeCheck::CONTAINS;
-	for (auto plane : m_Planes)
+	for (const Plane &plane : m_Planes)
 	{
 		char rejects = 0;
 		if (etm::dot(plane.n, a - plane.d) < 0)rejects++;
@@ -148,7 +170,7 @@ VolumeCheck Frustum::ContainsTriangle(vec3 &a, vec3 &b, vec3 &c)
 VolumeCheck Frustum::ContainsTriVolume(vec3 &a, vec3 &b, vec3 &c, float height)
 {
 	VolumeCheck ret = VolumeCheck::CONTAINS;
-	for (auto plane : m_Planes)
+	for (const Plane &plane : m_Planes)
 	{
 		char rejects = 0;
 		if (etm::dot(plane.n, a - plane.d) < 0)rejects++;
@@ -167,4 +189,42 @@ VolumeCheck Frustum::ContainsTriVolume(vec3 &a, vec3 &b, vec3 &c, float height)
 		else if (rejects > 0)ret = VolumeCheck::INTERSECT;
 	}
 	return ret;
+}
+//same as above with the base of the volume also scaled by baseHeight, planeMargins receives the smallest distance of the tested points to each plane
+//as long as no plane moves further than its margin the result stays the same, planes that weren't tested get the largest float
+VolumeCheck Frustum::ContainsTriVolume(vec3 &a, vec3 &b, vec3 &c, float baseHeight, float height, float* planeMargins)
+{
+	for (uint8 i = 0; i < PLANE_COUNT; ++i)
+	{
+		planeMargins[i] = std::numeric_limits<float>::max();
+	}
+	VolumeCheck ret = VolumeCheck::CONTAINS;
+	for (size_t i = 0; i < m_Planes.size(); ++i)
+	{
+		const Plane &plane = m_Planes[i];
+		float distA = etm::dot(plane.n, (a*baseHeight) - plane.d);
+		float distB = etm::dot(plane.n, (b*baseHeight) - plane.d);
+		float distC = etm::dot(plane.n, (c*baseHeight) - plane.d);
+		char rejects = 0;
+		if (distA < 0)rejects++;
+		if (distB < 0)rejects++;
+		if (distC < 0)rejects++;
+		planeMargins[i] = std::fminf(std::abs(distA), std::fminf(std::abs(distB), std::abs(distC)));
+		// if all three are outside a plane the triangle is outside the frustrum
+		if (rejects >= 3)
+		{
+			float distAH = etm::dot(plane.n, (a*height) - plane.d);
+			float distBH = etm::dot(plane.n, (b*height) - plane.d);
+			float distCH = etm::dot(plane.n, (c*height) - plane.d);
+			if (distAH < 0)rejects++;
+			if (distBH < 0)rejects++;
+			if (distCH < 0)rejects++;
+			planeMargins[i] = std::fminf(planeMargins[i], std::fminf(std::abs(distAH), std::fminf(std::abs(distBH), std::abs(distCH))));
+			if (rejects >= 6)return VolumeCheck::OUTSIDE;
+			else ret = VolumeCheck::INTERSECT;
+		}
+		// if at least one is outside the triangle intersects at least one plane
+		else if (rejects > 0)ret = VolumeCheck::INTERSECT;
+	}
+	return ret;
 }
\ No newline at end of file
@@ -29,24 +29,31 @@ struct FrustumCorners
 class Frustum
 {
 public:
+	static const uint8 PLANE_COUNT = 6;
+
 	Frustum();
 	~Frustum();
 
 	void Update();
 
 	void SetToCamera(CameraComponent* pCamera);
+	//for culling without a camera component, right is derived from forward and up
+	void SetCamera(const vec3 &position, const vec3 &forward, const vec3 &up, float fov, float nearPlane, float farPlane, float aspectRatio);
 	void SetCullTransform(mat4 objectWorld);
+	void SetCullTransform(const mat4 &objectWorld, const mat4 &objectWorldInverse);
 
 	VolumeCheck ContainsPoint(const vec3 &point) const;
 	VolumeCheck ContainsSphere(const Sphere &sphere) const;
 	VolumeCheck ContainsTriangle(vec3 &a, vec3 &b, vec3 &c);
 	VolumeCheck ContainsTriVolume(vec3 &a, vec3 &b, vec3 &c, float height);
+	VolumeCheck ContainsTriVolume(vec3 &a, vec3 &b, vec3 &c, float baseHeight, float height, float* planeMargins);
 
 	const vec3 &GetPositionOS() { return m_PositionObject; }
 	const float GetFOV() { return m_FOV; }
 	const float GetRadInvFOV() { return m_RadInvFOV; }
 
 	FrustumCorners GetCorners() { return m_Corners; }
+	const std::vector<Plane> &GetPlanes() const { return m_Planes; }
 
 private:
 	//transform to the culled objects object space and back to world space
@@ -64,6 +71,6 @@ private:
 	vec3 m_Forward;
 	vec3 m_Up;
 	vec3 m_Right;
-	float m_NearPlane, m_FarPlane, m_FOV;
+	float m_NearPlane, m_FarPlane, m_FOV, m_AspectRatio;
 };
 
@@ -19,11 +19,6 @@ void PointLight::UploadVariables(GLuint program, TransformComponent* comp, uint3
 	glUniform1f(glGetUniformLocation(program, 
 		(ligStr + idxStr + "].Radius").c_str()), radius);
 }
-void PointLight::DrawVolume(TransformComponent* pTransform)
-{
-	vec3 col = color*brightness;
-	PointLightVolume::GetInstance()->Draw(pTransform->GetPosition(), radius, col);
-}
 
 
 void DirectionalLight::UploadVariables(GLuint program, TransformComponent* comp, uint32 index)
@@ -42,8 +42,6 @@ public:
 	void SetRadius(float rad) { radius = rad;  m_Update = true;}
 	float GetRadius() { return radius; }
 
-	void DrawVolume(TransformComponent* pTransform);
-
 protected:
 	float radius;
 	virtual void UploadVariables(GLuint program, TransformComponent* comp, uint32 index);
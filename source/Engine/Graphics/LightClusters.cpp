@@ -0,0 +1,221 @@
+#include "stdafx.hpp"
+#include "LightClusters.hpp"
+
+#include <algorithm>
+
+#include "../Helper/TaskScheduler.hpp"
+
+namespace
+{
+	bool SphereIntersectsAABB(const vec3 &center, float radius, const AABB &box)
+	{
+		vec3 delta(std::max(std::max(box.min.x - center.x, center.x - box.max.x), 0.f),
+			std::max(std::max(box.min.y - center.y, center.y - box.max.y), 0.f),
+			std::max(std::max(box.min.z - center.z, center.z - box.max.z), 0.f));
+		return etm::dot(delta, delta) <= radius * radius;
+	}
+}
+
+LightClusters::LightClusters(const ivec3 &dimensions, TaskScheduler* pScheduler)
+	:m_Dimensions(dimensions)
+	,m_pScheduler(pScheduler)
+{
+	m_ClusterBounds.resize(m_Dimensions.x * m_Dimensions.y * m_Dimensions.z);
+	m_Clusters.resize(m_ClusterBounds.size());
+	m_SliceIndices.resize(m_Dimensions.z);
+	m_SliceHits.resize(m_Dimensions.z);
+	m_SliceNextIndex.resize(m_Dimensions.z);
+}
+LightClusters::~LightClusters()
+{
+}
+
+void LightClusters::SetProjection(const mat4 &projection, float nearPlane, float farPlane)
+{
+	if (m_Projection == projection && m_NearPlane == nearPlane && m_FarPlane == farPlane && m_SliceScale != 0.f) return;
+	m_Projection = projection;
+	m_NearPlane = nearPlane;
+	m_FarPlane = farPlane;
+	m_SliceScale = (float)m_Dimensions.z / logf(m_FarPlane / m_NearPlane);
+	m_SliceBias = m_SliceScale * logf(m_NearPlane);
+
+	//the view space line through each tile corner, from the near to the far plane
+	mat4 projectionInverse = etm::inverse(m_Projection);
+	auto unproject = [&projectionInverse](float x, float y, float z)
+	{
+		vec4 point = projectionInverse * vec4(x, y, z, 1.f);
+		return point.xyz / point.w;
+	};
+	std::vector<vec3> nearCorners;
+	std::vector<vec3> farCorners;
+	for (int32 y = 0; y <= m_Dimensions.y; ++y)
+	{
+		for (int32 x = 0; x <= m_Dimensions.x; ++x)
+		{
+			float ndcX = (float)x / (float)m_Dimensions.x * 2.f - 1.f;
+			float ndcY = (float)y / (float)m_Dimensions.y * 2.f - 1.f;
+			nearCorners.push_back(unproject(ndcX, ndcY, -1.f));
+			farCorners.push_back(unproject(ndcX, ndcY, 1.f));
+		}
+	}
+
+	for (int32 z = 0; z < m_Dimensions.z; ++z)
+	{
+		float depths[2] = { m_NearPlane * powf(m_FarPlane / m_NearPlane, (float)z / (float)m_Dimensions.z),
+			m_NearPlane * powf(m_FarPlane / m_NearPlane, (float)(z + 1) / (float)m_Dimensions.z) };
+		for (int32 y = 0; y < m_Dimensions.y; ++y)
+		{
+			for (int32 x = 0; x < m_Dimensions.x; ++x)
+			{
+				AABB &bounds = m_ClusterBounds[GetClusterIndex(ivec3(x, y, z))];
+				bounds.min = vec3(std::numeric_limits<float>::max());
+				bounds.max = vec3(std::numeric_limits<float>::lowest());
+				for (uint8 corner = 0; corner < 4; ++corner)
+				{
+					int32 cornerIndex = (y + corner / 2) * (m_Dimensions.x + 1) + x + corner % 2;
+					const vec3 &nearCorner = nearCorners[cornerIndex];
+					const vec3 &farCorner = farCorners[cornerIndex];
+					for (float depth : depths)
+					{
+						vec3 point = nearCorner + (farCorner - nearCorner) * ((depth - nearCorner.z) / (farCorner.z - nearCorner.z));
+						bounds.min = vec3(std::min(bounds.min.x, point.x), std::min(bounds.min.y, point.y), std::min(bounds.min.z, point.z));
+						bounds.max = vec3(std::max(bounds.max.x, point.x), std::max(bounds.max.y, point.y), std::max(bounds.max.z, point.z));
+					}
+				}
+			}
+		}
+	}
+}
+
+int32 LightClusters::GetSlice(float depth) const
+{
+	if (depth <= m_NearPlane) return 0;
+	return std::min((int32)floorf(logf(depth) * m_SliceScale - m_SliceBias), m_Dimensions.z - 1);
+}
+
+bool LightClusters::CalculateRange(const vec3 &viewPosition, float radius, LightRange &range) const
+{
+	float minDepth = viewPosition.z - radius;
+	float maxDepth = viewPosition.z + radius;
+	if (maxDepth < m_NearPlane || minDepth > m_FarPlane) return false;
+	range.viewPosition = viewPosition;
+	range.radius = radius;
+	range.minCluster.z = GetSlice(minDepth);
+	range.maxCluster.z = GetSlice(maxDepth);
+
+	//lights reaching behind the near plane can cover any part of the screen
+	range.minCluster.x = 0;
+	range.minCluster.y = 0;
+	range.maxCluster.x = m_Dimensions.x - 1;
+	range.maxCluster.y = m_Dimensions.y - 1;
+	if (minDepth <= m_NearPlane) return true;
+
+	//the projected corners of the box around the sphere enclose its projection
+	vec2 minNdc(std::numeric_limits<float>::max());
+	vec2 maxNdc(std::numeric_limits<float>::lowest());
+	for (uint8 corner = 0; corner < 8; ++corner)
+	{
+		vec3 point = viewPosition + vec3((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+		vec4 clip = m_Projection * vec4(point, 1.f);
+		vec2 ndc = clip.xy / clip.w;
+		minNdc = vec2(std::min(minNdc.x, ndc.x), std::min(minNdc.y, ndc.y));
+		maxNdc = vec2(std::max(maxNdc.x, ndc.x), std::max(maxNdc.y, ndc.y));
+	}
+	if (maxNdc.x < -1.f || maxNdc.y < -1.f || minNdc.x > 1.f || minNdc.y > 1.f) return false;
+
+	range.minCluster.x = etm::Clamp((int32)floorf((minNdc.x * 0.5f + 0.5f) * (float)m_Dimensions.x), m_Dimensions.x - 1, 0);
+	range.minCluster.y = etm::Clamp((int32)floorf((minNdc.y * 0.5f + 0.5f) * (float)m_Dimensions.y), m_Dimensions.y - 1, 0);
+	range.maxCluster.x = etm::Clamp((int32)floorf((maxNdc.x * 0.5f + 0.5f) * (float)m_Dimensions.x), m_Dimensions.x - 1, 0);
+	range.maxCluster.y = etm::Clamp((int32)floorf((maxNdc.y * 0.5f + 0.5f) * (float)m_Dimensions.y), m_Dimensions.y - 1, 0);
+	return true;
+}
+
+void LightClusters::Build(const mat4 &view, const std::vector<PointLight> &lights)
+{
+	m_Lights.clear();
+	m_LightRanges.clear();
+	LightRange range;
+	for (const PointLight &light : lights)
+	{
+		if (!CalculateRange((view * vec4(light.position, 1.f)).xyz, light.radius, range)) continue;
+		m_Lights.push_back(light);
+		m_LightRanges.push_back(range);
+	}
+
+	for (int32 slice = 0; slice < m_Dimensions.z; ++slice)
+	{
+		if (m_pScheduler) m_pScheduler->Push(0, [this, slice](uint32) { BinSlice(slice); });
+		else BinSlice(slice);
+	}
+	if (m_pScheduler) m_pScheduler->Run();
+
+	//concatenate the slices in order
+	size_t indexCount = 0;
+	for (const std::vector<uint32> &sliceIndices : m_SliceIndices)
+	{
+		indexCount += sliceIndices.size();
+	}
+	m_LightIndices.resize(indexCount);
+	uint32 sliceOffset = 0;
+	const uint32 clustersPerSlice = (uint32)(m_Dimensions.x * m_Dimensions.y);
+	for (int32 slice = 0; slice < m_Dimensions.z; ++slice)
+	{
+		const std::vector<uint32> &sliceIndices = m_SliceIndices[slice];
+		std::copy(sliceIndices.begin(), sliceIndices.end(), m_LightIndices.begin() + sliceOffset);
+		for (uint32 cluster = slice * clustersPerSlice; cluster < (slice + 1) * clustersPerSlice; ++cluster)
+		{
+			m_Clusters[cluster].offset += sliceOffset;
+		}
+		sliceOffset += (uint32)sliceIndices.size();
+	}
+}
+
+//Only touches the clusters and lists of its own slice
+//Each candidate is tested against the tiles in its screen rectangle, then the hits are sorted by cluster with a counting sort
+void LightClusters::BinSlice(int32 slice)
+{
+	const uint32 firstCluster = GetClusterIndex(ivec3(0, 0, slice));
+	const uint32 clusterCount = (uint32)(m_Dimensions.x * m_Dimensions.y);
+	for (uint32 cluster = firstCluster; cluster < firstCluster + clusterCount; ++cluster)
+	{
+		m_Clusters[cluster].count = 0;
+	}
+
+	std::vector<std::pair<uint32, uint32>> &hits = m_SliceHits[slice];
+	hits.clear();
+	for (uint32 light = 0; light < (uint32)m_LightRanges.size(); ++light)
+	{
+		const LightRange &range = m_LightRanges[light];
+		if (slice < range.minCluster.z || slice > range.maxCluster.z) continue;
+		for (int32 y = range.minCluster.y; y <= range.maxCluster.y; ++y)
+		{
+			for (int32 x = range.minCluster.x; x <= range.maxCluster.x; ++x)
+			{
+				uint32 cluster = firstCluster + y * m_Dimensions.x + x;
+				if (!SphereIntersectsAABB(range.viewPosition, range.radius, m_ClusterBounds[cluster])) continue;
+				hits.push_back(std::make_pair(cluster, light));
+				++m_Clusters[cluster].count;
+			}
+		}
+	}
+
+	uint32 offset = 0;
+	for (uint32 cluster = firstCluster; cluster < firstCluster + clusterCount; ++cluster)
+	{
+		m_Clusters[cluster].offset = offset;
+		offset += m_Clusters[cluster].count;
+	}
+	//lights were visited in order, so every cluster lists them in order too
+	std::vector<uint32> &indices = m_SliceIndices[slice];
+	indices.resize(hits.size());
+	std::vector<uint32> &nextIndex = m_SliceNextIndex[slice];
+	nextIndex.resize(clusterCount);
+	for (uint32 cluster = 0; cluster < clusterCount; ++cluster)
+	{
+		nextIndex[cluster] = m_Clusters[firstCluster + cluster].offset;
+	}
+	for (const std::pair<uint32, uint32> &hit : hits)
+	{
+		indices[nextIndex[hit.first - firstCluster]++] = hit.second;
+	}
+}
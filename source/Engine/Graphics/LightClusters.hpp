@@ -0,0 +1,103 @@
+#pragma once
+
+class TaskScheduler;
+
+//Light Clusters
+//**************
+
+// Splits the view frustum into a grid of clusters, screen tiles in x and y and depth slices in z, and bins point lights into them,
+// so deferred shading only evaluates the lights that can reach a pixel.
+// Slices are spaced exponentially between the near and far plane, which keeps clusters roughly as deep as they are wide.
+// A light is assigned to a cluster if the cluster is inside the screen rectangle and depth range of the light sphere,
+// and the sphere intersects the view space bounding box of the cluster. Lights outside of the screen or depth range are culled.
+// Depth slices are binned in parallel, the result is a packed light array, the range of each cluster in the light index list
+// and the list of light indices ordered by cluster.
+
+class LightClusters
+{
+public:
+	//packed as two RGBA texels for the GPU
+	struct PointLight
+	{
+		PointLight() = default;
+		PointLight(const vec3 &lightPosition, float lightRadius, const vec3 &lightColor)
+			:position(lightPosition), radius(lightRadius), color(lightColor) {}
+
+		vec3 position;
+		float radius = 0.f;
+		vec3 color;
+		float padding = 0.f;
+	};
+	//range in the light index list
+	struct Cluster
+	{
+		uint32 offset = 0;
+		uint32 count = 0;
+	};
+
+	//without a scheduler the slices are binned on the calling thread
+	LightClusters(const ivec3 &dimensions = ivec3(16, 9, 24), TaskScheduler* pScheduler = nullptr);
+	~LightClusters();
+
+	//recalculates the cluster bounds if the projection changed
+	void SetProjection(const mat4 &projection, float nearPlane, float farPlane);
+	//lights in world space
+	void Build(const mat4 &view, const std::vector<PointLight> &lights);
+
+	const ivec3& GetDimensions() const { return m_Dimensions; }
+	uint32 GetClusterIndex(const ivec3 &cluster) const { return (cluster.z * m_Dimensions.y + cluster.y) * m_Dimensions.x + cluster.x; }
+	//view space bounds
+	const AABB& GetClusterBounds(uint32 cluster) const { return m_ClusterBounds[cluster]; }
+
+	//slice of a positive view space depth, the same as floor(log(depth) * scale - bias) clamped to the grid
+	int32 GetSlice(float depth) const;
+	float GetSliceScale() const { return m_SliceScale; }
+	float GetSliceBias() const { return m_SliceBias; }
+
+	//lights that weren't culled, the light indices point into it
+	const std::vector<PointLight>& GetLights() const { return m_Lights; }
+	const std::vector<Cluster>& GetClusters() const { return m_Clusters; }
+	const std::vector<uint32>& GetLightIndices() const { return m_LightIndices; }
+
+private:
+	//clusters a light can touch, inclusive
+	struct LightRange
+	{
+		vec3 viewPosition;
+		float radius;
+		ivec3 minCluster;
+		ivec3 maxCluster;
+	};
+
+	bool CalculateRange(const vec3 &viewPosition, float radius, LightRange &range) const;
+	void BinSlice(int32 slice);
+
+	ivec3 m_Dimensions;
+	mat4 m_Projection;
+	float m_NearPlane = 0.f;
+	float m_FarPlane = 0.f;
+	float m_SliceScale = 0.f;
+	float m_SliceBias = 0.f;
+	std::vector<AABB> m_ClusterBounds;
+
+	std::vector<PointLight> m_Lights;
+	std::vector<LightRange> m_LightRanges;
+	std::vector<Cluster> m_Clusters;
+	std::vector<uint32> m_LightIndices;
+
+	//written by one worker each, cluster offsets are relative to the slice until they are merged
+	std::vector<std::vector<uint32>> m_SliceIndices;
+	//clusters and lights that intersect, and where the next light of each cluster goes
+	std::vector<std::vector<std::pair<uint32, uint32>>> m_SliceHits;
+	std::vector<std::vector<uint32>> m_SliceNextIndex;
+
+	TaskScheduler* m_pScheduler = nullptr;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	LightClusters(const LightClusters& obj);
+	LightClusters& operator=(const LightClusters& obj);
+};
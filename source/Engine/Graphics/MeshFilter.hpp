@@ -51,6 +51,9 @@ public:
 	size_t GetIndexCount() { return m_IndexCount; }
 
 	Sphere* GetBoundingSphere();
+	//vertex positions and triangle list in object space, kept for CPU side queries
+	const std::vector<vec3>& GetPositions() const { return m_Positions; }
+	const std::vector<GLuint>& GetIndices() const { return m_Indices; }
 private:
 	friend class MeshFilterLoader;
 	friend class ModelComponent;
@@ -0,0 +1,246 @@
+#include "stdafx.hpp"
+#include "OcclusionBuffer.hpp"
+
+#include <algorithm>
+
+#include "../Helper/TaskScheduler.hpp"
+
+OcclusionBuffer::OcclusionBuffer(const ivec2 &resolution, TaskScheduler* pScheduler)
+	: m_pScheduler(pScheduler)
+{
+	m_TilesX = std::max((resolution.x + TILE_WIDTH - 1) / TILE_WIDTH, 1);
+	m_TilesY = std::max((resolution.y + TILE_HEIGHT - 1) / TILE_HEIGHT, 1);
+	m_Width = m_TilesX * TILE_WIDTH;
+	m_Height = m_TilesY * TILE_HEIGHT;
+	m_Depth.assign(m_Width * m_Height, 1.f);
+	m_TileMaxDepth.assign(m_TilesX * m_TilesY, 1.f);
+	m_TileBins.resize(m_TilesX * m_TilesY);
+}
+OcclusionBuffer::~OcclusionBuffer()
+{
+}
+
+void OcclusionBuffer::Begin(const mat4 &viewProjection)
+{
+	m_ViewProjection = viewProjection;
+	std::fill(m_Depth.begin(), m_Depth.end(), 1.f);
+	std::fill(m_TileMaxDepth.begin(), m_TileMaxDepth.end(), 1.f);
+	m_Triangles.clear();
+	for (std::vector<uint32> &bin : m_TileBins)
+	{
+		bin.clear();
+	}
+}
+
+void OcclusionBuffer::AddOccluder(const std::vector<vec3> &positions, const std::vector<uint32> &indices, const mat4 &world)
+{
+	mat4 worldViewProjection = world * m_ViewProjection;
+	m_ScreenPositions.resize(positions.size());
+	m_IsBehind.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		vec4 clip = worldViewProjection * vec4(positions[i], 1.f);
+		m_IsBehind[i] = clip.w <= 1e-5f;
+		if (m_IsBehind[i]) continue;
+		vec3 ndc = clip.xyz / clip.w;
+		m_ScreenPositions[i] = vec3((ndc.x * 0.5f + 0.5f) * (float)m_Width, (ndc.y * 0.5f + 0.5f) * (float)m_Height, ndc.z);
+	}
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		//clipping against the near plane would add triangles, leaving them out only makes the occluder smaller
+		if (m_IsBehind[indices[i]] || m_IsBehind[indices[i + 1]] || m_IsBehind[indices[i + 2]]) continue;
+		AddTriangle(m_ScreenPositions[indices[i]], m_ScreenPositions[indices[i + 1]], m_ScreenPositions[indices[i + 2]]);
+	}
+}
+
+//Both windings are rasterized, so occluders don't depend on the face culling mode they are drawn with
+void OcclusionBuffer::AddTriangle(const vec3 &a, const vec3 &b, const vec3 &c)
+{
+	vec3 v[3] = { a, b, c };
+	float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+	if (area == 0.f) return;
+	if (area < 0.f)
+	{
+		std::swap(v[1], v[2]);
+		area = -area;
+	}
+
+	//pixels with their center inside the bounding rectangle
+	Triangle tri;
+	tri.minX = std::max((int32)std::ceil(std::min(std::min(v[0].x, v[1].x), v[2].x) - 0.5f), 0);
+	tri.minY = std::max((int32)std::ceil(std::min(std::min(v[0].y, v[1].y), v[2].y) - 0.5f), 0);
+	tri.maxX = std::min((int32)std::floor(std::max(std::max(v[0].x, v[1].x), v[2].x) - 0.5f), m_Width - 1);
+	tri.maxY = std::min((int32)std::floor(std::max(std::max(v[0].y, v[1].y), v[2].y) - 0.5f), m_Height - 1);
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY) return;
+
+	//edge i is opposite of vertex i and positive on the inside, divided by the area it is the barycentric weight of that vertex
+	for (uint8 i = 0; i < 3; ++i)
+	{
+		const vec3 &from = v[(i + 1) % 3];
+		const vec3 &to = v[(i + 2) % 3];
+		tri.edgeA[i] = from.y - to.y;
+		tri.edgeB[i] = to.x - from.x;
+		tri.edgeC[i] = (to.y - from.y) * from.x - (to.x - from.x) * from.y;
+	}
+	float deltaZ1 = (v[1].z - v[0].z) / area;
+	float deltaZ2 = (v[2].z - v[0].z) / area;
+	tri.depthA = tri.edgeA[1] * deltaZ1 + tri.edgeA[2] * deltaZ2;
+	tri.depthB = tri.edgeB[1] * deltaZ1 + tri.edgeB[2] * deltaZ2;
+	tri.depthC = v[0].z + tri.edgeC[1] * deltaZ1 + tri.edgeC[2] * deltaZ2;
+
+	uint32 index = (uint32)m_Triangles.size();
+	m_Triangles.push_back(tri);
+	for (int32 tileY = tri.minY / TILE_HEIGHT; tileY <= tri.maxY / TILE_HEIGHT; ++tileY)
+	{
+		for (int32 tileX = tri.minX / TILE_WIDTH; tileX <= tri.maxX / TILE_WIDTH; ++tileX)
+		{
+			m_TileBins[tileY * m_TilesX + tileX].push_back(index);
+		}
+	}
+}
+
+void OcclusionBuffer::Rasterize()
+{
+	for (int32 tileY = 0; tileY < m_TilesY; ++tileY)
+	{
+		for (int32 tileX = 0; tileX < m_TilesX; ++tileX)
+		{
+			if (m_TileBins[tileY * m_TilesX + tileX].empty()) continue;
+			if (m_pScheduler) m_pScheduler->Push(0, [this, tileX, tileY](uint32) { RasterizeTile(tileX, tileY); });
+			else RasterizeTile(tileX, tileY);
+		}
+	}
+	if (m_pScheduler) m_pScheduler->Run();
+}
+
+//Tiles don't share pixels, so they can be written by different workers without synchronizing
+void OcclusionBuffer::RasterizeTile(int32 tileX, int32 tileY)
+{
+	const int32 tileMinX = tileX * TILE_WIDTH;
+	const int32 tileMinY = tileY * TILE_HEIGHT;
+	const int32 tileMaxX = tileMinX + TILE_WIDTH - 1;
+	const int32 tileMaxY = tileMinY + TILE_HEIGHT - 1;
+#if defined(ETM_SIMD_SSE)
+	const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+#endif
+
+	for (uint32 index : m_TileBins[tileY * m_TilesX + tileX])
+	{
+		const Triangle &tri = m_Triangles[index];
+		//starts on a multiple of 4, tiles are too, so groups of 4 pixels never cross into the next tile
+		int32 minX = std::max(tri.minX, tileMinX) & ~3;
+		int32 maxX = std::min(tri.maxX, tileMaxX);
+		int32 minY = std::max(tri.minY, tileMinY);
+		int32 maxY = std::min(tri.maxY, tileMaxY);
+
+		for (int32 y = minY; y <= maxY; ++y)
+		{
+			float pixelY = (float)y + 0.5f;
+			float rowEdge[3];
+			for (uint8 i = 0; i < 3; ++i)
+			{
+				rowEdge[i] = tri.edgeB[i] * pixelY + tri.edgeC[i];
+			}
+			float rowDepth = tri.depthB * pixelY + tri.depthC;
+			float* pRow = m_Depth.data() + y * m_Width;
+
+#if defined(ETM_SIMD_SSE)
+			const __m128 edgeA0 = _mm_set1_ps(tri.edgeA[0]);
+			const __m128 edgeA1 = _mm_set1_ps(tri.edgeA[1]);
+			const __m128 edgeA2 = _mm_set1_ps(tri.edgeA[2]);
+			const __m128 rowEdge0 = _mm_set1_ps(rowEdge[0]);
+			const __m128 rowEdge1 = _mm_set1_ps(rowEdge[1]);
+			const __m128 rowEdge2 = _mm_set1_ps(rowEdge[2]);
+			const __m128 depthA = _mm_set1_ps(tri.depthA);
+			const __m128 rowDepthV = _mm_set1_ps(rowDepth);
+			for (int32 x = minX; x <= maxX; x += 4)
+			{
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), pixelOffsets);
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, pixelX), rowEdge0), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, pixelX), rowEdge1), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, pixelX), rowEdge2), zero));
+				if (_mm_movemask_ps(inside) == 0) continue;
+
+				__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, pixelX), rowDepthV);
+				__m128 current = _mm_loadu_ps(pRow + x);
+				__m128 nearest = _mm_min_ps(current, depth);
+				_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+#else
+			for (int32 x = minX; x <= maxX; ++x)
+			{
+				float pixelX = (float)x + 0.5f;
+				if (tri.edgeA[0] * pixelX + rowEdge[0] < 0.f) continue;
+				if (tri.edgeA[1] * pixelX + rowEdge[1] < 0.f) continue;
+				if (tri.edgeA[2] * pixelX + rowEdge[2] < 0.f) continue;
+				pRow[x] = std::min(pRow[x], tri.depthA * pixelX + rowDepth);
+			}
+#endif
+		}
+	}
+
+	float maxDepth = -1.f;
+	for (int32 y = tileMinY; y <= tileMaxY; ++y)
+	{
+		const float* pRow = m_Depth.data() + y * m_Width;
+		for (int32 x = tileMinX; x <= tileMaxX; ++x)
+		{
+			maxDepth = std::max(maxDepth, pRow[x]);
+		}
+	}
+	m_TileMaxDepth[tileY * m_TilesX + tileX] = maxDepth;
+}
+
+bool OcclusionBuffer::IsOccluded(const AABB &bounds) const
+{
+	//screen rectangle and nearest depth of the corners
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxY = std::numeric_limits<float>::lowest();
+	float nearestDepth = std::numeric_limits<float>::max();
+	for (uint8 corner = 0; corner < 8; ++corner)
+	{
+		vec3 point((corner & 1) ? bounds.max.x : bounds.min.x, (corner & 2) ? bounds.max.y : bounds.min.y, (corner & 4) ? bounds.max.z : bounds.min.z);
+		vec4 clip = m_ViewProjection * vec4(point, 1.f);
+		//bounds that reach behind the near plane contain the camera or are right in front of it
+		if (clip.w <= 1e-5f || clip.z < -clip.w) return false;
+		vec3 ndc = clip.xyz / clip.w;
+		minX = std::min(minX, ndc.x);
+		minY = std::min(minY, ndc.y);
+		maxX = std::max(maxX, ndc.x);
+		maxY = std::max(maxY, ndc.y);
+		nearestDepth = std::min(nearestDepth, ndc.z);
+	}
+
+	//every pixel the rectangle touches, the parts outside of the screen can't be seen anyway
+	int32 pixelMinX = std::max((int32)std::floor((minX * 0.5f + 0.5f) * (float)m_Width), 0);
+	int32 pixelMinY = std::max((int32)std::floor((minY * 0.5f + 0.5f) * (float)m_Height), 0);
+	int32 pixelMaxX = std::min((int32)std::floor((maxX * 0.5f + 0.5f) * (float)m_Width), m_Width - 1);
+	int32 pixelMaxY = std::min((int32)std::floor((maxY * 0.5f + 0.5f) * (float)m_Height), m_Height - 1);
+	if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY) return false;
+
+	for (int32 tileY = pixelMinY / TILE_HEIGHT; tileY <= pixelMaxY / TILE_HEIGHT; ++tileY)
+	{
+		for (int32 tileX = pixelMinX / TILE_WIDTH; tileX <= pixelMaxX / TILE_WIDTH; ++tileX)
+		{
+			if (m_TileMaxDepth[tileY * m_TilesX + tileX] < nearestDepth) continue;
+
+			int32 startX = std::max(pixelMinX, tileX * TILE_WIDTH);
+			int32 endX = std::min(pixelMaxX, tileX * TILE_WIDTH + TILE_WIDTH - 1);
+			int32 startY = std::max(pixelMinY, tileY * TILE_HEIGHT);
+			int32 endY = std::min(pixelMaxY, tileY * TILE_HEIGHT + TILE_HEIGHT - 1);
+			for (int32 y = startY; y <= endY; ++y)
+			{
+				const float* pRow = m_Depth.data() + y * m_Width;
+				for (int32 x = startX; x <= endX; ++x)
+				{
+					if (pRow[x] >= nearestDepth) return false;
+				}
+			}
+		}
+	}
+	return true;
+}
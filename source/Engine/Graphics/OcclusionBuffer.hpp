@@ -0,0 +1,81 @@
+#pragma once
+
+class TaskScheduler;
+
+//Occlusion Buffer
+//****************
+
+// Low resolution depth buffer on the CPU that occluder meshes are rasterized into, to reject bounds that are hidden behind them.
+// Triangles are binned into screen tiles first, then every tile is rasterized on its own by the workers of a scheduler,
+// 4 pixels at a time with SSE. Occluders only write pixels whose centers they cover and bounds are tested with their nearest depth
+// against every pixel they touch, so bounds are only reported occluded if all of them is behind occluders.
+// Depths are normalized device z in [-1, 1], the buffer is cleared to the far plane.
+
+class OcclusionBuffer
+{
+public:
+	static const int32 TILE_WIDTH = 32;
+	static const int32 TILE_HEIGHT = 16;
+
+	//the resolution is rounded up to whole tiles, without a scheduler the tiles are rasterized on the calling thread
+	OcclusionBuffer(const ivec2 &resolution = ivec2(256, 128), TaskScheduler* pScheduler = nullptr);
+	~OcclusionBuffer();
+
+	//clears the buffer and the occluders of the last frame
+	void Begin(const mat4 &viewProjection);
+	//triangle list in object space, triangles with a corner behind the camera are skipped
+	void AddOccluder(const std::vector<vec3> &positions, const std::vector<uint32> &indices, const mat4 &world);
+	//rasterizes every occluder added since Begin
+	void Rasterize();
+
+	bool IsOccluded(const AABB &bounds) const;
+
+	ivec2 GetResolution() const { return ivec2(m_Width, m_Height); }
+	float GetDepth(int32 x, int32 y) const { return m_Depth[y * m_Width + x]; }
+	size_t GetTriangleCount() const { return m_Triangles.size(); }
+
+private:
+	//edge functions and depth as a * x + b * y + c in pixels, and the pixels the triangle can cover
+	struct Triangle
+	{
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		int32 minX;
+		int32 minY;
+		int32 maxX;
+		int32 maxY;
+	};
+
+	void AddTriangle(const vec3 &a, const vec3 &b, const vec3 &c);
+	void RasterizeTile(int32 tileX, int32 tileY);
+
+	int32 m_Width;
+	int32 m_Height;
+	int32 m_TilesX;
+	int32 m_TilesY;
+	mat4 m_ViewProjection;
+
+	std::vector<float> m_Depth;
+	//farthest depth in each tile, bounds nearer than it in a tile don't need to look at its pixels
+	std::vector<float> m_TileMaxDepth;
+	std::vector<Triangle> m_Triangles;
+	std::vector<std::vector<uint32>> m_TileBins;
+
+	//screen positions of the current occluder
+	std::vector<vec3> m_ScreenPositions;
+	std::vector<bool> m_IsBehind;
+
+	TaskScheduler* m_pScheduler = nullptr;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	OcclusionBuffer(const OcclusionBuffer& obj);
+	OcclusionBuffer& operator=(const OcclusionBuffer& obj);
+};
@@ -0,0 +1,17 @@
+#include "stdafx.hpp"
+#include "PointLightInstances.hpp"
+
+#include "BatchFrustum.hpp"
+#include "SphereOccluders.hpp"
+
+void PointLightInstances::Build(const std::vector<Instance> &lights, const BatchFrustum &frustum, const SphereOccluders &occluders)
+{
+	m_Instances.clear();
+	for (const Instance &light : lights)
+	{
+		Sphere bounds(light.position, light.radius);
+		if (frustum.ContainsSphere(bounds) == VolumeCheck::OUTSIDE) continue;
+		if (occluders.IsOccluded(bounds)) continue;
+		m_Instances.push_back(light);
+	}
+}
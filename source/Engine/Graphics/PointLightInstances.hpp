@@ -0,0 +1,27 @@
+#pragma once
+#include "LightClusters.hpp"
+
+class BatchFrustum;
+class SphereOccluders;
+
+//Point Light Instances
+//*********************
+
+// Per instance data for drawing the volumes of all point lights of a frame with a single instanced draw call.
+// Instances are packed in one pass over the point lights of the scene, dropping the ones outside of the view frustum or behind sphere occluders.
+// The layout is the same as the lights of the clusters, two RGBA texels per light that the vertex shader fetches by instance ID.
+
+class PointLightInstances
+{
+public:
+	typedef LightClusters::PointLight Instance;
+
+	//keeps the order of the lights
+	void Build(const std::vector<Instance> &lights, const BatchFrustum &frustum, const SphereOccluders &occluders);
+
+	const std::vector<Instance>& GetInstances() const { return m_Instances; }
+	uint32 GetCount() const { return (uint32)m_Instances.size(); }
+
+private:
+	std::vector<Instance> m_Instances;
+};
@@ -0,0 +1,131 @@
+#include "stdafx.hpp"
+#include "Spectrum.hpp"
+
+#include <algorithm>
+
+Spectrum::Spectrum(double lambdaMin, double lambdaStep, const std::vector<double> &values)
+	: m_LambdaMin(lambdaMin)
+	, m_LambdaStep(lambdaStep)
+	, m_Values(values)
+{
+	assert(lambdaStep > 0.0);
+}
+Spectrum::Spectrum(double lambdaMin, double lambdaMax, double lambdaStep, double value)
+	: m_LambdaMin(lambdaMin)
+	, m_LambdaStep(lambdaStep)
+{
+	assert(lambdaStep > 0.0 && lambdaMax >= lambdaMin);
+	//the small offset keeps lambdaMax when the range is a multiple of the step that doesn't divide exactly
+	m_Values.resize((size_t)((lambdaMax - lambdaMin) / lambdaStep + 1e-6) + 1, value);
+}
+
+//Both lists are increasing, so one pass over them finds every interval
+Spectrum Spectrum::Resample(const std::vector<double> &wavelengths, const std::vector<double> &values,
+	double lambdaMin, double lambdaMax, double lambdaStep)
+{
+	assert(wavelengths.size() == values.size() && !wavelengths.empty());
+	Spectrum ret(lambdaMin, lambdaMax, lambdaStep);
+	size_t interval = 0;
+	for (size_t i = 0; i < ret.m_Values.size(); ++i)
+	{
+		double wavelength = ret.GetWavelength(i);
+		if (wavelength <= wavelengths.front())
+		{
+			ret.m_Values[i] = values.front();
+			continue;
+		}
+		while (interval + 1 < wavelengths.size() && wavelengths[interval + 1] <= wavelength)
+		{
+			++interval;
+		}
+		if (interval + 1 == wavelengths.size())
+		{
+			ret.m_Values[i] = values.back();
+			continue;
+		}
+		double u = (wavelength - wavelengths[interval]) / (wavelengths[interval + 1] - wavelengths[interval]);
+		ret.m_Values[i] = values[interval] * (1.0 - u) + values[interval + 1] * u;
+	}
+	return ret;
+}
+Spectrum Spectrum::Resample(double lambdaMin, double lambdaMax, double lambdaStep) const
+{
+	if (lambdaMin == m_LambdaMin && lambdaStep == m_LambdaStep && lambdaMax == GetLambdaMax())
+	{
+		return *this;
+	}
+	return Generate(lambdaMin, lambdaMax, lambdaStep, [this](double wavelength) { return Sample(wavelength); });
+}
+
+bool Spectrum::HasSameWavelengths(const Spectrum &other) const
+{
+	return m_LambdaMin == other.m_LambdaMin && m_LambdaStep == other.m_LambdaStep && m_Values.size() == other.m_Values.size();
+}
+
+double Spectrum::Sample(double wavelength) const
+{
+	assert(!m_Values.empty());
+	double u = (wavelength - m_LambdaMin) / m_LambdaStep;
+	if (u <= 0.0) return m_Values.front();
+	size_t index = (size_t)u;
+	if (index + 1 >= m_Values.size()) return m_Values.back();
+	u -= (double)index;
+	return m_Values[index] * (1.0 - u) + m_Values[index + 1] * u;
+}
+dvec3 Spectrum::Sample(const dvec3 &wavelengths) const
+{
+	return dvec3(Sample(wavelengths.x), Sample(wavelengths.y), Sample(wavelengths.z));
+}
+
+double Spectrum::Integrate() const
+{
+	double sum = 0.0;
+	for (double value : m_Values)
+	{
+		sum += value;
+	}
+	return sum * m_LambdaStep;
+}
+double Spectrum::Integrate(const Spectrum &weight) const
+{
+	assert(HasSameWavelengths(weight));
+	const double* pValues = m_Values.data();
+	const double* pWeights = weight.m_Values.data();
+	double sum = 0.0;
+	for (size_t i = 0; i < m_Values.size(); ++i)
+	{
+		sum += pValues[i] * pWeights[i];
+	}
+	return sum * m_LambdaStep;
+}
+
+Spectrum& Spectrum::operator+=(const Spectrum &rhs)
+{
+	assert(HasSameWavelengths(rhs));
+	double* pValues = m_Values.data();
+	const double* pOther = rhs.m_Values.data();
+	for (size_t i = 0; i < m_Values.size(); ++i)
+	{
+		pValues[i] += pOther[i];
+	}
+	return *this;
+}
+Spectrum& Spectrum::operator*=(const Spectrum &rhs)
+{
+	assert(HasSameWavelengths(rhs));
+	double* pValues = m_Values.data();
+	const double* pOther = rhs.m_Values.data();
+	for (size_t i = 0; i < m_Values.size(); ++i)
+	{
+		pValues[i] *= pOther[i];
+	}
+	return *this;
+}
+Spectrum& Spectrum::operator*=(double scalar)
+{
+	for (double &value : m_Values)
+	{
+		value *= scalar;
+	}
+	return *this;
+}
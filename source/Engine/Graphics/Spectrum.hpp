@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+
+//Spectrum
+//********
+
+// Values of a function of the wavelength (in nanometers), sampled at uniform steps.
+// Sampling only needs the index of the step instead of searching for the wavelength, and spectra on the same wavelengths combine
+// element by element over contiguous arrays the compiler can vectorize.
+
+class Spectrum
+{
+public:
+	Spectrum() {}
+	Spectrum(double lambdaMin, double lambdaStep, const std::vector<double> &values);
+	Spectrum(double lambdaMin, double lambdaMax, double lambdaStep, double value = 0.0);
+
+	//Linear interpolation of samples at increasing wavelengths with any spacing, outside of them the first and last values are kept
+	static Spectrum Resample(const std::vector<double> &wavelengths, const std::vector<double> &values,
+		double lambdaMin, double lambdaMax, double lambdaStep);
+	Spectrum Resample(double lambdaMin, double lambdaMax, double lambdaStep) const;
+
+	//Calls func(wavelength) for every step
+	template<typename TFunc>
+	static Spectrum Generate(double lambdaMin, double lambdaMax, double lambdaStep, TFunc func);
+
+	size_t Size() const { return m_Values.size(); }
+	double GetLambdaMin() const { return m_LambdaMin; }
+	double GetLambdaMax() const { return m_LambdaMin + m_LambdaStep * (double)(m_Values.size() - 1); }
+	double GetLambdaStep() const { return m_LambdaStep; }
+	double GetWavelength(size_t index) const { return m_LambdaMin + m_LambdaStep * (double)index; }
+	const std::vector<double>& GetValues() const { return m_Values; }
+	bool HasSameWavelengths(const Spectrum &other) const;
+
+	//Interpolated in constant time, clamped to the first and last value
+	double Sample(double wavelength) const;
+	dvec3 Sample(const dvec3 &wavelengths) const;
+
+	//Riemann sum over the steps, and the same of the product with a weight on the same wavelengths
+	double Integrate() const;
+	double Integrate(const Spectrum &weight) const;
+
+	//Element wise, spectra need to be on the same wavelengths
+	Spectrum& operator+=(const Spectrum &rhs);
+	Spectrum& operator*=(const Spectrum &rhs);
+	Spectrum& operator*=(double scalar);
+
+private:
+	double m_LambdaMin = 0.0;
+	double m_LambdaStep = 1.0;
+	std::vector<double> m_Values;
+};
+
+inline Spectrum operator+(Spectrum lhs, const Spectrum &rhs) { return lhs += rhs; }
+inline Spectrum operator*(Spectrum lhs, const Spectrum &rhs) { return lhs *= rhs; }
+inline Spectrum operator*(Spectrum lhs, double scalar) { return lhs *= scalar; }
+inline Spectrum operator*(double scalar, Spectrum rhs) { return rhs *= scalar; }
+
+template<typename TFunc>
+Spectrum Spectrum::Generate(double lambdaMin, double lambdaMax, double lambdaStep, TFunc func)
+{
+	Spectrum ret(lambdaMin, lambdaMax, lambdaStep);
+	for (size_t i = 0; i < ret.m_Values.size(); ++i)
+	{
+		ret.m_Values[i] = func(ret.GetWavelength(i));
+	}
+	return ret;
+}
@@ -0,0 +1,66 @@
+#include "stdafx.hpp"
+#include "SphereOccluders.hpp"
+
+void SphereOccluders::Clear()
+{
+	m_Occluders.clear();
+	m_Cones.clear();
+}
+
+void SphereOccluders::AddOccluder(const Sphere &occluder)
+{
+	m_Occluders.push_back(occluder);
+}
+
+void SphereOccluders::SetViewPosition(const vec3 &position)
+{
+	m_ViewPosition = position;
+	m_Cones.clear();
+	HorizonCone cone;
+	for (const Sphere &occluder : m_Occluders)
+	{
+		if (CreateCone(m_ViewPosition, occluder, cone)) m_Cones.push_back(cone);
+	}
+}
+
+bool SphereOccluders::IsOccluded(const Sphere &bounds) const
+{
+	for (const HorizonCone &cone : m_Cones)
+	{
+		if (IsInside(cone, m_ViewPosition, bounds)) return true;
+	}
+	return false;
+}
+
+bool SphereOccluders::IsOccluded(const vec3 &viewPosition, const Sphere &occluder, const Sphere &bounds)
+{
+	HorizonCone cone;
+	return CreateCone(viewPosition, occluder, cone) && IsInside(cone, viewPosition, bounds);
+}
+
+bool SphereOccluders::CreateCone(const vec3 &viewPosition, const Sphere &occluder, HorizonCone &cone)
+{
+	vec3 toCenter = occluder.pos - viewPosition;
+	float distanceSq = etm::dot(toCenter, toCenter);
+	float radiusSq = occluder.radius * occluder.radius;
+	if (distanceSq <= radiusSq) return false;
+
+	float distance = sqrtf(distanceSq);
+	float tangentLength = sqrtf(distanceSq - radiusSq);
+	cone.axis = toCenter / distance;
+	cone.sinAngle = occluder.radius / distance;
+	cone.cosAngle = tangentLength / distance;
+	cone.horizonDistance = tangentLength * cone.cosAngle;
+	return true;
+}
+
+bool SphereOccluders::IsInside(const HorizonCone &cone, const vec3 &viewPosition, const Sphere &bounds)
+{
+	vec3 toBounds = bounds.pos - viewPosition;
+	float axial = etm::dot(toBounds, cone.axis);
+	if (axial - bounds.radius < cone.horizonDistance) return false;
+
+	//distance from the center to the side of the cone, positive inside
+	float radial = sqrtf(std::max(etm::dot(toBounds, toBounds) - axial * axial, 0.f));
+	return axial * cone.sinAngle - radial * cone.cosAngle >= bounds.radius;
+}
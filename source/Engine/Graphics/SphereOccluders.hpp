@@ -0,0 +1,41 @@
+#pragma once
+
+//Sphere Occluders
+//****************
+
+// Large spheres such as planets that hide everything behind them from a viewpoint, tested analytically instead of rasterized.
+// Each occluder casts a cone from the viewpoint that touches it along its horizon. The visible cap of the sphere is in front of the plane
+// through the horizon, so bounds that are entirely inside the cone and behind that plane can't be seen.
+// Occluders that contain the viewpoint hide nothing.
+
+class SphereOccluders
+{
+public:
+	void Clear();
+	void AddOccluder(const Sphere &occluder);
+	//sets up the horizon cones for the viewpoint, call again after adding occluders or moving the viewpoint
+	void SetViewPosition(const vec3 &position);
+
+	//true if any occluder hides the whole sphere
+	bool IsOccluded(const Sphere &bounds) const;
+	static bool IsOccluded(const vec3 &viewPosition, const Sphere &occluder, const Sphere &bounds);
+
+	size_t GetOccluderCount() const { return m_Occluders.size(); }
+
+private:
+	struct HorizonCone
+	{
+		vec3 axis;
+		float sinAngle;
+		float cosAngle;
+		//distance from the viewpoint to the plane through the horizon along the axis
+		float horizonDistance;
+	};
+
+	static bool CreateCone(const vec3 &viewPosition, const Sphere &occluder, HorizonCone &cone);
+	static bool IsInside(const HorizonCone &cone, const vec3 &viewPosition, const Sphere &bounds);
+
+	std::vector<Sphere> m_Occluders;
+	std::vector<HorizonCone> m_Cones;
+	vec3 m_ViewPosition;
+};
@@ -64,7 +64,7 @@ void TextureData::SetParameters( TextureParameters params )
 	}
 	if(!etm::nearEqualsV(m_Parameters.borderColor, params.borderColor ))
 	{
-		glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, params.borderColor.data.data() );
+		glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, etm::valuePtr(params.borderColor) );
 	}
 	if(m_Parameters.genMipMaps == false && params.genMipMaps == true)
 	{
@@ -8,6 +8,7 @@
 #include "../Graphics/ShaderData.hpp"
 #include "../Graphics/TextureData.hpp"
 #include "../Graphics/Frustum.hpp"
+#include "../Helper/TaskScheduler.hpp"
 #include "ShadowRenderer.hpp"
 #include "PrimitiveRenderer.hpp"
 #include "RenderPipeline.hpp"
@@ -20,6 +21,8 @@ PointLightVolume::~PointLightVolume()
 {
 	if (!IsInitialized)
 		return;
+	glDeleteTextures(1, &m_InstanceTexture);
+	glDeleteBuffers(1, &m_InstanceBuffer);
 	SafeDelete(m_pMaterial);
 	SafeDelete(m_pNullMaterial);
 }
@@ -31,9 +34,17 @@ void PointLightVolume::Initialize()
 	m_pNullMaterial = new NullMaterial();
 	m_pNullMaterial->Initialize();
 
+	glGenBuffers(1, &m_InstanceBuffer);
+	glGenTextures(1, &m_InstanceTexture);
+	STATE->BindBuffer(GL_TEXTURE_BUFFER, m_InstanceBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+	STATE->LazyBindTexture(3, GL_TEXTURE_BUFFER, m_InstanceTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_InstanceBuffer);
+	m_pMaterial->SetLightData(m_InstanceTexture);
+
 	IsInitialized = true;
 }
-void PointLightVolume::Draw(vec3 pos, float radius, vec3 col)
+void PointLightVolume::Draw(const std::vector<LightClusters::PointLight> &instances)
 {
 	//Make sure everything is set up
 	if (!IsInitialized)
@@ -41,13 +52,14 @@ void PointLightVolume::Draw(vec3 pos, float radius, vec3 col)
 		Initialize();
 	}
 
-	//Frustum culling
-	Sphere objSphere = Sphere(pos, radius);
-	if (CAMERA->GetFrustum()->ContainsSphere(objSphere) == VolumeCheck::OUTSIDE)
+	if (instances.empty())
 		return;
 
-	//mat4 World = etm::translate(pos)*etm::scale(vec3(radius));
-	mat4 World = etm::scale( vec3( radius ) )*etm::translate( pos );
+	//orphans the storage of last frame instead of waiting for the GPU to finish reading it
+	size_t size = instances.size() * sizeof(LightClusters::PointLight);
+	STATE->BindBuffer(GL_TEXTURE_BUFFER, m_InstanceBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, size, instances.data());
 
 	//Draw the null material in the stencil buffer
 	//STATE->SetDepthEnabled(true);
@@ -67,10 +79,10 @@ void PointLightVolume::Draw(vec3 pos, float radius, vec3 col)
 	//STATE->SetCullEnabled(true);
 	//STATE->SetFaceCullingMode(GL_FRONT);
 
-	m_pMaterial->SetLight(pos, col, radius);
-	m_pMaterial->UploadVariables(World);
+	//the vertex shader places a sphere around each light
+	m_pMaterial->UploadVariables(mat4());
 
-	PrimitiveRenderer::GetInstance()->Draw<primitives::IcoSphere<2> >();
+	PrimitiveRenderer::GetInstance()->DrawInstanced<primitives::IcoSphere<2> >((uint32)instances.size());
 
 	//STATE->SetFaceCullingMode(GL_BACK);
 	//STATE->SetBlendEnabled(false);
@@ -170,4 +182,90 @@ void DirectLightVolume::DrawShadowed(vec3 dir, vec3 col, DirectionalShadowData *
 	}
 
 	PrimitiveRenderer::GetInstance()->Draw<primitives::Quad>();
-}
\ No newline at end of file
+}
+
+ClusteredLightVolume::ClusteredLightVolume(){}
+ClusteredLightVolume::~ClusteredLightVolume()
+{
+	if (!IsInitialized)
+		return;
+	glDeleteTextures(BUFFER_COUNT, m_Textures);
+	glDeleteBuffers(BUFFER_COUNT, m_Buffers);
+	SafeDelete(m_pClusters);
+}
+void ClusteredLightVolume::Initialize()
+{
+	m_pClusters = new LightClusters(ivec3(16, 9, 24), TaskScheduler::GetInstance());
+	m_pShader = ContentManager::Load<ShaderData>("Shaders/FwdLightClusteredShader.glsl");
+
+	STATE->SetShader(m_pShader);
+	glUniform1i(glGetUniformLocation(m_pShader->GetProgram(), "texGBufferA"), 0);
+	glUniform1i(glGetUniformLocation(m_pShader->GetProgram(), "texGBufferB"), 1);
+	glUniform1i(glGetUniformLocation(m_pShader->GetProgram(), "texGBufferC"), 2);
+	glUniform1i(glGetUniformLocation(m_pShader->GetProgram(), "lightData"), 3);
+	glUniform1i(glGetUniformLocation(m_pShader->GetProgram(), "clusterData"), 4);
+	glUniform1i(glGetUniformLocation(m_pShader->GetProgram(), "lightIndices"), 5);
+	m_uCamPos = glGetUniformLocation(m_pShader->GetProgram(), "camPos");
+	m_uClusterCount = glGetUniformLocation(m_pShader->GetProgram(), "clusterCount");
+	m_uSliceScale = glGetUniformLocation(m_pShader->GetProgram(), "sliceScale");
+	m_uSliceBias = glGetUniformLocation(m_pShader->GetProgram(), "sliceBias");
+
+	//lights are two RGBA texels, clusters an offset and a count
+	const GLenum formats[BUFFER_COUNT] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	glGenBuffers(BUFFER_COUNT, m_Buffers);
+	glGenTextures(BUFFER_COUNT, m_Textures);
+	for (uint32 i = 0; i < BUFFER_COUNT; ++i)
+	{
+		STATE->BindBuffer(GL_TEXTURE_BUFFER, m_Buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+		STATE->LazyBindTexture(3 + i, GL_TEXTURE_BUFFER, m_Textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_Buffers[i]);
+	}
+
+	IsInitialized = true;
+}
+void ClusteredLightVolume::UploadBuffer(BufferIndex index, const void* pData, size_t size)
+{
+	//orphans the storage of last frame instead of waiting for the GPU to finish reading it
+	STATE->BindBuffer(GL_TEXTURE_BUFFER, m_Buffers[index]);
+	glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, size, pData);
+}
+void ClusteredLightVolume::Draw(const std::vector<LightClusters::PointLight> &lights)
+{
+	if (!IsInitialized) Initialize();
+
+	m_pClusters->SetProjection(CAMERA->GetProj(), CAMERA->GetNearPlane(), CAMERA->GetFarPlane());
+	m_pClusters->Build(CAMERA->GetView(), lights);
+	if (m_pClusters->GetLightIndices().empty())
+		return;
+
+	const std::vector<LightClusters::PointLight> &clusterLights = m_pClusters->GetLights();
+	const std::vector<LightClusters::Cluster> &clusters = m_pClusters->GetClusters();
+	const std::vector<uint32> &lightIndices = m_pClusters->GetLightIndices();
+	UploadBuffer(LIGHT_DATA, clusterLights.data(), clusterLights.size() * sizeof(LightClusters::PointLight));
+	UploadBuffer(CLUSTER_DATA, clusters.data(), clusters.size() * sizeof(LightClusters::Cluster));
+	UploadBuffer(LIGHT_INDICES, lightIndices.data(), lightIndices.size() * sizeof(uint32));
+
+	STATE->SetShader(m_pShader);
+	auto gbufferTex = RenderPipeline::GetInstance()->GetGBuffer()->GetTextures();
+	for (uint32 i = 0; i < (uint32)gbufferTex.size(); i++)
+	{
+		STATE->LazyBindTexture(i, GL_TEXTURE_2D, gbufferTex[i]->GetHandle());
+	}
+	for (uint32 i = 0; i < BUFFER_COUNT; ++i)
+	{
+		STATE->LazyBindTexture(3 + i, GL_TEXTURE_BUFFER, m_Textures[i]);
+	}
+	//for position reconstruction
+	glUniform1f(glGetUniformLocation(m_pShader->GetProgram(), "projectionA"), CAMERA->GetDepthProjA());
+	glUniform1f(glGetUniformLocation(m_pShader->GetProgram(), "projectionB"), CAMERA->GetDepthProjB());
+	glUniformMatrix4fv(glGetUniformLocation(m_pShader->GetProgram(), "viewProjInv"), 1, GL_FALSE, etm::valuePtr(CAMERA->GetStatViewProjInv()));
+	glUniform3fv(m_uCamPos, 1, etm::valuePtr(CAMERA->GetTransform()->GetPosition()));
+
+	glUniform3iv(m_uClusterCount, 1, etm::valuePtr(m_pClusters->GetDimensions()));
+	glUniform1f(m_uSliceScale, m_pClusters->GetSliceScale());
+	glUniform1f(m_uSliceBias, m_pClusters->GetSliceBias());
+
+	PrimitiveRenderer::GetInstance()->Draw<primitives::Quad>();
+}
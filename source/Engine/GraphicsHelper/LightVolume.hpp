@@ -1,5 +1,6 @@
 #pragma once
 #include "../StaticDependancies/glad/glad.h"
+#include "../Graphics/LightClusters.hpp"
 
 class ShaderData;
 class TextureData;
@@ -8,13 +9,14 @@ class NullMaterial;
 class MeshFilter;
 class DirectionalShadowData;
 
+//Draws the sphere volumes of all point lights with one instanced draw call, the instances are culled and packed by PointLightInstances
 class PointLightVolume : public Singleton<PointLightVolume>
 {
 public:
 	PointLightVolume();
 	virtual ~PointLightVolume();
 
-	void Draw(vec3 pos, float radius, vec3 col);
+	void Draw(const std::vector<LightClusters::PointLight> &instances);
 
 private:
 	friend class AbstractFramework; //should init and destroy singleton
@@ -23,6 +25,10 @@ private:
 
 	LightMaterial* m_pMaterial;
 	NullMaterial* m_pNullMaterial;
+
+	//texture buffer the vertex shader fetches the instances from
+	GLuint m_InstanceBuffer = 0;
+	GLuint m_InstanceTexture = 0;
 };
 
 class DirectLightVolume : public Singleton<DirectLightVolume>
@@ -45,4 +51,42 @@ private:
 	GLint m_uCol;
 	GLint m_uDir;
 	GLint m_uCamPos;
-};
\ No newline at end of file
+};
+
+//Shades every point light in one fullscreen pass, looking up the lights of each pixel in the clusters of the camera
+class ClusteredLightVolume : public Singleton<ClusteredLightVolume>
+{
+public:
+	ClusteredLightVolume();
+	virtual ~ClusteredLightVolume();
+
+	void Draw(const std::vector<LightClusters::PointLight> &lights);
+
+	const LightClusters* GetClusters() const { return m_pClusters; }
+
+private:
+	friend class AbstractFramework; //should init and destroy singleton
+	void Initialize();
+	bool IsInitialized = false;
+
+	enum BufferIndex
+	{
+		LIGHT_DATA,
+		CLUSTER_DATA,
+		LIGHT_INDICES,
+		BUFFER_COUNT
+	};
+	void UploadBuffer(BufferIndex index, const void* pData, size_t size);
+
+	LightClusters* m_pClusters = nullptr;
+	ShaderData* m_pShader = nullptr;
+
+	//texture buffers the shader fetches from
+	GLuint m_Buffers[BUFFER_COUNT];
+	GLuint m_Textures[BUFFER_COUNT];
+
+	GLint m_uCamPos;
+	GLint m_uClusterCount;
+	GLint m_uSliceScale;
+	GLint m_uSliceBias;
+};
@@ -14,6 +14,15 @@ void PrimitiveGeometry::RootDraw()
 	}
 	Draw();
 }
+void PrimitiveGeometry::RootDrawInstanced(uint32 instanceCount)
+{
+	if (!m_IsInitialized)
+	{
+		Initialize();
+		m_IsInitialized = true;
+	}
+	DrawInstanced(instanceCount);
+}
 
 PrimitiveRenderer::PrimitiveRenderer()
 {
@@ -61,6 +70,12 @@ void primitives::Quad::Draw()
 	STATE->DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 	STATE->BindVertexArray(0);
 }
+void primitives::Quad::DrawInstanced(uint32 instanceCount)
+{
+	STATE->BindVertexArray(m_VAO);
+	STATE->DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+	STATE->BindVertexArray(0);
+}
 void primitives::Quad::Initialize()
 {
 	GLfloat quadVertices[] = 
@@ -95,6 +110,12 @@ void primitives::Cube::Draw()
 	STATE->DrawArrays(GL_TRIANGLES, 0, 36);
 	STATE->BindVertexArray(0);
 }
+void primitives::Cube::DrawInstanced(uint32 instanceCount)
+{
+	STATE->BindVertexArray(m_VAO);
+	STATE->DrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount);
+	STATE->BindVertexArray(0);
+}
 void primitives::Cube::Initialize()
 {
 	GLfloat vertices[] = 
@@ -174,6 +195,13 @@ void primitives::IcoSphere<level>::Draw()
 	STATE->BindVertexArray(0);
 }
 template<int32 level>
+void primitives::IcoSphere<level>::DrawInstanced(uint32 instanceCount)
+{
+	STATE->BindVertexArray(m_VAO);
+	STATE->DrawArraysInstanced(GL_TRIANGLES, 0, m_NumVerts, instanceCount);
+	STATE->BindVertexArray(0);
+}
+template<int32 level>
 void primitives::IcoSphere<level>::Initialize()
 {
 	auto ico = GetIcosahedronPositions(1);
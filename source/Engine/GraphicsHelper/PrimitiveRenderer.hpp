@@ -12,8 +12,10 @@ public:
 
 	virtual const std::type_info& GetType() const = 0;
 	void RootDraw();
+	void RootDrawInstanced(uint32 instanceCount);
 protected:
 	virtual void Draw() = 0;
+	virtual void DrawInstanced(uint32 instanceCount) = 0;
 	virtual void Initialize() = 0;
 
 	bool m_IsInitialized = false;
@@ -39,6 +41,21 @@ public:
 		}
 	}
 
+	//one draw call for all instances, the shader tells them apart by gl_InstanceID
+	template<class T>
+	void DrawInstanced(uint32 instanceCount)
+	{
+		const std::type_info& ti = typeid(T);
+		for (PrimitiveGeometry* geometry : m_pTypes)
+		{
+			const std::type_info& gType = geometry->GetType();
+			if (gType == ti)
+			{
+				geometry->RootDrawInstanced(instanceCount);
+			}
+		}
+	}
+
 	void AddGeometry(PrimitiveGeometry* pGeometry);
 
 private:
@@ -57,6 +74,7 @@ namespace primitives
 		const std::type_info& GetType() const { return typeid(Quad); }
 	protected:
 		void Draw(); //vec3 pos, vec2 tc
+		void DrawInstanced(uint32 instanceCount);
 		void Initialize();
 	private:
 		GLuint m_VAO = 0;
@@ -71,6 +89,7 @@ namespace primitives
 		const std::type_info& GetType() const { return typeid(Cube); }
 	protected:
 		void Draw(); //vec3 pos, vec3 norm, vec2 tc
+		void DrawInstanced(uint32 instanceCount);
 		void Initialize();
 	private:
 		GLuint m_VAO = 0;
@@ -86,6 +105,7 @@ namespace primitives
 		const std::type_info& GetType() const { return typeid(IcoSphere<level>); }
 	protected:
 		void Draw(); //vec3 pos
+		void DrawInstanced(uint32 instanceCount);
 		void Initialize();
 	private:
 		// #todo: generate with index buffer
@@ -20,6 +20,7 @@
 #include "ScreenSpaceReflections.h"
 #include "DebugRenderer.h"
 #include "ScreenshotCapture.h"
+#include "SceneVisibility.hpp"
 
 RenderPipeline::RenderPipeline()
 {
@@ -28,6 +29,7 @@ RenderPipeline::~RenderPipeline()
 {
 	PointLightVolume::GetInstance()->DestroyInstance();
 	DirectLightVolume::GetInstance()->DestroyInstance();
+	ClusteredLightVolume::GetInstance()->DestroyInstance();
 	ShadowRenderer::GetInstance()->DestroyInstance();
 	TextRenderer::GetInstance()->DestroyInstance();
 	PerformanceInfo::GetInstance()->DestroyInstance();
@@ -40,6 +42,7 @@ RenderPipeline::~RenderPipeline()
 	ScreenshotCapture::GetInstance()->DestroyInstance();
 
 	SafeDelete(m_pSSR);
+	SafeDelete(m_pVisibility);
 	SafeDelete(m_pGBuffer);
 	SafeDelete(m_pPostProcessing);
 	SafeDelete(m_pState);
@@ -57,6 +60,7 @@ void RenderPipeline::Initialize()
 
 	PointLightVolume::GetInstance();
 	DirectLightVolume::GetInstance();
+	ClusteredLightVolume::GetInstance();
 
 	DebugRenderer::GetInstance()->Initialize();
 	ShadowRenderer::GetInstance()->Initialize();
@@ -76,6 +80,8 @@ void RenderPipeline::Initialize()
 	m_pSSR = new ScreenSpaceReflections();
 	m_pSSR->Initialize();
 
+	m_pVisibility = new SceneVisibility();
+
 	PbrPrefilter::GetInstance()->Precompute(GRAPHICS.PbrBrdfLutSize);
 
 	m_ClearColor = vec3(101.f / 255.f, 114.f / 255.f, 107.f / 255.f)*0.1f;
@@ -85,6 +91,7 @@ void RenderPipeline::Initialize()
 
 void RenderPipeline::DrawShadow()
 {
+	m_pVisibility->DrawShadow(ShadowRenderer::GetInstance()->GetCasterFrustum());
 	for (auto pScene : m_pRenderScenes)
 	{
 		for (Entity* pEntity : pScene->m_pEntityVec)
@@ -97,18 +104,22 @@ void RenderPipeline::DrawShadow()
 void RenderPipeline::Draw(std::vector<AbstractScene*> pScenes, GLuint outFBO)
 {
 	m_pRenderScenes = pScenes;
+	//Visibility
+	//**********
+	//the camera and every shadow cascade query the entity trees of the scenes for the models in their frustum
+	m_pVisibility->Gather(pScenes);
+	m_pVisibility->CullCamera(*(CAMERA->GetFrustum()), CAMERA->GetTransform()->GetPosition());
+	//before the G-Buffer pass, so hidden models never reach the GPU
+	m_pVisibility->CullOccluded(CAMERA->GetViewProj());
+
 	//Shadow Mapping
 	//**************
 	m_pState->SetDepthEnabled(true);
 	m_pState->SetCullEnabled(true);
 	m_pState->SetFaceCullingMode(GL_FRONT);//Maybe draw two sided materials in seperate pass
-	for (auto pScene : pScenes)
+	for (LightComponent* pLight : m_pVisibility->GetLights())
 	{
-		auto lightVec = pScene->GetLights(); //Todo: automatically add all light components to an array for faster access
-		for (auto Light : lightVec)
-		{
-			Light->GenerateShadow();
-		}
+		pLight->GenerateShadow();
 	}
 
 	//Deferred Rendering
@@ -131,6 +142,7 @@ void RenderPipeline::Draw(std::vector<AbstractScene*> pScenes, GLuint outFBO)
 			pEntity->RootDraw();
 		}
 	}
+	m_pVisibility->DrawDeferred();
 	m_pState->SetCullEnabled(false);
 	//Step two: blend data and calculate lighting with gbuffer
 	//STATE->BindFramebuffer( 0 );
@@ -159,13 +171,18 @@ void RenderPipeline::Draw(std::vector<AbstractScene*> pScenes, GLuint outFBO)
 	m_pState->SetCullEnabled(true);
 	m_pState->SetFaceCullingMode(GL_FRONT);
 
-	for (auto pScene : pScenes)
+	if (GRAPHICS.UseClusteredLighting)
 	{
-		auto lightVec = pScene->GetLights(); 
-		for (auto Light : lightVec)
-		{
-			Light->DrawVolume();
-		}
+		ClusteredLightVolume::GetInstance()->Draw(m_pVisibility->GetPointLights());
+	}
+	else
+	{
+		PointLightVolume::GetInstance()->Draw(m_pVisibility->GetPointLights());
+	}
+	//point lights don't draw their own volumes
+	for (LightComponent* pLight : m_pVisibility->GetLights())
+	{
+		pLight->DrawVolume();
 	}
 
 	m_pState->SetFaceCullingMode(GL_BACK);
@@ -203,6 +220,7 @@ void RenderPipeline::Draw(std::vector<AbstractScene*> pScenes, GLuint outFBO)
 			pEntity->RootDrawForward();
 		}
 	}
+	m_pVisibility->DrawForward();
 
 #if defined(EDITOR) || defined(_DEBUG)
 	DebugRenderer::GetInstance()->Draw();
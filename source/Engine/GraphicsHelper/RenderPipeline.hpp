@@ -4,6 +4,7 @@
 class AbstractScene;
 class RenderState;
 class ScreenSpaceReflections;
+class SceneVisibility;
 
 class RenderPipeline : public Singleton<RenderPipeline>
 {
@@ -23,6 +24,7 @@ public:
 	void SwapBuffers();
 
 	RenderState* GetState() { return m_pState; }
+	SceneVisibility* GetVisibility() { return m_pVisibility; }
 
 	void OnResize();
 
@@ -36,5 +38,6 @@ private:
 	Gbuffer* m_pGBuffer = nullptr;
 	PostProcessingRenderer* m_pPostProcessing = nullptr;
 	ScreenSpaceReflections* m_pSSR = nullptr;
+	SceneVisibility* m_pVisibility = nullptr;
 	vec3 m_ClearColor;
 };
\ No newline at end of file
@@ -259,6 +259,18 @@ void RenderState::DrawArrays(GLenum mode, uint32 first, uint32 count)
 	PERFORMANCE->m_DrawCalls++;
 }
 
+void RenderState::DrawArraysInstanced(GLenum mode, uint32 first, uint32 count, uint32 primcount)
+{
+	glDrawArraysInstanced(mode, first, count, primcount);
+	PERFORMANCE->m_DrawCalls++;
+}
+
+void RenderState::MultiDrawArrays(GLenum mode, const int32* firsts, const int32* counts, uint32 drawCount)
+{
+	glMultiDrawArrays(mode, firsts, counts, drawCount);
+	PERFORMANCE->m_DrawCalls++;
+}
+
 void RenderState::DrawElements(GLenum mode, uint32 count, GLenum type, const void * indices)
 {
 	glDrawElements(mode, count, type, indices);
@@ -18,6 +18,7 @@ public:
 	void SetBlendEnabled(bool enabled, uint32 index);
 	void SetBlendEnabled(const std::vector<bool> &blendBuffers);
 	void SetStencilEnabled(bool enabled) { EnOrDisAble(m_StencilTestEnabled, enabled, GL_STENCIL_TEST); }
+	void SetDepthClampEnabled(bool enabled) { EnOrDisAble(m_DepthClampEnabled, enabled, GL_DEPTH_CLAMP); }
 	void SetCullEnabled(bool enabled) { EnOrDisAble(m_CullFaceEnabled, enabled, GL_CULL_FACE); }
 
 	void SetFaceCullingMode(GLenum cullMode);
@@ -47,6 +48,8 @@ public:
 
 	//Draw Calls
 	void DrawArrays(GLenum mode, uint32 first, uint32 count);
+	void DrawArraysInstanced(GLenum mode, uint32 first, uint32 count, uint32 primcount);
+	void MultiDrawArrays(GLenum mode, const int32* firsts, const int32* counts, uint32 drawCount);
 	void DrawElements(GLenum mode, uint32 count, GLenum type, const void * indices);
 	void DrawElementsInstanced(GLenum mode, uint32 count, GLenum type, const void * indices, uint32 primcount);
 
@@ -64,6 +67,7 @@ private:
 	int32 m_MaxDrawBuffers; //Depends on gpu and drivers
 
 	bool m_DepthTestEnabled = false;
+	bool m_DepthClampEnabled = false;
 
 	bool m_CullFaceEnabled = false;
 	GLenum m_CullFaceMode = GL_BACK;
@@ -0,0 +1,170 @@
+#include "stdafx.hpp"
+#include "SceneVisibility.hpp"
+
+#include <algorithm>
+
+#include "../SceneGraph/AbstractScene.hpp"
+#include "../SceneGraph/Entity.hpp"
+#include "../SceneGraph/BoundingVolumeTree.hpp"
+#include "../Components/ModelComponent.hpp"
+#include "../Components/LightComponent.hpp"
+#include "../Graphics/Light.hpp"
+#include "../Graphics/MeshFilter.hpp"
+#include "../Graphics/OcclusionBuffer.hpp"
+#include "../Helper/TaskScheduler.hpp"
+
+SceneVisibility::SceneVisibility()
+{
+	m_pOcclusionBuffer = new OcclusionBuffer(ivec2(256, 128), TaskScheduler::GetInstance());
+}
+SceneVisibility::~SceneVisibility()
+{
+	SafeDelete(m_pOcclusionBuffer);
+}
+
+void SceneVisibility::Gather(const std::vector<AbstractScene*> &pScenes)
+{
+	m_pScenes = pScenes;
+	m_SphereOccluders.Clear();
+	m_pLights.clear();
+	m_PointLights.clear();
+	for (AbstractScene* pScene : pScenes)
+	{
+		//the entity trees are read by every view of this frame
+		pScene->UpdateTransforms();
+		for (Entity* pEntity : pScene->m_pEntityVec)
+		{
+			GatherOccluders(pEntity);
+		}
+		for (LightComponent* pLight : pScene->GetLights())
+		{
+			m_pLights.push_back(pLight);
+			PointLight* pPointLight = pLight->GetLight<PointLight>();
+			if (pPointLight)
+			{
+				m_PointLights.push_back(LightClusters::PointLight(pLight->GetTransform()->GetWorld()[3].xyz, pPointLight->GetRadius(),
+					pPointLight->GetColor() * pPointLight->GetBrightness()));
+			}
+		}
+	}
+}
+
+void SceneVisibility::QueryModels(const BatchFrustum &frustum, std::vector<ModelComponent*> &pModels)
+{
+	pModels.clear();
+	for (AbstractScene* pScene : m_pScenes)
+	{
+		pScene->GetEntityTree()->QueryFrustum(frustum, m_Proxies);
+		for (int32 proxy : m_Proxies)
+		{
+			Entity* pEntity = static_cast<Entity*>(pScene->GetEntityTree()->GetUserData(proxy));
+			for (ModelComponent* pModel : pEntity->GetComponents<ModelComponent>())
+			{
+				if (pModel->GetCullMode() != ModelComponent::CullMode::DISABLED && pModel->IsDrawable())
+				{
+					pModels.push_back(pModel);
+				}
+			}
+		}
+	}
+}
+
+void SceneVisibility::GatherOccluders(Entity* pEntity)
+{
+	Sphere sphere;
+	if (pEntity->GetOccluderSphere(sphere)) m_SphereOccluders.AddOccluder(sphere);
+	for (Entity* pChild : pEntity->m_pChildVec)
+	{
+		GatherOccluders(pChild);
+	}
+}
+
+void SceneVisibility::CullCamera(const Frustum &frustum, const vec3 &viewPosition)
+{
+	BatchFrustum batchFrustum(frustum.GetPlanes());
+	QueryModels(batchFrustum, m_pModels);
+
+	//the tree tests boxes around the bounding spheres, the spheres themselves are tested in one pass
+	m_IsForward.resize(m_pModels.size());
+	m_Centers.resize(m_pModels.size());
+	m_Radii.resize(m_pModels.size());
+	for (size_t i = 0; i < m_pModels.size(); ++i)
+	{
+		Sphere sphere = m_pModels[i]->GetWorldBoundingSphere();
+		m_Centers.set(i, sphere.pos);
+		m_Radii[i] = sphere.radius;
+		m_IsForward[i] = m_pModels[i]->IsForwardRendered();
+	}
+	batchFrustum.CollectVisibleSpheres(m_Centers, m_Radii, m_VisibleIndices);
+	m_FrustumVisibleCount = (uint32)m_VisibleIndices.size();
+	m_SphereOccluders.SetViewPosition(viewPosition);
+
+	m_VisibleDeferred.clear();
+	m_VisibleForward.clear();
+	for (uint32 index : m_VisibleIndices)
+	{
+		if (m_SphereOccluders.IsOccluded(Sphere(m_Centers.get(index), m_Radii[index]))) continue;
+		if (m_IsForward[index]) m_VisibleForward.push_back(index);
+		else m_VisibleDeferred.push_back(index);
+	}
+
+	m_PointLightInstances.Build(m_PointLights, batchFrustum, m_SphereOccluders);
+}
+
+void SceneVisibility::CullOccluded(const mat4 &viewProjection)
+{
+	//only opaque models hide what is behind them
+	m_pOcclusionBuffer->Begin(viewProjection);
+	bool hasOccluders = false;
+	for (uint32 index : m_VisibleDeferred)
+	{
+		ModelComponent* pModel = m_pModels[index];
+		if (!pModel->IsOccluder()) continue;
+		m_pOcclusionBuffer->AddOccluder(pModel->m_pMeshFilter->GetPositions(), pModel->m_pMeshFilter->GetIndices(),
+			pModel->GetTransform()->GetWorld());
+		hasOccluders = true;
+	}
+
+	if (hasOccluders)
+	{
+		m_pOcclusionBuffer->Rasterize();
+		//occluders are never tested, they would be hidden by their own depth
+		auto isOccluded = [this](uint32 index)
+		{
+			return !m_pModels[index]->IsOccluder()
+				&& m_pOcclusionBuffer->IsOccluded(AABB(Sphere(m_Centers.get(index), m_Radii[index])));
+		};
+		m_VisibleDeferred.erase(std::remove_if(m_VisibleDeferred.begin(), m_VisibleDeferred.end(), isOccluded), m_VisibleDeferred.end());
+		m_VisibleForward.erase(std::remove_if(m_VisibleForward.begin(), m_VisibleForward.end(), isOccluded), m_VisibleForward.end());
+	}
+
+	uint32 visibleCount = (uint32)(m_VisibleDeferred.size() + m_VisibleForward.size());
+	PERFORMANCE->m_VisibleModels = visibleCount;
+	//including the ones behind sphere occluders
+	PERFORMANCE->m_OccludedModels = m_FrustumVisibleCount - visibleCount;
+}
+
+void SceneVisibility::DrawDeferred()
+{
+	for (uint32 index : m_VisibleDeferred)
+	{
+		m_pModels[index]->DrawCall();
+	}
+}
+void SceneVisibility::DrawForward()
+{
+	for (uint32 index : m_VisibleForward)
+	{
+		m_pModels[index]->DrawCall();
+	}
+}
+
+void SceneVisibility::DrawShadow(const BatchFrustum &casterFrustum)
+{
+	//casters are kept apart from the camera lists, which are drawn after the shadow maps
+	QueryModels(casterFrustum, m_pCasters);
+	for (ModelComponent* pModel : m_pCasters)
+	{
+		pModel->DrawShadowCall();
+	}
+}
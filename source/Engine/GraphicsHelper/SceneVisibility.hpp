@@ -0,0 +1,88 @@
+#pragma once
+#include "../Graphics/BatchFrustum.hpp"
+#include "../Graphics/SphereOccluders.hpp"
+#include "../Graphics/PointLightInstances.hpp"
+
+class AbstractScene;
+class Entity;
+class ModelComponent;
+class LightComponent;
+class OcclusionBuffer;
+
+//Scene Visibility
+//****************
+
+// Each view (the camera and every shadow cascade) queries the entity trees of the rendered scenes for the culled models in its frustum.
+// The camera tests the world bounds of those models in one linear pass and draws from the compacted list of visible models.
+// Models with culling disabled are not gathered and keep being drawn with their entities.
+// Models completely hidden behind the spheres of planets are dropped analytically, see SphereOccluders.
+// Lights are gathered in the same pass, and the point lights the camera sees are packed for clustered shading or instanced light volumes.
+// Models marked as occluders that the camera sees are rasterized on the CPU, and the other visible models hidden behind them are not drawn.
+
+class SceneVisibility
+{
+public:
+	SceneVisibility();
+	~SceneVisibility();
+
+	void Gather(const std::vector<AbstractScene*> &pScenes);
+
+	//splits the models visible to the camera into the deferred and forward lists, without the ones behind sphere occluders
+	void CullCamera(const Frustum &frustum, const vec3 &viewPosition);
+	//removes models hidden behind the visible occluders from both lists
+	void CullOccluded(const mat4 &viewProjection);
+	void DrawDeferred();
+	void DrawForward();
+
+	//draws the shadow casters that intersect the volume of a cascade
+	void DrawShadow(const BatchFrustum &casterFrustum);
+
+	//set up for the camera by CullCamera, light volumes and atmospheres are tested against them too
+	const SphereOccluders& GetSphereOccluders() const { return m_SphereOccluders; }
+
+	//lights on all entities of the rendered scenes, children included
+	const std::vector<LightComponent*>& GetLights() const { return m_pLights; }
+	//point lights in world space inside the camera frustum and not hidden behind sphere occluders
+	const std::vector<LightClusters::PointLight>& GetPointLights() const { return m_PointLightInstances.GetInstances(); }
+
+	size_t GetModelCount() const { return m_pModels.size(); }
+	const std::vector<uint32>& GetVisibleDeferred() const { return m_VisibleDeferred; }
+	const std::vector<uint32>& GetVisibleForward() const { return m_VisibleForward; }
+
+private:
+	void GatherOccluders(Entity* pEntity);
+	//drawable models with culling enabled on the entities whose proxies intersect the frustum
+	void QueryModels(const BatchFrustum &frustum, std::vector<ModelComponent*> &pModels);
+
+	std::vector<AbstractScene*> m_pScenes;
+	std::vector<int32> m_Proxies;
+	std::vector<ModelComponent*> m_pCasters;
+
+	std::vector<ModelComponent*> m_pModels;
+	std::vector<bool> m_IsForward;
+	vec3soa m_Centers;
+	std::vector<float> m_Radii;
+
+	std::vector<uint32> m_VisibleDeferred;
+	std::vector<uint32> m_VisibleForward;
+	//reused by every view to avoid allocating each frame
+	std::vector<uint32> m_VisibleIndices;
+	//inside the camera frustum, before occlusion culling
+	uint32 m_FrustumVisibleCount = 0;
+
+	SphereOccluders m_SphereOccluders;
+
+	std::vector<LightComponent*> m_pLights;
+	std::vector<LightClusters::PointLight> m_PointLights;
+	PointLightInstances m_PointLightInstances;
+
+	OcclusionBuffer* m_pOcclusionBuffer = nullptr;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	SceneVisibility(const SceneVisibility& obj);
+	SceneVisibility& operator=(const SceneVisibility& obj);
+};
@@ -36,6 +36,8 @@ void ShadowRenderer::MapDirectional(TransformComponent *pTransform, DirectionalS
 	FrustumCorners corners = CAMERA->GetFrustum()->GetCorners();
 	corners.Transform(lightView);
 
+	//casters between the light and a cascade are flattened onto its near plane instead of being clipped
+	STATE->SetDepthClampEnabled(true);
 	for (int32 i = 0; i < GRAPHICS.NumCascades; i++)
 	{
 		//calculate orthographic projection matrix based on cascade
@@ -75,6 +77,10 @@ void ShadowRenderer::MapDirectional(TransformComponent *pTransform, DirectionalS
 		m_LightVP = lightView * lightProjection;
 		pShadowData->m_Cascades[i].lightVP = m_LightVP;
 
+		//only casters that intersect the cascade are drawn into it, including ones outside of it toward the light
+		m_CasterFrustum.SetViewProjection(m_LightVP);
+		m_CasterFrustum.ExtendPlane(BatchFrustum::NEAR_PLANE, GRAPHICS.CSMDrawDistance);
+
 		//Set viewport
 		ivec2 res = pShadowData->m_Cascades[i].pTexture->GetResolution();
 		STATE->SetViewport(ivec2(0), res);
@@ -86,6 +92,7 @@ void ShadowRenderer::MapDirectional(TransformComponent *pTransform, DirectionalS
 		//Draw scene with light matrix and null material
 		RenderPipeline::GetInstance()->DrawShadow();
 	}
+	STATE->SetDepthClampEnabled(false);
 }
 
 DirectionalShadowData::DirectionalShadowData(ivec2 Resolution)
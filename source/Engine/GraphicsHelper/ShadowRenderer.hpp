@@ -1,5 +1,6 @@
 #pragma once
 #include "../StaticDependancies/glad/glad.h"
+#include "../Graphics/BatchFrustum.hpp"
 
 class ShaderData;
 class TextureData;
@@ -16,6 +17,8 @@ public:
 
 	void MapDirectional(TransformComponent *pTransform, DirectionalShadowData *pShadowData);
 	mat4 GetLightVP() { return m_LightVP; }
+	//volume of the cascade that is being drawn, extended toward the light
+	const BatchFrustum& GetCasterFrustum() const { return m_CasterFrustum; }
 	NullMaterial* GetNullMaterial() { return m_pMaterial; }
 
 private:
@@ -28,6 +31,7 @@ private:
 
 	NullMaterial* m_pMaterial;
 	mat4 m_LightVP;
+	BatchFrustum m_CasterFrustum;
 };
 
 class DirectionalShadowData
@@ -62,7 +62,7 @@ void SpriteRenderer::Initialize()
 	//Create empty dummy texture
 	m_EmptyTex = new TextureData( 1, 1, GL_RGB, GL_RGB, GL_FLOAT );
 
-	m_EmptyTex->Build( (void*)(vec4(1).data.data()) );
+	m_EmptyTex->Build( (void*)etm::valuePtr(vec4(1)) );
 
 	TextureParameters params( true );
 	params.minFilter = GL_NEAREST;
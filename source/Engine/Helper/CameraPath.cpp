@@ -0,0 +1,73 @@
+#include "stdafx.hpp"
+#include "CameraPath.hpp"
+
+#include <sstream>
+#include <iomanip>
+
+#include "../FileSystem/Entry.h"
+#include "../FileSystem/FileUtil.h"
+
+std::string CameraPath::ToText() const
+{
+	std::ostringstream stream;
+	//enough digits for the floats to read back exactly
+	stream << std::setprecision(9);
+	stream << "# position xyz, forward xyz, fov, aspect ratio\n";
+	for (const CameraPathFrame &frame : m_Frames)
+	{
+		stream << frame.position.x << ' ' << frame.position.y << ' ' << frame.position.z << ' '
+			<< frame.forward.x << ' ' << frame.forward.y << ' ' << frame.forward.z << ' '
+			<< frame.fov << ' ' << frame.aspectRatio << '\n';
+	}
+	return stream.str();
+}
+
+bool CameraPath::FromText(const std::string &text)
+{
+	m_Frames.clear();
+	for (const std::string &line : FileUtil::ParseLines(text))
+	{
+		if (line.empty() || line[0] == '#') continue;
+
+		std::istringstream stream(line);
+		CameraPathFrame frame;
+		stream >> frame.position.x >> frame.position.y >> frame.position.z
+			>> frame.forward.x >> frame.forward.y >> frame.forward.z
+			>> frame.fov >> frame.aspectRatio;
+		if (stream.fail())
+		{
+			LOG("CameraPath::FromText > Couldn't read frame '" + line + "'", Warning);
+			return false;
+		}
+		m_Frames.push_back(frame);
+	}
+	return true;
+}
+
+bool CameraPath::Load(const std::string &fileName)
+{
+	File* pFile = new File(fileName, nullptr);
+	if (!pFile->Open(FILE_ACCESS_MODE::Read))
+	{
+		SafeDelete(pFile);
+		return false;
+	}
+	std::string text = FileUtil::AsText(pFile->Read());
+	SafeDelete(pFile);
+	return FromText(text);
+}
+
+bool CameraPath::Save(const std::string &fileName) const
+{
+	File* pFile = new File(fileName, nullptr);
+	FILE_ACCESS_FLAGS flags;
+	flags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Create | FILE_ACCESS_FLAGS::FLAGS::Truncate);
+	if (!pFile->Open(FILE_ACCESS_MODE::Write, flags))
+	{
+		SafeDelete(pFile);
+		return false;
+	}
+	bool result = pFile->Write(FileUtil::FromText(ToText()));
+	SafeDelete(pFile);
+	return result;
+}
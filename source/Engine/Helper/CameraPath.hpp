@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//Camera Path
+//***********
+
+// A recorded camera flight, so the same views can be replayed without a window, for example to benchmark the planet triangulation.
+// Stored as text with one frame per line: position xyz, forward xyz, field of view in degrees and aspect ratio.
+
+struct CameraPathFrame
+{
+	vec3 position;
+	vec3 forward;
+	float fov = 45.f;
+	float aspectRatio = 16.f / 9.f;
+};
+
+class CameraPath
+{
+public:
+	void AddFrame(const CameraPathFrame &frame) { m_Frames.push_back(frame); }
+	const std::vector<CameraPathFrame> &GetFrames() const { return m_Frames; }
+	void Clear() { m_Frames.clear(); }
+
+	std::string ToText() const;
+	//lines that are empty or start with # are skipped, returns false if a line couldn't be read
+	bool FromText(const std::string &text);
+
+	bool Load(const std::string &fileName);
+	bool Save(const std::string &fileName) const;
+
+private:
+	std::vector<CameraPathFrame> m_Frames;
+};
@@ -9,6 +9,10 @@ public:
 	uint32 m_DrawCalls = 0;
 	uint32 m_PrevDrawCalls = 0;
 
+	//models in the camera frustum of the last frame, split by the occlusion test
+	uint32 m_VisibleModels = 0;
+	uint32 m_OccludedModels = 0;
+
 	int32 GetRegularFPS() { return m_RegularFPS; }
 	float GetFrameMS() { return m_FrameMS; }
 
@@ -0,0 +1,230 @@
+#include "stdafx.hpp"
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+
+thread_local TaskScheduler* TaskScheduler::s_pWorkerScheduler = nullptr;
+thread_local TaskScheduler* TaskScheduler::s_pInlineScheduler = nullptr;
+thread_local std::vector<TaskScheduler::Task> TaskScheduler::s_InlineTasks;
+
+TaskScheduler::TaskScheduler(uint32 workerCount)
+	: m_PendingTasks(0)
+	, m_QueuedTasks(0)
+	, m_SleepingWorkers(0)
+	, m_IsRunning(false)
+	, m_Submitter(std::thread::id())
+{
+	if (workerCount == 0)
+	{
+		workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	for (uint32 worker = 0; worker < workerCount; ++worker)
+	{
+		m_Workers.push_back(new Worker());
+	}
+	//worker 0 is whichever thread calls Run
+	for (uint32 worker = 1; worker < workerCount; ++worker)
+	{
+		m_Threads.push_back(std::thread(&TaskScheduler::WorkerThread, this, worker));
+	}
+}
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_RunMutex);
+		m_IsShuttingDown = true;
+	}
+	m_RunCondition.notify_all();
+	for (std::thread &thread : m_Threads)
+	{
+		thread.join();
+	}
+	for (Worker* pWorker : m_Workers)
+	{
+		SafeDelete(pWorker);
+	}
+}
+
+void TaskScheduler::Push(uint32 worker, const Task &task)
+{
+	if (!AcquireSubmission())
+	{
+		s_InlineTasks.push_back(task);
+		return;
+	}
+
+	//counted before it is visible, so the pending count can't reach zero while the task is queued
+	++m_PendingTasks;
+	if (!m_IsRunning.load())
+	{
+		std::lock_guard<std::mutex> lock(m_RunMutex);
+		m_StagedTasks.push_back(std::make_pair(worker, task));
+		return;
+	}
+
+	{
+		Worker* pWorker = m_Workers[worker];
+		std::lock_guard<std::mutex> lock(pWorker->mutex);
+		pWorker->tasks.push_back(task);
+	}
+	++m_QueuedTasks;
+	//a sleeping worker registers before it checks the queue count, so either it sees the task or it is woken here
+	if (m_SleepingWorkers.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_RunMutex);
+		}
+		m_WorkCondition.notify_one();
+	}
+}
+
+void TaskScheduler::Run()
+{
+	if (s_pInlineScheduler == this)
+	{
+		RunInline();
+		return;
+	}
+	//nothing was pushed by this thread
+	if (m_Submitter.load() != std::this_thread::get_id()) return;
+
+	uint32 runIndex;
+	{
+		std::lock_guard<std::mutex> lock(m_RunMutex);
+		runIndex = ++m_RunIndex;
+		for (const std::pair<uint32, Task> &staged : m_StagedTasks)
+		{
+			Worker* pWorker = m_Workers[staged.first];
+			std::lock_guard<std::mutex> workerLock(pWorker->mutex);
+			pWorker->tasks.push_back(staged.second);
+		}
+		m_QueuedTasks += (uint32)m_StagedTasks.size();
+		m_StagedTasks.clear();
+		if (m_PendingTasks.load() == 0)
+		{
+			m_FinishedRunIndex = runIndex;
+		}
+		else
+		{
+			m_IsRunning = true;
+		}
+	}
+	m_RunCondition.notify_all();
+	ExecuteTasks(0, runIndex);
+
+	m_Submitter = std::thread::id();
+	m_SubmitMutex.unlock();
+}
+
+bool TaskScheduler::AcquireSubmission()
+{
+	//tasks that run on the workers push more tasks for the same run
+	if (s_pWorkerScheduler == this || m_Submitter.load() == std::this_thread::get_id()) return true;
+	if (s_pInlineScheduler == this) return false;
+
+	//don't wait for the run of another thread, the frame or the async generation that pushes here shouldn't stall behind it
+	if (m_SubmitMutex.try_lock())
+	{
+		m_Submitter = std::this_thread::get_id();
+		return true;
+	}
+	s_pInlineScheduler = this;
+	return false;
+}
+
+void TaskScheduler::RunInline()
+{
+	//newest first, like a worker takes its own tasks
+	while (!s_InlineTasks.empty())
+	{
+		Task task = s_InlineTasks.back();
+		s_InlineTasks.pop_back();
+		task(0);
+	}
+	s_pInlineScheduler = nullptr;
+}
+
+void TaskScheduler::execute(const size_t numRanges, const std::function<void(size_t rangeIdx)> &run)
+{
+	for (size_t rangeIdx = 0; rangeIdx < numRanges; ++rangeIdx)
+	{
+		Push(0, [&run, rangeIdx](uint32) { run(rangeIdx); });
+	}
+	Run();
+}
+
+void TaskScheduler::WorkerThread(uint32 worker)
+{
+	s_pWorkerScheduler = this;
+	uint32 runIndex = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_RunMutex);
+			m_RunCondition.wait(lock, [this, runIndex]() { return m_IsShuttingDown || m_RunIndex != runIndex; });
+			if (m_IsShuttingDown) return;
+			runIndex = m_RunIndex;
+		}
+		ExecuteTasks(worker, runIndex);
+	}
+}
+
+void TaskScheduler::ExecuteTasks(uint32 worker, uint32 runIndex)
+{
+	Task task;
+	for (;;)
+	{
+		if (PopTask(worker, task))
+		{
+			task(worker);
+			if (--m_PendingTasks == 0)
+			{
+				//the last task ends whichever run is current, even if this worker joined it late
+				{
+					std::lock_guard<std::mutex> lock(m_RunMutex);
+					m_IsRunning = false;
+					m_FinishedRunIndex = m_RunIndex;
+				}
+				m_WorkCondition.notify_all();
+			}
+			continue;
+		}
+
+		//nothing left to steal, sleep until a running task pushes more or the last one is done
+		std::unique_lock<std::mutex> lock(m_RunMutex);
+		++m_SleepingWorkers;
+		m_WorkCondition.wait(lock, [this, runIndex]() { return m_QueuedTasks.load() > 0 || m_FinishedRunIndex >= runIndex; });
+		--m_SleepingWorkers;
+		if (m_FinishedRunIndex >= runIndex) return;
+	}
+}
+
+bool TaskScheduler::PopTask(uint32 worker, Task &task)
+{
+	//newest own task first, it most likely works on data that is still in the cache
+	{
+		Worker* pWorker = m_Workers[worker];
+		std::lock_guard<std::mutex> lock(pWorker->mutex);
+		if (!pWorker->tasks.empty())
+		{
+			task = pWorker->tasks.back();
+			pWorker->tasks.pop_back();
+			--m_QueuedTasks;
+			return true;
+		}
+	}
+	//steal the oldest task of another worker, which is usually the biggest one
+	for (uint32 offset = 1; offset < (uint32)m_Workers.size(); ++offset)
+	{
+		Worker* pVictim = m_Workers[(worker + offset) % m_Workers.size()];
+		std::lock_guard<std::mutex> lock(pVictim->mutex);
+		if (!pVictim->tasks.empty())
+		{
+			task = pVictim->tasks.front();
+			pVictim->tasks.pop_front();
+			--m_QueuedTasks;
+			return true;
+		}
+	}
+	return false;
+}
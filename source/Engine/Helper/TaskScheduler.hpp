@@ -0,0 +1,95 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+#include "Singleton.hpp"
+
+//Task Scheduler
+//**************
+
+// Runs tasks on a fixed set of worker threads, tasks can push more tasks while they run.
+// Every worker has its own deque, it takes its newest task first and steals the oldest task of another worker once it runs out,
+// so a task that turns out to be large gets split up across threads while small ones stay on the thread that created them.
+// It also serves as the executor for parallel etm batch operations.
+// The instance from GetInstance is shared by all engine systems, so the hardware threads aren't oversubscribed by private pools.
+// Only one thread submits tasks at a time, another thread that pushes tasks meanwhile runs them itself once it calls Run.
+
+class TaskScheduler : public etm::batch_executor, public Singleton<TaskScheduler>
+{
+public:
+	typedef std::function<void(uint32 worker)> Task;
+
+	//the worker count includes the thread calling Run, 0 creates one worker per hardware thread
+	TaskScheduler(uint32 workerCount = 0);
+	~TaskScheduler();
+
+	uint32 GetWorkerCount() const { return (uint32)m_Workers.size(); }
+
+	//from inside a task with the worker index it received, or before Run with any index
+	//tasks pushed before Run are held back until Run starts, so workers never pick them up early
+	void Push(uint32 worker, const Task &task);
+	//Blocks until all tasks including the ones they pushed are done, the calling thread works as worker 0
+	//workers that run out of tasks sleep until another task is pushed or the run is over
+	void Run();
+
+	//batch executor interface - runs every range as a task, don't call it from inside a task of the same scheduler
+	size_t concurrency() const override { return m_Workers.size(); }
+	void execute(const size_t numRanges, const std::function<void(size_t rangeIdx)> &run) override;
+
+private:
+	struct Worker
+	{
+		std::deque<Task> tasks;
+		std::mutex mutex;
+	};
+
+	//true if the tasks this thread pushes go to the workers, false if it runs them itself
+	bool AcquireSubmission();
+	void RunInline();
+
+	void WorkerThread(uint32 worker);
+	void ExecuteTasks(uint32 worker, uint32 runIndex);
+	bool PopTask(uint32 worker, Task &task);
+
+	std::vector<Worker*> m_Workers;
+	std::vector<std::thread> m_Threads;
+
+	//pushed before Run, with the worker they were pushed to
+	std::vector<std::pair<uint32, Task>> m_StagedTasks;
+
+	//tasks that aren't finished, and tasks that sit in a worker deque
+	std::atomic<uint32> m_PendingTasks;
+	std::atomic<uint32> m_QueuedTasks;
+	std::atomic<uint32> m_SleepingWorkers;
+	std::atomic<bool> m_IsRunning;
+
+	std::mutex m_RunMutex;
+	//signals a new run or the shutdown to idle worker threads
+	std::condition_variable m_RunCondition;
+	//signals a pushed task or the end of the run to workers inside a run
+	std::condition_variable m_WorkCondition;
+	uint32 m_RunIndex = 0;
+	uint32 m_FinishedRunIndex = 0;
+	bool m_IsShuttingDown = false;
+
+	//held by the submitting thread from its first push until its run is done
+	std::mutex m_SubmitMutex;
+	std::atomic<std::thread::id> m_Submitter;
+
+	static thread_local TaskScheduler* s_pWorkerScheduler;
+	//tasks of a thread that pushed while another thread was submitting, with worker 0 like the caller of Run gets
+	static thread_local TaskScheduler* s_pInlineScheduler;
+	static thread_local std::vector<Task> s_InlineTasks;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	TaskScheduler(const TaskScheduler& obj);
+	TaskScheduler& operator=(const TaskScheduler& obj);
+};
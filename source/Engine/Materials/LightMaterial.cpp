@@ -7,9 +7,8 @@
 #include "../Framebuffers/Gbuffer.hpp"
 #include "../GraphicsHelper/RenderPipeline.hpp"
 
-LightMaterial::LightMaterial(vec3 col):
-	Material("Shaders/FwdLightPointShader.glsl"),
-	m_Color(col)
+LightMaterial::LightMaterial():
+	Material("Shaders/FwdLightPointShader.glsl")
 {
 	m_LayoutFlags = VertexFlags::POSITION;
 	m_DrawForward = true;
@@ -23,10 +22,6 @@ void LightMaterial::LoadTextures()
 }
 void LightMaterial::AccessShaderAttributes()
 {
-	m_uCol = glGetUniformLocation(m_Shader->GetProgram(), "Color");
-	m_uPosition = glGetUniformLocation(m_Shader->GetProgram(), "Position");
-	m_uRadius = glGetUniformLocation(m_Shader->GetProgram(), "Radius");
-
 	m_uCamPos = glGetUniformLocation(m_Shader->GetProgram(), "camPos");
 	m_uProjA = glGetUniformLocation(m_Shader->GetProgram(), "projectionA");
 	m_uProjB = glGetUniformLocation(m_Shader->GetProgram(), "projectionB");
@@ -37,6 +32,7 @@ void LightMaterial::UploadDerivedVariables()
 	glUniform1i(glGetUniformLocation(m_Shader->GetProgram(), "texGBufferA"), 0);
 	glUniform1i(glGetUniformLocation(m_Shader->GetProgram(), "texGBufferB"), 1);
 	glUniform1i(glGetUniformLocation(m_Shader->GetProgram(), "texGBufferC"), 2);
+	glUniform1i(glGetUniformLocation(m_Shader->GetProgram(), "lightData"), 3);
 	auto gbufferTex = RenderPipeline::GetInstance()->GetGBuffer()->GetTextures();
 	for (uint32 i = 0; i < (uint32)gbufferTex.size(); i++)
 	{
@@ -48,7 +44,5 @@ void LightMaterial::UploadDerivedVariables()
 	glUniformMatrix4fv(m_uViewProjInv, 1, GL_FALSE, etm::valuePtr(CAMERA->GetStatViewProjInv()));
 	glUniform3fv(m_uCamPos, 1, etm::valuePtr(CAMERA->GetTransform()->GetPosition()));
 
-	glUniform3f(m_uPosition, m_Position.x, m_Position.y, m_Position.z);
-	glUniform3f(m_uCol, m_Color.x, m_Color.y, m_Color.z);
-	glUniform1f(m_uRadius, m_Radius);
+	STATE->LazyBindTexture(3, GL_TEXTURE_BUFFER, m_LightData);
 }
\ No newline at end of file
@@ -4,15 +4,11 @@
 class LightMaterial : public Material
 {
 public:
-	LightMaterial(vec3 col = vec3(1, 1, 1));
+	LightMaterial();
 	~LightMaterial();
 
-	void SetLight(vec3 pos, vec3 color, float radius)
-	{
-		m_Position = pos;
-		m_Color = color;
-		m_Radius = radius;
-	}
+	//texture buffer with two RGBA texels per light, see PointLightInstances
+	void SetLightData(GLuint texture) { m_LightData = texture; }
 private:
 	void LoadTextures();
 	void AccessShaderAttributes();
@@ -21,12 +17,7 @@ private:
 
 private:
 	//Parameters
-	GLint m_uCol;
-	vec3 m_Color;
-	GLint m_uPosition;
-	vec3 m_Position;
-	GLint m_uRadius;
-	float m_Radius;
+	GLuint m_LightData = 0;
 
 	GLint m_uCamPos;
 
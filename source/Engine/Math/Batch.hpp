@@ -0,0 +1,354 @@
+#pragma once
+
+#include "Vector.hpp"
+#include "Matrix.hpp"
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+#include <limits>
+
+//ETEngine math
+namespace etm
+{
+	//Structure of arrays
+	//*******************
+
+	// Stores a list of vectors with every component in its own contiguous array, so that batch operations can work on
+	// 4 (SSE) elements at a time without shuffling
+
+	template <uint8 n, class T>
+	struct soa
+	{
+		//members
+		std::array<std::vector<T>, n> components;
+
+		//constructors
+		soa() = default;
+		explicit soa(const size_t count) { resize(count); }
+		explicit soa(const std::vector<vector<n, T>> &vectors)
+		{
+			resize(vectors.size());
+			for (size_t i = 0; i < vectors.size(); ++i)
+			{
+				set(i, vectors[i]);
+			}
+		}
+
+		size_t size() const { return components[0].size(); }
+		void resize(const size_t count)
+		{
+			for (auto &component : components)
+			{
+				component.resize(count);
+			}
+		}
+
+		void set(const size_t index, const vector<n, T> &vec)
+		{
+			for (uint8 i = 0; i < n; ++i)
+			{
+				components[i][index] = vec[i];
+			}
+		}
+		vector<n, T> get(const size_t index) const
+		{
+			vector<n, T> ret;
+			for (uint8 i = 0; i < n; ++i)
+			{
+				ret[i] = components[i][index];
+			}
+			return ret;
+		}
+
+		//access to a component array
+		T* operator[](const uint8 component) { return components[component].data(); }
+		T const* operator[](const uint8 component) const { return components[component].data(); }
+	};
+
+	//Batch executor
+	//**************
+
+	// Runs the ranges of a parallel batch on an existing thread pool, so batch operations never start threads themselves
+	// execute has to call run(rangeIdx) once for every rangeIdx in [0, numRanges) and only return after all of them are done
+
+	class batch_executor
+	{
+	public:
+		virtual ~batch_executor() = default;
+
+		//number of ranges that can run at the same time
+		virtual size_t concurrency() const = 0;
+		virtual void execute(const size_t numRanges, const std::function<void(size_t rangeIdx)> &run) = 0;
+	};
+
+	namespace detail
+	{
+		//Elements processed by a single thread before parallel batches are worth splitting up
+		static const size_t BATCH_PARALLEL_GRAIN = 16384;
+
+		//Number of ranges a batch of count elements is split into
+		inline size_t NumRanges(const size_t count, batch_executor* const executor)
+		{
+			const size_t numThreads = executor ? std::max(executor->concurrency(), static_cast<size_t>(1)) : 1;
+			if (numThreads == 1 || count < BATCH_PARALLEL_GRAIN * 2)
+			{
+				return 1;
+			}
+			return std::min(numThreads, count / BATCH_PARALLEL_GRAIN);
+		}
+
+		//Splits [0, count) into ranges that are multiples of 4 elements and calls func(begin, end, rangeIdx) on each of them
+		//if there is more than one range, they are handed to the executor
+		template <class TFunc>
+		void ForRanges(const size_t count, batch_executor* const executor, TFunc func)
+		{
+			const size_t numRanges = NumRanges(count, executor);
+			if (numRanges == 1)
+			{
+				func(static_cast<size_t>(0), count, static_cast<size_t>(0));
+				return;
+			}
+
+			const size_t rangeSize = ((count / numRanges) + 3) & ~static_cast<size_t>(3);
+			executor->execute(numRanges, [&](size_t rangeIdx)
+			{
+				const size_t begin = rangeIdx * rangeSize;
+				const size_t end = (rangeIdx == numRanges - 1) ? count : begin + rangeSize;
+				func(begin, end, rangeIdx);
+			});
+		}
+
+		//Kernels
+		//*******
+		// All of them work on the range [begin, end) and keep the scalar order of operations, so the SIMD and scalar paths agree
+
+		inline void TransformRange(const matrix<4, 4, float> &mat,
+			const float* inX, const float* inY, const float* inZ, const float* inW, const float w,
+			float* outX, float* outY, float* outZ, float* outW, const size_t begin, const size_t end)
+		{
+			size_t i = begin;
+#ifdef ETM_SIMD_SSE
+			__m128 m[4][4];
+			for (uint8 row = 0; row < 4; ++row)
+			{
+				for (uint8 col = 0; col < 4; ++col)
+				{
+					m[row][col] = _mm_set1_ps(mat.data[row][col]);
+				}
+			}
+			const __m128 wConst = _mm_set1_ps(w);
+			for (; i + 4 <= end; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(inX + i);
+				__m128 y = _mm_loadu_ps(inY + i);
+				__m128 z = _mm_loadu_ps(inZ + i);
+				__m128 wIn = inW ? _mm_loadu_ps(inW + i) : wConst;
+
+				_mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][0]), _mm_mul_ps(y, m[1][0])), _mm_mul_ps(z, m[2][0])), _mm_mul_ps(wIn, m[3][0])));
+				_mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][1]), _mm_mul_ps(y, m[1][1])), _mm_mul_ps(z, m[2][1])), _mm_mul_ps(wIn, m[3][1])));
+				_mm_storeu_ps(outZ + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][2]), _mm_mul_ps(y, m[1][2])), _mm_mul_ps(z, m[2][2])), _mm_mul_ps(wIn, m[3][2])));
+				if (outW)
+				{
+					_mm_storeu_ps(outW + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][3]), _mm_mul_ps(y, m[1][3])), _mm_mul_ps(z, m[2][3])), _mm_mul_ps(wIn, m[3][3])));
+				}
+			}
+#endif
+			for (; i < end; ++i)
+			{
+				const float x = inX[i];
+				const float y = inY[i];
+				const float z = inZ[i];
+				const float wIn = inW ? inW[i] : w;
+				outX[i] = x * mat.data[0][0] + y * mat.data[1][0] + z * mat.data[2][0] + wIn * mat.data[3][0];
+				outY[i] = x * mat.data[0][1] + y * mat.data[1][1] + z * mat.data[2][1] + wIn * mat.data[3][1];
+				outZ[i] = x * mat.data[0][2] + y * mat.data[1][2] + z * mat.data[2][2] + wIn * mat.data[3][2];
+				if (outW)
+				{
+					outW[i] = x * mat.data[0][3] + y * mat.data[1][3] + z * mat.data[2][3] + wIn * mat.data[3][3];
+				}
+			}
+		}
+
+		inline void DotRange(const float* aX, const float* aY, const float* aZ,
+			const float* bX, const float* bY, const float* bZ, float* out, const bool root, const size_t begin, const size_t end)
+		{
+			size_t i = begin;
+#ifdef ETM_SIMD_SSE
+			for (; i + 4 <= end; i += 4)
+			{
+				__m128 result = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(_mm_loadu_ps(aX + i), _mm_loadu_ps(bX + i)),
+					_mm_mul_ps(_mm_loadu_ps(aY + i), _mm_loadu_ps(bY + i))),
+					_mm_mul_ps(_mm_loadu_ps(aZ + i), _mm_loadu_ps(bZ + i)));
+				_mm_storeu_ps(out + i, root ? _mm_sqrt_ps(result) : result);
+			}
+#endif
+			for (; i < end; ++i)
+			{
+				const float result = aX[i] * bX[i] + aY[i] * bY[i] + aZ[i] * bZ[i];
+				out[i] = root ? std::sqrt(result) : result;
+			}
+		}
+
+		inline void NormalizeRange(const float* inX, const float* inY, const float* inZ,
+			float* outX, float* outY, float* outZ, const size_t begin, const size_t end)
+		{
+			size_t i = begin;
+#ifdef ETM_SIMD_SSE
+			for (; i + 4 <= end; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(inX + i);
+				__m128 y = _mm_loadu_ps(inY + i);
+				__m128 z = _mm_loadu_ps(inZ + i);
+				__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+				_mm_storeu_ps(outX + i, _mm_div_ps(x, len));
+				_mm_storeu_ps(outY + i, _mm_div_ps(y, len));
+				_mm_storeu_ps(outZ + i, _mm_div_ps(z, len));
+			}
+#endif
+			for (; i < end; ++i)
+			{
+				const float len = std::sqrt(inX[i] * inX[i] + inY[i] * inY[i] + inZ[i] * inZ[i]);
+				outX[i] = inX[i] / len;
+				outY[i] = inY[i] / len;
+				outZ[i] = inZ[i] / len;
+			}
+		}
+
+		inline void MinMaxRange(const float* in, float &outMin, float &outMax, const size_t begin, const size_t end)
+		{
+			float minVal = std::numeric_limits<float>::max();
+			float maxVal = std::numeric_limits<float>::lowest();
+			size_t i = begin;
+#ifdef ETM_SIMD_SSE
+			if (end - begin >= 4)
+			{
+				__m128 minReg = _mm_set1_ps(minVal);
+				__m128 maxReg = _mm_set1_ps(maxVal);
+				for (; i + 4 <= end; i += 4)
+				{
+					__m128 val = _mm_loadu_ps(in + i);
+					minReg = _mm_min_ps(minReg, val);
+					maxReg = _mm_max_ps(maxReg, val);
+				}
+				float mins[4], maxs[4];
+				_mm_storeu_ps(mins, minReg);
+				_mm_storeu_ps(maxs, maxReg);
+				minVal = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+				maxVal = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+			}
+#endif
+			for (; i < end; ++i)
+			{
+				minVal = std::min(minVal, in[i]);
+				maxVal = std::max(maxVal, in[i]);
+			}
+			outMin = minVal;
+			outMax = maxVal;
+		}
+	} // namespace detail
+
+	//Batch operations
+	//****************
+	// Output arrays can be the same as the input arrays, they must hold at least as many elements as the input
+	// With an executor, large batches are split into ranges that run on its threads
+
+	//transforms vec4s by a matrix, same as mat * vec for every element
+	inline void transform(const matrix<4, 4, float> &mat, const soa<4, float> &in, soa<4, float> &out, batch_executor* const executor = nullptr)
+	{
+		out.resize(in.size());
+		detail::ForRanges(in.size(), executor, [&](size_t begin, size_t end, size_t)
+		{
+			detail::TransformRange(mat, in[0], in[1], in[2], in[3], 0.f, out[0], out[1], out[2], out[3], begin, end);
+		});
+	}
+	//transforms positions (w = 1), same as (mat * vec4(point, 1)).xyz for every element
+	inline void transformPoints(const matrix<4, 4, float> &mat, const soa<3, float> &in, soa<3, float> &out, batch_executor* const executor = nullptr)
+	{
+		out.resize(in.size());
+		detail::ForRanges(in.size(), executor, [&](size_t begin, size_t end, size_t)
+		{
+			detail::TransformRange(mat, in[0], in[1], in[2], nullptr, 1.f, out[0], out[1], out[2], nullptr, begin, end);
+		});
+	}
+	//transforms directions (w = 0), same as (mat * vec4(dir, 0)).xyz for every element
+	inline void transformVectors(const matrix<4, 4, float> &mat, const soa<3, float> &in, soa<3, float> &out, batch_executor* const executor = nullptr)
+	{
+		out.resize(in.size());
+		detail::ForRanges(in.size(), executor, [&](size_t begin, size_t end, size_t)
+		{
+			detail::TransformRange(mat, in[0], in[1], in[2], nullptr, 0.f, out[0], out[1], out[2], nullptr, begin, end);
+		});
+	}
+
+	inline void normalize(const soa<3, float> &in, soa<3, float> &out, batch_executor* const executor = nullptr)
+	{
+		out.resize(in.size());
+		detail::ForRanges(in.size(), executor, [&](size_t begin, size_t end, size_t)
+		{
+			detail::NormalizeRange(in[0], in[1], in[2], out[0], out[1], out[2], begin, end);
+		});
+	}
+
+	//element wise dot product of lhs and rhs
+	inline void dot(const soa<3, float> &lhs, const soa<3, float> &rhs, std::vector<float> &out, batch_executor* const executor = nullptr)
+	{
+		ETM_ASSERT(lhs.size() == rhs.size());
+		out.resize(lhs.size());
+		detail::ForRanges(lhs.size(), executor, [&](size_t begin, size_t end, size_t)
+		{
+			detail::DotRange(lhs[0], lhs[1], lhs[2], rhs[0], rhs[1], rhs[2], out.data(), false, begin, end);
+		});
+	}
+	inline void lengthSquared(const soa<3, float> &in, std::vector<float> &out, batch_executor* const executor = nullptr)
+	{
+		dot(in, in, out, executor);
+	}
+	inline void length(const soa<3, float> &in, std::vector<float> &out, batch_executor* const executor = nullptr)
+	{
+		out.resize(in.size());
+		detail::ForRanges(in.size(), executor, [&](size_t begin, size_t end, size_t)
+		{
+			detail::DotRange(in[0], in[1], in[2], in[0], in[1], in[2], out.data(), true, begin, end);
+		});
+	}
+
+	//component wise minimum and maximum over all elements - returns false for empty input
+	template <uint8 n>
+	inline bool minMax(const soa<n, float> &in, vector<n, float> &outMin, vector<n, float> &outMax, batch_executor* const executor = nullptr)
+	{
+		if (in.size() == 0)
+		{
+			return false;
+		}
+		const size_t numRanges = detail::NumRanges(in.size(), executor);
+		std::vector<vector<n, float>> rangeMin(numRanges, vector<n, float>(std::numeric_limits<float>::max()));
+		std::vector<vector<n, float>> rangeMax(numRanges, vector<n, float>(std::numeric_limits<float>::lowest()));
+		detail::ForRanges(in.size(), executor, [&](size_t begin, size_t end, size_t rangeIdx)
+		{
+			for (uint8 component = 0; component < n; ++component)
+			{
+				detail::MinMaxRange(in[component], rangeMin[rangeIdx][component], rangeMax[rangeIdx][component], begin, end);
+			}
+		});
+		outMin = rangeMin[0];
+		outMax = rangeMax[0];
+		for (size_t rangeIdx = 1; rangeIdx < numRanges; ++rangeIdx)
+		{
+			for (uint8 component = 0; component < n; ++component)
+			{
+				outMin[component] = std::min(outMin[component], rangeMin[rangeIdx][component]);
+				outMax[component] = std::max(outMax[component], rangeMax[rangeIdx][component]);
+			}
+		}
+		return true;
+	}
+
+} // namespace etm
+
+//shorthands
+typedef etm::soa<3, float> vec3soa;
+typedef etm::soa<4, float> vec4soa;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <vector>
+
 struct Plane
 {
 	Plane()
@@ -35,6 +38,105 @@ struct Sphere
 	vec3 pos;
 	float radius;
 };
+struct AABB
+{
+	AABB()
+	{
+		min = vec3(0, 0, 0);
+		max = vec3(0, 0, 0);
+	}
+	AABB(vec3 minimum, vec3 maximum)
+	{
+		min = minimum;
+		max = maximum;
+	}
+	explicit AABB(const Sphere &sphere)
+	{
+		min = sphere.pos - vec3(sphere.radius);
+		max = sphere.pos + vec3(sphere.radius);
+	}
+	vec3 min;
+	vec3 max;
+};
+
+//Unit icosahedron, evaluated at compile time
+//the corners lie on three orthogonal golden rectangles, normalized so every vertex is at distance 1 from the center
+constexpr float ICOSAHEDRON_LONG = 0.8506508083520399f;		//golden ratio / length(vec2(golden ratio, 1))
+constexpr float ICOSAHEDRON_SHORT = 0.5257311121191336f;	//1 / length(vec2(golden ratio, 1))
+constexpr std::array<vec3, 12> ICOSAHEDRON_POSITIONS =
+{ {
+	//X plane
+	vec3(ICOSAHEDRON_LONG, 0, -ICOSAHEDRON_SHORT),		//rf 0
+	vec3(-ICOSAHEDRON_LONG, 0, -ICOSAHEDRON_SHORT),		//lf 1
+	vec3(ICOSAHEDRON_LONG, 0, ICOSAHEDRON_SHORT),		//rb 2
+	vec3(-ICOSAHEDRON_LONG, 0, ICOSAHEDRON_SHORT),		//lb 3
+	//Y plane
+	vec3(0, -ICOSAHEDRON_SHORT, ICOSAHEDRON_LONG),		//db 4
+	vec3(0, -ICOSAHEDRON_SHORT, -ICOSAHEDRON_LONG),		//df 5
+	vec3(0, ICOSAHEDRON_SHORT, ICOSAHEDRON_LONG),		//ub 6
+	vec3(0, ICOSAHEDRON_SHORT, -ICOSAHEDRON_LONG),		//uf 7
+	//Z plane
+	vec3(-ICOSAHEDRON_SHORT, ICOSAHEDRON_LONG, 0),		//lu 8
+	vec3(-ICOSAHEDRON_SHORT, -ICOSAHEDRON_LONG, 0),		//ld 9
+	vec3(ICOSAHEDRON_SHORT, ICOSAHEDRON_LONG, 0),		//ru 10
+	vec3(ICOSAHEDRON_SHORT, -ICOSAHEDRON_LONG, 0)		//rd 11
+} };
+//For inverse winding
+constexpr std::array<uint32, 60> ICOSAHEDRON_INDICES =
+{ {
+	1, 3, 8,
+	1, 3, 9,
+	0, 2, 10,
+	0, 2, 11,
+
+	5, 7, 0,
+	5, 7, 1,
+	4, 6, 2,
+	4, 6, 3,
+
+	9, 11, 4,
+	9, 11, 5,
+	8, 10, 6,
+	8, 10, 7,
+
+	1, 7, 8,
+	1, 5, 9,
+	0, 7, 10,
+	0, 5, 11,
+
+	3, 6, 8,
+	3, 4, 9,
+	2, 6, 10,
+	2, 4, 11
+} };
+//for uniform winding
+constexpr std::array<uint32, 60> ICOSAHEDRON_INDICES_BFC =
+{ {
+	1,8,3,
+	1,3,9,
+	0,2, 10,
+	0,11,2,
+
+	5,0,7,
+	5,7,1,
+	4,6,2,
+	4,3,6,
+
+	9, 4,11,
+	9,11,5,
+	8,10,6,
+	8, 7,10,
+
+	1,7,8,
+	1,9,5,
+	0,10,7,
+	0,5,11,
+
+	3,8,6,
+	3,4,9,
+	2,6 ,10,
+	2,11,4
+} };
 
 std::vector<vec3> GetIcosahedronPositions(float size = 1);
 std::vector<uint32> GetIcosahedronIndices();//For inverse winding
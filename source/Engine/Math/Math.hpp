@@ -1,7 +1,7 @@
 #pragma once
 //inspired by JoeyDeVries/Cell , g-truc/glm , Game Engine Architecture
 //implementing a custom math library for the learning experience, completeness, control and easy build setup
-//#todo SIMD support
+//SIMD specializations for vec4, mat4 and quat are selected at compile time, see Simd.hpp
 //#todo move implementation to .inl files
 
 #include "Vector.hpp"
@@ -9,4 +9,5 @@
 #include "Quaternion.hpp"
 #include "Transform.hpp"
 #include "MathUtil.hpp"
-#include "Geometry.hpp"
\ No newline at end of file
+#include "Geometry.hpp"
+#include "Batch.hpp"
\ No newline at end of file
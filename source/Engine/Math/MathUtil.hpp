@@ -2,6 +2,19 @@
 
 #include "../Helper/AtomicTypes.hpp"
 
+#include <cassert>
+
+//Range and size checks are compiled into debug builds only, define ETM_CHECKED to keep them in other configurations
+#if defined(_DEBUG) && !defined(ETM_CHECKED)
+	#define ETM_CHECKED
+#endif
+
+#ifdef ETM_CHECKED
+	#define ETM_ASSERT(condition) assert(condition)
+#else
+	#define ETM_ASSERT(condition)
+#endif
+
 namespace etm
 {
 
@@ -9,17 +22,17 @@ namespace etm
 #define ETM_DEFAULT_EPSILON_T static_cast<T>(ETM_DEFAULT_EPSILON)
 
 	//180 degrees
-	static const float PI = 3.1415926535897932384626433832795028841971693993751058209749445f;
+	static constexpr float PI = 3.1415926535897932384626433832795028841971693993751058209749445f;
 	//360 degrees
-	static const float PI2 = PI * 2;
+	static constexpr float PI2 = PI * 2;
 	//90 degrees
-	static const float PI_DIV2 = PI * 0.5f;
+	static constexpr float PI_DIV2 = PI * 0.5f;
 	//45 degrees
-	static const float PI_DIV4 = PI * 0.25f;
+	static constexpr float PI_DIV4 = PI * 0.25f;
 	//30 degrees
-	static const float PI_DIV6 = PI / 6.f;
+	static constexpr float PI_DIV6 = PI / 6.f;
 	//1 degree
-	static const float PI_DIV180 = PI / 180.f;
+	static constexpr float PI_DIV180 = PI / 180.f;
 
 	template <class T>
 	inline bool nearEquals(T lhs, T rhs, T epsilon = ETM_DEFAULT_EPSILON_T )
@@ -30,7 +43,7 @@ namespace etm
 	template<class T>
 	inline T Clamp(const T &value, T hi, T lo)
 	{
-		assert( hi >= lo );
+		ETM_ASSERT( hi >= lo );
 		T result = value;
 
 		if (value > hi)
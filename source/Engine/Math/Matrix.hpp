@@ -33,13 +33,13 @@ namespace etm
 			};
 		};
 
-		static uint8 Rows() { return m; }
-		static uint8 Collumns() { return n; }
+		static constexpr uint8 Rows() { return m; }
+		static constexpr uint8 Collumns() { return n; }
 		typedef T value_type;
 
 		//Constructors
 		//Identity default constructor
-		matrix()
+		constexpr matrix() : data{}
 		{
 			for (uint8 rowIdx = 0; rowIdx < m; ++rowIdx)
 			{
@@ -53,9 +53,9 @@ namespace etm
 		{
 			//uninitialized constructor
 		}
-		matrix(const std::initializer_list<T> args)
+		constexpr matrix(const std::initializer_list<T> args) : data{}
 		{
-			assert(args.size() <= m * n);
+			ETM_ASSERT(args.size() <= m * n);
 			uint8 rowIdx = 0, colIdx = 0;
 
 			for (auto& it : args)
@@ -68,23 +68,27 @@ namespace etm
 				}
 			}
 		}
-		matrix(const etm::vector<n, T> rowList[m])
+		constexpr matrix(const etm::vector<n, T> rowList[m]) : data{}
 		{
 			for (uint8 rowIdx = 0; rowIdx < m; ++rowIdx)
 			{
-				rows[rowIdx] = rowList[rowIdx];
+				for (uint8 colIdx = 0; colIdx < n; ++colIdx)
+				{
+					data[rowIdx][colIdx] = rowList[rowIdx][colIdx];
+				}
 			}
 		}
 
 		//operators
+		// in constant expressions only data is initialized, so compile time code should index data directly instead of rows
 		etm::vector<n, T> operator[]( const uint8 rowIdx )const
 		{
-			assert( rowIdx >= 0 && rowIdx < m );
+			ETM_ASSERT( rowIdx < m );
 			return rows[rowIdx];
 		}
 		etm::vector<n, T>& operator[](const uint8 rowIdx)
 		{
-			assert(rowIdx >= 0 && rowIdx < m);
+			ETM_ASSERT( rowIdx < m );
 			return rows[rowIdx];
 		}
 	};
@@ -138,34 +142,34 @@ namespace etm
 	//matrix operators
 	//****************
 	template <uint8 m, uint8 n, class T>
-	matrix<m, n, T> operator+(const matrix<m, n, T>& lhs, const matrix<m, n, T>& rhs)
+	constexpr matrix<m, n, T> operator+(const matrix<m, n, T>& lhs, const matrix<m, n, T>& rhs)
 	{
 		matrix<m, n, T> result;
-		for (uint8 col = 0; col < n; ++col)
+		for (uint8 row = 0; row < m; ++row)
 		{
-			for (uint8 row = 0; row < m; ++row)
+			for (uint8 col = 0; col < n; ++col)
 			{
-				result[col][row] = lhs[col][row] + rhs[col][row];
+				result.data[row][col] = lhs.data[row][col] + rhs.data[row][col];
 			}
 		}
 		return result;
 	}
 	template <uint8 m, uint8 n, class T>
-	matrix<m, n, T> operator-(const matrix<m, n, T>& lhs, const matrix<m, n, T>& rhs)
+	constexpr matrix<m, n, T> operator-(const matrix<m, n, T>& lhs, const matrix<m, n, T>& rhs)
 	{
 		matrix<m, n, T> result;
-		for (uint8 col = 0; col < n; ++col)
+		for (uint8 row = 0; row < m; ++row)
 		{
-			for (uint8 row = 0; row < m; ++row)
+			for (uint8 col = 0; col < n; ++col)
 			{
-				result[col][row] = lhs[col][row] - rhs[col][row];
+				result.data[row][col] = lhs.data[row][col] - rhs.data[row][col];
 			}
 		}
 		return result;
 	}
 	//multiplication: lhs rows * rhs cols
 	template <uint8 m, uint8 n, class T>
-	matrix<m, m, T> operator*(const matrix<m, n, T>& lhs, const matrix<n, m, T>& rhs)
+	constexpr matrix<m, m, T> operator*(const matrix<m, n, T>& lhs, const matrix<n, m, T>& rhs)
 	{
 		matrix<m, m, T> result;
 		for (uint8 col = 0; col < m; ++col)
@@ -176,33 +180,36 @@ namespace etm
 				T value = {};
 				for (uint8 j = 0; j < n; ++j)
 				{
-					value += lhs[row][j] * rhs[j][col];
+					value += lhs.data[row][j] * rhs.data[j][col];
 				}
-				result[row][col] = value;
+				result.data[row][col] = value;
 			}
 		}
 		return result;
 	}
 	//vector - matrix multiplication - col major convention -> vectors are 3x1 matrices and therefore on the right side
 	template <uint8 m, uint8 n, class T>
-	vector<m, T> operator*(const matrix<m, n, T>& lhs, const vector<m, T>& rhs)
+	constexpr vector<m, T> operator*(const matrix<m, n, T>& lhs, const vector<m, T>& rhs)
 	{
 		vector<m, T> result(0);
 		for (uint8 rowIdx = 0; rowIdx < m; ++rowIdx)
 		{
 			for(uint8 i = 0; i < m; ++i)
-				result[rowIdx] += lhs[i][rowIdx] * rhs[i];
+				result[rowIdx] += lhs.data[i][rowIdx] * rhs[i];
 		}
 		return result;
 	}
 	//scalar - matrix multiplication
 	template <uint8 m, uint8 n, class T>
-	matrix<m, n, T> operator*( const matrix<m, n, T>& lhs, const T rhs )
+	constexpr matrix<m, n, T> operator*( const matrix<m, n, T>& lhs, const T rhs )
 	{
 		matrix<m, n, T> result;
 		for(uint8 rowIdx = 0; rowIdx < m; ++rowIdx)
 		{
-			result[rowIdx] = lhs[rowIdx] * rhs;
+			for(uint8 colIdx = 0; colIdx < n; ++colIdx)
+			{
+				result.data[rowIdx][colIdx] = lhs.data[rowIdx][colIdx] * rhs;
+			}
 		}
 		return result;
 	}
@@ -211,7 +218,7 @@ namespace etm
 	//**********
 
 	template <unsigned int m, unsigned int n, class T>
-	inline matrix<m, n, T> transpose(const matrix<m, n, T>& mat)
+	constexpr matrix<m, n, T> transpose(const matrix<m, n, T>& mat)
 	{
 		matrix<n, m, T> result;
 
@@ -219,7 +226,7 @@ namespace etm
 		{
 			for (uint8 rowIdx = 0; rowIdx < n; ++rowIdx)
 			{
-				result[rowIdx][colIdx] = mat[colIdx][rowIdx];
+				result.data[rowIdx][colIdx] = mat.data[colIdx][rowIdx];
 			}
 		}
 		return result;
@@ -370,6 +377,8 @@ namespace etm
 
 }//namespace etm
 
+#include "MatrixSimd.inl"
+
 //shorthands
 typedef etm::matrix<2, 2, float>  mat2;
 typedef etm::matrix<3, 3, float>  mat3;
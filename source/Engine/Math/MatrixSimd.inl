@@ -0,0 +1,181 @@
+#pragma once
+
+//SSE specializations for mat4
+//****************************
+
+// These replace the generic templates for matrix<4, 4, float> when ETM_SIMD_SSE is defined (see Simd.hpp)
+// The order of operations matches the scalar versions, so results are identical to the generic implementation
+
+#ifdef ETM_SIMD_SSE
+
+namespace etm
+{
+	namespace simd
+	{
+		inline void LoadRows(const matrix<4, 4, float> &mat, __m128 rows[4])
+		{
+			rows[0] = _mm_loadu_ps(mat.data[0]);
+			rows[1] = _mm_loadu_ps(mat.data[1]);
+			rows[2] = _mm_loadu_ps(mat.data[2]);
+			rows[3] = _mm_loadu_ps(mat.data[3]);
+		}
+		inline matrix<4, 4, float> StoreRows(const __m128 rows[4])
+		{
+			matrix<4, 4, float> result(uninitialized);
+			_mm_storeu_ps(result.data[0], rows[0]);
+			_mm_storeu_ps(result.data[1], rows[1]);
+			_mm_storeu_ps(result.data[2], rows[2]);
+			_mm_storeu_ps(result.data[3], rows[3]);
+			return result;
+		}
+
+		//linear combination of the rhs rows weighted by the lhs row
+		inline __m128 CombineRows(const __m128 lhsRow, const __m128 rhsRows[4])
+		{
+			__m128 result = _mm_mul_ps(_mm_shuffle_ps(lhsRow, lhsRow, _MM_SHUFFLE(0, 0, 0, 0)), rhsRows[0]);
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(lhsRow, lhsRow, _MM_SHUFFLE(1, 1, 1, 1)), rhsRows[1]));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(lhsRow, lhsRow, _MM_SHUFFLE(2, 2, 2, 2)), rhsRows[2]));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(lhsRow, lhsRow, _MM_SHUFFLE(3, 3, 3, 3)), rhsRows[3]));
+			return result;
+		}
+
+		//2x2 sub determinants of rows 1-3 used for the cofactors of the inverse,
+		//the result is the vector fac(a, b) from the generic implementation
+		template <int a, int b>
+		inline __m128 InverseFactor(const __m128 rows[4])
+		{
+			__m128 swp0a = _mm_shuffle_ps(rows[3], rows[2], _MM_SHUFFLE(b, b, b, b));
+			__m128 swp0b = _mm_shuffle_ps(rows[3], rows[2], _MM_SHUFFLE(a, a, a, a));
+
+			__m128 swp00 = _mm_shuffle_ps(rows[2], rows[1], _MM_SHUFFLE(a, a, a, a));
+			__m128 swp01 = _mm_shuffle_ps(swp0a, swp0a, _MM_SHUFFLE(2, 0, 0, 0));
+			__m128 swp02 = _mm_shuffle_ps(swp0b, swp0b, _MM_SHUFFLE(2, 0, 0, 0));
+			__m128 swp03 = _mm_shuffle_ps(rows[2], rows[1], _MM_SHUFFLE(b, b, b, b));
+
+			return _mm_sub_ps(_mm_mul_ps(swp00, swp01), _mm_mul_ps(swp02, swp03));
+		}
+		//builds (mat[1][col], mat[0][col], mat[0][col], mat[0][col])
+		template <int col>
+		inline __m128 InverseVec(const __m128 rows[4])
+		{
+			__m128 temp = _mm_shuffle_ps(rows[1], rows[0], _MM_SHUFFLE(col, col, col, col));
+			return _mm_shuffle_ps(temp, temp, _MM_SHUFFLE(2, 2, 2, 0));
+		}
+	} // namespace simd
+
+	//matrix product
+	template <>
+	inline matrix<4, 4, float> operator*<4, 4, float>(const matrix<4, 4, float>& lhs, const matrix<4, 4, float>& rhs)
+	{
+		matrix<4, 4, float> result(uninitialized);
+#ifdef ETM_SIMD_AVX
+		//process two rows at once, each 128 bit lane holds one row
+		__m256 rhs0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data[0]));
+		__m256 rhs1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data[1]));
+		__m256 rhs2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data[2]));
+		__m256 rhs3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data[3]));
+		for (uint8 rowIdx = 0; rowIdx < 4; rowIdx += 2)
+		{
+			__m256 lhsRows = _mm256_loadu_ps(lhs.data[rowIdx]);
+			__m256 row = _mm256_mul_ps(_mm256_shuffle_ps(lhsRows, lhsRows, _MM_SHUFFLE(0, 0, 0, 0)), rhs0);
+			row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(lhsRows, lhsRows, _MM_SHUFFLE(1, 1, 1, 1)), rhs1));
+			row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(lhsRows, lhsRows, _MM_SHUFFLE(2, 2, 2, 2)), rhs2));
+			row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(lhsRows, lhsRows, _MM_SHUFFLE(3, 3, 3, 3)), rhs3));
+			_mm256_storeu_ps(result.data[rowIdx], row);
+		}
+#else
+		__m128 rhsRows[4];
+		simd::LoadRows(rhs, rhsRows);
+		_mm_storeu_ps(result.data[0], simd::CombineRows(_mm_loadu_ps(lhs.data[0]), rhsRows));
+		_mm_storeu_ps(result.data[1], simd::CombineRows(_mm_loadu_ps(lhs.data[1]), rhsRows));
+		_mm_storeu_ps(result.data[2], simd::CombineRows(_mm_loadu_ps(lhs.data[2]), rhsRows));
+		_mm_storeu_ps(result.data[3], simd::CombineRows(_mm_loadu_ps(lhs.data[3]), rhsRows));
+#endif
+		return result;
+	}
+
+	//vector - matrix multiplication
+	template <>
+	inline vector<4, float> operator*<4, 4, float>(const matrix<4, 4, float>& lhs, const vector<4, float>& rhs)
+	{
+		__m128 rows[4];
+		simd::LoadRows(lhs, rows);
+		return simd::Store(simd::CombineRows(simd::Load(rhs), rows));
+	}
+
+	//scalar - matrix multiplication
+	template <>
+	inline matrix<4, 4, float> operator*<4, 4, float>(const matrix<4, 4, float>& lhs, const float rhs)
+	{
+		__m128 rows[4];
+		simd::LoadRows(lhs, rows);
+		const __m128 scalar = _mm_set1_ps(rhs);
+		for (uint8 rowIdx = 0; rowIdx < 4; ++rowIdx)
+		{
+			rows[rowIdx] = _mm_mul_ps(rows[rowIdx], scalar);
+		}
+		return simd::StoreRows(rows);
+	}
+
+	template <>
+	inline matrix<4, 4, float> transpose<4, 4, float>(const matrix<4, 4, float>& mat)
+	{
+		__m128 rows[4];
+		simd::LoadRows(mat, rows);
+		_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+		return simd::StoreRows(rows);
+	}
+
+	//same cofactor expansion as the generic version
+	template <>
+	inline matrix<4, 4, float> inverse<float>(const matrix<4, 4, float>& mat)
+	{
+		__m128 rows[4];
+		simd::LoadRows(mat, rows);
+
+		__m128 fac0 = simd::InverseFactor<2, 3>(rows);
+		__m128 fac1 = simd::InverseFactor<1, 3>(rows);
+		__m128 fac2 = simd::InverseFactor<1, 2>(rows);
+		__m128 fac3 = simd::InverseFactor<0, 3>(rows);
+		__m128 fac4 = simd::InverseFactor<0, 2>(rows);
+		__m128 fac5 = simd::InverseFactor<0, 1>(rows);
+
+		__m128 vec0 = simd::InverseVec<0>(rows);
+		__m128 vec1 = simd::InverseVec<1>(rows);
+		__m128 vec2 = simd::InverseVec<2>(rows);
+		__m128 vec3 = simd::InverseVec<3>(rows);
+
+		__m128 inv0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vec1, fac0), _mm_mul_ps(vec2, fac1)), _mm_mul_ps(vec3, fac2));
+		__m128 inv1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vec0, fac0), _mm_mul_ps(vec2, fac3)), _mm_mul_ps(vec3, fac4));
+		__m128 inv2 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vec0, fac1), _mm_mul_ps(vec1, fac3)), _mm_mul_ps(vec3, fac5));
+		__m128 inv3 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vec0, fac2), _mm_mul_ps(vec1, fac4)), _mm_mul_ps(vec2, fac5));
+
+		const __m128 signA = _mm_set_ps(-1.f, 1.f, -1.f, 1.f);
+		const __m128 signB = _mm_set_ps(1.f, -1.f, 1.f, -1.f);
+		__m128 result[4];
+		result[0] = _mm_mul_ps(inv0, signA);
+		result[1] = _mm_mul_ps(inv1, signB);
+		result[2] = _mm_mul_ps(inv2, signA);
+		result[3] = _mm_mul_ps(inv3, signB);
+
+		//first column of the result dotted with the first row of the input gives the determinant
+		__m128 col0a = _mm_shuffle_ps(result[0], result[1], _MM_SHUFFLE(0, 0, 0, 0));
+		__m128 col0b = _mm_shuffle_ps(result[2], result[3], _MM_SHUFFLE(0, 0, 0, 0));
+		__m128 col0 = _mm_shuffle_ps(col0a, col0b, _MM_SHUFFLE(2, 0, 2, 0));
+
+		//(x + y) + (z + w)
+		__m128 dot0 = _mm_mul_ps(rows[0], col0);
+		__m128 dot1 = _mm_add_ps(dot0, _mm_shuffle_ps(dot0, dot0, _MM_SHUFFLE(2, 3, 0, 1)));
+		dot1 = _mm_add_ps(dot1, _mm_shuffle_ps(dot1, dot1, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		__m128 detFrac = _mm_div_ps(_mm_set1_ps(1.f), dot1);
+		for (uint8 rowIdx = 0; rowIdx < 4; ++rowIdx)
+		{
+			result[rowIdx] = _mm_mul_ps(result[rowIdx], detFrac);
+		}
+		return simd::StoreRows(result);
+	}
+
+} // namespace etm
+
+#endif // ETM_SIMD_SSE
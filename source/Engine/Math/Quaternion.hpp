@@ -209,6 +209,8 @@ namespace etm
 
 }//namespace etm
 
+#include "QuaternionSimd.inl"
+
 //shorthands
 typedef etm::quaternion<float>  quat;
 typedef etm::quaternion<double> quatd; //ultra precise rotations ? maybe someone wants to simulate a clockwork
\ No newline at end of file
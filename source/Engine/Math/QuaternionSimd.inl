@@ -0,0 +1,58 @@
+#pragma once
+
+//SSE specializations for quat
+//****************************
+
+// These replace the generic templates for quaternion<float> when ETM_SIMD_SSE is defined (see Simd.hpp)
+// The order of operations matches the scalar versions, so results are identical to the generic implementation
+
+#ifdef ETM_SIMD_SSE
+
+namespace etm
+{
+	//Grassman product
+	template <>
+	inline quaternion<float> operator*<float>(const quaternion<float>& lhs, const quaternion<float>& rhs)
+	{
+		__m128 lhsQ = simd::Load(lhs.v4);
+		__m128 rhsQ = simd::Load(rhs.v4);
+		__m128 lhsW = _mm_shuffle_ps(lhsQ, lhsQ, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 rhsW = _mm_shuffle_ps(rhsQ, rhsQ, _MM_SHUFFLE(3, 3, 3, 3));
+
+		//w = rhs.w*lhs.w - dot(rhs.v, lhs.v)
+		__m128 w = _mm_sub_ss(_mm_mul_ss(rhsW, lhsW), simd::Dot3(rhsQ, lhsQ));
+
+		//v = rhs.w*lhs.v + lhs.w*rhs.v + cross(lhs.v, rhs.v)
+		__m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rhsW, lhsQ), _mm_mul_ps(lhsW, rhsQ)), simd::Cross(lhsQ, rhsQ));
+
+		quaternion<float> result;
+		_mm_storeu_ps(result.v4.data, v);
+		result.w = _mm_cvtss_f32(w);
+		return result;
+	}
+
+	//Rotate vector with quaternion
+	template <>
+	inline vector<3, float> operator*<float>(const quaternion<float>& q, const vector<3, float>& vec)
+	{
+		__m128 quatReg = simd::Load(q.v4);
+		__m128 qv = _mm_and_ps(quatReg, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+		__m128 qw = _mm_shuffle_ps(quatReg, quatReg, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 vecReg = simd::Load(vec);
+		const __m128 two = _mm_set1_ps(2.f);
+
+		//(2*(w*w) - 1)*vec
+		__m128 scale = _mm_sub_ps(_mm_mul_ps(two, _mm_mul_ps(qw, qw)), _mm_set1_ps(1.f));
+		__m128 result = _mm_mul_ps(scale, vecReg);
+
+		//+ 2 * (dot(q.v, vec)*q.v + q.w*cross(q.v, vec))
+		__m128 projected = _mm_mul_ps(simd::Dot3(qv, vecReg), qv);
+		__m128 perpendicular = _mm_mul_ps(qw, simd::Cross(qv, vecReg));
+		result = _mm_add_ps(result, _mm_mul_ps(two, _mm_add_ps(projected, perpendicular)));
+
+		return simd::Store3(result);
+	}
+
+} // namespace etm
+
+#endif // ETM_SIMD_SSE
@@ -0,0 +1,18 @@
+#pragma once
+
+//SIMD configuration for the math library
+//***************************************
+
+// The vec4, mat4 and quat specializations in the *Simd.inl files are only compiled in if the target supports at least SSE2,
+// otherwise the generic scalar templates are used. Define ETM_NO_SIMD to force the scalar fallback on any target.
+
+#if !defined(ETM_NO_SIMD)
+#	if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define ETM_SIMD_SSE
+#		include <emmintrin.h>
+#	endif
+#	if defined(ETM_SIMD_SSE) && defined(__AVX__)
+#		define ETM_SIMD_AVX
+#		include <immintrin.h>
+#	endif
+#endif
@@ -159,4 +159,6 @@ namespace etm
 		return result;
 	}
 
-} // namespace etm
\ No newline at end of file
+} // namespace etm
+
+#include "TransformSimd.inl"
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+//SSE specializations for float transforms
+//****************************************
+
+// These replace the generic templates for float matrices when ETM_SIMD_SSE is defined (see Simd.hpp)
+// The order of operations matches the scalar versions, so results are identical to the generic implementation
+
+#ifdef ETM_SIMD_SSE
+
+namespace etm
+{
+	//look at
+	template <>
+	inline matrix<4, 4, float> lookAt<float>(const vector<3, float>& position, const vector<3, float>& target, const vector<3, float>& worldUp)
+	{
+		__m128 pos = simd::Load(position);
+
+		__m128 forward = simd::Normalize3(_mm_sub_ps(simd::Load(target), pos));
+		__m128 right = simd::Normalize3(simd::Cross(simd::Load(worldUp), forward));
+		__m128 up = simd::Cross(forward, right);
+
+		//put the translation in the w component and transpose so the basis vectors end up in the columns
+		const __m128 signMask = _mm_set1_ps(-0.f);
+		__m128 rows[4];
+		rows[0] = simd::SetW(right, _mm_xor_ps(simd::Dot3(right, pos), signMask));
+		rows[1] = simd::SetW(up, _mm_xor_ps(simd::Dot3(up, pos), signMask));
+		rows[2] = simd::SetW(forward, _mm_xor_ps(simd::Dot3(forward, pos), signMask));
+		rows[3] = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+		_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+		return simd::StoreRows(rows);
+	}
+
+} // namespace etm
+
+#endif // ETM_SIMD_SSE
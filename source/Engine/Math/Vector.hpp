@@ -2,9 +2,9 @@
 #pragma warning(disable : 4201) //nameless struct union - used in math library
 
 #include "MathUtil.hpp"
+#include "Simd.hpp"
 
 #include <initializer_list>
-#include <array>
 #include <rttr/registration>
 
 //ETEngine math
@@ -28,45 +28,39 @@ namespace etm
 	{
 	public:
 		//members
-		std::array<T, n> data;
+		T data[n];
 
 		//constructors
-		vector()
+		constexpr vector() : data{} {}
+		constexpr vector(const T &rhs) : data{}
 		{
 			for (uint8 i = 0; i < n; ++i)
 			{
-				data[i] = 0;
+				data[i] = rhs;
 			}
 		}
-		vector(const T &rhs)
+		constexpr vector(const std::initializer_list<T> args) : data{}
 		{
-			for (auto& el : data) 
-			{
-				el = rhs;
-			}
-		}
-		vector(const std::initializer_list<T> args)
-		{
-			assert(args.size() <= n);
-			int32 index = 0;
+			ETM_ASSERT(args.size() <= n);
+			uint8 index = 0;
 			for (auto begin = args.begin(); begin != args.end(); ++begin)
 			{
-				data.at(index++) = *begin;
+				data[index++] = *begin;
 			}
 		}
 
 		//operators
-		T operator[] (const uint8 index) const
+		constexpr T operator[] (const uint8 index) const
 		{
-			assert(index >= 0 && index < n);
-			return data.at(index);
+			ETM_ASSERT(index < n);
+			return data[index];
 		}
-		T& operator[] (const uint8 index)
+		constexpr T& operator[] (const uint8 index)
 		{
-			assert(index >= 0 && index < n);
-			return data.at(index);
+			ETM_ASSERT(index < n);
+			return data[index];
 		}
-		vector<n, T> operator-() const;
+		constexpr vector<n, T> operator-() const;
 
 		//string conversion
 		std::string ToString() const;
@@ -76,52 +70,46 @@ namespace etm
 	//specializations
 	//***************
 
+	// The named members (x, y, xyz ...) alias the data array, but in constant expressions only data is initialized,
+	// so functions meant to be evaluated at compile time read components through operator[]
+
 	//vec2
 	template <typename T>
 	struct vector<2, T>
 	{
 		union
 		{
-			std::array<T, 2> data;
+			T data[2];
 			struct
 			{
 				T x;
 				T y;
 			};
 		};
-		vector()
+		constexpr vector() : data{} {}
+		constexpr vector(const T &rhs) : data{ rhs, rhs } {}
+		constexpr vector(const std::initializer_list<T> args) : data{}
 		{
-			data = { 0, 0 };
-		}
-		vector(const T &rhs)
-		{
-			data = { rhs, rhs };
-		}
-		vector(const std::initializer_list<T> args)
-		{
-			assert(args.size() <= 2);
-			int32 index = 0;
+			ETM_ASSERT(args.size() <= 2);
+			uint8 index = 0;
 			for (auto begin = args.begin(); begin != args.end(); ++begin) 
 			{
-				data.at(index++) = *begin;
+				data[index++] = *begin;
 			}
 		}
-		vector(const T& x, const T& y)
-		{
-			data = { x, y };
-		}
+		constexpr vector(const T& x, const T& y) : data{ x, y } {}
 		//operators
-		T operator[] (const uint8 index) const
+		constexpr T operator[] (const uint8 index) const
 		{
-			assert(index >= 0 && index < 2);
-			return data.at(index);
+			ETM_ASSERT(index < 2);
+			return data[index];
 		}
-		T& operator[] (const uint8 index)
+		constexpr T& operator[] (const uint8 index)
 		{
-			assert(index >= 0 && index < 2);
-			return data.at(index);
+			ETM_ASSERT(index < 2);
+			return data[index];
 		}
-		vector<2, T> operator-() const;
+		constexpr vector<2, T> operator-() const;
 
 		//string conversion
 		std::string ToString() const;
@@ -134,7 +122,7 @@ namespace etm
 	{
 		union
 		{
-			std::array<T, 3> data;
+			T data[3];
 			struct
 			{
 				T x;
@@ -162,48 +150,33 @@ namespace etm
 		static vector<3, T> FORWARD;
 		static vector<3, T> BACK;
 
-		vector()
+		constexpr vector() : data{} {}
+		constexpr vector(const T &rhs) : data{ rhs, rhs, rhs } {}
+		constexpr vector(const std::initializer_list<T> args) : data{}
 		{
-			data = { 0, 0, 0 };
-		}
-		vector(const T &rhs)
-		{
-			data = { rhs, rhs, rhs };
-		}
-		vector(const std::initializer_list<T> args)
-		{
-			assert(args.size() <= 3);
-			int32 index = 0;
+			ETM_ASSERT(args.size() <= 3);
+			uint8 index = 0;
 			for (auto begin = args.begin(); begin != args.end(); ++begin) 
 			{
-				data.at(index++) = *begin;
+				data[index++] = *begin;
 			}
 		}
-		vector(const T& x, const T& y, const T& z)
-		{
-			data = { x, y, z };
-		}
-		vector(const vector<2, T>& vec, const T& z)
-		{
-			data = { vec.x, vec.y, z };
-		}
-		vector(const T& x, const vector<2, T>& vec)
-		{
-			data = { x, vec.x, vec.y };
-		}
+		constexpr vector(const T& x, const T& y, const T& z) : data{ x, y, z } {}
+		constexpr vector(const vector<2, T>& vec, const T& z) : data{ vec[0], vec[1], z } {}
+		constexpr vector(const T& x, const vector<2, T>& vec) : data{ x, vec[0], vec[1] } {}
 
 		//operators
-		T operator[] (const uint8 index) const
+		constexpr T operator[] (const uint8 index) const
 		{
-			assert(index >= 0 && index < 3);
-			return data.at(index);
+			ETM_ASSERT(index < 3);
+			return data[index];
 		}
-		T& operator[] (const uint8 index)
+		constexpr T& operator[] (const uint8 index)
 		{
-			assert(index >= 0 && index < 3);
-			return data.at(index);
+			ETM_ASSERT(index < 3);
+			return data[index];
 		}
-		vector<3, T> operator-() const;
+		constexpr vector<3, T> operator-() const;
 
 		//string conversion
 		std::string ToString() const;
@@ -224,7 +197,7 @@ namespace etm
 	{
 		union
 		{
-			std::array<T, 4> data;
+			T data[4];
 			struct
 			{
 				T x;
@@ -270,67 +243,44 @@ namespace etm
 		};
 
 		//constructors
-		vector()
+		constexpr vector() : data{} {}
+		explicit vector( etm::ctor )
 		{
-			data = { 0, 0, 0, 0 };
+			//uninitialized constructor
 		}
-		vector(const T &rhs)
+		constexpr vector(const T &rhs) : data{ rhs, rhs, rhs, rhs } {}
+		constexpr vector(const std::initializer_list<T> args) : data{}
 		{
-			data = { rhs, rhs, rhs, rhs };
-		}
-		vector(const std::initializer_list<T> args)
-		{
-			assert(args.size() <= 4);
-			int index = 0;
+			ETM_ASSERT(args.size() <= 4);
+			uint8 index = 0;
 			for (auto begin = args.begin(); begin != args.end(); ++begin) 
 			{
-				data.at(index++) = *begin;
+				data[index++] = *begin;
 			}
 		}
 		//with scalars
-		vector(const T& x, const T& y, const T& z, const T& w)
-		{
-			data = { x, y, z, w };
-		}
+		constexpr vector(const T& x, const T& y, const T& z, const T& w) : data{ x, y, z, w } {}
 		//with vec2
-		vector(const vector<2, T>& xy, const vector<2, T>& zw)
-		{
-			data = { xy.x, xy.y, zw.x, zw.y };
-		}
-		vector(const vector<2, T>& xy, const T& z, const T& w)
-		{
-			data = { xy.x, xy.y, z, w };
-		}
-		vector(const T& x, const T& y, const vector<2, T>& zw)
-		{
-			data = { x, y, zw.x, zw.y };
-		}
-		vector(const T& x, const vector<2, T>& yz, const T& w)
-		{
-			data = { x, yz.x, yz.y, w };
-		}
+		constexpr vector(const vector<2, T>& xy, const vector<2, T>& zw) : data{ xy[0], xy[1], zw[0], zw[1] } {}
+		constexpr vector(const vector<2, T>& xy, const T& z, const T& w) : data{ xy[0], xy[1], z, w } {}
+		constexpr vector(const T& x, const T& y, const vector<2, T>& zw) : data{ x, y, zw[0], zw[1] } {}
+		constexpr vector(const T& x, const vector<2, T>& yz, const T& w) : data{ x, yz[0], yz[1], w } {}
 		//with vec3
-		vector(const vector<3, T>& xyz, const T& w)
-		{
-			data = { xyz.x, xyz.y, xyz.z, w };
-		}
-		vector(const T& x, const vector<3, T>& yzw)
-		{
-			data = { x, yzw.x, yzw.y, yzw.z };
-		}
+		constexpr vector(const vector<3, T>& xyz, const T& w) : data{ xyz[0], xyz[1], xyz[2], w } {}
+		constexpr vector(const T& x, const vector<3, T>& yzw) : data{ x, yzw[0], yzw[1], yzw[2] } {}
 
 		//operators
-		T operator[] (const uint8 index) const
+		constexpr T operator[] (const uint8 index) const
 		{
-			assert(index >= 0 && index < 4);
-			return data.at(index);
+			ETM_ASSERT(index < 4);
+			return data[index];
 		}
-		T& operator[] (const uint8 index)
+		constexpr T& operator[] (const uint8 index)
 		{
-			assert(index >= 0 && index < 4);
-			return data.at(index);
+			ETM_ASSERT(index < 4);
+			return data[index];
 		}
-		vector<4, T> operator-() const;
+		constexpr vector<4, T> operator-() const;
 
 		//string conversion
 		std::string ToString() const;
@@ -344,8 +294,8 @@ namespace etm
 	std::string etm::vector<n, T>::ToString() const
 	{
 		std::string ret = "[";
-		for(uint8 i = 0; i < data.size(); ++i)
-			ret += (i == data.size() - 1) ? (data[i]) : (data[i]+", ");
+		for(uint8 i = 0; i < n; ++i)
+			ret += (i == n - 1) ? (data[i]) : (data[i]+", ");
 		return ret + "]";
 	}
 	template <uint8 n, class T>
@@ -390,7 +340,7 @@ namespace etm
 
 	//negate
 	template <uint8 n, class T>
-	inline vector<n, T> vector<n, T>::operator-() const
+	constexpr vector<n, T> vector<n, T>::operator-() const
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i)
@@ -400,24 +350,24 @@ namespace etm
 		return result;
 	}
 	template <class T>
-	inline vector<2, T> vector<2, T>::operator-() const
+	constexpr vector<2, T> vector<2, T>::operator-() const
 	{
-		return{ -x, -y };
+		return vector<2, T>(-data[0], -data[1]);
 	}
 	template <class T>
-	inline vector<3, T> vector<3, T>::operator-() const
+	constexpr vector<3, T> vector<3, T>::operator-() const
 	{
-		return{ -x, -y, -z };
+		return vector<3, T>(-data[0], -data[1], -data[2]);
 	}
 	template <class T>
-	inline vector<4, T> vector<4, T>::operator-() const
+	constexpr vector<4, T> vector<4, T>::operator-() const
 	{
-		return{ -x, -y, -z, -w };
+		return vector<4, T>(-data[0], -data[1], -data[2], -data[3]);
 	}
 
 	// addition
 	template <uint8 n, class T>
-	inline vector<n, T> operator+(const vector<n, T> &lhs, const T scalar)
+	constexpr vector<n, T> operator+(const vector<n, T> &lhs, const T scalar)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -427,15 +377,15 @@ namespace etm
 		return result;
 	}
 	template <uint8 n, class T>
-	inline vector<n, T> operator+(const T scalar, const vector<n, T> &rhs)
+	constexpr vector<n, T> operator+(const T scalar, const vector<n, T> &rhs)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i)
-			result[i] = lhs[i] + scalar;
+			result[i] = rhs[i] + scalar;
 		return result;
 	}
 	template <uint8 n, class T>
-	inline vector<n, T> operator+(const vector<n, T> &lhs, const vector<n, T> &rhs)
+	constexpr vector<n, T> operator+(const vector<n, T> &lhs, const vector<n, T> &rhs)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i)
@@ -445,7 +395,7 @@ namespace etm
 
 	// subtraction
 	template <uint8 n, class T>
-	inline vector<n, T> operator-(const vector<n, T> &lhs, const T scalar)
+	constexpr vector<n, T> operator-(const vector<n, T> &lhs, const T scalar)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -455,7 +405,7 @@ namespace etm
 		return result;
 	}
 	template <uint8 n, class T>
-	inline vector<n, T> operator-(const vector<n, T> &lhs, const vector<n, T> &rhs)
+	constexpr vector<n, T> operator-(const vector<n, T> &lhs, const vector<n, T> &rhs)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -467,7 +417,7 @@ namespace etm
 
 	// multiplication
 	template <uint8 n, class T>
-	inline vector<n, T> operator*(const vector<n, T> lhs, const T &scalar)
+	constexpr vector<n, T> operator*(const vector<n, T> lhs, const T &scalar)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -477,7 +427,7 @@ namespace etm
 		return result;
 	}
 	template <uint8 n, class T>
-	inline vector<n, T> operator*(const T scalar, const vector<n, T> &lhs)
+	constexpr vector<n, T> operator*(const T scalar, const vector<n, T> &lhs)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -487,7 +437,7 @@ namespace etm
 		return result;
 	}
 	template <uint8 n, class T>
-	inline vector<n, T> operator*(const vector<n, T> &lhs, const vector<n, T> &rhs) // hadamard product
+	constexpr vector<n, T> operator*(const vector<n, T> &lhs, const vector<n, T> &rhs) // hadamard product
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -499,7 +449,7 @@ namespace etm
 
 	//division
 	template <uint8 n, class T>
-	inline vector<n, T> operator/(const vector<n, T> &lhs, const T scalar)
+	constexpr vector<n, T> operator/(const vector<n, T> &lhs, const T scalar)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -509,7 +459,7 @@ namespace etm
 		return result;
 	}
 	template <uint8 n, class T>
-	inline vector<n, T> operator/(const T scalar, const vector<n, T> &rhs)
+	constexpr vector<n, T> operator/(const T scalar, const vector<n, T> &rhs)
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i)
@@ -519,7 +469,7 @@ namespace etm
 		return result;
 	}
 	template <uint8 n, class T>
-	inline vector<n, T> operator/(const vector<n, T> &lhs, const vector<n, T> &rhs) //hadamard product
+	constexpr vector<n, T> operator/(const vector<n, T> &lhs, const vector<n, T> &rhs) //hadamard product
 	{
 		vector<n, T> result;
 		for (uint8 i = 0; i < n; ++i) 
@@ -552,7 +502,7 @@ namespace etm
 	}
 
 	template <uint8 n, class T>
-	inline T dot(const vector<n, T> &lhs, const vector<n, T> &rhs)
+	constexpr T dot(const vector<n, T> &lhs, const vector<n, T> &rhs)
 	{
 		T result = {};
 		for (uint8 i = 0; i < n; ++i)
@@ -562,25 +512,25 @@ namespace etm
 
 	//this is important so we do template specaializations
 	template <class T>
-	inline T dot(const vector<2, T> &lhs, const vector<2, T> &rhs)
+	constexpr T dot(const vector<2, T> &lhs, const vector<2, T> &rhs)
 	{
-		return lhs.x * rhs.x + lhs.y * rhs.y;
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1];
 	}
 
 	template <class T>
-	inline T dot(const vector<3, T> &lhs, const vector<3, T> &rhs)
+	constexpr T dot(const vector<3, T> &lhs, const vector<3, T> &rhs)
 	{
-		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
 	}
 
 	template <class T>
-	inline T dot(const vector<4, T> &lhs, const vector<4, T> &rhs)
+	constexpr T dot(const vector<4, T> &lhs, const vector<4, T> &rhs)
 	{
-		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w;
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2] + lhs[3] * rhs[3];
 	}
 
 	template <uint8 n, class T>
-	inline T lengthSquared(const vector<n, T> &vec)
+	constexpr T lengthSquared(const vector<n, T> &vec)
 	{
 		return etm::dot(vec, vec);
 	}
@@ -596,7 +546,7 @@ namespace etm
 		return length(lhs - rhs);
 	}
 	template <uint8 n, class T>
-	inline T distanceSquared(const vector<n, T> &lhs, const vector<n, T> &rhs)
+	constexpr T distanceSquared(const vector<n, T> &lhs, const vector<n, T> &rhs)
 	{
 		return lengthSquared(lhs - rhs);
 	}
@@ -644,7 +594,7 @@ namespace etm
 	}
 
 	template<typename T, uint8 n,typename T2>
-	inline vector<n, T> vecCast(const vector<n, T2> &vec)
+	constexpr vector<n, T> vecCast(const vector<n, T2> &vec)
 	{
 		vector<n, T> ret;
 		for (uint8 i = 0; i < n; ++i)
@@ -658,12 +608,9 @@ namespace etm
 	//*****************************
 	//vec2
 	template<class T>
-	inline vector<2, T> perpendicular(const vector<2, T>& vec)
+	constexpr vector<2, T> perpendicular(const vector<2, T>& vec)
 	{
-		vector<2, T> result;
-		result.x = -vec.y;
-		result.y = vec.x;
-		return result;
+		return vector<2, T>(-vec[1], vec[0]);
 	}
 	//Vectors need to be prenormalized
 	template<class T>
@@ -675,15 +622,12 @@ namespace etm
 	//vec3
 	//direction will be left handed (lhs = thumb, rhs = index, result -> middle finger);
 	template<class T>
-	inline vector<3, T> cross(const vector<3, T>& lhs, const vector<3, T>& rhs)
+	constexpr vector<3, T> cross(const vector<3, T>& lhs, const vector<3, T>& rhs)
 	{
-		vector<3, T> result;
-
-		result.x = lhs.y*rhs.z - lhs.z*rhs.y;
-		result.y = lhs.z*rhs.x - lhs.x*rhs.z;
-		result.z = lhs.x*rhs.y - lhs.y*rhs.x;
-
-		return result;
+		return vector<3, T>(
+			lhs[1]*rhs[2] - lhs[2]*rhs[1],
+			lhs[2]*rhs[0] - lhs[0]*rhs[2],
+			lhs[0]*rhs[1] - lhs[1]*rhs[0]);
 	}
 	//inputs vectors must be prenormalized, 
 	//and, for accurate measurments the outAxis should also be normalized after
@@ -706,6 +650,8 @@ namespace etm
 	
 } // namespace etm
 
+#include "VectorSimd.inl"
+
 //shorthands
 typedef etm::vector<2, float>  vec2;
 typedef etm::vector<3, float>  vec3;
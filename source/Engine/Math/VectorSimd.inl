@@ -0,0 +1,147 @@
+#pragma once
+
+//SSE specializations for vec4
+//****************************
+
+// These replace the generic templates for vector<4, float> when ETM_SIMD_SSE is defined (see Simd.hpp)
+// The order of operations matches the scalar versions, so results are identical to the generic implementation
+
+#ifdef ETM_SIMD_SSE
+
+namespace etm
+{
+	namespace simd
+	{
+		inline __m128 Load(const vector<4, float> &vec)
+		{
+			return _mm_loadu_ps(vec.data);
+		}
+		inline vector<4, float> Store(const __m128 reg)
+		{
+			vector<4, float> result(uninitialized);
+			_mm_storeu_ps(result.data, reg);
+			return result;
+		}
+
+		//vec3s are 12 bytes so we can't load them directly without reading past the end, w is set to zero
+		inline __m128 Load(const vector<3, float> &vec)
+		{
+			return _mm_set_ps(0.f, vec.z, vec.y, vec.x);
+		}
+		inline vector<3, float> Store3(const __m128 reg)
+		{
+			float temp[4];
+			_mm_storeu_ps(temp, reg);
+			return vector<3, float>(temp[0], temp[1], temp[2]);
+		}
+
+		//sums x, y and z in the same order as the scalar dot product and returns the result in every lane
+		inline __m128 HorizontalAdd3(const __m128 reg)
+		{
+			__m128 sum = _mm_add_ss(reg, _mm_shuffle_ps(reg, reg, _MM_SHUFFLE(1, 1, 1, 1)));
+			sum = _mm_add_ss(sum, _mm_shuffle_ps(reg, reg, _MM_SHUFFLE(2, 2, 2, 2)));
+			return _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(0, 0, 0, 0));
+		}
+		inline __m128 HorizontalAdd4(const __m128 reg)
+		{
+			__m128 sum = _mm_add_ss(reg, _mm_shuffle_ps(reg, reg, _MM_SHUFFLE(1, 1, 1, 1)));
+			sum = _mm_add_ss(sum, _mm_shuffle_ps(reg, reg, _MM_SHUFFLE(2, 2, 2, 2)));
+			sum = _mm_add_ss(sum, _mm_shuffle_ps(reg, reg, _MM_SHUFFLE(3, 3, 3, 3)));
+			return _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(0, 0, 0, 0));
+		}
+
+		inline __m128 Dot3(const __m128 lhs, const __m128 rhs)
+		{
+			return HorizontalAdd3(_mm_mul_ps(lhs, rhs));
+		}
+		//left handed cross product, w will be zero if it is zero in both inputs
+		inline __m128 Cross(const __m128 lhs, const __m128 rhs)
+		{
+			__m128 lhsYZX = _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 lhsZXY = _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(3, 1, 0, 2));
+			__m128 rhsYZX = _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 rhsZXY = _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(3, 1, 0, 2));
+			return _mm_sub_ps(_mm_mul_ps(lhsYZX, rhsZXY), _mm_mul_ps(lhsZXY, rhsYZX));
+		}
+		//replaces the w component of vec with the first component of w
+		inline __m128 SetW(const __m128 vec, const __m128 w)
+		{
+			__m128 zw = _mm_shuffle_ps(w, vec, _MM_SHUFFLE(2, 2, 0, 0));
+			return _mm_shuffle_ps(vec, zw, _MM_SHUFFLE(0, 2, 1, 0));
+		}
+		inline __m128 Normalize3(const __m128 vec)
+		{
+			return _mm_div_ps(vec, _mm_sqrt_ps(Dot3(vec, vec)));
+		}
+	} // namespace simd
+
+	//negate
+	template <>
+	inline vector<4, float> vector<4, float>::operator-() const
+	{
+		return simd::Store(_mm_xor_ps(simd::Load(*this), _mm_set1_ps(-0.f)));
+	}
+
+	//addition
+	template <>
+	inline vector<4, float> operator+<4, float>(const vector<4, float> &lhs, const vector<4, float> &rhs)
+	{
+		return simd::Store(_mm_add_ps(simd::Load(lhs), simd::Load(rhs)));
+	}
+	template <>
+	inline vector<4, float> operator+<4, float>(const vector<4, float> &lhs, const float scalar)
+	{
+		return simd::Store(_mm_add_ps(simd::Load(lhs), _mm_set1_ps(scalar)));
+	}
+
+	//subtraction
+	template <>
+	inline vector<4, float> operator-<4, float>(const vector<4, float> &lhs, const vector<4, float> &rhs)
+	{
+		return simd::Store(_mm_sub_ps(simd::Load(lhs), simd::Load(rhs)));
+	}
+	template <>
+	inline vector<4, float> operator-<4, float>(const vector<4, float> &lhs, const float scalar)
+	{
+		return simd::Store(_mm_sub_ps(simd::Load(lhs), _mm_set1_ps(scalar)));
+	}
+
+	//multiplication
+	template <>
+	inline vector<4, float> operator*<4, float>(const vector<4, float> lhs, const float &scalar)
+	{
+		return simd::Store(_mm_mul_ps(simd::Load(lhs), _mm_set1_ps(scalar)));
+	}
+	template <>
+	inline vector<4, float> operator*<4, float>(const float scalar, const vector<4, float> &lhs)
+	{
+		return simd::Store(_mm_mul_ps(simd::Load(lhs), _mm_set1_ps(scalar)));
+	}
+	template <>
+	inline vector<4, float> operator*<4, float>(const vector<4, float> &lhs, const vector<4, float> &rhs)
+	{
+		return simd::Store(_mm_mul_ps(simd::Load(lhs), simd::Load(rhs)));
+	}
+
+	//division
+	template <>
+	inline vector<4, float> operator/<4, float>(const vector<4, float> &lhs, const float scalar)
+	{
+		return simd::Store(_mm_div_ps(simd::Load(lhs), _mm_set1_ps(scalar)));
+	}
+	template <>
+	inline vector<4, float> operator/<4, float>(const vector<4, float> &lhs, const vector<4, float> &rhs)
+	{
+		return simd::Store(_mm_div_ps(simd::Load(lhs), simd::Load(rhs)));
+	}
+
+	//dot product
+	template <>
+	inline float dot<float>(const vector<4, float> &lhs, const vector<4, float> &rhs)
+	{
+		return _mm_cvtss_f32(simd::HorizontalAdd4(_mm_mul_ps(simd::Load(lhs), simd::Load(rhs))));
+	}
+
+} // namespace etm
+
+#endif // ETM_SIMD_SSE
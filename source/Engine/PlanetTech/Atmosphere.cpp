@@ -11,6 +11,7 @@
 #include "../Graphics/TextureData.hpp"
 #include "../GraphicsHelper/PrimitiveRenderer.hpp"
 #include "../GraphicsHelper/RenderPipeline.hpp"
+#include "../GraphicsHelper/SceneVisibility.hpp"
 #include "../Graphics/Frustum.hpp"
 #include "SpriteRenderer.hpp"
 #include "Skybox.hpp"
@@ -19,6 +20,7 @@
 
 
 Atmosphere::Atmosphere(const std::string &paramFileName)
+	: m_CacheFile(AtmosphereTables::GetCacheFileName(paramFileName))
 {
 	m_Params = AtmosphereParameters(paramFileName, m_SkyColor, m_SunColor);
 }
@@ -40,14 +42,32 @@ void Atmosphere::Precalculate()
 
 void Atmosphere::Initialize()
 {
-	Precalculate();
+	//the look up tables only change with the parameters, computing them once is enough
+	uint32 hash = AtmosphereTables::GetHash(m_Params, m_Settings);
+	AtmosphereTables tables;
+	if (!m_CacheFile.empty() && tables.Load(m_CacheFile, hash))
+	{
+		CreateTextures(tables);
+	}
+	else
+	{
+		Precalculate();
+		tables = ReadBackTables();
+		if (!m_CacheFile.empty() && !tables.Save(m_CacheFile, hash))
+		{
+			LOG("Couldn't save the atmosphere look up tables to " + m_CacheFile + ", they will be computed again next time", Warning);
+		}
+	}
+	m_Tables.transmittanceSize = tables.transmittanceSize;
+	m_Tables.transmittance = std::move(tables.transmittance);
+
 	//Load and compile Shaders
 	m_pShader = ContentManager::Load<ShaderData>("Shaders/PostAtmosphere.glsl");
 	GetUniforms();
 }
 void Atmosphere::Draw(Planet* pPlanet, float radius)
 {
-	vec3 pos = pPlanet->GetTransform()->GetPosition();
+	vec3 pos = pPlanet->GetTransform()->GetWorldPosition();
 	float surfaceRadius = pPlanet->GetRadius();
 	radius += surfaceRadius;
 	float icoRadius = radius / 0.996407747f;//scale up the sphere so the face center reaches the top of the atmosphere
@@ -55,6 +75,9 @@ void Atmosphere::Draw(Planet* pPlanet, float radius)
 	Sphere objSphere = Sphere(pos, radius);
 	if (CAMERA->GetFrustum()->ContainsSphere(objSphere) == VolumeCheck::OUTSIDE)
 		return;
+	//behind another planet
+	if (RenderPipeline::GetInstance()->GetVisibility()->GetSphereOccluders().IsOccluded(objSphere))
+		return;
 
 	//mat4 World = etm::translate(pos)*etm::scale(vec3(icoRadius));
 	mat4 World = etm::scale(vec3(icoRadius))*etm::translate(pos);
@@ -92,7 +115,7 @@ void Atmosphere::Draw(Planet* pPlanet, float radius)
 	glUniform1f(m_uSurfaceRadius, surfaceRadius);
 
 	m_Params.Upload(m_pShader, "uAtmosphere");
-	AtmospherePrecompute::GetInstance()->GetSettings().UploadTextureSize(m_pShader);
+	m_Settings.UploadTextureSize(m_pShader);
 
 	vec3 skySpectralRadToLum = vec3((float)m_SkyColor.x, (float)m_SkyColor.y, (float)m_SkyColor.z);
 	glUniform3fv(m_uSkySpectralRadToLum, 1, etm::valuePtr(skySpectralRadToLum));
@@ -125,6 +148,19 @@ void Atmosphere::Draw(Planet* pPlanet, float radius)
 	STATE->SetCullEnabled(false);
 }
 
+vec3 Atmosphere::GetTransmittance(float r, float mu) const
+{
+	return m_Tables.GetTransmittanceToSpace(m_Params, r, mu);
+}
+vec3 Atmosphere::GetSunIrradiance(const vec3 &position, const vec3 &sunDir) const
+{
+	return m_Tables.GetSunIrradiance(m_Params, position, sunDir);
+}
+void Atmosphere::GetSunIrradiance(const etm::soa<3, float> &positions, const vec3 &sunDir, etm::soa<3, float> &irradiance) const
+{
+	m_Tables.GetSunIrradiance(m_Params, positions, sunDir, irradiance);
+}
+
 void Atmosphere::GetUniforms()
 {
 	if (!m_pShader)
@@ -150,4 +186,37 @@ void Atmosphere::GetUniforms()
 
 	m_uSkySpectralRadToLum = glGetUniformLocation(m_pShader->GetProgram(), "uSkySpectralRadToLum");
 	m_uSunSpectralRadToLum = glGetUniformLocation(m_pShader->GetProgram(), "uSunSpectralRadToLum");
-}
\ No newline at end of file
+}
+
+//Same formats the precomputation renders to
+void Atmosphere::CreateTextures(AtmosphereTables &tables)
+{
+	m_TexTransmittance = new TextureData(tables.transmittanceSize.x, tables.transmittanceSize.y,
+		m_Settings.INTERNAL2D, m_Settings.FORMAT, GL_FLOAT);
+	m_TexTransmittance->Build(tables.transmittance.data());
+	m_TexTransmittance->SetParameters(m_Settings.m_TexParams);
+
+	m_TexIrradiance = new TextureData(tables.irradianceSize.x, tables.irradianceSize.y,
+		m_Settings.INTERNAL2D, m_Settings.FORMAT, GL_FLOAT);
+	m_TexIrradiance->Build(tables.irradiance.data());
+	m_TexIrradiance->SetParameters(m_Settings.m_TexParams);
+
+	m_TexInscatter = new TextureData(tables.scatteringSize.x, tables.scatteringSize.y,
+		m_Settings.INTERNAL3D, m_Settings.FORMAT, GL_FLOAT, tables.scatteringSize.z);
+	m_TexInscatter->Build(tables.scattering.data());
+	m_TexInscatter->SetParameters(m_Settings.m_TexParams);
+}
+
+AtmosphereTables Atmosphere::ReadBackTables()
+{
+	AtmosphereTables tables(m_Settings);
+	auto readBack = [](TextureData* pTexture, std::vector<vec4> &values)
+	{
+		STATE->LazyBindTexture(0, pTexture->GetTarget(), pTexture->GetHandle());
+		glGetTexImage(pTexture->GetTarget(), 0, GL_RGBA, GL_FLOAT, values.data());
+	};
+	readBack(m_TexTransmittance, tables.transmittance);
+	readBack(m_TexIrradiance, tables.irradiance);
+	readBack(m_TexInscatter, tables.scattering);
+	return tables;
+}
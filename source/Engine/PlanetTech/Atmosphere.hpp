@@ -3,6 +3,7 @@
 #include "../Graphics/TextureData.hpp"
 
 #include "AtmosphereSettings.h"
+#include "AtmosphereTables.hpp"
 
 class Planet;
 class Atmosphere;
@@ -22,10 +23,18 @@ public:
 
 	void SetSunlight(LightComponent* pLight) { m_pSun = pLight; }
 
+	//CPU look ups in the transmittance table for lighting, available after Initialize
+	//positions are relative to the planet center in the units of the atmosphere parameters, sunDir points towards the sun
+	vec3 GetTransmittance(float r, float mu) const;
+	vec3 GetSunIrradiance(const vec3 &position, const vec3 &sunDir) const;
+	void GetSunIrradiance(const etm::soa<3, float> &positions, const vec3 &sunDir, etm::soa<3, float> &irradiance) const;
+
 private:
 	friend class AtmospherePrecompute;
 
 	void GetUniforms();
+	void CreateTextures(AtmosphereTables &tables);
+	AtmosphereTables ReadBackTables();
 
 	//Camera and pos reconstruction from gbuffer
 	GLint m_uMatModel;
@@ -49,6 +58,9 @@ private:
 	GLint m_uSunSpectralRadToLum;
 
 	AtmosphereParameters m_Params;
+	AtmosphereSettings m_Settings;
+	//look up tables are read from here when the parameters didn't change since they were computed
+	std::string m_CacheFile;
 	dvec3 m_SkyColor;
 	dvec3 m_SunColor;
 
@@ -56,6 +68,8 @@ private:
 	TextureData* m_TexTransmittance;
 	TextureData* m_TexIrradiance;
 	TextureData* m_TexInscatter;
+	//only the transmittance stays in memory
+	AtmosphereTables m_Tables;
 
 	ShaderData* m_pShader;
 };
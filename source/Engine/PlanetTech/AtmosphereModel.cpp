@@ -0,0 +1,504 @@
+#include "stdafx.hpp"
+#include "AtmosphereModel.hpp"
+
+#include <algorithm>
+
+#include "../Helper/TaskScheduler.hpp"
+
+//Sample counts, units and formulas are the ones in CommonAtmosphere.glsl, where everything is explained in detail
+
+namespace
+{
+	float ClampCosine(float mu)
+	{
+		return etm::Clamp(mu, 1.f, -1.f);
+	}
+	float ClampDistance(float d)
+	{
+		return std::max(d, 0.f);
+	}
+	float SafeSqrt(float a)
+	{
+		return sqrtf(std::max(a, 0.f));
+	}
+	vec3 Exp(const vec3 &v)
+	{
+		return vec3(expf(v.x), expf(v.y), expf(v.z));
+	}
+	vec3 Saturate(const vec3 &v)
+	{
+		return vec3(std::min(v.x, 1.f), std::min(v.y, 1.f), std::min(v.z, 1.f));
+	}
+
+	float GetLayerDensity(const DensityProfileLayer &layer, float altitude)
+	{
+		float density = layer.exp_term * expf(layer.exp_scale * altitude) + layer.linear_term * altitude + layer.constant_term;
+		return etm::Clamp(density, 1.f, 0.f);
+	}
+	float GetProfileDensity(const DensityProfile &profile, float altitude)
+	{
+		return altitude < profile.layers[0].width ? GetLayerDensity(profile.layers[0], altitude) : GetLayerDensity(profile.layers[1], altitude);
+	}
+
+	float RayleighPhaseFunction(float nu)
+	{
+		float k = 3.f / (16.f * etm::PI);
+		return k * (1.f + nu * nu);
+	}
+	float MiePhaseFunction(float g, float nu)
+	{
+		float k = 3.f / (8.f * etm::PI) * (1.f - g * g) / (2.f + g * g);
+		return k * (1.f + nu * nu) / powf(1.f + g * g - 2.f * g * nu, 1.5f);
+	}
+
+	//Spreads the rows of a 2D table over the workers
+	void ForEachRow(TaskScheduler &scheduler, int32 rowCount, const std::function<void(int32 y)> &function)
+	{
+		for (int32 y = 0; y < rowCount; ++y)
+		{
+			scheduler.Push(0, [&function, y](uint32) { function(y); });
+		}
+		scheduler.Run();
+	}
+}
+
+AtmosphereModel::AtmosphereModel(const AtmosphereParameters &params, const AtmosphereSettings &settings)
+	: m_Params(params)
+	, m_Settings(settings)
+	, m_Tables(settings)
+{ }
+
+//The same steps AtmospherePrecompute renders, every one waits for the previous one to finish
+void AtmosphereModel::Precalculate(uint32 workerCount)
+{
+	TaskScheduler scheduler(workerCount);
+	const ivec2 transmittanceSize = m_Tables.transmittanceSize;
+	const ivec2 irradianceSize = m_Tables.irradianceSize;
+	const ivec3 scatteringSize = m_Tables.scatteringSize;
+
+	m_DeltaIrradiance.assign(m_Tables.irradiance.size(), vec4(0.f));
+	m_DeltaRayleigh.assign(m_Tables.scattering.size(), vec4(0.f));
+	m_DeltaMie.assign(m_Tables.scattering.size(), vec4(0.f));
+	m_DeltaScatteringDensity.assign(m_Tables.scattering.size(), vec4(0.f));
+
+	ForEachRow(scheduler, transmittanceSize.y, [&](int32 y)
+	{
+		for (int32 x = 0; x < transmittanceSize.x; ++x)
+		{
+			float r, mu;
+			GetRMuFromTransmittanceTextureUv(vec2((x + 0.5f) / transmittanceSize.x, (y + 0.5f) / transmittanceSize.y), r, mu);
+			m_Tables.transmittance[y * transmittanceSize.x + x] = vec4(ComputeTransmittanceToTopAtmosphereBoundary(r, mu), 0.f);
+		}
+	});
+
+	//the direct irradiance only feeds the next order, the irradiance table starts out empty
+	ForEachRow(scheduler, irradianceSize.y, [&](int32 y)
+	{
+		for (int32 x = 0; x < irradianceSize.x; ++x)
+		{
+			float r, muS;
+			GetRMuSFromIrradianceTextureUv(vec2((x + 0.5f) / irradianceSize.x, (y + 0.5f) / irradianceSize.y), r, muS);
+			m_DeltaIrradiance[y * irradianceSize.x + x] = vec4(ComputeDirectIrradiance(r, muS), 0.f);
+			m_Tables.irradiance[y * irradianceSize.x + x] = vec4(0.f);
+		}
+	});
+
+	ForEachScatteringRow(scheduler, [&](int32 layer, int32 y)
+	{
+		for (int32 x = 0; x < scatteringSize.x; ++x)
+		{
+			float r, mu, muS, nu;
+			bool rayIntersectsGround;
+			GetRMuMuSNuFromScatteringTextureFragCoord(vec3(x + 0.5f, y + 0.5f, layer + 0.5f), r, mu, muS, nu, rayIntersectsGround);
+			vec3 rayleigh, mie;
+			ComputeSingleScattering(r, mu, muS, nu, rayIntersectsGround, rayleigh, mie);
+			int32 texel = (layer * scatteringSize.y + y) * scatteringSize.x + x;
+			m_DeltaRayleigh[texel] = vec4(rayleigh, 0.f);
+			m_DeltaMie[texel] = vec4(mie, 0.f);
+			m_Tables.scattering[texel] = vec4(rayleigh, mie.x);
+		}
+	});
+
+	for (int32 scatteringOrder = 2; scatteringOrder <= m_Settings.SCATTERING_ORDERS; ++scatteringOrder)
+	{
+		ForEachScatteringRow(scheduler, [&](int32 layer, int32 y)
+		{
+			for (int32 x = 0; x < scatteringSize.x; ++x)
+			{
+				float r, mu, muS, nu;
+				bool rayIntersectsGround;
+				GetRMuMuSNuFromScatteringTextureFragCoord(vec3(x + 0.5f, y + 0.5f, layer + 0.5f), r, mu, muS, nu, rayIntersectsGround);
+				m_DeltaScatteringDensity[(layer * scatteringSize.y + y) * scatteringSize.x + x] = vec4(ComputeScatteringDensity(r, mu, muS, nu, scatteringOrder), 0.f);
+			}
+		});
+
+		ForEachRow(scheduler, irradianceSize.y, [&](int32 y)
+		{
+			for (int32 x = 0; x < irradianceSize.x; ++x)
+			{
+				float r, muS;
+				GetRMuSFromIrradianceTextureUv(vec2((x + 0.5f) / irradianceSize.x, (y + 0.5f) / irradianceSize.y), r, muS);
+				vec3 irradiance = ComputeIndirectIrradiance(r, muS, scatteringOrder);
+				m_DeltaIrradiance[y * irradianceSize.x + x] = vec4(irradiance, 0.f);
+				m_Tables.irradiance[y * irradianceSize.x + x] = m_Tables.irradiance[y * irradianceSize.x + x] + vec4(irradiance, 0.f);
+			}
+		});
+
+		ForEachScatteringRow(scheduler, [&](int32 layer, int32 y)
+		{
+			for (int32 x = 0; x < scatteringSize.x; ++x)
+			{
+				float r, mu, muS, nu;
+				bool rayIntersectsGround;
+				GetRMuMuSNuFromScatteringTextureFragCoord(vec3(x + 0.5f, y + 0.5f, layer + 0.5f), r, mu, muS, nu, rayIntersectsGround);
+				vec3 multipleScattering = ComputeMultipleScattering(r, mu, muS, nu, rayIntersectsGround);
+				int32 texel = (layer * scatteringSize.y + y) * scatteringSize.x + x;
+				m_DeltaRayleigh[texel] = vec4(multipleScattering, 0.f);
+				m_Tables.scattering[texel] = m_Tables.scattering[texel] + vec4(multipleScattering / RayleighPhaseFunction(nu), 0.f);
+			}
+		});
+	}
+
+	m_DeltaIrradiance = std::vector<vec4>();
+	m_DeltaRayleigh = std::vector<vec4>();
+	m_DeltaMie = std::vector<vec4>();
+	m_DeltaScatteringDensity = std::vector<vec4>();
+}
+
+void AtmosphereModel::ForEachScatteringRow(TaskScheduler &scheduler, const std::function<void(int32 layer, int32 y)> &function)
+{
+	int32 height = m_Tables.scatteringSize.y;
+	ForEachRow(scheduler, m_Tables.scatteringSize.z * height, [&function, height](int32 row) { function(row / height, row % height); });
+}
+
+//***********************
+// TRANSMITTANCE
+//***********************
+
+float AtmosphereModel::DistanceToTopAtmosphereBoundary(float r, float mu) const
+{
+	float discriminant = r * r * (mu * mu - 1.f) + m_Params.top_radius * m_Params.top_radius;
+	return ClampDistance(-r * mu + SafeSqrt(discriminant));
+}
+float AtmosphereModel::DistanceToBottomAtmosphereBoundary(float r, float mu) const
+{
+	float discriminant = r * r * (mu * mu - 1.f) + m_Params.bottom_radius * m_Params.bottom_radius;
+	return ClampDistance(-r * mu - SafeSqrt(discriminant));
+}
+float AtmosphereModel::DistanceToNearestAtmosphereBoundary(float r, float mu, bool rayIntersectsGround) const
+{
+	return rayIntersectsGround ? DistanceToBottomAtmosphereBoundary(r, mu) : DistanceToTopAtmosphereBoundary(r, mu);
+}
+bool AtmosphereModel::RayIntersectsGround(float r, float mu) const
+{
+	return mu < 0.f && r * r * (mu * mu - 1.f) + m_Params.bottom_radius * m_Params.bottom_radius >= 0.f;
+}
+
+float AtmosphereModel::ComputeOpticalLengthToTopAtmosphereBoundary(const DensityProfile &profile, float r, float mu) const
+{
+	const int32 sampleCount = 500;
+	float dx = DistanceToTopAtmosphereBoundary(r, mu) / (float)sampleCount;
+	float result = 0.f;
+	for (int32 i = 0; i <= sampleCount; ++i)
+	{
+		float d = (float)i * dx;
+		float rI = sqrtf(d * d + 2.f * r * mu * d + r * r);
+		float y = GetProfileDensity(profile, rI - m_Params.bottom_radius);
+		//trapezoidal rule
+		float weight = i == 0 || i == sampleCount ? 0.5f : 1.f;
+		result += y * weight * dx;
+	}
+	return result;
+}
+vec3 AtmosphereModel::ComputeTransmittanceToTopAtmosphereBoundary(float r, float mu) const
+{
+	float rayleighLength = ComputeOpticalLengthToTopAtmosphereBoundary(m_Params.rayleigh_density, r, mu);
+	float mieLength = ComputeOpticalLengthToTopAtmosphereBoundary(m_Params.mie_density, r, mu);
+	float absorptionLength = ComputeOpticalLengthToTopAtmosphereBoundary(m_Params.absorption_density, r, mu);
+	return Exp(-(m_Params.rayleighScattering * rayleighLength + m_Params.mieExtinction * mieLength + m_Params.absorptionExtinction * absorptionLength));
+}
+
+void AtmosphereModel::GetRMuFromTransmittanceTextureUv(const vec2 &uv, float &r, float &mu) const
+{
+	float xMu = AtmosphereTables::GetUnitRangeFromTextureCoord(uv.x, m_Settings.TRANSMITTANCE_W);
+	float xR = AtmosphereTables::GetUnitRangeFromTextureCoord(uv.y, m_Settings.TRANSMITTANCE_H);
+	float H = sqrtf(m_Params.top_radius * m_Params.top_radius - m_Params.bottom_radius * m_Params.bottom_radius);
+	float rho = H * xR;
+	r = sqrtf(rho * rho + m_Params.bottom_radius * m_Params.bottom_radius);
+	float dMin = m_Params.top_radius - r;
+	float dMax = rho + H;
+	float d = dMin + xMu * (dMax - dMin);
+	mu = d == 0.f ? 1.f : (H * H - rho * rho - d * d) / (2.f * r * d);
+	mu = ClampCosine(mu);
+}
+
+vec3 AtmosphereModel::GetTransmittanceToTopAtmosphereBoundary(float r, float mu) const
+{
+	return m_Tables.GetTransmittanceToTopAtmosphereBoundary(m_Params, r, mu);
+}
+vec3 AtmosphereModel::GetTransmittance(float r, float mu, float d, bool rayIntersectsGround) const
+{
+	float rD = etm::Clamp(sqrtf(d * d + 2.f * r * mu * d + r * r), m_Params.top_radius, m_Params.bottom_radius);
+	float muD = ClampCosine((r * mu + d) / rD);
+	if (rayIntersectsGround)
+	{
+		return Saturate(GetTransmittanceToTopAtmosphereBoundary(rD, -muD) / GetTransmittanceToTopAtmosphereBoundary(r, -mu));
+	}
+	return Saturate(GetTransmittanceToTopAtmosphereBoundary(r, mu) / GetTransmittanceToTopAtmosphereBoundary(rD, muD));
+}
+vec3 AtmosphereModel::GetTransmittanceToSun(float r, float muS) const
+{
+	return m_Tables.GetTransmittanceToSun(m_Params, r, muS);
+}
+
+//***********************
+// SCATTERING
+//***********************
+
+void AtmosphereModel::ComputeSingleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, vec3 &rayleigh, vec3 &mie) const
+{
+	const int32 sampleCount = 50;
+	float dx = DistanceToNearestAtmosphereBoundary(r, mu, rayIntersectsGround) / (float)sampleCount;
+	vec3 rayleighSum(0.f);
+	vec3 mieSum(0.f);
+	for (int32 i = 0; i <= sampleCount; ++i)
+	{
+		float d = (float)i * dx;
+		float rD = etm::Clamp(sqrtf(d * d + 2.f * r * mu * d + r * r), m_Params.top_radius, m_Params.bottom_radius);
+		float muSD = ClampCosine((r * muS + d * nu) / rD);
+		vec3 transmittance = GetTransmittance(r, mu, d, rayIntersectsGround) * GetTransmittanceToSun(rD, muSD);
+		float weight = i == 0 || i == sampleCount ? 0.5f : 1.f;
+		rayleighSum = rayleighSum + transmittance * GetProfileDensity(m_Params.rayleigh_density, rD - m_Params.bottom_radius) * weight;
+		mieSum = mieSum + transmittance * GetProfileDensity(m_Params.mie_density, rD - m_Params.bottom_radius) * weight;
+	}
+	rayleigh = rayleighSum * dx * m_Params.solarIrradiance * m_Params.rayleighScattering;
+	mie = mieSum * dx * m_Params.solarIrradiance * m_Params.mieScattering;
+}
+
+vec4 AtmosphereModel::GetScatteringTextureUvwzFromRMuMuSNu(float r, float mu, float muS, float nu, bool rayIntersectsGround) const
+{
+	float H = sqrtf(m_Params.top_radius * m_Params.top_radius - m_Params.bottom_radius * m_Params.bottom_radius);
+	float rho = SafeSqrt(r * r - m_Params.bottom_radius * m_Params.bottom_radius);
+	float uR = AtmosphereTables::GetTextureCoordFromUnitRange(rho / H, m_Settings.INSCATTER_R);
+
+	float rMu = r * mu;
+	float discriminant = rMu * rMu - r * r + m_Params.bottom_radius * m_Params.bottom_radius;
+	float uMu;
+	if (rayIntersectsGround)
+	{
+		float d = -rMu - SafeSqrt(discriminant);
+		float dMin = r - m_Params.bottom_radius;
+		float dMax = rho;
+		uMu = 0.5f - 0.5f * AtmosphereTables::GetTextureCoordFromUnitRange(dMax == dMin ? 0.f : (d - dMin) / (dMax - dMin), m_Settings.INSCATTER_MU / 2);
+	}
+	else
+	{
+		float d = -rMu + SafeSqrt(discriminant + H * H);
+		float dMin = m_Params.top_radius - r;
+		float dMax = rho + H;
+		uMu = 0.5f + 0.5f * AtmosphereTables::GetTextureCoordFromUnitRange((d - dMin) / (dMax - dMin), m_Settings.INSCATTER_MU / 2);
+	}
+
+	float d = DistanceToTopAtmosphereBoundary(m_Params.bottom_radius, muS);
+	float dMin = m_Params.top_radius - m_Params.bottom_radius;
+	float dMax = H;
+	float a = (d - dMin) / (dMax - dMin);
+	float A = -2.f * m_Params.mu_s_min * m_Params.bottom_radius / (dMax - dMin);
+	float uMuS = AtmosphereTables::GetTextureCoordFromUnitRange(std::max(1.f - a / A, 0.f) / (1.f + a), m_Settings.INSCATTER_MU_S);
+
+	float uNu = (nu + 1.f) / 2.f;
+	return vec4(uNu, uMuS, uMu, uR);
+}
+void AtmosphereModel::GetRMuMuSNuFromScatteringTextureFragCoord(const vec3 &fragCoord, float &r, float &mu, float &muS, float &nu, bool &rayIntersectsGround) const
+{
+	float fragCoordNu = floorf(fragCoord.x / (float)m_Settings.INSCATTER_MU_S);
+	float fragCoordMuS = fmodf(fragCoord.x, (float)m_Settings.INSCATTER_MU_S);
+	vec4 uvwz(fragCoordNu / (float)(m_Settings.INSCATTER_NU - 1), fragCoordMuS / (float)m_Settings.INSCATTER_MU_S,
+		fragCoord.y / (float)m_Settings.INSCATTER_MU, fragCoord.z / (float)m_Settings.INSCATTER_R);
+
+	float H = sqrtf(m_Params.top_radius * m_Params.top_radius - m_Params.bottom_radius * m_Params.bottom_radius);
+	float rho = H * AtmosphereTables::GetUnitRangeFromTextureCoord(uvwz.w, m_Settings.INSCATTER_R);
+	r = sqrtf(rho * rho + m_Params.bottom_radius * m_Params.bottom_radius);
+
+	if (uvwz.z < 0.5f)
+	{
+		float dMin = r - m_Params.bottom_radius;
+		float dMax = rho;
+		float d = dMin + (dMax - dMin) * AtmosphereTables::GetUnitRangeFromTextureCoord(1.f - 2.f * uvwz.z, m_Settings.INSCATTER_MU / 2);
+		mu = d == 0.f ? -1.f : ClampCosine(-(rho * rho + d * d) / (2.f * r * d));
+		rayIntersectsGround = true;
+	}
+	else
+	{
+		float dMin = m_Params.top_radius - r;
+		float dMax = rho + H;
+		float d = dMin + (dMax - dMin) * AtmosphereTables::GetUnitRangeFromTextureCoord(2.f * uvwz.z - 1.f, m_Settings.INSCATTER_MU / 2);
+		mu = d == 0.f ? 1.f : ClampCosine((H * H - rho * rho - d * d) / (2.f * r * d));
+		rayIntersectsGround = false;
+	}
+
+	float xMuS = AtmosphereTables::GetUnitRangeFromTextureCoord(uvwz.y, m_Settings.INSCATTER_MU_S);
+	float dMin = m_Params.top_radius - m_Params.bottom_radius;
+	float dMax = H;
+	float A = -2.f * m_Params.mu_s_min * m_Params.bottom_radius / (dMax - dMin);
+	float a = (A - xMuS * A) / (1.f + xMuS * A);
+	float d = dMin + std::min(a, A) * (dMax - dMin);
+	muS = d == 0.f ? 1.f : ClampCosine((H * H - d * d) / (2.f * m_Params.bottom_radius * d));
+
+	nu = ClampCosine(uvwz.x * 2.f - 1.f);
+	//the range nu can have with mu and muS
+	float spread = sqrtf((1.f - mu * mu) * (1.f - muS * muS));
+	nu = etm::Clamp(nu, mu * muS + spread, mu * muS - spread);
+}
+
+//The 4D table is stored in 3D with nu and muS sharing an axis, so neighbouring nu values are blended by hand
+vec3 AtmosphereModel::GetScattering(const std::vector<vec4> &table, float r, float mu, float muS, float nu, bool rayIntersectsGround) const
+{
+	vec4 uvwz = GetScatteringTextureUvwzFromRMuMuSNu(r, mu, muS, nu, rayIntersectsGround);
+	float texCoordX = uvwz.x * (float)(m_Settings.INSCATTER_NU - 1);
+	float texX = floorf(texCoordX);
+	float lerp = texCoordX - texX;
+	vec3 uvw0((texX + uvwz.y) / (float)m_Settings.INSCATTER_NU, uvwz.z, uvwz.w);
+	vec3 uvw1((texX + 1.f + uvwz.y) / (float)m_Settings.INSCATTER_NU, uvwz.z, uvwz.w);
+	return (AtmosphereTables::Sample(table, m_Tables.scatteringSize, uvw0) * (1.f - lerp) + AtmosphereTables::Sample(table, m_Tables.scatteringSize, uvw1) * lerp).xyz;
+}
+vec3 AtmosphereModel::GetScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, int32 scatteringOrder) const
+{
+	if (scatteringOrder == 1)
+	{
+		vec3 rayleigh = GetScattering(m_DeltaRayleigh, r, mu, muS, nu, rayIntersectsGround);
+		vec3 mie = GetScattering(m_DeltaMie, r, mu, muS, nu, rayIntersectsGround);
+		return rayleigh * RayleighPhaseFunction(nu) + mie * MiePhaseFunction(m_Params.mie_phase_function_g, nu);
+	}
+	return GetScattering(m_DeltaRayleigh, r, mu, muS, nu, rayIntersectsGround);
+}
+
+vec3 AtmosphereModel::ComputeScatteringDensity(float r, float mu, float muS, float nu, int32 scatteringOrder) const
+{
+	vec3 zenithDirection(0.f, 0.f, 1.f);
+	vec3 omega(sqrtf(1.f - mu * mu), 0.f, mu);
+	float sunDirX = omega.x == 0.f ? 0.f : (nu - mu * muS) / omega.x;
+	float sunDirY = sqrtf(std::max(1.f - sunDirX * sunDirX - muS * muS, 0.f));
+	vec3 omegaS(sunDirX, sunDirY, muS);
+
+	const int32 sampleCount = 16;
+	const float dphi = etm::PI / (float)sampleCount;
+	const float dtheta = etm::PI / (float)sampleCount;
+	vec3 rayleighMie(0.f);
+
+	//the density only depends on the altitude
+	float rayleighDensity = GetProfileDensity(m_Params.rayleigh_density, r - m_Params.bottom_radius);
+	float mieDensity = GetProfileDensity(m_Params.mie_density, r - m_Params.bottom_radius);
+
+	for (int32 l = 0; l < sampleCount; ++l)
+	{
+		float theta = ((float)l + 0.5f) * dtheta;
+		float cosTheta = cosf(theta);
+		float sinTheta = sinf(theta);
+		bool rayThetaIntersectsGround = RayIntersectsGround(r, cosTheta);
+
+		float distanceToGround = 0.f;
+		vec3 transmittanceToGround(0.f);
+		vec3 groundAlbedo(0.f);
+		if (rayThetaIntersectsGround)
+		{
+			distanceToGround = DistanceToBottomAtmosphereBoundary(r, cosTheta);
+			transmittanceToGround = GetTransmittance(r, cosTheta, distanceToGround, true);
+			groundAlbedo = m_Params.groundAlbedo;
+		}
+
+		for (int32 m = 0; m < 2 * sampleCount; ++m)
+		{
+			float phi = ((float)m + 0.5f) * dphi;
+			vec3 omegaI(cosf(phi) * sinTheta, sinf(phi) * sinTheta, cosTheta);
+			float domegaI = dtheta * dphi * sinTheta;
+
+			float nu1 = etm::dot(omegaS, omegaI);
+			vec3 incidentRadiance = GetScattering(r, omegaI.z, muS, nu1, rayThetaIntersectsGround, scatteringOrder - 1);
+
+			//light from the ground only reaches rays that hit it
+			if (rayThetaIntersectsGround)
+			{
+				vec3 groundNormal = etm::normalize(zenithDirection * r + omegaI * distanceToGround);
+				vec3 groundIrradiance = AtmosphereTables::Sample(m_DeltaIrradiance, m_Tables.irradianceSize,
+					GetIrradianceTextureUvFromRMuS(m_Params.bottom_radius, etm::dot(groundNormal, omegaS))).xyz;
+				incidentRadiance = incidentRadiance + transmittanceToGround * groundAlbedo * (1.f / etm::PI) * groundIrradiance;
+			}
+
+			float nu2 = etm::dot(omega, omegaI);
+			rayleighMie = rayleighMie + incidentRadiance * (m_Params.rayleighScattering * rayleighDensity * RayleighPhaseFunction(nu2) +
+				m_Params.mieScattering * mieDensity * MiePhaseFunction(m_Params.mie_phase_function_g, nu2)) * domegaI;
+		}
+	}
+	return rayleighMie;
+}
+
+vec3 AtmosphereModel::ComputeMultipleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround) const
+{
+	const int32 sampleCount = 50;
+	float dx = DistanceToNearestAtmosphereBoundary(r, mu, rayIntersectsGround) / (float)sampleCount;
+	vec3 rayleighMieSum(0.f);
+	for (int32 i = 0; i <= sampleCount; ++i)
+	{
+		float d = (float)i * dx;
+		float rI = etm::Clamp(sqrtf(d * d + 2.f * r * mu * d + r * r), m_Params.top_radius, m_Params.bottom_radius);
+		float muI = ClampCosine((r * mu + d) / rI);
+		float muSI = ClampCosine((r * muS + d * nu) / rI);
+
+		vec3 rayleighMie = GetScattering(m_DeltaScatteringDensity, rI, muI, muSI, nu, rayIntersectsGround) * GetTransmittance(r, mu, d, rayIntersectsGround) * dx;
+		float weight = i == 0 || i == sampleCount ? 0.5f : 1.f;
+		rayleighMieSum = rayleighMieSum + rayleighMie * weight;
+	}
+	return rayleighMieSum;
+}
+
+//***********************
+// GROUND IRRADIANCE
+//***********************
+
+void AtmosphereModel::GetRMuSFromIrradianceTextureUv(const vec2 &uv, float &r, float &muS) const
+{
+	float xMuS = AtmosphereTables::GetUnitRangeFromTextureCoord(uv.x, m_Settings.IRRADIANCE_W);
+	float xR = AtmosphereTables::GetUnitRangeFromTextureCoord(uv.y, m_Settings.IRRADIANCE_H);
+	r = m_Params.bottom_radius + xR * (m_Params.top_radius - m_Params.bottom_radius);
+	muS = ClampCosine(2.f * xMuS - 1.f);
+}
+vec2 AtmosphereModel::GetIrradianceTextureUvFromRMuS(float r, float muS) const
+{
+	float xR = (r - m_Params.bottom_radius) / (m_Params.top_radius - m_Params.bottom_radius);
+	float xMuS = muS * 0.5f + 0.5f;
+	return vec2(AtmosphereTables::GetTextureCoordFromUnitRange(xMuS, m_Settings.IRRADIANCE_W), AtmosphereTables::GetTextureCoordFromUnitRange(xR, m_Settings.IRRADIANCE_H));
+}
+
+vec3 AtmosphereModel::ComputeDirectIrradiance(float r, float muS) const
+{
+	float alphaS = m_Params.sun_angular_radius;
+	//approximate average of the cosine factor over the visible part of the sun disc
+	float averageCosineFactor = muS < -alphaS ? 0.f : (muS > alphaS ? muS : (muS + alphaS) * (muS + alphaS) / (4.f * alphaS));
+	return m_Params.solarIrradiance * GetTransmittanceToTopAtmosphereBoundary(r, muS) * averageCosineFactor;
+}
+
+//Like the shader this reads the scattering of the order it computes, not of the one before
+vec3 AtmosphereModel::ComputeIndirectIrradiance(float r, float muS, int32 scatteringOrder) const
+{
+	const int32 sampleCount = 32;
+	const float dphi = etm::PI / (float)sampleCount;
+	const float dtheta = etm::PI / (float)sampleCount;
+
+	vec3 result(0.f);
+	vec3 omegaS(sqrtf(1.f - muS * muS), 0.f, muS);
+	for (int32 j = 0; j < sampleCount / 2; ++j)
+	{
+		float theta = ((float)j + 0.5f) * dtheta;
+		for (int32 i = 0; i < 2 * sampleCount; ++i)
+		{
+			float phi = ((float)i + 0.5f) * dphi;
+			vec3 omega(cosf(phi) * sinf(theta), sinf(phi) * sinf(theta), cosf(theta));
+			float domega = dtheta * dphi * sinf(theta);
+
+			float nu = etm::dot(omega, omegaS);
+			result = result + GetScattering(r, omega.z, muS, nu, false, scatteringOrder) * omega.z * domega;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <functional>
+
+#include "AtmosphereSettings.h"
+#include "AtmosphereTables.hpp"
+
+class TaskScheduler;
+
+//Atmosphere Model
+//****************
+
+// CPU version of the precomputed atmospheric scattering from the AtmoPreComp shaders, following them step by step so its tables can stand in for the ones rendered on the GPU.
+// It doesn't need a graphics context, so tables can be created headless and the shaders have something to be tested against.
+
+class AtmosphereModel
+{
+public:
+	AtmosphereModel(const AtmosphereParameters &params, const AtmosphereSettings &settings);
+
+	//Computes the tables with the scattering orders from the settings, on workerCount threads or one per hardware thread for 0
+	void Precalculate(uint32 workerCount = 0);
+	const AtmosphereTables& GetTables() const { return m_Tables; }
+
+	//integrated along the ray
+	vec3 ComputeTransmittanceToTopAtmosphereBoundary(float r, float mu) const;
+	//looked up in the transmittance table, like the shaders do
+	vec3 GetTransmittanceToTopAtmosphereBoundary(float r, float mu) const;
+
+private:
+	//Transmittance
+	float DistanceToTopAtmosphereBoundary(float r, float mu) const;
+	float DistanceToBottomAtmosphereBoundary(float r, float mu) const;
+	float DistanceToNearestAtmosphereBoundary(float r, float mu, bool rayIntersectsGround) const;
+	bool RayIntersectsGround(float r, float mu) const;
+	float ComputeOpticalLengthToTopAtmosphereBoundary(const DensityProfile &profile, float r, float mu) const;
+	void GetRMuFromTransmittanceTextureUv(const vec2 &uv, float &r, float &mu) const;
+	vec3 GetTransmittance(float r, float mu, float d, bool rayIntersectsGround) const;
+	vec3 GetTransmittanceToSun(float r, float muS) const;
+
+	//Scattering
+	void ComputeSingleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, vec3 &rayleigh, vec3 &mie) const;
+	vec4 GetScatteringTextureUvwzFromRMuMuSNu(float r, float mu, float muS, float nu, bool rayIntersectsGround) const;
+	void GetRMuMuSNuFromScatteringTextureFragCoord(const vec3 &fragCoord, float &r, float &mu, float &muS, float &nu, bool &rayIntersectsGround) const;
+	vec3 GetScattering(const std::vector<vec4> &table, float r, float mu, float muS, float nu, bool rayIntersectsGround) const;
+	vec3 GetScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, int32 scatteringOrder) const;
+	vec3 ComputeScatteringDensity(float r, float mu, float muS, float nu, int32 scatteringOrder) const;
+	vec3 ComputeMultipleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround) const;
+
+	//Ground irradiance
+	void GetRMuSFromIrradianceTextureUv(const vec2 &uv, float &r, float &muS) const;
+	vec2 GetIrradianceTextureUvFromRMuS(float r, float muS) const;
+	vec3 ComputeDirectIrradiance(float r, float muS) const;
+	vec3 ComputeIndirectIrradiance(float r, float muS, int32 scatteringOrder) const;
+
+	//Runs the function for every row of the scattering table, rows of all layers counted one after another
+	void ForEachScatteringRow(TaskScheduler &scheduler, const std::function<void(int32 layer, int32 y)> &function);
+
+	AtmosphereParameters m_Params;
+	AtmosphereSettings m_Settings;
+	AtmosphereTables m_Tables;
+
+	//only used while precalculating, the multiple scattering shares its table with the single rayleigh scattering like the GPU textures do
+	std::vector<vec4> m_DeltaIrradiance;
+	std::vector<vec4> m_DeltaRayleigh;
+	std::vector<vec4> m_DeltaMie;
+	std::vector<vec4> m_DeltaScatteringDensity;
+};
@@ -96,7 +96,6 @@ void AtmospherePrecompute::Precalculate(Atmosphere* atmo)
 
 	STATE->BindFramebuffer(m_FBO);
 
-	int32 numScatteringOrders = 4;
 	mat3 luminanceFromRadiance = mat3(); //Might not be needed as we dont precompute luminance
 	bool blend = false; //Same here
 
@@ -179,7 +178,7 @@ void AtmospherePrecompute::Precalculate(Atmosphere* atmo)
 	}
 
 	// Compute the 2nd, 3rd and 4th order of scattering, in sequence.
-	for (int32 scatteringOrder = 2; scatteringOrder <= numScatteringOrders; ++scatteringOrder)
+	for (int32 scatteringOrder = 2; scatteringOrder <= m_Settings.SCATTERING_ORDERS; ++scatteringOrder)
 	{
 		// Compute the scattering density, and store it in
 		// delta_scattering_density_texture.
@@ -271,36 +270,23 @@ void AtmospherePrecompute::SetUniforms(ShaderData* shader, TextureData* transmit
 	glUniform1i(glGetUniformLocation(shader->GetProgram(), "uTexMie"), mie->GetHandle());
 }
 
-void AtmospherePrecompute::ComputeSpectralRadianceToLuminanceFactors(const std::vector<double>& wavelengths,
-	const std::vector<double>& solar_irradiance, double lambda_power, dvec3 &color)
+//The luminance of each channel per unit of radiance, over the whole visible spectrum instead of only the three wavelengths rendered
+void AtmospherePrecompute::ComputeSpectralRadianceToLuminanceFactors(const Spectrum &solarIrradiance, double lambdaPower, dvec3 &color)
 {
-	color = dvec3(0);
 	auto pCIE = CIE::GetInstance();
-	int32 dlambda = 1;
 	dvec3 lambdaVec = dvec3(AtmosphereSettings::kLambdaR, AtmosphereSettings::kLambdaG, AtmosphereSettings::kLambdaB);
-	dvec3 solarRGB = pCIE->Interpolate(wavelengths, solar_irradiance, lambdaVec);
-	for (int lambda = AtmosphereSettings::kLambdaMin; lambda < AtmosphereSettings::kLambdaMax; lambda += dlambda)
+	dvec3 solarRGB = solarIrradiance.Sample(lambdaVec);
+	Spectrum irradiance = solarIrradiance.Resample(pCIE->GetLambdaMin(), pCIE->GetLambdaMax(), CIE::LAMBDA_STEP);
+	for (uint8 channel = 0; channel < 3; ++channel)
 	{
-		double irradiance = pCIE->Interpolate(wavelengths, solar_irradiance, lambda);
-
-		dvec3 xyz = pCIE->GetValue(lambda, AtmosphereSettings::kLambdaMin, AtmosphereSettings::kLambdaMax);
-		dvec3 rgb = pCIE->GetRGB(xyz);
-
-		color = color + (rgb*irradiance / solarRGB * etm::pow((double)lambda / lambdaVec, lambda_power));
+		Spectrum weighted = irradiance * Spectrum::Generate(pCIE->GetLambdaMin(), pCIE->GetLambdaMax(), CIE::LAMBDA_STEP,
+			[lambdaPower, &lambdaVec, channel](double lambda) { return pow(lambda / lambdaVec[channel], lambdaPower); });
+		color[channel] = pCIE->GetRGB(weighted)[channel] / solarRGB[channel];
 	}
-	color = color * (AtmosphereSettings::MAX_LUMINOUS_EFFICACY * dlambda);
+	color = color * AtmosphereSettings::MAX_LUMINOUS_EFFICACY;
 }
 
-void AtmospherePrecompute::ConvertSpectrumToLinearSrgb( const std::vector<double>& wavelengths,
-	const std::vector<double>& spectrum, dvec3 &rgb) 
+void AtmospherePrecompute::ConvertSpectrumToLinearSrgb(const Spectrum &spectrum, dvec3 &rgb)
 {
-	dvec3 xyz = dvec3(0);
-	auto pCIE = CIE::GetInstance();
-	const int32 dlambda = 1;
-	for (int lambda = m_Settings.kLambdaMin; lambda < m_Settings.kLambdaMax; lambda += dlambda) 
-	{
-		double value = pCIE->Interpolate(wavelengths, spectrum, lambda);
-		xyz = xyz + pCIE->GetValue(lambda, AtmosphereSettings::kLambdaMin, AtmosphereSettings::kLambdaMax) * value;
-	}
-	rgb = pCIE->GetRGB(xyz);
+	rgb = CIE::GetInstance()->GetRGB(spectrum);
 }
\ No newline at end of file
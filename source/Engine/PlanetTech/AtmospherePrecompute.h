@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AtmosphereSettings.h"
+#include "../Graphics/Spectrum.hpp"
 
 class Atmosphere;
 
@@ -15,12 +16,12 @@ public:
 	void SetUniforms(ShaderData* shader, TextureData* transmittance,
 		TextureData* scattering, TextureData* irradiance, TextureData* mie);
 
-	static void ComputeSpectralRadianceToLuminanceFactors(const std::vector<double>& wavelengths, const std::vector<double>& solar_irradiance, double lambda_power, dvec3 &color);
+	static void ComputeSpectralRadianceToLuminanceFactors(const Spectrum &solarIrradiance, double lambdaPower, dvec3 &color);
 
 	const AtmosphereSettings& GetSettings() { return m_Settings; }
 
 private:
-	void ConvertSpectrumToLinearSrgb(const std::vector<double>& wavelengths, const std::vector<double>& spectrum, dvec3 &rgb);
+	void ConvertSpectrumToLinearSrgb(const Spectrum &spectrum, dvec3 &rgb);
 
 	friend class Atmosphere;// #temp
 
@@ -1,14 +1,14 @@
 #include "stdafx.hpp"
 #include "AtmosphereSettings.h"
 #include "AtmospherePrecompute.h"
-#include "CIE.h"
+#include "Spectrum.hpp"
 #include "FileSystem\Entry.h"
 #include "FileSystem\JSONparser.h"
 #include "FileSystem\FileUtil.h"
 
-vec3 InterpolatedSpectrum(const std::vector<double_t> &wavelengths, const std::vector<double_t> &v, const dvec3 &lambdas, float scale)
+vec3 InterpolatedSpectrum(const Spectrum &spectrum, const dvec3 &lambdas, float scale)
 {
-	dvec3 ret = CIE::GetInstance()->Interpolate(wavelengths, v, lambdas);
+	dvec3 ret = spectrum.Sample(lambdas);
 	return vec3((float)ret.x, (float)ret.y, (float)ret.z) * scale;
 }
 
@@ -70,50 +70,44 @@ AtmosphereParameters::AtmosphereParameters(std::string paramFileName, dvec3 &sky
 	int32 lambdaIncrement; JSON::ApplyNumValue(root, lambdaIncrement, "lambda increment");
 	double rayleighLambdaExp; JSON::ApplyNumValue(root, rayleighLambdaExp, "rayleigh lambda exp");
 
-	std::vector<double> wavelengths;
-	std::vector<double> solar_irradiance;
-	std::vector<double> rayleigh_scattering;
-	std::vector<double> mie_scattering;
-	std::vector<double> mie_extinction;
-	std::vector<double> absorption_extinction;
-	std::vector<double> ground_albedo;
-	for (int32 l = kLambdaMin; l <= kLambdaMax; l += lambdaIncrement)
-	{
-		double lambda = static_cast<double>(l) * 1e-3;  // micro-meters
-		double mie = kMieAngstromBeta / kMieScaleHeight * pow(lambda, -kMieAngstromAlpha);
-		wavelengths.push_back(l);
-		solar_irradiance.push_back(kSolarIrradiance[(l - kLambdaMin) / lambdaIncrement]);
-		rayleigh_scattering.push_back(kRayleigh * pow(lambda, rayleighLambdaExp));
-		mie_scattering.push_back(mie * kMieSingleScatteringAlbedo);
-		mie_extinction.push_back(mie);
-		absorption_extinction.push_back(kMaxOzoneNumberDensity * kOzoneCrossSection[(l - kLambdaMin) / lambdaIncrement]);
-		ground_albedo.push_back(kGroundAlbedo);
-	}
+	//the parameter file has its spectra at uniform steps already
+	double lambdaMin = (double)kLambdaMin;
+	double lambdaMax = (double)kLambdaMax;
+	double lambdaStep = (double)lambdaIncrement;
+	auto getSample = [&](const std::vector<double> &values, double lambda) { return values[(size_t)((lambda - lambdaMin) / lambdaStep + 0.5)]; };
+	auto getMie = [&](double lambda) { return kMieAngstromBeta / kMieScaleHeight * pow(lambda * 1e-3, -kMieAngstromAlpha); };// micro-meters
+
+	Spectrum solar_irradiance = Spectrum::Generate(lambdaMin, lambdaMax, lambdaStep, [&](double lambda) { return getSample(kSolarIrradiance, lambda); });
+	Spectrum rayleigh_scattering = Spectrum::Generate(lambdaMin, lambdaMax, lambdaStep, [&](double lambda) { return kRayleigh * pow(lambda * 1e-3, rayleighLambdaExp); });
+	Spectrum mie_extinction = Spectrum::Generate(lambdaMin, lambdaMax, lambdaStep, getMie);
+	Spectrum mie_scattering = mie_extinction * kMieSingleScatteringAlbedo;
+	Spectrum absorption_extinction = Spectrum::Generate(lambdaMin, lambdaMax, lambdaStep, [&](double lambda) { return kMaxOzoneNumberDensity * getSample(kOzoneCrossSection, lambda); });
+	Spectrum ground_albedo(lambdaMin, lambdaMax, lambdaStep, kGroundAlbedo);
 
 	AtmosphereSettings settings = AtmosphereSettings();
 	dvec3 lambdas = dvec3(settings.kLambdaR, settings.kLambdaG, settings.kLambdaB);
 	double kLengthUnitInMeters; JSON::ApplyNumValue(root, kLengthUnitInMeters, "length unit in meters");
 
-	solarIrradiance = InterpolatedSpectrum(wavelengths, solar_irradiance, lambdas, 1.f);
+	solarIrradiance = InterpolatedSpectrum(solar_irradiance, lambdas, 1.f);
 	JSON::ApplyNumValue(root, sun_angular_radius, "sun angular diameter"); sun_angular_radius /= 2.0;
 	JSON::ApplyNumValue(root, bottom_radius, "bottom radius"); bottom_radius /= (float)kLengthUnitInMeters;
 	JSON::ApplyNumValue(root, top_radius, "top radius"); top_radius /= (float)kLengthUnitInMeters;
 	bottom_radius = 1737.1f;// #temp , moon specific
 	top_radius = 1837.1f;// #temp , moon specific
 	rayleigh_density = DensityProfile({ rayleigh_layer }, (float)kLengthUnitInMeters);
-	rayleighScattering = InterpolatedSpectrum(wavelengths, rayleigh_scattering, lambdas, (float)kLengthUnitInMeters);
+	rayleighScattering = InterpolatedSpectrum(rayleigh_scattering, lambdas, (float)kLengthUnitInMeters);
 	mie_density = DensityProfile({ mie_layer }, (float)kLengthUnitInMeters);
-	mieScattering = InterpolatedSpectrum(wavelengths, mie_scattering, lambdas, (float)kLengthUnitInMeters);
-	mieExtinction = InterpolatedSpectrum(wavelengths, mie_extinction, lambdas, (float)kLengthUnitInMeters);
+	mieScattering = InterpolatedSpectrum(mie_scattering, lambdas, (float)kLengthUnitInMeters);
+	mieExtinction = InterpolatedSpectrum(mie_extinction, lambdas, (float)kLengthUnitInMeters);
 	mie_phase_function_g = (float)0.8f;
 	JSON::ApplyNumValue(root, mie_phase_function_g, "mie phase function");
 	absorption_density = DensityProfile(ozone_density, (float)kLengthUnitInMeters);
-	absorptionExtinction = InterpolatedSpectrum(wavelengths, absorption_extinction, lambdas, (float)kLengthUnitInMeters);
-	groundAlbedo = InterpolatedSpectrum(wavelengths, ground_albedo, lambdas, 1.f);
+	absorptionExtinction = InterpolatedSpectrum(absorption_extinction, lambdas, (float)kLengthUnitInMeters);
+	groundAlbedo = InterpolatedSpectrum(ground_albedo, lambdas, 1.f);
 	JSON::ApplyNumValue(root, mu_s_min, "mu s min"); mu_s_min = cosf(etm::radians(mu_s_min));
 
-	AtmospherePrecompute::ComputeSpectralRadianceToLuminanceFactors(wavelengths, solar_irradiance, -3, skyColor);
-	AtmospherePrecompute::ComputeSpectralRadianceToLuminanceFactors(wavelengths, solar_irradiance, 0, sunColor);
+	AtmospherePrecompute::ComputeSpectralRadianceToLuminanceFactors(solar_irradiance, -3, skyColor);
+	AtmospherePrecompute::ComputeSpectralRadianceToLuminanceFactors(solar_irradiance, 0, sunColor);
 }
 
 void AtmosphereParameters::Upload(ShaderData* shader, const std::string &varName)
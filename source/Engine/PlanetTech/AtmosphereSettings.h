@@ -67,6 +67,8 @@ public:
 	int32 INSCATTER_MU_S = 32;
 	int32 INSCATTER_NU = 8;
 
+	int32 SCATTERING_ORDERS = 4;
+
 	static constexpr double kLambdaR = 680.0;
 	static constexpr double kLambdaG = 550.0;
 	static constexpr double kLambdaB = 440.0;
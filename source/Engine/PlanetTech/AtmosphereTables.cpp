@@ -0,0 +1,283 @@
+#include "stdafx.hpp"
+#include "AtmosphereTables.hpp"
+
+#include <algorithm>
+
+#include "AtmosphereSettings.h"
+#include "FileSystem\Entry.h"
+
+static const char TABLES_MAGIC[4] = { 'E', 'T', 'A', 'T' };
+//increase when the precomputation changes in a way the parameters don't show, so old caches are recomputed
+static const uint32 TABLES_VERSION = 1;
+
+namespace
+{
+	struct TablesHeader
+	{
+		char magic[4];
+		uint32 version;
+		uint32 hash;
+		int32 transmittanceW;
+		int32 transmittanceH;
+		int32 irradianceW;
+		int32 irradianceH;
+		int32 scatteringW;
+		int32 scatteringH;
+		int32 scatteringD;
+	};
+
+	template<typename T>
+	void AppendBytes(std::string &bytes, const T &value)
+	{
+		bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	void AppendProfile(std::string &bytes, const DensityProfile &profile)
+	{
+		for (const DensityProfileLayer &layer : profile.layers)
+		{
+			AppendBytes(bytes, layer.width);
+			AppendBytes(bytes, layer.exp_term);
+			AppendBytes(bytes, layer.exp_scale);
+			AppendBytes(bytes, layer.linear_term);
+			AppendBytes(bytes, layer.constant_term);
+		}
+	}
+
+	float Smoothstep(float edge0, float edge1, float x)
+	{
+		float t = etm::Clamp((x - edge0) / (edge1 - edge0), 1.f, 0.f);
+		return t * t * (3.f - 2.f * t);
+	}
+
+	//Texels and weight for linear filtering with clamp to edge
+	void GetLinearTexels(float coord, int32 size, int32 &first, int32 &second, float &weight)
+	{
+		float texel = coord * size - 0.5f;
+		float firstTexel = floorf(texel);
+		weight = texel - firstTexel;
+		first = etm::Clamp((int32)firstTexel, size - 1, 0);
+		second = etm::Clamp((int32)firstTexel + 1, size - 1, 0);
+	}
+	vec4 SampleLayer(const vec4* pLayer, const ivec2 &size, const vec2 &uv)
+	{
+		int32 x0, x1, y0, y1;
+		float fx, fy;
+		GetLinearTexels(uv.x, size.x, x0, x1, fx);
+		GetLinearTexels(uv.y, size.y, y0, y1, fy);
+		vec4 bottom = pLayer[y0 * size.x + x0] * (1.f - fx) + pLayer[y0 * size.x + x1] * fx;
+		vec4 top = pLayer[y1 * size.x + x0] * (1.f - fx) + pLayer[y1 * size.x + x1] * fx;
+		return bottom * (1.f - fy) + top * fy;
+	}
+}
+
+AtmosphereTables::AtmosphereTables(const AtmosphereSettings &settings)
+	: transmittanceSize(settings.TRANSMITTANCE_W, settings.TRANSMITTANCE_H)
+	, irradianceSize(settings.IRRADIANCE_W, settings.IRRADIANCE_H)
+	, scatteringSize(settings.INSCATTER_NU * settings.INSCATTER_MU_S, settings.INSCATTER_MU, settings.INSCATTER_R)
+{
+	transmittance.resize(transmittanceSize.x * transmittanceSize.y);
+	irradiance.resize(irradianceSize.x * irradianceSize.y);
+	scattering.resize(scatteringSize.x * scatteringSize.y * scatteringSize.z);
+}
+
+//Field by field, so padding never ends up in the hash
+uint32 AtmosphereTables::GetHash(const AtmosphereParameters &params, const AtmosphereSettings &settings)
+{
+	std::string bytes;
+	AppendBytes(bytes, TABLES_VERSION);
+	AppendBytes(bytes, params.solarIrradiance);
+	AppendBytes(bytes, params.sun_angular_radius);
+	AppendBytes(bytes, params.bottom_radius);
+	AppendBytes(bytes, params.top_radius);
+	AppendProfile(bytes, params.rayleigh_density);
+	AppendBytes(bytes, params.rayleighScattering);
+	AppendProfile(bytes, params.mie_density);
+	AppendBytes(bytes, params.mieScattering);
+	AppendBytes(bytes, params.mieExtinction);
+	AppendBytes(bytes, params.mie_phase_function_g);
+	AppendProfile(bytes, params.absorption_density);
+	AppendBytes(bytes, params.absorptionExtinction);
+	AppendBytes(bytes, params.groundAlbedo);
+	AppendBytes(bytes, params.mu_s_min);
+
+	for (int32 value : { settings.TRANSMITTANCE_W, settings.TRANSMITTANCE_H, settings.IRRADIANCE_W, settings.IRRADIANCE_H,
+		settings.INSCATTER_R, settings.INSCATTER_MU, settings.INSCATTER_MU_S, settings.INSCATTER_NU, settings.SCATTERING_ORDERS })
+	{
+		AppendBytes(bytes, value);
+	}
+	return FnvHash(bytes);
+}
+
+std::string AtmosphereTables::GetCacheFileName(const std::string &paramFileName)
+{
+	return paramFileName.substr(0, paramFileName.rfind('.')) + ".atmocache";
+}
+
+std::vector<uint8> AtmosphereTables::Serialize(uint32 hash) const
+{
+	TablesHeader header;
+	std::copy(TABLES_MAGIC, TABLES_MAGIC + 4, header.magic);
+	header.version = TABLES_VERSION;
+	header.hash = hash;
+	header.transmittanceW = transmittanceSize.x;
+	header.transmittanceH = transmittanceSize.y;
+	header.irradianceW = irradianceSize.x;
+	header.irradianceH = irradianceSize.y;
+	header.scatteringW = scatteringSize.x;
+	header.scatteringH = scatteringSize.y;
+	header.scatteringD = scatteringSize.z;
+
+	std::vector<uint8> data(sizeof(TablesHeader) + (transmittance.size() + irradiance.size() + scattering.size()) * sizeof(vec4));
+	memcpy(data.data(), &header, sizeof(TablesHeader));
+	uint8* pTable = data.data() + sizeof(TablesHeader);
+	for (const std::vector<vec4>* pValues : { &transmittance, &irradiance, &scattering })
+	{
+		memcpy(pTable, pValues->data(), pValues->size() * sizeof(vec4));
+		pTable += pValues->size() * sizeof(vec4);
+	}
+	return data;
+}
+
+bool AtmosphereTables::Deserialize(const uint8* pData, size_t size, uint32 hash)
+{
+	if (!pData || size < sizeof(TablesHeader)) return false;
+	TablesHeader header;
+	memcpy(&header, pData, sizeof(TablesHeader));
+	if (!std::equal(TABLES_MAGIC, TABLES_MAGIC + 4, header.magic) || header.version != TABLES_VERSION || header.hash != hash) return false;
+
+	ivec2 transmittanceRes(header.transmittanceW, header.transmittanceH);
+	ivec2 irradianceRes(header.irradianceW, header.irradianceH);
+	ivec3 scatteringRes(header.scatteringW, header.scatteringH, header.scatteringD);
+	for (int32 dimension : { transmittanceRes.x, transmittanceRes.y, irradianceRes.x, irradianceRes.y, scatteringRes.x, scatteringRes.y, scatteringRes.z })
+	{
+		if (dimension <= 0 || dimension > 4096) return false;
+	}
+	size_t transmittanceCount = (size_t)transmittanceRes.x * transmittanceRes.y;
+	size_t irradianceCount = (size_t)irradianceRes.x * irradianceRes.y;
+	size_t scatteringCount = (size_t)scatteringRes.x * scatteringRes.y * scatteringRes.z;
+	if (size != sizeof(TablesHeader) + (transmittanceCount + irradianceCount + scatteringCount) * sizeof(vec4)) return false;
+
+	const vec4* pTable = reinterpret_cast<const vec4*>(pData + sizeof(TablesHeader));
+	transmittanceSize = transmittanceRes;
+	transmittance.assign(pTable, pTable + transmittanceCount);
+	pTable += transmittanceCount;
+	irradianceSize = irradianceRes;
+	irradiance.assign(pTable, pTable + irradianceCount);
+	pTable += irradianceCount;
+	scatteringSize = scatteringRes;
+	scattering.assign(pTable, pTable + scatteringCount);
+	return true;
+}
+
+bool AtmosphereTables::Save(const std::string &fileName, uint32 hash) const
+{
+	File* pFile = new File(fileName, nullptr);
+	FILE_ACCESS_FLAGS flags;
+	flags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Create | FILE_ACCESS_FLAGS::FLAGS::Truncate);
+	bool isSaved = pFile->Open(FILE_ACCESS_MODE::Write, flags) && pFile->Write(Serialize(hash));
+	SafeDelete(pFile);
+	return isSaved;
+}
+
+bool AtmosphereTables::Load(const std::string &fileName, uint32 hash)
+{
+	File* pFile = new File(fileName, nullptr);
+	FILE_ACCESS_FLAGS flags;
+	flags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Exists);
+	if (!pFile->Open(FILE_ACCESS_MODE::Read, flags))
+	{
+		SafeDelete(pFile);
+		return false;
+	}
+	std::vector<uint8> data = pFile->Read();
+	SafeDelete(pFile);
+	return Deserialize(data.data(), data.size(), hash);
+}
+
+vec4 AtmosphereTables::Sample(const std::vector<vec4> &table, const ivec2 &size, const vec2 &uv)
+{
+	return SampleLayer(table.data(), size, uv);
+}
+vec4 AtmosphereTables::Sample(const std::vector<vec4> &table, const ivec3 &size, const vec3 &uvw)
+{
+	int32 z0, z1;
+	float fz;
+	GetLinearTexels(uvw.z, size.z, z0, z1, fz);
+	int32 layerSize = size.x * size.y;
+	return SampleLayer(table.data() + z0 * layerSize, size.xy, uvw.xy) * (1.f - fz) + SampleLayer(table.data() + z1 * layerSize, size.xy, uvw.xy) * fz;
+}
+
+float AtmosphereTables::GetTextureCoordFromUnitRange(float x, int32 textureSize)
+{
+	return 0.5f / (float)textureSize + x * (1.f - 1.f / (float)textureSize);
+}
+float AtmosphereTables::GetUnitRangeFromTextureCoord(float u, int32 textureSize)
+{
+	return (u - 0.5f / (float)textureSize) / (1.f - 1.f / (float)textureSize);
+}
+
+//Same mapping as GetTransmittanceTextureUvFromRMu in CommonAtmosphere.glsl
+vec3 AtmosphereTables::GetTransmittanceToTopAtmosphereBoundary(const AtmosphereParameters &params, float r, float mu) const
+{
+	float H = sqrtf(params.top_radius * params.top_radius - params.bottom_radius * params.bottom_radius);
+	float rho = sqrtf(std::max(r * r - params.bottom_radius * params.bottom_radius, 0.f));
+	float discriminant = r * r * (mu * mu - 1.f) + params.top_radius * params.top_radius;
+	float d = std::max(-r * mu + sqrtf(std::max(discriminant, 0.f)), 0.f);
+	float dMin = params.top_radius - r;
+	float dMax = rho + H;
+	vec2 uv(GetTextureCoordFromUnitRange((d - dMin) / (dMax - dMin), transmittanceSize.x), GetTextureCoordFromUnitRange(rho / H, transmittanceSize.y));
+	return Sample(transmittance, transmittanceSize, uv).xyz;
+}
+vec3 AtmosphereTables::GetTransmittanceToSun(const AtmosphereParameters &params, float r, float muS) const
+{
+	float sinThetaH = params.bottom_radius / r;
+	float cosThetaH = -sqrtf(std::max(1.f - sinThetaH * sinThetaH, 0.f));
+	return GetTransmittanceToTopAtmosphereBoundary(params, r, muS) *
+		Smoothstep(-sinThetaH * params.sun_angular_radius, sinThetaH * params.sun_angular_radius, muS - cosThetaH);
+}
+
+vec3 AtmosphereTables::GetTransmittanceToSpace(const AtmosphereParameters &params, float r, float mu) const
+{
+	r = std::max(r, params.bottom_radius);
+	if (r > params.top_radius)
+	{
+		//rays leaving the planet or passing the atmosphere never lose any light
+		float discriminant = r * r * (mu * mu - 1.f) + params.top_radius * params.top_radius;
+		if (mu >= 0.f || discriminant < 0.f) return vec3(1.f);
+
+		float distanceToTop = -r * mu - sqrtf(discriminant);
+		mu = etm::Clamp((r * mu + distanceToTop) / params.top_radius, 1.f, -1.f);
+		r = params.top_radius;
+	}
+	return GetTransmittanceToTopAtmosphereBoundary(params, r, mu);
+}
+
+vec3 AtmosphereTables::GetSunIrradiance(const AtmosphereParameters &params, const vec3 &position, const vec3 &sunDir) const
+{
+	float r = etm::length(position);
+	return GetSunIrradiance(params, r, etm::dot(position, sunDir) / r);
+}
+void AtmosphereTables::GetSunIrradiance(const AtmosphereParameters &params, const etm::soa<3, float> &positions, const vec3 &sunDir,
+	etm::soa<3, float> &irradiance) const
+{
+	std::vector<float> radii;
+	etm::length(positions, radii);
+	irradiance.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		float muS = (positions[0][i] * sunDir.x + positions[1][i] * sunDir.y + positions[2][i] * sunDir.z) / radii[i];
+		irradiance.set(i, GetSunIrradiance(params, radii[i], muS));
+	}
+}
+vec3 AtmosphereTables::GetSunIrradiance(const AtmosphereParameters &params, float r, float muS) const
+{
+	//below the ground is treated like standing on it
+	r = std::max(r, params.bottom_radius);
+	muS = etm::Clamp(muS, 1.f, -1.f);
+
+	float sinThetaH = params.bottom_radius / r;
+	float cosThetaH = -sqrtf(std::max(1.f - sinThetaH * sinThetaH, 0.f));
+	float visibleSun = Smoothstep(-sinThetaH * params.sun_angular_radius, sinThetaH * params.sun_angular_radius, muS - cosThetaH);
+	if (visibleSun <= 0.f) return vec3(0.f);
+	return params.solarIrradiance * GetTransmittanceToSpace(params, r, muS) * visibleSun;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+struct AtmosphereParameters;
+struct AtmosphereSettings;
+
+//Atmosphere Tables
+//*****************
+
+// The look up tables an atmosphere renders with, in the layout of the textures they are uploaded to.
+// Computing them takes a while and they only depend on the parameters and texture sizes, so they are cached on disk keyed by a hash of both.
+
+class AtmosphereTables
+{
+public:
+	AtmosphereTables() {}
+	AtmosphereTables(const AtmosphereSettings &settings);
+
+	//Changes with anything the tables depend on, including the version of the code that computes them
+	static uint32 GetHash(const AtmosphereParameters &params, const AtmosphereSettings &settings);
+	//the cache lives next to the parameter file
+	static std::string GetCacheFileName(const std::string &paramFileName);
+
+	std::vector<uint8> Serialize(uint32 hash) const;
+	//false if the data is broken or was computed for a different hash, the tables stay unchanged then
+	bool Deserialize(const uint8* pData, size_t size, uint32 hash);
+
+	bool Save(const std::string &fileName, uint32 hash) const;
+	bool Load(const std::string &fileName, uint32 hash);
+
+	//Sampled with linear filtering and clamp to edge, the same way the GPU samples the textures
+	static vec4 Sample(const std::vector<vec4> &table, const ivec2 &size, const vec2 &uv);
+	static vec4 Sample(const std::vector<vec4> &table, const ivec3 &size, const vec3 &uvw);
+	//maps [0, 1] to the centers of the first and last texel
+	static float GetTextureCoordFromUnitRange(float x, int32 textureSize);
+	static float GetUnitRangeFromTextureCoord(float u, int32 textureSize);
+
+	//Transmittance queries, r and positions are relative to the planet center in the units of the parameters, mu is the cosine from the zenith
+	//r has to be within the atmosphere, like in the shaders
+	vec3 GetTransmittanceToTopAtmosphereBoundary(const AtmosphereParameters &params, float r, float mu) const;
+	//includes the part of the sun disc hidden behind the horizon
+	vec3 GetTransmittanceToSun(const AtmosphereParameters &params, float r, float muS) const;
+	//r can also be in space, the ray then starts where it enters the atmosphere
+	vec3 GetTransmittanceToSpace(const AtmosphereParameters &params, float r, float mu) const;
+	//irradiance of the sun reaching a position, sunDir points towards the sun
+	vec3 GetSunIrradiance(const AtmosphereParameters &params, const vec3 &position, const vec3 &sunDir) const;
+	void GetSunIrradiance(const AtmosphereParameters &params, const etm::soa<3, float> &positions, const vec3 &sunDir, etm::soa<3, float> &irradiance) const;
+
+	//rgb transmittance, irradiance and scattering with the red channel of the single mie scattering in alpha
+	ivec2 transmittanceSize;
+	std::vector<vec4> transmittance;
+	ivec2 irradianceSize;
+	std::vector<vec4> irradiance;
+	ivec3 scatteringSize;
+	std::vector<vec4> scattering;
+
+private:
+	vec3 GetSunIrradiance(const AtmosphereParameters &params, float r, float muS) const;
+};
@@ -0,0 +1,159 @@
+#include "stdafx.hpp"
+#include "HeightBounds.hpp"
+
+#include <algorithm>
+#include <limits>
+
+HeightBounds::HeightBounds(const std::vector<float> &heights, int32 width, int32 height)
+{
+	assert(heights.size() == (size_t)(width * height));
+	Level base;
+	base.width = width;
+	base.height = height;
+	base.minimum = heights;
+	base.maximum = heights;
+	m_Levels.push_back(base);
+
+	//every cell covers 2x2 cells of the level below, the last row or column covers one if the size is odd
+	while (m_Levels.back().width > 1 || m_Levels.back().height > 1)
+	{
+		const Level &below = m_Levels.back();
+		Level level;
+		level.width = (below.width + 1) / 2;
+		level.height = (below.height + 1) / 2;
+		level.minimum.resize(level.width * level.height);
+		level.maximum.resize(level.width * level.height);
+		for (int32 y = 0; y < level.height; ++y)
+		{
+			for (int32 x = 0; x < level.width; ++x)
+			{
+				float minimum = std::numeric_limits<float>::max();
+				float maximum = -std::numeric_limits<float>::max();
+				for (int32 by = y * 2; by < std::min(y * 2 + 2, below.height); ++by)
+				{
+					for (int32 bx = x * 2; bx < std::min(x * 2 + 2, below.width); ++bx)
+					{
+						minimum = std::min(minimum, below.minimum[by * below.width + bx]);
+						maximum = std::max(maximum, below.maximum[by * below.width + bx]);
+					}
+				}
+				level.minimum[y * level.width + x] = minimum;
+				level.maximum[y * level.width + x] = maximum;
+			}
+		}
+		m_Levels.push_back(level);
+	}
+}
+
+void HeightBounds::GetTriangleBounds(const vec3 &a, const vec3 &b, const vec3 &c, float &minHeight, float &maxHeight) const
+{
+	//the spherical triangle lies within the smallest cap around its center that contains the corners
+	vec3 na = etm::normalize(a);
+	vec3 nb = etm::normalize(b);
+	vec3 nc = etm::normalize(c);
+	vec3 center = etm::normalize(na + nb + nc);
+	//angle from the chord length, acos of the dot product loses all precision for small triangles
+	float maxChord = std::max(etm::length(na - center), std::max(etm::length(nb - center), etm::length(nc - center)));
+	GetCapBounds(center, 2.f * asinf(std::min(maxChord * 0.5f, 1.f)), minHeight, maxHeight);
+}
+
+void HeightBounds::GetCapBounds(const vec3 &direction, float angularRadius, float &minHeight, float &maxHeight) const
+{
+	const Level &base = m_Levels[0];
+	//a little extra so float rounding doesn't lose texels on the edge of the range
+	angularRadius += 1e-5f;
+
+	//latitude and longitude range of the cap, in the same mapping as the shader: u = atan(z, x) / 2pi, v = acos(y) / pi
+	float polar = acosf(etm::Clamp(direction.y, 1.f, -1.f));
+	float polarMin = polar - angularRadius;
+	float polarMax = polar + angularRadius;
+	float uMin, uMax;
+	if (polarMin <= 0.f || polarMax >= etm::PI)
+	{
+		//caps around a pole cover every longitude
+		polarMin = std::max(polarMin, 0.f);
+		polarMax = std::min(polarMax, etm::PI);
+		uMin = 0.f;
+		uMax = 1.f;
+	}
+	else
+	{
+		float azimuth = atan2f(direction.z, direction.x);
+		float halfWidth = asinf(std::min(sinf(angularRadius) / sinf(polar), 1.f));
+		uMin = (azimuth - halfWidth) / (etm::PI * 2);
+		uMax = (azimuth + halfWidth) / (etm::PI * 2);
+	}
+	float vMin = polarMin / etm::PI;
+	float vMax = polarMax / etm::PI;
+
+	//texels linear filtering uses for the range, floor of the texel coordinates shifted by half a texel, plus the next one
+	int32 x0 = (int32)floorf(uMin * base.width - 0.5f);
+	int32 x1 = (int32)floorf(uMax * base.width - 0.5f) + 1;
+	int32 y0 = (int32)floorf(vMin * base.height - 0.5f);
+	int32 y1 = (int32)floorf(vMax * base.height - 0.5f) + 1;
+
+	//the texture repeats, so ranges reaching past a border continue on the other side
+	ivec2 columns[2];
+	ivec2 rows[2];
+	uint32 columnCount = SplitWrappedRange(x0, x1, base.width, columns);
+	uint32 rowCount = SplitWrappedRange(y0, y1, base.height, rows);
+	minHeight = std::numeric_limits<float>::max();
+	maxHeight = -std::numeric_limits<float>::max();
+	for (uint32 row = 0; row < rowCount; ++row)
+	{
+		for (uint32 column = 0; column < columnCount; ++column)
+		{
+			float rangeMin, rangeMax;
+			GetTexelBounds(columns[column].x, columns[column].y, rows[row].x, rows[row].y, rangeMin, rangeMax);
+			minHeight = std::min(minHeight, rangeMin);
+			maxHeight = std::max(maxHeight, rangeMax);
+		}
+	}
+}
+
+//Turns an inclusive range that may reach past the borders into at most two ranges within [0, size)
+uint32 HeightBounds::SplitWrappedRange(int32 first, int32 last, int32 size, ivec2* ranges)
+{
+	if (last - first >= size - 1)
+	{
+		ranges[0] = ivec2(0, size - 1);
+		return 1;
+	}
+	first = ((first % size) + size) % size;
+	last = ((last % size) + size) % size;
+	if (first <= last)
+	{
+		ranges[0] = ivec2(first, last);
+		return 1;
+	}
+	ranges[0] = ivec2(first, size - 1);
+	ranges[1] = ivec2(0, last);
+	return 2;
+}
+
+//Bounds of an inclusive texel range of the base level
+void HeightBounds::GetTexelBounds(int32 x0, int32 x1, int32 y0, int32 y1, float &minHeight, float &maxHeight) const
+{
+	//go up until the range spans at most two cells in both directions
+	size_t levelIdx = 0;
+	while (levelIdx + 1 < m_Levels.size() && (x1 - x0 > 1 || y1 - y0 > 1))
+	{
+		x0 /= 2;
+		x1 /= 2;
+		y0 /= 2;
+		y1 /= 2;
+		++levelIdx;
+	}
+	const Level &level = m_Levels[levelIdx];
+
+	minHeight = std::numeric_limits<float>::max();
+	maxHeight = -std::numeric_limits<float>::max();
+	for (int32 y = y0; y <= y1; ++y)
+	{
+		for (int32 x = x0; x <= x1; ++x)
+		{
+			minHeight = std::min(minHeight, level.minimum[y * level.width + x]);
+			maxHeight = std::max(maxHeight, level.maximum[y * level.width + x]);
+		}
+	}
+}
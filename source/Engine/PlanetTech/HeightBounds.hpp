@@ -0,0 +1,36 @@
+#pragma once
+
+//Height Bounds
+//*************
+
+// Min max pyramid over an equirectangular height map, using the same mapping as the planet patch shader.
+// Every level halves the resolution of the one below it, so the bounds of any part of the sphere are found by reading a handful of cells
+// at the level where the cells are about as large as the queried area.
+
+class HeightBounds
+{
+public:
+	//heights are the normalized values of the height map, row by row starting at the north pole
+	HeightBounds(const std::vector<float> &heights, int32 width, int32 height);
+
+	//normalized min and max height of the terrain above a triangle on the sphere, including the texels linear filtering blends in
+	void GetTriangleBounds(const vec3 &a, const vec3 &b, const vec3 &c, float &minHeight, float &maxHeight) const;
+	//same for every direction within angularRadius of the normalized direction
+	void GetCapBounds(const vec3 &direction, float angularRadius, float &minHeight, float &maxHeight) const;
+
+	size_t GetLevelCount() const { return m_Levels.size(); }
+
+private:
+	struct Level
+	{
+		int32 width = 0;
+		int32 height = 0;
+		std::vector<float> minimum;
+		std::vector<float> maximum;
+	};
+
+	static uint32 SplitWrappedRange(int32 first, int32 last, int32 size, ivec2* ranges);
+	void GetTexelBounds(int32 x0, int32 x1, int32 y0, int32 y1, float &minHeight, float &maxHeight) const;
+
+	std::vector<Level> m_Levels;
+};
@@ -24,6 +24,7 @@ void Patch::Init()
 	m_uCamPos = glGetUniformLocation(m_pPatchShader->GetProgram(), "camPos");
 	m_uRadius = glGetUniformLocation(m_pPatchShader->GetProgram(), "radius");
 	m_uMorphRange = glGetUniformLocation(m_pPatchShader->GetProgram(), "morphRange");
+	m_uMorphLatency = glGetUniformLocation(m_pPatchShader->GetProgram(), "morphLatency");
 
 	m_uMaxHeight = glGetUniformLocation(m_pPatchShader->GetProgram(), "maxHeight");
 
@@ -43,6 +44,18 @@ void Patch::Init()
 	m_pPatchShader->Upload("texDetail1"_hash, (int32)2);
 	m_pPatchShader->Upload("texDetail2"_hash, (int32)3);
 	m_pPatchShader->Upload("texHeightDetail"_hash, (int32)4);
+
+	//instances are decoded starting from the same icosahedron faces the triangulator subdivides
+	PatchDecoder decoder(m_pPlanet->GetRadius());
+	for (uint32 face = 0; face < 20; face++)
+	{
+		for (uint32 corner = 0; corner < 3; corner++)
+		{
+			const vec3 &pos = decoder.GetFaceCorner(face, corner);
+			glUniform3f(glGetUniformLocation(m_pPatchShader->GetProgram(),
+				("faceCorners[" + std::to_string(face * 3 + corner) + "]").c_str()), pos.x, pos.y, pos.z);
+		}
+	}
 	
 	//Buffer Initialisation
 	//*********************
@@ -64,18 +77,10 @@ void Patch::Init()
 	//instances
 	//bind
 	STATE->BindBuffer(GL_ARRAY_BUFFER, m_VBOInstance);
+	//both words of the compact instance as one uvec2
 	glEnableVertexAttribArray(2);
-	glEnableVertexAttribArray(3);
-	glEnableVertexAttribArray(4);
-	glEnableVertexAttribArray(5);
-	glVertexAttribIPointer(2, 1, GL_INT, sizeof(PatchInstance), (GLvoid*)offsetof(PatchInstance, level));
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(PatchInstance), (GLvoid*)offsetof(PatchInstance, a));
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(PatchInstance), (GLvoid*)offsetof(PatchInstance, r));
-	glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(PatchInstance), (GLvoid*)offsetof(PatchInstance, s));
+	glVertexAttribIPointer(2, 2, GL_UNSIGNED_INT, sizeof(PatchInstance), (GLvoid*)offsetof(PatchInstance, low));
 	glVertexAttribDivisor(2, 1);
-	glVertexAttribDivisor(3, 1);
-	glVertexAttribDivisor(4, 1);
-	glVertexAttribDivisor(5, 1);
 	//Indices
 	STATE->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 	//unbind
@@ -143,16 +148,27 @@ void Patch::GenerateGeometry(int16 levels)
 	STATE->BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void Patch::BindInstances(std::vector<PatchInstance> &instances)
+void Patch::BindInstances(const std::vector<PatchInstance> &instances, size_t firstChanged)
 {
 	//update buffer
 	m_NumInstances = (int32)instances.size();
 	STATE->BindBuffer(GL_ARRAY_BUFFER, m_VBOInstance);
-	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(PatchInstance), instances.data(), GL_STATIC_DRAW);
+	//grow with some headroom, so the buffer doesn't need to be reallocated whenever a few triangles split
+	if (instances.size() > m_InstanceCapacity)
+	{
+		m_InstanceCapacity = instances.size() + instances.size() / 2;
+		glBufferData(GL_ARRAY_BUFFER, m_InstanceCapacity * sizeof(PatchInstance), nullptr, GL_DYNAMIC_DRAW);
+		firstChanged = 0;
+	}
+	if (firstChanged < instances.size())
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, firstChanged * sizeof(PatchInstance), (instances.size() - firstChanged) * sizeof(PatchInstance), 
+			instances.data() + firstChanged);
+	}
 	STATE->BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void Patch::UploadDistanceLUT(std::vector<float> &distances)
+void Patch::UploadDistanceLUT(const std::vector<float> &distances)
 {
 	STATE->SetShader(m_pPatchShader);
 	for (size_t i = 0; i < distances.size(); i++)
@@ -168,10 +184,12 @@ void Patch::Draw()
 	STATE->SetShader(m_pPatchShader);
 
 	// Pass transformations to the shader
-	glUniformMatrix4fv(m_uModel, 1, GL_FALSE, etm::valuePtr(m_pPlanet->GetTransform()->GetWorld()));
+	// camera relative, so the planets vertices stay precise even if it is far from the origin
+	mat4 model = m_pPlanet->GetTransform()->GetCameraRelativeWorld(CAMERA->GetTransform()->GetAbsolutePosition());
+	glUniformMatrix4fv(m_uModel, 1, GL_FALSE, etm::valuePtr(model));
 	//m_pPatchShader->Upload("model"_hash, m_pPlanet->GetTransform()->GetWorld());
 	//m_pPatchShader->Upload("viewProj"_hash, CAMERA->GetViewProj());
-	glUniformMatrix4fv(m_uViewProj, 1, GL_FALSE, etm::valuePtr(CAMERA->GetViewProj()));
+	glUniformMatrix4fv(m_uViewProj, 1, GL_FALSE, etm::valuePtr(CAMERA->GetStatViewProj()));
 
 	//Set other uniforms here too!
 	vec3 camPos = m_pPlanet->GetTriangulator()->GetFrustum()->GetPositionOS();
@@ -181,6 +199,9 @@ void Patch::Draw()
 	//m_pPatchShader->Upload("morphRange"_hash, m_MorphRange);
 	glUniform1f(m_uRadius, m_pPlanet->GetRadius());
 	glUniform1f(m_uMorphRange, m_MorphRange);
+	//the instances can be generated for an older camera position, delay morphing by how far the camera moved since then
+	//so patches that split or merge late still start out fully morphed and don't pop
+	glUniform1f(m_uMorphLatency, etm::distance(camPos, m_pPlanet->GetTriangulator()->GetGeneratedCameraPosition()));
 
 	glUniform1f(m_uDelta, 1 / (float)(m_RC - 1));
 	//m_pPatchShader->Upload("patchDelta"_hash, 1 / (float)(m_RC - 1));
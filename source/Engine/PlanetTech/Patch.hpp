@@ -1,4 +1,5 @@
 #pragma once
+#include "PatchInstance.hpp"
 
 class ShaderData;
 class Planet;
@@ -13,20 +14,6 @@ struct PatchVertex
 	vec2 pos;
 	vec2 morph;
 };
-struct PatchInstance
-{
-	PatchInstance(BYTE Level, vec3 A, vec3 R, vec3 S)
-	{
-		level = Level;
-		a = A;
-		r = R;
-		s = S;
-	}
-	int32 level;
-	vec3 a;
-	vec3 r;
-	vec3 s;
-};
 class Patch
 {
 public:
@@ -39,8 +26,8 @@ public:
 
 	void Init();
 	void GenerateGeometry(int16 levels);
-	void BindInstances(std::vector<PatchInstance> &instances);
-	void UploadDistanceLUT(std::vector<float> &distances);
+	void BindInstances(const std::vector<PatchInstance> &instances, size_t firstChanged = 0);
+	void UploadDistanceLUT(const std::vector<float> &distances);
 	void Draw();
 private:
 	std::vector<PatchVertex>m_Vertices;
@@ -49,6 +36,7 @@ private:
 	Planet *m_pPlanet = nullptr;
 
 	int32 m_NumInstances = 0;
+	size_t m_InstanceCapacity = 0;
 
 	int16 m_Levels;
 	uint32 m_RC;
@@ -70,6 +58,7 @@ private:
 	GLint m_uRadius;
 	float m_MorphRange = 0.5f;
 	GLint m_uMorphRange;
+	GLint m_uMorphLatency;
 
 	GLint m_uDelta;
 
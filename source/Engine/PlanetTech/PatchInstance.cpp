@@ -0,0 +1,116 @@
+#include "stdafx.hpp"
+#include "PatchInstance.hpp"
+
+#include <algorithm>
+
+#include "../Math/Geometry.hpp"
+
+//Rounding error the corners of deep triangles can have relative to the triangles above them, in radians
+constexpr double ENCODE_TOLERANCE = 4e-6;
+
+//Exact comparison, the vector comparison operators allow an epsilon
+static bool IsSameVector(const vec3 &lhs, const vec3 &rhs)
+{
+	return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+}
+
+//Signed angle between a direction and the nearest edge of a triangle on the sphere, positive inside
+static double GetInsideAngle(const vec3 &a, const vec3 &b, const vec3 &c, const vec3 &direction)
+{
+	dvec3 da(a.x, a.y, a.z);
+	dvec3 db(b.x, b.y, b.z);
+	dvec3 dc(c.x, c.y, c.z);
+	dvec3 dir(direction.x, direction.y, direction.z);
+	//the winding alternates between levels
+	double winding = etm::dot(etm::cross(db - da, dc - da), da) < 0 ? -1 : 1;
+	double ab = winding * etm::dot(etm::normalize(etm::cross(da, db)), dir);
+	double bc = winding * etm::dot(etm::normalize(etm::cross(db, dc)), dir);
+	double ca = winding * etm::dot(etm::normalize(etm::cross(dc, da)), dir);
+	return std::min(ab, std::min(bc, ca));
+}
+
+PatchInstance PatchInstance::GetChildInstance(uint32 child) const
+{
+	int32 level = GetLevel() + 1;
+	assert(level <= MAX_LEVEL);
+	PatchInstance instance = *this;
+	instance.low = (instance.low & ~(31u << 5)) | ((uint32)level << 5);
+	if (level < 12) instance.low |= child << (10 + 2 * (level - 1));
+	else instance.high |= child << (2 * (level - 12));
+	return instance;
+}
+
+PatchDecoder::PatchDecoder(float radius)
+	:m_Radius(radius)
+{
+	//same corners as the triangulators root triangles
+	auto ico = GetIcosahedronPositions(m_Radius);
+	for (uint32 index : GetIcosahedronIndices())
+	{
+		m_FaceCorners.push_back(ico[index]);
+	}
+}
+
+void PatchDecoder::Decode(const PatchInstance &instance, vec3 &a, vec3 &b, vec3 &c) const
+{
+	uint32 face = instance.GetFace();
+	a = GetFaceCorner(face, 0);
+	b = GetFaceCorner(face, 1);
+	c = GetFaceCorner(face, 2);
+	vec3 A, B, C;
+	for (int32 level = 1; level <= instance.GetLevel(); ++level)
+	{
+		GetPatchMidpoints(a, b, c, m_Radius, A, B, C);
+		SelectPatchChild(instance.GetChild(level), A, B, C, a, b, c);
+	}
+}
+
+bool PatchDecoder::Encode(int32 level, const vec3 &a, const vec3 &r, const vec3 &s, PatchInstance &instance) const
+{
+	if (level < 0 || level > PatchInstance::MAX_LEVEL) return false;
+	vec3 direction = etm::normalize(a * 3.f + r + s);
+
+	//walks down the children containing the center of the triangle, the ones close to an edge are tried in order of how far inside they are
+	struct Candidate
+	{
+		PatchInstance instance;
+		vec3 a, b, c;
+		double inside;
+	};
+	std::vector<Candidate> stack;
+	for (uint32 face = 0; face < (uint32)m_FaceCorners.size() / 3; ++face)
+	{
+		Candidate root{ PatchInstance(face), GetFaceCorner(face, 0), GetFaceCorner(face, 1), GetFaceCorner(face, 2), 0.0 };
+		root.inside = GetInsideAngle(root.a, root.b, root.c, direction);
+		if (root.inside > -ENCODE_TOLERANCE) stack.push_back(root);
+	}
+	std::sort(stack.begin(), stack.end(), [](const Candidate &lhs, const Candidate &rhs) { return lhs.inside < rhs.inside; });
+
+	while (!stack.empty())
+	{
+		Candidate candidate = stack.back();
+		stack.pop_back();
+		if (candidate.instance.GetLevel() == level)
+		{
+			if (IsSameVector(candidate.a, a) && IsSameVector(candidate.b - candidate.a, r) && IsSameVector(candidate.c - candidate.a, s))
+			{
+				instance = candidate.instance;
+				return true;
+			}
+			continue;
+		}
+		vec3 A, B, C;
+		GetPatchMidpoints(candidate.a, candidate.b, candidate.c, m_Radius, A, B, C);
+		size_t first = stack.size();
+		for (uint32 child = 0; child < 4; ++child)
+		{
+			Candidate next = candidate;
+			next.instance = candidate.instance.GetChildInstance(child);
+			SelectPatchChild(child, A, B, C, next.a, next.b, next.c);
+			next.inside = GetInsideAngle(next.a, next.b, next.c, direction);
+			if (next.inside > -ENCODE_TOLERANCE) stack.push_back(next);
+		}
+		std::sort(stack.begin() + first, stack.end(), [](const Candidate &lhs, const Candidate &rhs) { return lhs.inside < rhs.inside; });
+	}
+	return false;
+}
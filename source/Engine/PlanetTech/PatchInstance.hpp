@@ -0,0 +1,79 @@
+#pragma once
+
+//Patch Instance
+//**************
+
+// Every patch covers a triangle from recursively subdividing one of the icosahedron faces,
+// so instead of its corners an instance only stores the face, the level and which of the 4 children was taken at every level.
+// Decoding repeats the triangulators subdivision along that path, which reproduces the corners bit exact.
+
+struct PatchInstance
+{
+	PatchInstance() {}
+	explicit PatchInstance(uint32 face)
+		:low(face)
+	{
+	}
+
+	//the deepest level the path fits in, 10 header bits and 2 bits per level
+	static const int32 MAX_LEVEL = 27;
+
+	uint32 GetFace() const { return low & 31u; }
+	int32 GetLevel() const { return (int32)((low >> 5) & 31u); }
+	//index of the child that was taken to get from level-1 to level, in the order Triangulator::Split creates them
+	uint32 GetChild(int32 level) const
+	{
+		return level < 12 ? (low >> (10 + 2 * (level - 1))) & 3u : (high >> (2 * (level - 12))) & 3u;
+	}
+	PatchInstance GetChildInstance(uint32 child) const;
+
+	bool operator==(const PatchInstance &other) const { return low == other.low && high == other.high; }
+	bool operator!=(const PatchInstance &other) const { return !(*this == other); }
+
+	//face in bits 0-4, level in bits 5-9 and the children taken at levels 1 to 11
+	uint32 low = 0;
+	//children taken at levels 12 to 27
+	uint32 high = 0;
+};
+
+//Midpoints of the edges opposite to a, b and c, pushed out onto the sphere
+inline void GetPatchMidpoints(const vec3 &a, const vec3 &b, const vec3 &c, float radius, vec3 &A, vec3 &B, vec3 &C)
+{
+	A = b + ((c - b)*0.5f);
+	B = c + ((a - c)*0.5f);
+	C = a + ((b - a)*0.5f);
+	A = A * radius / etm::length(A);
+	B = B * radius / etm::length(B);
+	C = C * radius / etm::length(C);
+}
+
+//Corners of a child in the order Triangulator::Split creates them, from the midpoints of the parent
+inline void SelectPatchChild(uint32 child, const vec3 &A, const vec3 &B, const vec3 &C, vec3 &a, vec3 &b, vec3 &c)
+{
+	switch (child)
+	{
+	case 0: b = B; c = C; break;
+	case 1: a = A; c = C; break;
+	case 2: a = A; b = B; break;
+	default: a = A; b = B; c = C; break;
+	}
+}
+
+//Converts between instances and the corners of the triangle they cover, for a planet of a given radius
+class PatchDecoder
+{
+public:
+	PatchDecoder(float radius);
+
+	const vec3 &GetFaceCorner(uint32 face, uint32 corner) const { return m_FaceCorners[face * 3 + corner]; }
+
+	void Decode(const PatchInstance &instance, vec3 &a, vec3 &b, vec3 &c) const;
+	//Finds the instance of a triangle given by a corner and the edges to the other two, as patches were drawn before they were encoded
+	//false if that isn't exactly one of the triangles the triangulator generates,
+	//past level 22 neighbouring triangles start rounding to the same corners so the result can be any of them
+	bool Encode(int32 level, const vec3 &a, const vec3 &r, const vec3 &s, PatchInstance &instance) const;
+
+private:
+	float m_Radius = 0.f;
+	std::vector<vec3> m_FaceCorners;
+};
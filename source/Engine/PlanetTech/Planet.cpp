@@ -11,10 +11,15 @@
 #include "../Graphics/Frustum.hpp"
 #include "Triangulator.hpp"
 #include "Patch.hpp"
+#include "PlanetSurface.hpp"
+#include "PlanetCollider.hpp"
 #include "Atmosphere.hpp"
 #include "../Content/TextureLoader.hpp"
 #include "../GraphicsHelper/RenderPipeline.hpp"
+#include "../GraphicsHelper/SceneVisibility.hpp"
 #include "../GraphicsHelper/RenderState.hpp"
+#include "../SceneGraph/AbstractScene.hpp"
+#include "../Physics/PhysicsWorld.h"
 
 Planet::Planet()
 {
@@ -26,10 +31,14 @@ Planet::~Planet()
 {
 	SafeDelete(m_pPatch);
 	SafeDelete(m_pTriangulator);
+	SafeDelete(m_pCollider);
+	SafeDelete(m_pSurface);
 }
 
 void Planet::Initialize()
 {
+	//the planet stays at the scene center, the floating origin moves everything relative to it
+	GetTransform()->SetAbsolutePosition(dvec3(0, 0, 0));
 	GetTransform()->SetRotation(GetTransform()->GetRotation() * quat(vec3(0.0f, 1.0f, 0.0f), etm::radians(270.f)));
 
 	//LoadTextures
@@ -42,13 +51,23 @@ void Planet::Initialize()
 	m_pHeightDetail = CONTENT::Load<TextureData>("Resources/Textures/PlanetTextures/MoonHeightDetail1.jpg");
 	pTL->UseSrgb(false);
 
+	CreateSurface();
+	if (m_pSurface) m_pTriangulator->SetHeightBounds(m_pSurface->GetHeightBounds());
 	m_pTriangulator->Init();
+	m_pTriangulator->SetAsync(true);
 	m_pPatch->Init();
+
+	//Rigid bodies land on the terrain instead of falling through it
+	if (m_pSurface)
+	{
+		m_pCollider = new PlanetCollider(m_pSurface, GetScene()->GetPhysicsWorld()->GetWorld());
+		m_pCollider->SetGravity(m_Gravity);
+		m_pCollider->SetAsync(true);
+	}
 }
 
 void Planet::Update()
 {
-	GetTransform()->SetPosition(0, 0, 0);
 	if (INPUT->IsKeyboardKeyPressed('R'))m_Rotate = !m_Rotate;
 	if(m_Rotate)
 	{
@@ -57,20 +76,52 @@ void Planet::Update()
 
 	// #todo should happen after transform update maybe at the beginning of draw
 
+	//Frustum update
+	//**************
+	if (INPUT->IsKeyboardKeyPressed(SDL_SCANCODE_SPACE))m_LockFrustum = !m_LockFrustum;
+
+	Frustum* pFrustum = m_pTriangulator->GetFrustum();
+	pFrustum->SetCullTransform(GetTransform()->GetWorld(), GetTransform()->GetWorldInverse());
+	if (!m_LockFrustum) pFrustum->SetToCamera(CAMERA);
+	pFrustum->Update();
+	m_pTriangulator->SetViewportWidth(WINDOW.Width);
+
+	//Collision update
+	//****************
+	//tiles around the rigid bodies, before the physics world steps
+	if (m_pCollider)
+	{
+		m_pCollider->SetTransform(GetTransform()->GetWorldPosition(), GetTransform()->GetWorldRotation());
+		m_pCollider->Update();
+	}
+
 	//Change Planet Geometry
 	//**********************
-	if (m_pTriangulator->Update())
+	//Change the actual vertex positions, in async mode this only picks up what the worker finished meanwhile
+	m_pTriangulator->GenerateGeometry();
+	//Bind patch instances, only the part that changed since last frame is uploaded
+	if (m_pTriangulator->IsGeometryChanged())
 	{
-		//Change the actual vertex positions
-		m_pTriangulator->GenerateGeometry();
-		//Bind patch instances
-		m_pPatch->BindInstances(m_pTriangulator->m_Positions);
-		m_pPatch->UploadDistanceLUT(m_pTriangulator->m_DistanceLUT);
+		m_pPatch->BindInstances(m_pTriangulator->GetPositions(), m_pTriangulator->GetFirstChangedInstance());
 	}
+	if (m_pTriangulator->IsDistanceLUTChanged())
+	{
+		m_pPatch->UploadDistanceLUT(m_pTriangulator->GetDistanceLUT());
+	}
+}
+
+bool Planet::GetOccluderSphere(Sphere &sphere) const
+{
+	sphere = Sphere(GetTransform()->GetWorldPosition(), m_Radius);
+	return true;
 }
 
 void Planet::Draw()
 {
+	//behind another planet
+	if (RenderPipeline::GetInstance()->GetVisibility()->GetSphereOccluders().IsOccluded(Sphere(GetTransform()->GetWorldPosition(), m_Radius + m_MaxHeight)))
+		return;
+
 	STATE->SetCullEnabled(false);
 	m_pPatch->Draw();
 	STATE->SetCullEnabled(true);
@@ -83,6 +134,97 @@ void Planet::DrawForward()
 	}
 }
 
+namespace
+{
+	//Reads the red channel of a texture back from the GPU, undoing the sRGB encoding the shaders get for free when sampling
+	std::vector<float> ReadBackTexture(TextureData* pTexture)
+	{
+		ivec2 res = pTexture->GetResolution();
+		std::vector<float> values(res.x * res.y);
+		STATE->LazyBindTexture(0, GL_TEXTURE_2D, pTexture->GetHandle());
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, values.data());
+		GLint format;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+		if (format == GL_SRGB || format == GL_SRGB8 || format == GL_SRGB_ALPHA || format == GL_SRGB8_ALPHA8)
+		{
+			for (float &value : values)
+			{
+				value = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			}
+		}
+		return values;
+	}
+}
+
+//Copies the terrain to the CPU, so the bounds and queries match exactly what the patch shader samples
+void Planet::CreateSurface()
+{
+	if (!m_pHeight) return;
+	ivec2 res = m_pHeight->GetResolution();
+	m_pSurface = new PlanetSurface(ReadBackTexture(m_pHeight), res.x, res.y, m_Radius, m_MaxHeight);
+
+	//the same detail the shader adds, the height map is twice as wide as it is high
+	if (m_pHeightDetail)
+	{
+		res = m_pHeightDetail->GetResolution();
+		m_pSurface->AddDetailLayer(ReadBackTexture(m_pHeightDetail), res.x, res.y, vec2(200, 100), m_MaxHeight*0.1f, 0.f);
+	}
+	if (m_pDetail2)
+	{
+		res = m_pDetail2->GetResolution();
+		m_pSurface->AddDetailLayer(ReadBackTexture(m_pDetail2), res.x, res.y, vec2(1400, 700), -0.01f, 0.01f);
+	}
+}
+
+float Planet::SampleHeight(const vec3 &position) const
+{
+	if (!m_pSurface) return 0.f;
+	return m_pSurface->SampleHeight((GetTransform()->GetWorldInverse() * vec4(position, 1)).xyz);
+}
+void Planet::SampleHeights(const vec3soa &positions, std::vector<float> &heights, etm::batch_executor* executor) const
+{
+	if (!m_pSurface)
+	{
+		heights.assign(positions.size(), 0.f);
+		return;
+	}
+	vec3soa local;
+	etm::transformPoints(GetTransform()->GetWorldInverse(), positions, local, executor);
+	m_pSurface->SampleHeights(local, heights, executor);
+}
+
+//The planet is only ever scaled uniformly, so distances convert with the length of a transformed unit vector
+bool Planet::Raycast(const vec3 &origin, const vec3 &direction, float maxDistance, float &distance) const
+{
+	if (!m_pSurface) return false;
+	const mat4 &worldInverse = GetTransform()->GetWorldInverse();
+	vec3 localDirection = (worldInverse * vec4(direction, 0)).xyz;
+	float scale = etm::length(localDirection);
+	if (!m_pSurface->Raycast((worldInverse * vec4(origin, 1)).xyz, localDirection / scale, maxDistance * scale, distance)) return false;
+	distance /= scale;
+	return true;
+}
+void Planet::Raycast(const vec3soa &origins, const vec3soa &directions, float maxDistance, std::vector<float> &distances, etm::batch_executor* executor) const
+{
+	if (!m_pSurface)
+	{
+		distances.assign(origins.size(), -1.f);
+		return;
+	}
+	const mat4 &worldInverse = GetTransform()->GetWorldInverse();
+	float scale = etm::length((worldInverse * vec4(1, 0, 0, 0)).xyz);
+	vec3soa localOrigins;
+	vec3soa localDirections;
+	etm::transformPoints(worldInverse, origins, localOrigins, executor);
+	etm::transformVectors(worldInverse, directions, localDirections, executor);
+	etm::normalize(localDirections, localDirections, executor);
+	m_pSurface->Raycast(localOrigins, localDirections, maxDistance * scale, distances, executor);
+	for (float &distance : distances)
+	{
+		if (distance >= 0.f) distance /= scale;
+	}
+}
+
 int32 Planet::GetVertexCount()
 {
 	return m_pTriangulator->GetVertexCount()*m_pPatch->GetVertexCount();
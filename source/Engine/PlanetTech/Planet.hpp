@@ -6,6 +6,8 @@ class Frustum;
 class TextureData;
 class Triangulator;
 class Patch;
+class PlanetSurface;
+class PlanetCollider;
 class Atmosphere;
 class LightComponent;
 
@@ -19,6 +21,16 @@ public:
 	float GetMaxHeight() { return m_MaxHeight; }
 	int32 GetVertexCount();
 	Triangulator* GetTriangulator() { return m_pTriangulator; }
+	const PlanetSurface* GetSurface() const { return m_pSurface; }
+
+	//Terrain queries in world space, safe from any thread as long as the planet isn't moved at the same time
+	//batches are split across the executor's threads if one is given
+	//height of the ground above the radius below a world position
+	float SampleHeight(const vec3 &position) const;
+	void SampleHeights(const vec3soa &positions, std::vector<float> &heights, etm::batch_executor* executor = nullptr) const;
+	//distance to the ground along a normalized direction, see PlanetSurface::Raycast, misses in the batch get -1
+	bool Raycast(const vec3 &origin, const vec3 &direction, float maxDistance, float &distance) const;
+	void Raycast(const vec3soa &origins, const vec3soa &directions, float maxDistance, std::vector<float> &distances, etm::batch_executor* executor = nullptr) const;
 
 	TextureData* GetHeightMap() { return m_pHeight; }
 	TextureData* GetDiffuseMap() { return m_pDiffuse; }
@@ -35,6 +47,9 @@ public:
 
 	void SetSunlight(LightComponent* pLight);;
 
+	//the surface below the terrain hides everything on the far side of the planet
+	bool GetOccluderSphere(Sphere &sphere) const override;
+
 protected:
 	virtual void Initialize();
 	virtual void Update();
@@ -43,11 +58,16 @@ protected:
 
 	virtual void LoadPlanet() = 0;
 
+private:
+	void CreateSurface();
+
 protected:
 
 	//Planet parameters
 	float m_Radius = 1737.1f;
 	float m_MaxHeight = 10.7f;
+	//acceleration towards the center for rigid bodies
+	float m_Gravity = 1.62f;
 
 	TextureData* m_pDiffuse = nullptr;
 	TextureData* m_pDetail1 = nullptr;
@@ -57,6 +77,8 @@ protected:
 
 private:
 	bool m_Rotate = false;
+	//keeps triangulating for the same view while the camera flies around, for inspecting the culling
+	bool m_LockFrustum = false;
 
 	Atmosphere* m_pAtmopshere = nullptr;
 	float m_AtmRadius;
@@ -64,4 +86,6 @@ private:
 	//Calculations
 	Triangulator* m_pTriangulator = nullptr;
 	Patch* m_pPatch = nullptr;
+	PlanetSurface* m_pSurface = nullptr;
+	PlanetCollider* m_pCollider = nullptr;
 };
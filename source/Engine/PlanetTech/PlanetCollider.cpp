@@ -0,0 +1,363 @@
+#include "stdafx.hpp"
+#include "PlanetCollider.hpp"
+
+#include <algorithm>
+
+#include <btBulletDynamicsCommon.h>
+#include "../Physics/BulletETM.h"
+#include "../Helper/TaskScheduler.hpp"
+#include "PlanetSurface.hpp"
+
+struct PlanetCollider::Tile
+{
+	~Tile()
+	{
+		delete pObject;
+		delete pShape;
+		delete pMesh;
+	}
+
+	PatchInstance instance;
+	//vertices are relative to the first corner, which keeps them precise on large planets
+	vec3 origin;
+	std::vector<float> vertices;
+	std::vector<int32> indices;
+
+	btTriangleIndexVertexArray* pMesh = nullptr;
+	btBvhTriangleMeshShape* pShape = nullptr;
+	btCollisionObject* pObject = nullptr;
+
+	uint64 lastUsed = 0;
+	//only changed by the main thread, once the builder handed the tile back
+	bool isBuilt = false;
+	bool isActive = false;
+};
+
+static uint64 GetTileKey(const PatchInstance &instance)
+{
+	return ((uint64)instance.high << 32) | instance.low;
+}
+
+PlanetCollider::PlanetCollider(const PlanetSurface* pSurface, btDiscreteDynamicsWorld* pWorld, float tileSize, uint32 tileSegments)
+	: m_pSurface(pSurface)
+	, m_pWorld(pWorld)
+	, m_Decoder(pSurface->GetRadius())
+	, m_TileSegments(std::max(tileSegments, 1u))
+{
+	//icosahedron edges are about 1.05 times the radius, halving every level
+	float radius = m_pSurface->GetRadius();
+	m_TileLevel = (int32)ceilf(log2f(1.0515f * radius / tileSize));
+	m_TileLevel = std::max(std::min(m_TileLevel, PatchInstance::MAX_LEVEL), 0);
+	m_InnerRadius = radius + m_pSurface->GetMinHeight();
+	m_OuterRadius = radius + m_pSurface->GetMaxHeight();
+
+	m_pScheduler = TaskScheduler::GetInstance();
+}
+PlanetCollider::~PlanetCollider()
+{
+	if (m_AsyncThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_AsyncMutex);
+			m_IsShuttingDown = true;
+		}
+		m_AsyncCondition.notify_all();
+		m_AsyncThread.join();
+	}
+	for (Tile* pTile : m_ActiveTiles)
+	{
+		m_pWorld->removeCollisionObject(pTile->pObject);
+	}
+	for (auto &tile : m_Tiles)
+	{
+		delete tile.second;
+	}
+}
+
+void PlanetCollider::SetTransform(const vec3 &position, const quat &rotation)
+{
+	m_Position = position;
+	m_Rotation = rotation;
+	btTransform planet(ToBtQuat(m_Rotation), ToBtVec3(m_Position));
+	for (Tile* pTile : m_ActiveTiles)
+	{
+		pTile->pObject->setWorldTransform(planet * btTransform(btQuaternion::getIdentity(), ToBtVec3(pTile->origin)));
+	}
+}
+
+void PlanetCollider::SetAsync(bool async)
+{
+	WaitForBuilds();
+	m_Async = async;
+	if (m_Async && !m_AsyncThread.joinable())
+	{
+		m_AsyncThread = std::thread(&PlanetCollider::AsyncThread, this);
+	}
+}
+
+void PlanetCollider::WaitForBuilds()
+{
+	std::unique_lock<std::mutex> lock(m_AsyncMutex);
+	m_AsyncCondition.wait(lock, [this]() { return !m_IsBuilding && m_Requested.empty(); });
+}
+
+void PlanetCollider::Update()
+{
+	++m_Frame;
+	CollectBuiltTiles();
+
+	btTransform planet(ToBtQuat(m_Rotation), ToBtVec3(m_Position));
+	std::vector<Tile*> requests;
+	btCollisionObjectArray &objects = m_pWorld->getCollisionObjectArray();
+	for (int32 i = 0; i < m_pWorld->getNumCollisionObjects(); ++i)
+	{
+		//tiles are plain collision objects, so this only visits the bodies
+		btRigidBody* pBody = btRigidBody::upcast(objects[i]);
+		if (!pBody || pBody->isStaticOrKinematicObject()) continue;
+
+		btVector3 center;
+		btScalar radius;
+		pBody->getCollisionShape()->getBoundingSphere(center, radius);
+		center = pBody->getWorldTransform() * center;
+		if (m_Gravity > 0.f)
+		{
+			btVector3 down = planet.getOrigin() - center;
+			if (down.length2() > 0.f) pBody->setGravity(down.normalized() * m_Gravity);
+		}
+
+		//everything the body can reach before the next tiles arrive
+		btVector3 travel = pBody->getLinearVelocity() * m_LookAhead * 0.5f;
+		center += travel;
+		radius += travel.length() + pBody->getCollisionShape()->getMargin();
+
+		m_FoundTiles.clear();
+		FindTiles(ToEtmVec3(planet.invXform(center)), radius, m_FoundTiles);
+		for (const PatchInstance &instance : m_FoundTiles)
+		{
+			UseTile(instance, requests);
+		}
+	}
+
+	//tiles no body came close to this frame leave the world but stay cached
+	for (size_t i = 0; i < m_ActiveTiles.size();)
+	{
+		Tile* pTile = m_ActiveTiles[i];
+		if (pTile->lastUsed == m_Frame)
+		{
+			++i;
+			continue;
+		}
+		m_pWorld->removeCollisionObject(pTile->pObject);
+		pTile->isActive = false;
+		m_ActiveTiles[i] = m_ActiveTiles.back();
+		m_ActiveTiles.pop_back();
+	}
+
+	if (!requests.empty())
+	{
+		if (m_Async)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_AsyncMutex);
+				m_Requested.insert(m_Requested.end(), requests.begin(), requests.end());
+			}
+			m_AsyncCondition.notify_all();
+		}
+		else
+		{
+			BuildTiles(requests);
+			for (Tile* pTile : requests)
+			{
+				pTile->isBuilt = true;
+				ActivateTile(pTile);
+			}
+		}
+	}
+	EvictTiles();
+}
+
+size_t PlanetCollider::GetCachedTileCount() const
+{
+	size_t count = 0;
+	for (const auto &tile : m_Tiles)
+	{
+		if (tile.second->isBuilt && !tile.second->isActive) ++count;
+	}
+	return count;
+}
+
+void PlanetCollider::FindTiles(const vec3 &center, float radius, std::vector<PatchInstance> &tiles) const
+{
+	float distance = etm::length(center);
+	if (distance - radius > m_OuterRadius || distance + radius < m_InnerRadius) return;
+	for (uint32 face = 0; face < 20; ++face)
+	{
+		FindTiles(m_Decoder.GetFaceCorner(face, 0), m_Decoder.GetFaceCorner(face, 1), m_Decoder.GetFaceCorner(face, 2), PatchInstance(face), center, radius, tiles);
+	}
+}
+
+//Walks down the subdivision, skipping triangles whose part of the terrain shell is out of reach
+void PlanetCollider::FindTiles(const vec3 &a, const vec3 &b, const vec3 &c, const PatchInstance &instance, const vec3 &center, float radius, std::vector<PatchInstance> &tiles) const
+{
+	//the triangle lies within a cap around its center, the part of the shell under that cap fits in a sphere
+	vec3 axis = etm::normalize(a + b + c);
+	float planetRadius = m_pSurface->GetRadius();
+	float cosAngle = std::min(std::min(etm::dot(axis, a), etm::dot(axis, b)), etm::dot(axis, c)) / planetRadius;
+	float middle = (m_InnerRadius * cosAngle + m_OuterRadius) * 0.5f;
+	auto rimDistance = [middle, cosAngle](float shellRadius)
+	{
+		return std::sqrt(std::max(shellRadius * shellRadius + middle * middle - 2.f * shellRadius * middle * cosAngle, 0.f));
+	};
+	float boundsRadius = std::max(std::max(rimDistance(m_InnerRadius), rimDistance(m_OuterRadius)), std::max(m_OuterRadius - middle, middle - m_InnerRadius));
+	float reach = boundsRadius + radius;
+	if (etm::lengthSquared(center - axis * middle) > reach * reach) return;
+
+	if (instance.GetLevel() == m_TileLevel)
+	{
+		tiles.push_back(instance);
+		return;
+	}
+	vec3 A, B, C;
+	GetPatchMidpoints(a, b, c, planetRadius, A, B, C);
+	for (uint32 child = 0; child < 4; ++child)
+	{
+		vec3 ca = a, cb = b, cc = c;
+		SelectPatchChild(child, A, B, C, ca, cb, cc);
+		FindTiles(ca, cb, cc, instance.GetChildInstance(child), center, radius, tiles);
+	}
+}
+
+void PlanetCollider::UseTile(const PatchInstance &instance, std::vector<Tile*> &requests)
+{
+	Tile* &pTile = m_Tiles[GetTileKey(instance)];
+	if (!pTile)
+	{
+		pTile = new Tile();
+		pTile->instance = instance;
+		requests.push_back(pTile);
+	}
+	pTile->lastUsed = m_Frame;
+	if (pTile->isBuilt && !pTile->isActive) ActivateTile(pTile);
+}
+
+//Triangle grid over the patch, with its vertices pushed out to the terrain like the patch shader does
+void PlanetCollider::BuildTile(Tile* pTile) const
+{
+	vec3 a, b, c;
+	m_Decoder.Decode(pTile->instance, a, b, c);
+	vec3 r = b - a;
+	vec3 s = c - a;
+	pTile->origin = a;
+
+	uint32 segments = m_TileSegments;
+	vec3soa directions((segments + 1) * (segments + 2) / 2);
+	size_t vertex = 0;
+	for (uint32 i = 0; i <= segments; ++i)
+	{
+		for (uint32 j = 0; j <= segments - i; ++j)
+		{
+			directions.set(vertex++, a + r * ((float)i / segments) + s * ((float)j / segments));
+		}
+	}
+	std::vector<float> heights;
+	m_pSurface->SampleHeights(directions, heights);
+
+	pTile->vertices.resize(directions.size() * 3);
+	for (size_t i = 0; i < directions.size(); ++i)
+	{
+		vec3 position = etm::normalize(directions.get(i)) * (m_pSurface->GetRadius() + heights[i]) - a;
+		pTile->vertices[i * 3] = position.x;
+		pTile->vertices[i * 3 + 1] = position.y;
+		pTile->vertices[i * 3 + 2] = position.z;
+	}
+
+	//rows get one vertex shorter towards c
+	auto index = [segments](uint32 i, uint32 j) { return (int32)(i * (segments + 1) - i * (i - 1) / 2 + j); };
+	pTile->indices.clear();
+	pTile->indices.reserve(segments * segments * 3);
+	for (uint32 i = 0; i < segments; ++i)
+	{
+		for (uint32 j = 0; j < segments - i; ++j)
+		{
+			pTile->indices.insert(pTile->indices.end(), { index(i, j), index(i + 1, j), index(i, j + 1) });
+			if (j + 1 < segments - i)
+			{
+				pTile->indices.insert(pTile->indices.end(), { index(i + 1, j), index(i + 1, j + 1), index(i, j + 1) });
+			}
+		}
+	}
+
+	pTile->pMesh = new btTriangleIndexVertexArray((int32)pTile->indices.size() / 3, pTile->indices.data(), 3 * sizeof(int32),
+		(int32)directions.size(), pTile->vertices.data(), 3 * sizeof(float));
+	pTile->pShape = new btBvhTriangleMeshShape(pTile->pMesh, true);
+	pTile->pObject = new btCollisionObject();
+	pTile->pObject->setCollisionShape(pTile->pShape);
+	pTile->pObject->setCollisionFlags(pTile->pObject->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
+}
+
+void PlanetCollider::BuildTiles(std::vector<Tile*> &tiles)
+{
+	for (Tile* pTile : tiles)
+	{
+		m_pScheduler->Push(0, [this, pTile](uint32) { BuildTile(pTile); });
+	}
+	m_pScheduler->Run();
+}
+
+//Takes over what the async thread finished, the tiles join the world once a body asks for them
+void PlanetCollider::CollectBuiltTiles()
+{
+	std::lock_guard<std::mutex> lock(m_AsyncMutex);
+	for (Tile* pTile : m_Built)
+	{
+		pTile->isBuilt = true;
+	}
+	m_Built.clear();
+}
+
+void PlanetCollider::ActivateTile(Tile* pTile)
+{
+	btTransform planet(ToBtQuat(m_Rotation), ToBtVec3(m_Position));
+	pTile->pObject->setWorldTransform(planet * btTransform(btQuaternion::getIdentity(), ToBtVec3(pTile->origin)));
+	m_pWorld->addCollisionObject(pTile->pObject, btBroadphaseProxy::StaticFilter, btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::StaticFilter);
+	pTile->isActive = true;
+	m_ActiveTiles.push_back(pTile);
+}
+
+//Drops the cached tiles that were used the longest time ago
+void PlanetCollider::EvictTiles()
+{
+	std::vector<Tile*> cached;
+	for (const auto &tile : m_Tiles)
+	{
+		if (tile.second->isBuilt && !tile.second->isActive) cached.push_back(tile.second);
+	}
+	if (cached.size() <= m_CacheSize) return;
+
+	auto oldest = cached.begin() + (cached.size() - m_CacheSize);
+	std::nth_element(cached.begin(), oldest, cached.end(), [](const Tile* lhs, const Tile* rhs) { return lhs->lastUsed < rhs->lastUsed; });
+	for (auto it = cached.begin(); it != oldest; ++it)
+	{
+		m_Tiles.erase(GetTileKey((*it)->instance));
+		delete *it;
+	}
+}
+
+void PlanetCollider::AsyncThread()
+{
+	std::unique_lock<std::mutex> lock(m_AsyncMutex);
+	for (;;)
+	{
+		m_AsyncCondition.wait(lock, [this]() { return !m_Requested.empty() || m_IsShuttingDown; });
+		if (m_IsShuttingDown) return;
+		std::vector<Tile*> tiles;
+		tiles.swap(m_Requested);
+		m_IsBuilding = true;
+		lock.unlock();
+		BuildTiles(tiles);
+		lock.lock();
+		m_Built.insert(m_Built.end(), tiles.begin(), tiles.end());
+		m_IsBuilding = false;
+		m_AsyncCondition.notify_all();
+	}
+}
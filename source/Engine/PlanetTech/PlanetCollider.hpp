@@ -0,0 +1,105 @@
+#pragma once
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "PatchInstance.hpp"
+
+class PlanetSurface;
+class TaskScheduler;
+class btDiscreteDynamicsWorld;
+
+//Planet Collider
+//***************
+
+// Gives a planet a physics representation by streaming small triangle mesh tiles of its surface into a bullet world.
+// Tiles are the triangles of the icosahedron subdivision at a fixed level, only the ones near dynamic bodies are built and added,
+// so the cost follows the number of bodies and not the size of the planet.
+// Meshes are built from the CPU copy of the terrain on worker threads, tiles no body needs anymore leave the world and stay cached for a while.
+
+class PlanetCollider
+{
+public:
+	//tileSize is roughly the edge length of a tile, every edge is split into tileSegments for the mesh
+	PlanetCollider(const PlanetSurface* pSurface, btDiscreteDynamicsWorld* pWorld, float tileSize = 32.f, uint32 tileSegments = 16);
+	~PlanetCollider();
+
+	//where the planet is in the world, tiles follow it
+	void SetTransform(const vec3 &position, const quat &rotation);
+	//pulls dynamic bodies towards the center of the planet instead of the worlds gravity, 0 leaves their gravity alone
+	void SetGravity(float acceleration) { m_Gravity = acceleration; }
+	//seconds of movement at their current velocity that tiles are requested ahead of bodies, covering the time builds take in async mode
+	void SetLookAhead(float seconds) { m_LookAhead = seconds; }
+	//amount of tiles that are out of the world but kept around in case a body comes back
+	void SetCacheSize(size_t tileCount) { m_CacheSize = tileCount; }
+
+	//In async mode tiles are built in the background and join the world on a later update, otherwise Update builds them right away
+	void SetAsync(bool async);
+	bool IsAsync() const { return m_Async; }
+	void WaitForBuilds();
+
+	//Finds the tiles the bodies in the world need, once per frame before the simulation steps
+	void Update();
+
+	int32 GetTileLevel() const { return m_TileLevel; }
+	size_t GetActiveTileCount() const { return m_ActiveTiles.size(); }
+	size_t GetCachedTileCount() const;
+	size_t GetTileCount() const { return m_Tiles.size(); }
+
+private:
+	struct Tile;
+
+	void FindTiles(const vec3 &center, float radius, std::vector<PatchInstance> &tiles) const;
+	void FindTiles(const vec3 &a, const vec3 &b, const vec3 &c, const PatchInstance &instance, const vec3 &center, float radius, std::vector<PatchInstance> &tiles) const;
+	void UseTile(const PatchInstance &instance, std::vector<Tile*> &requests);
+	void BuildTile(Tile* pTile) const;
+	void BuildTiles(std::vector<Tile*> &tiles);
+	void CollectBuiltTiles();
+	void ActivateTile(Tile* pTile);
+	void EvictTiles();
+
+	void AsyncThread();
+
+	const PlanetSurface* m_pSurface = nullptr;
+	btDiscreteDynamicsWorld* m_pWorld = nullptr;
+	PatchDecoder m_Decoder;
+
+	int32 m_TileLevel = 0;
+	uint32 m_TileSegments = 0;
+	//the shell the terrain lies in
+	float m_InnerRadius = 0.f;
+	float m_OuterRadius = 0.f;
+
+	vec3 m_Position;
+	quat m_Rotation;
+	float m_Gravity = 0.f;
+	float m_LookAhead = 0.5f;
+	size_t m_CacheSize = 512;
+
+	uint64 m_Frame = 0;
+	std::unordered_map<uint64, Tile*> m_Tiles;
+	std::vector<Tile*> m_ActiveTiles;
+	std::vector<PatchInstance> m_FoundTiles;
+
+	//the engine wide scheduler, shared with the triangulator
+	TaskScheduler* m_pScheduler = nullptr;
+
+	//tiles move between these lists under the mutex, the async thread builds whatever was requested
+	bool m_Async = false;
+	std::thread m_AsyncThread;
+	std::mutex m_AsyncMutex;
+	std::condition_variable m_AsyncCondition;
+	std::vector<Tile*> m_Requested;
+	std::vector<Tile*> m_Built;
+	bool m_IsBuilding = false;
+	bool m_IsShuttingDown = false;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	PlanetCollider(const PlanetCollider& obj);
+	PlanetCollider& operator=(const PlanetCollider& obj);
+};
@@ -0,0 +1,485 @@
+#include "stdafx.hpp"
+#include "PlanetSurface.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "HeightBounds.hpp"
+#include "PatchInstance.hpp"
+
+//Triangles at the bottom of the tree are about this many texels of the height map across
+constexpr float LEAF_TEXELS = 16.f;
+constexpr int32 MAX_LEAF_LEVEL = 7;
+//Fraction of a texel the ray moves between samples while marching
+constexpr float MARCH_STEP_TEXELS = 0.5f;
+//Crossings are narrowed down to about float precision at the surface
+constexpr float REFINE_PRECISION = 1e-7f;
+//Relative slack on the planes between triangles, so rays running along an edge don't slip through both of them
+constexpr double PLANE_TOLERANCE = 1e-6;
+
+//Polynomial atan2 and acos, written so the scalar and SIMD versions do exactly the same operations and batches match single queries
+//both stay well below a hundredth of a texel from the exact result
+static float Atan2(float y, float x)
+{
+	float ax = std::abs(x);
+	float ay = std::abs(y);
+	float maxValue = std::max(ax, ay);
+	float ratio = maxValue > 0.f ? std::min(ax, ay) / maxValue : 0.f;
+	//reduce to [0, tan(pi/8)]
+	bool reduce = ratio > 0.414213562f;
+	float r = reduce ? (ratio - 1.f) / (ratio + 1.f) : ratio;
+	float z = r * r;
+	float angle = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * r + r;
+	if (reduce) angle = angle + 0.785398163f;
+	if (ay > ax) angle = 1.57079633f - angle;
+	if (x < 0.f) angle = 3.14159265f - angle;
+	return y < 0.f ? -angle : angle;
+}
+static float Acos(float x)
+{
+	float ax = std::min(std::abs(x), 1.f);
+	float p = ((((((-0.0012624911f * ax + 0.0066700901f) * ax - 0.0170881256f) * ax + 0.0308918810f) * ax - 0.0501743046f) * ax + 0.0889789874f) * ax - 0.2145988016f) * ax + 1.5707963050f;
+	float angle = std::sqrt(1.f - ax) * p;
+	return x < 0.f ? 3.14159265f - angle : angle;
+}
+
+#ifdef ETM_SIMD_SSE
+static inline __m128 Select(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+{
+	return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+static inline __m128 Abs(__m128 x)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.f), x);
+}
+static __m128 Atan2(__m128 y, __m128 x)
+{
+	__m128 ax = Abs(x);
+	__m128 ay = Abs(y);
+	__m128 maxValue = _mm_max_ps(ax, ay);
+	__m128 ratio = _mm_and_ps(_mm_cmpgt_ps(maxValue, _mm_setzero_ps()), _mm_div_ps(_mm_min_ps(ax, ay), maxValue));
+	__m128 reduce = _mm_cmpgt_ps(ratio, _mm_set1_ps(0.414213562f));
+	__m128 one = _mm_set1_ps(1.f);
+	__m128 r = Select(reduce, _mm_div_ps(_mm_sub_ps(ratio, one), _mm_add_ps(ratio, one)), ratio);
+	__m128 z = _mm_mul_ps(r, r);
+	__m128 angle = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(8.05374449538e-2f), z), _mm_set1_ps(1.38776856032e-1f));
+	angle = _mm_add_ps(_mm_mul_ps(angle, z), _mm_set1_ps(1.99777106478e-1f));
+	angle = _mm_sub_ps(_mm_mul_ps(angle, z), _mm_set1_ps(3.33329491539e-1f));
+	angle = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(angle, z), r), r);
+	angle = Select(reduce, _mm_add_ps(angle, _mm_set1_ps(0.785398163f)), angle);
+	angle = Select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(1.57079633f), angle), angle);
+	angle = Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(3.14159265f), angle), angle);
+	return Select(_mm_cmplt_ps(y, _mm_setzero_ps()), _mm_xor_ps(angle, _mm_set1_ps(-0.f)), angle);
+}
+static __m128 Acos(__m128 x)
+{
+	__m128 ax = _mm_min_ps(Abs(x), _mm_set1_ps(1.f));
+	__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.0012624911f), ax), _mm_set1_ps(0.0066700901f));
+	p = _mm_sub_ps(_mm_mul_ps(p, ax), _mm_set1_ps(0.0170881256f));
+	p = _mm_add_ps(_mm_mul_ps(p, ax), _mm_set1_ps(0.0308918810f));
+	p = _mm_sub_ps(_mm_mul_ps(p, ax), _mm_set1_ps(0.0501743046f));
+	p = _mm_add_ps(_mm_mul_ps(p, ax), _mm_set1_ps(0.0889789874f));
+	p = _mm_sub_ps(_mm_mul_ps(p, ax), _mm_set1_ps(0.2145988016f));
+	p = _mm_add_ps(_mm_mul_ps(p, ax), _mm_set1_ps(1.5707963050f));
+	__m128 angle = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.f), ax)), p);
+	return Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(3.14159265f), angle), angle);
+}
+#endif
+
+//Texture repeats in both directions like the shaders sampler
+static inline int32 WrapTexel(int32 texel, int32 size)
+{
+	texel %= size;
+	return texel < 0 ? texel + size : texel;
+}
+
+//Interval of t where origin + t * direction lies within a sphere around the planets center
+static bool IntersectSphere(const dvec3 &origin, const dvec3 &direction, double radius, double &enter, double &exit)
+{
+	double b = etm::dot(origin, direction);
+	double c = etm::dot(origin, origin) - radius * radius;
+	double discriminant = b * b - c;
+	if (discriminant < 0.0) return false;
+	double root = std::sqrt(discriminant);
+	enter = -b - root;
+	exit = -b + root;
+	return true;
+}
+
+PlanetSurface::PlanetSurface(const std::vector<float> &heights, int32 width, int32 height, float radius, float maxHeight)
+	: m_Radius(radius)
+	, m_MaxHeight(maxHeight)
+{
+	Layer base;
+	base.values = heights;
+	base.width = width;
+	base.height = height;
+	base.tiling = vec2(1, 1);
+	base.scale = maxHeight;
+	m_Layers.push_back(base);
+
+	m_pBounds = new HeightBounds(heights, width, height);
+
+	//the shader samples the height map at texel centers, so the texels along a meridian set the resolution
+	float texelAngle = std::min(etm::PI / height, etm::PI * 2 / width);
+	m_MarchStep = texelAngle * MARCH_STEP_TEXELS * m_Radius;
+	//the icosahedron faces have an angle of about pi/3 between their center and corners, halving every level
+	m_LeafLevel = (int32)ceilf(log2f((etm::PI / 3.f) / (texelAngle * LEAF_TEXELS)));
+	m_LeafLevel = std::max(std::min(m_LeafLevel, MAX_LEAF_LEVEL), 0);
+	BuildTree();
+}
+PlanetSurface::~PlanetSurface()
+{
+	SafeDelete(m_pBounds);
+}
+
+void PlanetSurface::AddDetailLayer(const std::vector<float> &values, int32 width, int32 height, vec2 tiling, float scale, float offset)
+{
+	assert(values.size() == (size_t)(width * height));
+	Layer layer;
+	layer.values = values;
+	layer.width = width;
+	layer.height = height;
+	layer.tiling = tiling;
+	layer.scale = scale;
+	layer.offset = offset;
+	m_Layers.push_back(layer);
+
+	//the detail repeats all over the planet, so its whole range applies to every triangle
+	auto range = std::minmax_element(values.begin(), values.end());
+	float low = offset + scale * *range.first;
+	float high = offset + scale * *range.second;
+	m_DetailMin += std::min(low, high);
+	m_DetailMax += std::max(low, high);
+}
+
+float PlanetSurface::GetMinHeight() const
+{
+	float minHeight = std::numeric_limits<float>::max();
+	for (const NodeBounds &bounds : m_Tree[0])
+	{
+		minHeight = std::min(minHeight, bounds.minHeight);
+	}
+	return minHeight * m_MaxHeight + m_DetailMin;
+}
+float PlanetSurface::GetMaxHeight() const
+{
+	float maxHeight = -std::numeric_limits<float>::max();
+	for (const NodeBounds &bounds : m_Tree[0])
+	{
+		maxHeight = std::max(maxHeight, bounds.maxHeight);
+	}
+	return maxHeight * m_MaxHeight + m_DetailMax;
+}
+
+void PlanetSurface::BuildTree()
+{
+	m_Tree.clear();
+	m_Tree.resize(m_LeafLevel + 1);
+	size_t nodeCount = 20;
+	for (std::vector<NodeBounds> &level : m_Tree)
+	{
+		level.resize(nodeCount);
+		nodeCount *= 4;
+	}
+
+	//same corners as the triangulators root triangles
+	PatchDecoder decoder(m_Radius);
+	m_FaceCorners.clear();
+	for (uint32 face = 0; face < 20; ++face)
+	{
+		for (uint32 corner = 0; corner < 3; ++corner)
+		{
+			m_FaceCorners.push_back(decoder.GetFaceCorner(face, corner));
+		}
+		CalculateLeafBounds(m_FaceCorners[face * 3], m_FaceCorners[face * 3 + 1], m_FaceCorners[face * 3 + 2], 0, face);
+	}
+}
+
+//Bounds of the leaves from the height map, the triangles above them cover exactly their 4 children
+void PlanetSurface::CalculateLeafBounds(const vec3 &a, const vec3 &b, const vec3 &c, int32 level, size_t index)
+{
+	NodeBounds &bounds = m_Tree[level][index];
+	if (level == m_LeafLevel)
+	{
+		m_pBounds->GetTriangleBounds(a, b, c, bounds.minHeight, bounds.maxHeight);
+		return;
+	}
+	vec3 A, B, C;
+	GetPatchMidpoints(a, b, c, m_Radius, A, B, C);
+	bounds.minHeight = std::numeric_limits<float>::max();
+	bounds.maxHeight = -std::numeric_limits<float>::max();
+	for (uint32 child = 0; child < 4; ++child)
+	{
+		vec3 ca = a, cb = b, cc = c;
+		SelectPatchChild(child, A, B, C, ca, cb, cc);
+		CalculateLeafBounds(ca, cb, cc, level + 1, index * 4 + child);
+		const NodeBounds &childBounds = m_Tree[level + 1][index * 4 + child];
+		bounds.minHeight = std::min(bounds.minHeight, childBounds.minHeight);
+		bounds.maxHeight = std::max(bounds.maxHeight, childBounds.maxHeight);
+	}
+}
+
+float PlanetSurface::SampleHeight(const vec3 &direction) const
+{
+	float height;
+	SampleRange(&direction.x, &direction.y, &direction.z, &height, 0, 1);
+	return height;
+}
+
+void PlanetSurface::SampleHeights(const vec3soa &directions, std::vector<float> &heights, etm::batch_executor* executor) const
+{
+	heights.resize(directions.size());
+	etm::detail::ForRanges(directions.size(), executor, [&](size_t begin, size_t end, size_t)
+	{
+		SampleRange(directions[0], directions[1], directions[2], heights.data(), begin, end);
+	});
+}
+
+//Heights in the directions [begin, end), 4 at a time where SIMD is available
+void PlanetSurface::SampleRange(const float* x, const float* y, const float* z, float* out, size_t begin, size_t end) const
+{
+	size_t i = begin;
+#ifdef ETM_SIMD_SSE
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		//same mapping as the shader: u = atan(z, x) / 2pi, v = acos(y) / pi
+		__m128 u = _mm_mul_ps(Atan2(_mm_div_ps(vz, length), _mm_div_ps(vx, length)), _mm_set1_ps(0.159154943f));
+		__m128 v = _mm_mul_ps(Acos(_mm_div_ps(vy, length)), _mm_set1_ps(0.318309886f));
+
+		__m128 height = _mm_setzero_ps();
+		for (const Layer &layer : m_Layers)
+		{
+			__m128 tx = _mm_sub_ps(_mm_mul_ps(u, _mm_set1_ps(layer.tiling.x * layer.width)), _mm_set1_ps(0.5f));
+			__m128 ty = _mm_sub_ps(_mm_mul_ps(v, _mm_set1_ps(layer.tiling.y * layer.height)), _mm_set1_ps(0.5f));
+			//floor, truncation rounds negative values up
+			__m128i ix = _mm_cvttps_epi32(tx);
+			__m128i iy = _mm_cvttps_epi32(ty);
+			ix = _mm_add_epi32(ix, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(ix), tx)));
+			iy = _mm_add_epi32(iy, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(iy), ty)));
+			__m128 wx = _mm_sub_ps(tx, _mm_cvtepi32_ps(ix));
+			__m128 wy = _mm_sub_ps(ty, _mm_cvtepi32_ps(iy));
+
+			int32 texelX[4], texelY[4];
+			_mm_storeu_si128((__m128i*)texelX, ix);
+			_mm_storeu_si128((__m128i*)texelY, iy);
+			float v00[4], v10[4], v01[4], v11[4];
+			for (uint32 lane = 0; lane < 4; ++lane)
+			{
+				int32 x0 = WrapTexel(texelX[lane], layer.width);
+				int32 x1 = WrapTexel(texelX[lane] + 1, layer.width);
+				int32 y0 = WrapTexel(texelY[lane], layer.height) * layer.width;
+				int32 y1 = WrapTexel(texelY[lane] + 1, layer.height) * layer.width;
+				v00[lane] = layer.values[y0 + x0];
+				v10[lane] = layer.values[y0 + x1];
+				v01[lane] = layer.values[y1 + x0];
+				v11[lane] = layer.values[y1 + x1];
+			}
+			__m128 one = _mm_set1_ps(1.f);
+			__m128 ox = _mm_sub_ps(one, wx);
+			__m128 top = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(v00), ox), _mm_mul_ps(_mm_loadu_ps(v10), wx));
+			__m128 bottom = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(v01), ox), _mm_mul_ps(_mm_loadu_ps(v11), wx));
+			__m128 value = _mm_add_ps(_mm_mul_ps(top, _mm_sub_ps(one, wy)), _mm_mul_ps(bottom, wy));
+			height = _mm_add_ps(height, _mm_add_ps(_mm_set1_ps(layer.offset), _mm_mul_ps(_mm_set1_ps(layer.scale), value)));
+		}
+		_mm_storeu_ps(out + i, height);
+	}
+#endif
+	for (; i < end; ++i)
+	{
+		float length = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+		float u = Atan2(z[i] / length, x[i] / length) * 0.159154943f;
+		float v = Acos(y[i] / length) * 0.318309886f;
+
+		float height = 0.f;
+		for (const Layer &layer : m_Layers)
+		{
+			float tx = u * (layer.tiling.x * layer.width) - 0.5f;
+			float ty = v * (layer.tiling.y * layer.height) - 0.5f;
+			int32 ix = (int32)floorf(tx);
+			int32 iy = (int32)floorf(ty);
+			float wx = tx - (float)ix;
+			float wy = ty - (float)iy;
+
+			int32 x0 = WrapTexel(ix, layer.width);
+			int32 x1 = WrapTexel(ix + 1, layer.width);
+			int32 y0 = WrapTexel(iy, layer.height) * layer.width;
+			int32 y1 = WrapTexel(iy + 1, layer.height) * layer.width;
+			float ox = 1.f - wx;
+			float top = layer.values[y0 + x0] * ox + layer.values[y0 + x1] * wx;
+			float bottom = layer.values[y1 + x0] * ox + layer.values[y1 + x1] * wx;
+			float value = top * (1.f - wy) + bottom * wy;
+			height = height + (layer.offset + layer.scale * value);
+		}
+		out[i] = height;
+	}
+}
+
+bool PlanetSurface::Raycast(const vec3 &origin, const vec3 &direction, float maxDistance, float &distance) const
+{
+	vec3 dir = etm::normalize(direction);
+	dvec3 rayOrigin(origin.x, origin.y, origin.z);
+	dvec3 rayDirection(dir.x, dir.y, dir.z);
+
+	struct Node
+	{
+		int32 level;
+		size_t index;
+		vec3 a, b, c;
+		double start;
+		double end;
+	};
+	//Part of the ray within the triangles cone and height range, empty if there is none
+	auto clipNode = [&](Node &node) -> bool
+	{
+		const NodeBounds &bounds = m_Tree[node.level][node.index];
+		double start = 0.0;
+		double end = maxDistance;
+
+		//the cone from the center through the triangle, the winding alternates between levels
+		dvec3 a(node.a.x, node.a.y, node.a.z);
+		dvec3 b(node.b.x, node.b.y, node.b.z);
+		dvec3 c(node.c.x, node.c.y, node.c.z);
+		double winding = etm::dot(etm::cross(a, b), c) < 0.0 ? -1.0 : 1.0;
+		dvec3 normals[3] = { etm::cross(a, b) * winding, etm::cross(b, c) * winding, etm::cross(c, a) * winding };
+		for (const dvec3 &normal : normals)
+		{
+			double offset = etm::dot(normal, rayOrigin) + PLANE_TOLERANCE * etm::length(normal) * m_Radius;
+			double speed = etm::dot(normal, rayDirection);
+			if (speed == 0.0)
+			{
+				if (offset < 0.0) return false;
+			}
+			else if (speed > 0.0) start = std::max(start, -offset / speed);
+			else end = std::min(end, -offset / speed);
+		}
+
+		//above the highest point of the terrain the ray can't hit anything
+		double enter, exit;
+		if (!IntersectSphere(rayOrigin, rayDirection, m_Radius + bounds.maxHeight * m_MaxHeight + m_DetailMax, enter, exit)) return false;
+		start = std::max(start, enter);
+		end = std::min(end, exit);
+		//and once it is below the lowest point it certainly did
+		if (IntersectSphere(rayOrigin, rayDirection, m_Radius + bounds.minHeight * m_MaxHeight + m_DetailMin, enter, exit) && exit >= start)
+		{
+			end = std::min(end, std::max(enter, start));
+		}
+		node.start = start;
+		node.end = end;
+		return start <= end;
+	};
+
+	//front to back through the subdivision, the closest children are on top of the stack
+	//which never holds more than the faces plus the siblings of every node on the way down
+	Node stack[24 + 3 * MAX_LEAF_LEVEL];
+	uint32 stackSize = 0;
+	auto sortPushed = [&stack, &stackSize](uint32 first)
+	{
+		std::sort(stack + first, stack + stackSize, [](const Node &lhs, const Node &rhs) { return lhs.start > rhs.start; });
+	};
+	for (uint32 face = 0; face < 20; ++face)
+	{
+		Node &node = stack[stackSize];
+		node = Node{ 0, face, m_FaceCorners[face * 3], m_FaceCorners[face * 3 + 1], m_FaceCorners[face * 3 + 2], 0.0, 0.0 };
+		if (clipNode(node)) ++stackSize;
+	}
+	sortPushed(0);
+
+	double closest = std::numeric_limits<double>::max();
+	while (stackSize > 0)
+	{
+		Node node = stack[--stackSize];
+		if (node.start >= closest) continue;
+		if (node.level == m_LeafLevel)
+		{
+			float hit;
+			if (MarchSegment(origin, dir, (float)node.start, (float)node.end, hit)) closest = std::min(closest, (double)hit);
+			continue;
+		}
+		vec3 A, B, C;
+		GetPatchMidpoints(node.a, node.b, node.c, m_Radius, A, B, C);
+		uint32 first = stackSize;
+		for (uint32 child = 0; child < 4; ++child)
+		{
+			Node &childNode = stack[stackSize];
+			childNode = Node{ node.level + 1, node.index * 4 + child, node.a, node.b, node.c, 0.0, 0.0 };
+			SelectPatchChild(child, A, B, C, childNode.a, childNode.b, childNode.c);
+			if (clipNode(childNode)) ++stackSize;
+		}
+		sortPushed(first);
+	}
+
+	if (closest > maxDistance) return false;
+	distance = (float)closest;
+	return true;
+}
+
+void PlanetSurface::Raycast(const vec3soa &origins, const vec3soa &directions, float maxDistance, std::vector<float> &distances, etm::batch_executor* executor) const
+{
+	assert(origins.size() == directions.size());
+	distances.resize(origins.size());
+	etm::detail::ForRanges(origins.size(), executor, [&](size_t begin, size_t end, size_t)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			float distance;
+			distances[i] = Raycast(origins.get(i), directions.get(i), maxDistance, distance) ? distance : -1.f;
+		}
+	});
+}
+
+//Samples the terrain along a piece of the ray a few steps at a time and narrows down the first step that ends below the surface
+bool PlanetSurface::MarchSegment(const vec3 &origin, const vec3 &direction, float start, float end, float &distance) const
+{
+	uint32 stepCount = std::max((uint32)ceilf((end - start) / m_MarchStep), 1u);
+	float step = (end - start) / stepCount;
+
+	float previous = start;
+	const uint32 batchSize = 8;
+	float x[batchSize], y[batchSize], z[batchSize], heights[batchSize], distances[batchSize];
+	for (uint32 first = 0; first <= stepCount; first += batchSize)
+	{
+		uint32 count = std::min(batchSize, stepCount + 1 - first);
+		for (uint32 sample = 0; sample < count; ++sample)
+		{
+			distances[sample] = start + step * (first + sample);
+			vec3 position = origin + direction * distances[sample];
+			x[sample] = position.x;
+			y[sample] = position.y;
+			z[sample] = position.z;
+		}
+		SampleRange(x, y, z, heights, 0, count);
+		for (uint32 sample = 0; sample < count; ++sample)
+		{
+			float altitude = std::sqrt(x[sample] * x[sample] + y[sample] * y[sample] + z[sample] * z[sample]) - m_Radius;
+			if (altitude > heights[sample])
+			{
+				previous = distances[sample];
+				continue;
+			}
+			if (first + sample == 0)
+			{
+				distance = start;
+				return true;
+			}
+			//the surface is crossed somewhere between the last sample above it and this one
+			float above = previous;
+			float below = distances[sample];
+			while (below - above > m_Radius * REFINE_PRECISION)
+			{
+				float middle = (above + below) * 0.5f;
+				if (middle == above || middle == below) break;
+				vec3 position = origin + direction * middle;
+				if (etm::length(position) - m_Radius > SampleHeight(position)) above = middle;
+				else below = middle;
+			}
+			distance = below;
+			return true;
+		}
+	}
+	return false;
+}
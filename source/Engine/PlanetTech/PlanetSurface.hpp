@@ -0,0 +1,85 @@
+#pragma once
+
+class HeightBounds;
+
+//Planet Surface
+//**************
+
+// CPU copy of the terrain the patch shader puts on top of the sphere, so gameplay code can find the ground without reading back from the GPU.
+// Heights are sampled with the same mapping, wrapping and bilinear filtering as the shader.
+// Raycasts walk down the same icosahedron subdivision the triangulator uses, skipping every triangle whose height range the ray misses,
+// and only march through the triangles at the bottom of the tree where the ray passes close to the terrain.
+// Everything is in the planets object space and nothing changes after the detail layers are added, so any number of threads can query at once.
+
+class PlanetSurface
+{
+public:
+	//heights are the normalized values of the height map, row by row starting at the north pole, scaled by maxHeight
+	PlanetSurface(const std::vector<float> &heights, int32 width, int32 height, float radius, float maxHeight);
+	~PlanetSurface();
+
+	//Tiled maps the shader adds on top of the height map, each adds offset + scale * value at uv * tiling, needs to happen before any query
+	void AddDetailLayer(const std::vector<float> &values, int32 width, int32 height, vec2 tiling, float scale, float offset);
+
+	//bounds of the height map alone
+	const HeightBounds* GetHeightBounds() const { return m_pBounds; }
+	float GetRadius() const { return m_Radius; }
+	//lowest and highest the terrain gets anywhere, detail included
+	float GetMinHeight() const;
+	float GetMaxHeight() const;
+
+	//Height of the terrain above the radius, in the direction from the planets center, which doesn't need to be normalized
+	float SampleHeight(const vec3 &direction) const;
+	void SampleHeights(const vec3soa &directions, std::vector<float> &heights, etm::batch_executor* executor = nullptr) const;
+
+	//Distance along the normalized direction to the first point where the ray meets the terrain, false if that is further than maxDistance
+	//rays starting below the surface hit at a distance of 0, detail smaller than the march step can be stepped over
+	bool Raycast(const vec3 &origin, const vec3 &direction, float maxDistance, float &distance) const;
+	//misses get a distance of -1
+	void Raycast(const vec3soa &origins, const vec3soa &directions, float maxDistance, std::vector<float> &distances, etm::batch_executor* executor = nullptr) const;
+
+private:
+	struct Layer
+	{
+		std::vector<float> values;
+		int32 width = 0;
+		int32 height = 0;
+		vec2 tiling;
+		float scale = 1.f;
+		float offset = 0.f;
+	};
+	struct NodeBounds
+	{
+		float minHeight;
+		float maxHeight;
+	};
+
+	void SampleRange(const float* x, const float* y, const float* z, float* out, size_t begin, size_t end) const;
+	void BuildTree();
+	void CalculateLeafBounds(const vec3 &a, const vec3 &b, const vec3 &c, int32 level, size_t index);
+	bool MarchSegment(const vec3 &origin, const vec3 &direction, float start, float end, float &distance) const;
+
+	float m_Radius = 0.f;
+	float m_MaxHeight = 0.f;
+
+	std::vector<Layer> m_Layers;
+	//range of what all detail layers together can add
+	float m_DetailMin = 0.f;
+	float m_DetailMax = 0.f;
+
+	HeightBounds* m_pBounds = nullptr;
+
+	std::vector<vec3> m_FaceCorners;
+	//height range of every triangle of the subdivision down to the leaf level, level by level with each face taking 4^level consecutive nodes
+	std::vector<std::vector<NodeBounds>> m_Tree;
+	int32 m_LeafLevel = 0;
+	float m_MarchStep = 0.f;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	PlanetSurface(const PlanetSurface& obj);
+	PlanetSurface& operator=(const PlanetSurface& obj);
+};
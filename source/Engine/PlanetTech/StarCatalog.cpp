@@ -0,0 +1,232 @@
+#include "stdafx.hpp"
+#include "StarCatalog.hpp"
+
+#include <algorithm>
+#include <limits>
+
+static const char CATALOG_MAGIC[4] = { 'E', 'T', 'S', 'C' };
+static const uint32 CATALOG_VERSION = 1;
+static const uint32 MAX_CELL_RESOLUTION = 256;
+
+static_assert(sizeof(vec4) == 16, "stars are read straight from the catalog");
+
+static bool IsFainter(float magnitude, const vec4 &star) { return magnitude < star.w; }
+
+std::vector<uint8> StarCatalog::Build(const std::vector<vec4> &stars, uint32 cellResolution)
+{
+	cellResolution = std::max(std::min(cellResolution, MAX_CELL_RESOLUTION), 1u);
+	uint32 cellCount = 6 * cellResolution * cellResolution;
+	std::vector<std::vector<vec4>> cells(cellCount);
+	for (const vec4 &star : stars)
+	{
+		cells[GetCellIndex(star.xyz, cellResolution)].push_back(star);
+	}
+
+	Header header;
+	std::copy(CATALOG_MAGIC, CATALOG_MAGIC + 4, header.magic);
+	header.version = CATALOG_VERSION;
+	header.starCount = (uint32)stars.size();
+	header.cellResolution = cellResolution;
+	header.starOffset = (uint32)((sizeof(Header) + cellCount * sizeof(Cell) + 15) & ~(size_t)15);
+	std::fill(header.padding, header.padding + 3, 0u);
+
+	std::vector<uint8> catalog(header.starOffset + stars.size() * sizeof(vec4), 0);
+	memcpy(catalog.data(), &header, sizeof(Header));
+	Cell* pCells = reinterpret_cast<Cell*>(catalog.data() + sizeof(Header));
+	vec4* pStars = reinterpret_cast<vec4*>(catalog.data() + header.starOffset);
+	uint32 first = 0;
+	for (uint32 cell = 0; cell < cellCount; ++cell)
+	{
+		//stars of the same magnitude stay in the order they came in
+		std::vector<vec4> &cellStars = cells[cell];
+		std::stable_sort(cellStars.begin(), cellStars.end(), [](const vec4 &lhs, const vec4 &rhs) { return lhs.w < rhs.w; });
+		pCells[cell].first = first;
+		pCells[cell].count = (uint32)cellStars.size();
+		std::copy(cellStars.begin(), cellStars.end(), pStars + first);
+		first += (uint32)cellStars.size();
+	}
+	return catalog;
+}
+
+//Cells are numbered face by face, row by row, the major axis picks the face
+uint32 StarCatalog::GetCellIndex(const vec3 &direction, uint32 cellResolution)
+{
+	vec3 absolute(std::abs(direction.x), std::abs(direction.y), std::abs(direction.z));
+	uint32 face;
+	float major, u, v;
+	if (absolute.x >= absolute.y && absolute.x >= absolute.z)
+	{
+		face = direction.x < 0.f ? 1 : 0;
+		major = absolute.x;
+		u = direction.y;
+		v = direction.z;
+	}
+	else if (absolute.y >= absolute.z)
+	{
+		face = direction.y < 0.f ? 3 : 2;
+		major = absolute.y;
+		u = direction.z;
+		v = direction.x;
+	}
+	else
+	{
+		face = direction.z < 0.f ? 5 : 4;
+		major = absolute.z;
+		u = direction.x;
+		v = direction.y;
+	}
+	if (major <= 0.f) return 0;
+
+	auto toCell = [cellResolution, major](float coordinate)
+	{
+		float cell = (coordinate / major * 0.5f + 0.5f) * cellResolution;
+		return std::min((uint32)std::max(cell, 0.f), cellResolution - 1);
+	};
+	return (face * cellResolution + toCell(v)) * cellResolution + toCell(u);
+}
+
+//Direction through a point of a cube face, u and v in cells
+vec3 StarCatalog::GetCellDirection(uint32 face, uint32 cellResolution, float u, float v)
+{
+	float side = face % 2 == 0 ? 1.f : -1.f;
+	u = u / cellResolution * 2.f - 1.f;
+	v = v / cellResolution * 2.f - 1.f;
+	switch (face / 2)
+	{
+	case 0: return etm::normalize(vec3(side, u, v));
+	case 1: return etm::normalize(vec3(v, side, u));
+	default: return etm::normalize(vec3(u, v, side));
+	}
+}
+
+bool StarCatalog::Open(const uint8* pData, size_t size)
+{
+	m_pStars = nullptr;
+	m_pCells = nullptr;
+	m_CellAxes.clear();
+	m_CellCosAngles.clear();
+
+	if (!pData || size < sizeof(Header)) return false;
+	const Header* pHeader = reinterpret_cast<const Header*>(pData);
+	if (!std::equal(CATALOG_MAGIC, CATALOG_MAGIC + 4, pHeader->magic) || pHeader->version != CATALOG_VERSION) return false;
+	if (pHeader->cellResolution == 0 || pHeader->cellResolution > MAX_CELL_RESOLUTION) return false;
+
+	uint32 resolution = pHeader->cellResolution;
+	uint32 cellCount = 6 * resolution * resolution;
+	if (pHeader->starOffset % 16 != 0 || pHeader->starOffset < sizeof(Header) + cellCount * sizeof(Cell)) return false;
+	if ((uint64)size < (uint64)pHeader->starOffset + (uint64)pHeader->starCount * sizeof(vec4)) return false;
+
+	const Cell* pCells = reinterpret_cast<const Cell*>(pData + sizeof(Header));
+	for (uint32 cell = 0; cell < cellCount; ++cell)
+	{
+		if ((uint64)pCells[cell].first + pCells[cell].count > pHeader->starCount) return false;
+	}
+
+	m_StarCount = pHeader->starCount;
+	m_CellResolution = resolution;
+	m_pCells = pCells;
+	m_pStars = reinterpret_cast<const vec4*>(pData + pHeader->starOffset);
+
+	//cube face cells are bounded by great circles, so the cone through their corners holds all of them
+	m_MinMagnitude = std::numeric_limits<float>::max();
+	m_MaxMagnitude = -std::numeric_limits<float>::max();
+	for (uint32 cell = 0; cell < cellCount; ++cell)
+	{
+		uint32 face = cell / (resolution * resolution);
+		float u = (float)(cell % resolution);
+		float v = (float)((cell / resolution) % resolution);
+		vec3 axis = GetCellDirection(face, resolution, u + 0.5f, v + 0.5f);
+		float cosAngle = std::min(std::min(etm::dot(axis, GetCellDirection(face, resolution, u, v)), etm::dot(axis, GetCellDirection(face, resolution, u + 1, v))),
+			std::min(etm::dot(axis, GetCellDirection(face, resolution, u, v + 1)), etm::dot(axis, GetCellDirection(face, resolution, u + 1, v + 1))));
+		m_CellAxes.push_back(axis);
+		m_CellCosAngles.push_back(cosAngle);
+
+		if (m_pCells[cell].count == 0) continue;
+		m_MinMagnitude = std::min(m_MinMagnitude, m_pStars[m_pCells[cell].first].w);
+		m_MaxMagnitude = std::max(m_MaxMagnitude, m_pStars[m_pCells[cell].first + m_pCells[cell].count - 1].w);
+	}
+	return true;
+}
+
+uint32 StarCatalog::GetStarCount(uint32 cell, float magnitudeLimit) const
+{
+	const vec4* pFirst = m_pStars + m_pCells[cell].first;
+	return (uint32)(std::upper_bound(pFirst, pFirst + m_pCells[cell].count, magnitudeLimit, IsFainter) - pFirst);
+}
+
+uint32 StarCatalog::GetStarCount(float magnitudeLimit) const
+{
+	uint32 count = 0;
+	for (uint32 cell = 0; cell < GetCellCount(); ++cell)
+	{
+		count += GetStarCount(cell, magnitudeLimit);
+	}
+	return count;
+}
+
+//Bisects the magnitude range, every step only searches the cells
+float StarCatalog::GetMagnitudeLimit(uint32 starCount) const
+{
+	if (starCount >= m_StarCount) return m_MaxMagnitude;
+	float brighter = m_MinMagnitude - 1.f;
+	float fainter = m_MaxMagnitude;
+	for (uint32 step = 0; step < 64; ++step)
+	{
+		float middle = (brighter + fainter) * 0.5f;
+		if (middle == brighter || middle == fainter) break;
+		if (GetStarCount(middle) <= starCount) brighter = middle;
+		else fainter = middle;
+	}
+	return brighter;
+}
+
+void StarCatalog::GetVisibleRanges(const mat4 &viewProj, float magnitudeLimit, float margin, std::vector<int32> &firsts, std::vector<int32> &counts) const
+{
+	firsts.clear();
+	counts.clear();
+
+	//a direction is on screen when w +- x and w +- y of the projection are positive, without translation those are planes through the eye
+	auto clipRow = [&viewProj](uint8 component) { return vec3(viewProj[0][component], viewProj[1][component], viewProj[2][component]); };
+	vec3 x = clipRow(0);
+	vec3 y = clipRow(1);
+	vec3 w = clipRow(3);
+	vec3 planes[4] = { w + x, w - x, w + y, w - y };
+	for (vec3 &plane : planes)
+	{
+		plane = etm::normalize(plane);
+	}
+
+	for (uint32 cell = 0; cell < GetCellCount(); ++cell)
+	{
+		uint32 count = GetStarCount(cell, magnitudeLimit);
+		if (count == 0) continue;
+
+		float angle = acosf(etm::Clamp(m_CellCosAngles[cell], 1.f, -1.f)) + margin;
+		if (angle < etm::PI_DIV2)
+		{
+			float sinAngle = sinf(angle);
+			bool isVisible = true;
+			for (const vec3 &plane : planes)
+			{
+				if (etm::dot(plane, m_CellAxes[cell]) < -sinAngle)
+				{
+					isVisible = false;
+					break;
+				}
+			}
+			if (!isVisible) continue;
+		}
+
+		//neighbouring cells that are drawn completely join into one range
+		uint32 first = m_pCells[cell].first;
+		if (!counts.empty() && (uint32)(firsts.back() + counts.back()) == first)
+		{
+			counts.back() += (int32)count;
+		}
+		else
+		{
+			firsts.push_back((int32)first);
+			counts.push_back((int32)count);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+//Star Catalog
+//************
+
+// Binary star data that can be used straight from a memory mapped file, without parsing or copying it.
+// The sky is split into a grid of cells on the faces of a cube, the stars are grouped by cell and sorted from bright to faint within each cell,
+// so a magnitude limit keeps the first stars of every cell and cells outside of the view are skipped as a whole.
+// Stars are stored ready for the GPU as [X, Z, Y, magnitude], the HYG coordinates swizzled to y up.
+
+class StarCatalog
+{
+public:
+	struct Cell
+	{
+		uint32 first;
+		uint32 count;
+	};
+
+	//Creates a catalog from stars in the [X, Z, Y, magnitude] layout, with cellResolution by cellResolution cells on each cube face
+	static std::vector<uint8> Build(const std::vector<vec4> &stars, uint32 cellResolution = 8);
+	//cell the direction falls into, directions don't need to be normalized
+	static uint32 GetCellIndex(const vec3 &direction, uint32 cellResolution);
+
+	//Reads the catalog in place, the memory has to stay valid for as long as the catalog is used, false if it isn't a valid catalog
+	bool Open(const uint8* pData, size_t size);
+	bool IsOpen() const { return m_pStars != nullptr; }
+
+	uint32 GetStarCount() const { return m_StarCount; }
+	const vec4* GetStars() const { return m_pStars; }
+	uint32 GetCellResolution() const { return m_CellResolution; }
+	uint32 GetCellCount() const { return (uint32)m_CellAxes.size(); }
+	const Cell& GetCell(uint32 cell) const { return m_pCells[cell]; }
+
+	//stars of a cell with a magnitude up to the limit, they always come first
+	uint32 GetStarCount(uint32 cell, float magnitudeLimit) const;
+	uint32 GetStarCount(float magnitudeLimit) const;
+	//the faintest magnitude limit that keeps the count of stars on the whole sky within starCount
+	float GetMagnitudeLimit(uint32 starCount) const;
+
+	//Ranges of stars up to the magnitude limit in cells that can be seen with a view projection without translation,
+	//margin is the angle a stars sprite reaches beyond its center
+	void GetVisibleRanges(const mat4 &viewProj, float magnitudeLimit, float margin, std::vector<int32> &firsts, std::vector<int32> &counts) const;
+
+private:
+	struct Header
+	{
+		char magic[4];
+		uint32 version;
+		uint32 starCount;
+		uint32 cellResolution;
+		//from the start of the file, aligned to 16 bytes
+		uint32 starOffset;
+		uint32 padding[3];
+	};
+
+	static vec3 GetCellDirection(uint32 face, uint32 cellResolution, float u, float v);
+
+	uint32 m_StarCount = 0;
+	uint32 m_CellResolution = 0;
+	const Cell* m_pCells = nullptr;
+	const vec4* m_pStars = nullptr;
+
+	//cone around every cell
+	std::vector<vec3> m_CellAxes;
+	std::vector<float> m_CellCosAngles;
+
+	float m_MinMagnitude = 0.f;
+	float m_MaxMagnitude = 0.f;
+};
@@ -14,35 +14,15 @@ StarField::~StarField()
 {
 	glDeleteVertexArrays(1, &m_VAO);
 	glDeleteBuffers(1, &m_VBO);
+	SafeDelete(m_pCatalogFile);
 }
 
 void StarField::Initialize()
 {
-	File* jsonFile = new File(m_DataFile, nullptr);
-	if (!jsonFile->Open(FILE_ACCESS_MODE::Read))
+	std::string catalogFile = m_DataFile.substr(0, m_DataFile.rfind('.')) + ".stars";
+	if (!MapCatalog(catalogFile) && !CreateCatalog(catalogFile))
 		return;
 
-	JSON::Parser parser = JSON::Parser(FileUtil::AsText(jsonFile->Read()));
-	delete jsonFile;
-	jsonFile = nullptr;
-
-	JSON::Object* root = parser.GetRoot();
-	uint32 starCount = 0;
-
-	JSON::Array* jstarArray = (*root)["stars"]->arr();
-	for (auto jStar : jstarArray->value)
-	{
-		vec4 star;
-		if (JSON::ArrayVector(jStar, star) && m_MaxStars == 0 ? true : starCount < m_MaxStars)
-		{
-			//HYG coordinates are in a different coordinate system Z up Y forward 
-			//first component is magnitude
-			//output [X, Z, Y, mag]
-			m_Stars.push_back(vec4(star[1], star[3], star[2], star[0]));
-			starCount++;
-		}
-	}
-	
 	m_pShader = ContentManager::Load<ShaderData>("Shaders/FwdStarField.glsl");
 	m_pSprite = ContentManager::Load<TextureData>("Resources/Textures/starSprite.png");
 
@@ -57,8 +37,8 @@ void StarField::Initialize()
 	STATE->BindVertexArray(m_VAO);
 	STATE->BindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
-	//set data and attributes
-	glBufferData(GL_ARRAY_BUFFER, m_Stars.size()*sizeof(vec4), m_Stars.data(), GL_DYNAMIC_DRAW);
+	//set data and attributes, straight from the catalog
+	glBufferData(GL_ARRAY_BUFFER, m_Catalog.GetStarCount()*sizeof(vec4), m_Catalog.GetStars(), GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, (GLint)4, GL_FLOAT, GL_FALSE, (GLsizei)sizeof(vec4), (GLvoid*)0);
@@ -68,6 +48,74 @@ void StarField::Initialize()
 	STATE->BindVertexArray(0);
 }
 
+bool StarField::MapCatalog(const std::string &catalogFile)
+{
+	m_pCatalogFile = new File(catalogFile, nullptr);
+	uint64 size = 0;
+	const uint8* pData = nullptr;
+	FILE_ACCESS_FLAGS flags;
+	flags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Exists);
+	if (m_pCatalogFile->Open(FILE_ACCESS_MODE::Read, flags))
+	{
+		pData = m_pCatalogFile->Map(size);
+		//the mapping outlives the handle
+		m_pCatalogFile->Close();
+	}
+	if (!pData || !m_Catalog.Open(pData, (size_t)size))
+	{
+		SafeDelete(m_pCatalogFile);
+		return false;
+	}
+	return true;
+}
+
+//Reads the json data once and saves it as a binary catalog for the next time
+bool StarField::CreateCatalog(const std::string &catalogFile)
+{
+	File* jsonFile = new File(m_DataFile, nullptr);
+	if (!jsonFile->Open(FILE_ACCESS_MODE::Read))
+	{
+		SafeDelete(jsonFile);
+		return false;
+	}
+
+	JSON::Parser parser = JSON::Parser(FileUtil::AsText(jsonFile->Read()));
+	SafeDelete(jsonFile);
+
+	JSON::Object* root = parser.GetRoot();
+	std::vector<vec4> stars;
+
+	JSON::Array* jstarArray = (*root)["stars"]->arr();
+	for (auto jStar : jstarArray->value)
+	{
+		vec4 star;
+		if (JSON::ArrayVector(jStar, star))
+		{
+			//HYG coordinates are in a different coordinate system Z up Y forward 
+			//first component is magnitude
+			//output [X, Z, Y, mag]
+			stars.push_back(vec4(star[1], star[3], star[2], star[0]));
+		}
+	}
+
+	m_CatalogData = StarCatalog::Build(stars);
+	if (!m_Catalog.Open(m_CatalogData.data(), m_CatalogData.size()))
+	{
+		LOG("Creating the star catalog failed", Error);
+		return false;
+	}
+
+	File* pFile = new File(catalogFile, nullptr);
+	FILE_ACCESS_FLAGS flags;
+	flags.SetFlags(FILE_ACCESS_FLAGS::FLAGS::Create | FILE_ACCESS_FLAGS::FLAGS::Truncate);
+	if (!pFile->Open(FILE_ACCESS_MODE::Write, flags) || !pFile->Write(m_CatalogData))
+	{
+		LOG("Couldn't save the star catalog to " + catalogFile + ", it will be created from the json data again next time", Warning);
+	}
+	SafeDelete(pFile);
+	return true;
+}
+
 void StarField::DrawForward()
 {
 	STATE->SetBlendEnabled(true);
@@ -84,7 +132,21 @@ void StarField::DrawForward()
 	m_pShader->Upload("uBaseFlux"_hash, m_BaseFlux);
 	m_pShader->Upload("uBaseMag"_hash, m_BaseMag);
 	m_pShader->Upload("uAspectRatio"_hash, WINDOW.GetAspectRatio());
-	STATE->DrawArrays(GL_POINTS, 0, m_DrawnStars);
+
+	//the brightest stars up to the drawn count, only from the cells on screen
+	if (m_IsLimitDirty)
+	{
+		uint32 drawnStars = m_MaxStars == 0 ? m_DrawnStars : std::min(m_DrawnStars, m_MaxStars);
+		m_MagnitudeLimit = m_Catalog.GetMagnitudeLimit(drawnStars);
+		m_IsLimitDirty = false;
+	}
+	//sprites reach out diagonally by up to twice the radius at a distance of 1
+	float spriteAngle = atanf(m_Radius * 2.f);
+	m_Catalog.GetVisibleRanges(CAMERA->GetStatViewProj(), m_MagnitudeLimit, spriteAngle, m_DrawFirsts, m_DrawCounts);
+	if (!m_DrawFirsts.empty())
+	{
+		STATE->MultiDrawArrays(GL_POINTS, m_DrawFirsts.data(), m_DrawCounts.data(), (uint32)m_DrawFirsts.size());
+	}
 	STATE->BindVertexArray(0);
 	STATE->SetBlendEnabled(false);
 }
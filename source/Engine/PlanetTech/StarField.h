@@ -1,15 +1,19 @@
 #pragma once
 #include "../SceneGraph/Entity.hpp"
+#include "StarCatalog.hpp"
+
+class File;
 
 class StarField : public Entity
 {
 public:
+	//the binary catalog is created next to the json data the first time, and memory mapped from then on
 	StarField(const std::string &dataFile);
 	virtual ~StarField();
 
 	void SetRadius(float radius) { m_Radius = radius; }
-	void SetMaxStars(uint32 maxStars) { m_MaxStars = maxStars; }
-	void SetDrawnStars(uint32 drawnStars) { m_DrawnStars = drawnStars; }
+	void SetMaxStars(uint32 maxStars) { m_MaxStars = maxStars; m_IsLimitDirty = true; }
+	void SetDrawnStars(uint32 drawnStars) { m_DrawnStars = drawnStars; m_IsLimitDirty = true; }
 	void SetBaseFlux(float mult) { m_BaseFlux = mult; }
 	void SetBaseMag(float mag) { m_BaseMag = mag; }
 
@@ -20,9 +24,21 @@ protected:
 	virtual void DrawForward();
 
 private:
-	std::vector<vec4> m_Stars;
+	bool MapCatalog(const std::string &catalogFile);
+	bool CreateCatalog(const std::string &catalogFile);
+
 	std::string m_DataFile;
 
+	StarCatalog m_Catalog;
+	File* m_pCatalogFile = nullptr;
+	//only filled when the catalog was just created from the json data
+	std::vector<uint8> m_CatalogData;
+
+	float m_MagnitudeLimit = 0.f;
+	bool m_IsLimitDirty = true;
+	std::vector<int32> m_DrawFirsts;
+	std::vector<int32> m_DrawCounts;
+
 	ShaderData* m_pShader  = nullptr;
 	TextureData* m_pSprite = nullptr;
 
@@ -1,184 +1,641 @@
 #include "stdafx.hpp"
 #include "Triangulator.hpp"
 
+#include <algorithm>
+
 #include "../Graphics/Frustum.hpp"
 #include "Planet.hpp"
+#include "../Helper/TaskScheduler.hpp"
+#include "HeightBounds.hpp"
+
+//Angle between the center and the corners of a triangle for every subdivision level, halving from acos(0.5) at the icosahedron level
+constexpr int32 TRI_LEVEL_LUT_SIZE = 32;
+struct TriLevelAngleLUT
+{
+	float angles[TRI_LEVEL_LUT_SIZE];
+};
+constexpr TriLevelAngleLUT GenerateTriLevelAngleLUT()
+{
+	TriLevelAngleLUT lut{};
+	float angle = etm::PI / 3.f;
+	for (int32 level = 0; level < TRI_LEVEL_LUT_SIZE; ++level)
+	{
+		lut.angles[level] = angle;
+		angle *= 0.5f;
+	}
+	return lut;
+}
+constexpr TriLevelAngleLUT TRI_LEVEL_ANGLES = GenerateTriLevelAngleLUT();
+
+//The patch shader adds detail maps on top of the height map, up to a tenth of the max height plus a fixed amount
+constexpr float DETAIL_HEIGHT_SCALE = 0.1f;
+constexpr float DETAIL_HEIGHT_OFFSET = 0.01f;
 
-#include "../Components/TransformComponent.hpp"
-#include "../Components/CameraComponent.hpp"
+//Relative float error allowed for when deciding if a triangle can't have changed, larger than the rounding error of the heuristic
+constexpr float SLACK_EPSILON = 1e-5f;
+
+//Exact comparisons, the vector comparison operators allow an epsilon
+static bool IsSameVector(const vec3 &lhs, const vec3 &rhs)
+{
+	return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+}
+static bool IsSameFrustum(const FrustumCorners &lhs, const FrustumCorners &rhs)
+{
+	return IsSameVector(lhs.na, rhs.na) && IsSameVector(lhs.nb, rhs.nb) && IsSameVector(lhs.nc, rhs.nc) && IsSameVector(lhs.nd, rhs.nd)
+		&& IsSameVector(lhs.fa, rhs.fa) && IsSameVector(lhs.fb, rhs.fb) && IsSameVector(lhs.fc, rhs.fc) && IsSameVector(lhs.fd, rhs.fd);
+}
+
+TriPool::~TriPool()
+{
+	for (Tri* pChunk : m_Chunks)
+	{
+		delete[] pChunk;
+	}
+}
+
+Tri* TriPool::Allocate()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_FreeBlocks.empty())
+	{
+		Tri* pChunk = new Tri[BLOCKS_PER_CHUNK * 4];
+		m_Chunks.push_back(pChunk);
+		for (size_t block = BLOCKS_PER_CHUNK; block > 0; --block)
+		{
+			m_FreeBlocks.push_back(pChunk + (block - 1) * 4);
+		}
+	}
+	Tri* pBlock = m_FreeBlocks.back();
+	m_FreeBlocks.pop_back();
+	return pBlock;
+}
+
+void TriPool::Release(Tri* pBlock)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_FreeBlocks.push_back(pBlock);
+}
 
 Triangulator::Triangulator(Planet* pPlanet)
 	: m_pPlanet(pPlanet)
 {
 	m_pFrustum = new Frustum();
 }
+Triangulator::Triangulator(float radius, float maxHeight)
+	: m_Radius(radius)
+	, m_MaxHeight(maxHeight)
+{
+	m_pFrustum = new Frustum();
+}
 Triangulator::~Triangulator()
 {
+	if (m_AsyncThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_AsyncMutex);
+			m_IsShuttingDown = true;
+		}
+		m_AsyncCondition.notify_all();
+		m_AsyncThread.join();
+	}
 	SafeDelete(m_pFrustum);
 }
 
 void Triangulator::Init()
 {
-	auto ico = GetIcosahedronPositions(m_pPlanet->GetRadius());
+	if (m_pPlanet)
+	{
+		m_Radius = m_pPlanet->GetRadius();
+		m_MaxHeight = m_pPlanet->GetMaxHeight();
+	}
+
+	auto ico = GetIcosahedronPositions(m_Radius);
 	auto indices = GetIcosahedronIndices();
 	for (size_t i = 0; i < indices.size(); i+=3)
 	{
-		m_Icosahedron.push_back(Tri(ico[indices[i]], ico[indices[i+1]], ico[indices[i+2]], nullptr, 0));
+		m_Icosahedron.push_back(Tri(ico[indices[i]], ico[indices[i+1]], ico[indices[i+2]], nullptr, 0, PatchInstance((uint32)i / 3)));
 	}
 
 	Precalculate();
-	
-	//First geometry generation
-	GenerateGeometry();
-}
-
-bool Triangulator::Update()
-{
-	//Set Max subd level
-	//bool levelChanged = false;
-	//if (INPUT->IsKeyboardKeyPressed(SDL_SCANCODE_UP))
-	//{
-	//	m_MaxLevel++;
-	//	levelChanged = true;
-	//}
-	//if (INPUT->IsKeyboardKeyPressed(SDL_SCANCODE_DOWN) && m_MaxLevel>0)
-	//{
-	//	m_MaxLevel--;
-	//	levelChanged = true;
-	//}
-	//if (levelChanged)Precalculate();
-	m_MaxLevel = 22;
-	Precalculate();
-
-	//Frustum update
-	if (INPUT->IsKeyboardKeyPressed(SDL_SCANCODE_SPACE))m_LockFrustum = !m_LockFrustum;
-
-	m_pFrustum->SetCullTransform(m_pPlanet->GetTransform()->GetWorld());
-	if (!m_LockFrustum) m_pFrustum->SetToCamera(CAMERA);
-	m_pFrustum->Update();
+	for (Tri &root : m_Icosahedron)
+	{
+		CalculateVolume(root);
+	}
 
-	return true;
+	m_pScheduler = TaskScheduler::GetInstance();
+	m_Contexts.resize(m_pScheduler->GetWorkerCount());
+	for (uint32 worker = 0; worker < (uint32)m_Contexts.size(); ++worker)
+	{
+		m_Contexts[worker].worker = worker;
+	}
 }
 
 void Triangulator::Precalculate()
 {
 	//determine culling angle behind planet based on max height
-	float cullingAngle = acosf(m_pPlanet->GetRadius()/(m_pPlanet->GetRadius()+m_pPlanet->GetMaxHeight()));
+	float cullingAngle = acosf(m_Radius/(m_Radius+m_MaxHeight));
 	//Dot Product LUT
+	assert(m_MaxLevel < TRI_LEVEL_LUT_SIZE);
+	assert(m_MaxLevel <= PatchInstance::MAX_LEVEL);
 	m_TriLevelDotLUT.clear();
 	m_TriLevelDotLUT.push_back(0.5f+sinf(cullingAngle));
-	float angle = acosf(0.5f);
 	for (int32 i = 1; i <= m_MaxLevel; i++)
 	{
-		angle *= 0.5f;
-		m_TriLevelDotLUT.push_back(sinf(angle+cullingAngle));
+		m_TriLevelDotLUT.push_back(sinf(TRI_LEVEL_ANGLES.angles[i]+cullingAngle));
 	}
 	//height multipliers
 	m_HeightMultLUT.clear();
+	m_SurfaceMultLUT.clear();
 	vec3 a = m_Icosahedron[0].a;
 	vec3 b = m_Icosahedron[0].b;
 	vec3 c = m_Icosahedron[0].c;
 	vec3 center = (a + b + c) / 3.f;
-	center = center * m_pPlanet->GetRadius() / etm::length(center);//+maxHeight
-	m_HeightMultLUT.push_back(1 / etm::dot( etm::normalize(a), etm::normalize(center)));
-	float normMaxHeight = m_pPlanet->GetMaxHeight() / m_pPlanet->GetRadius();
+	center = center * m_Radius / etm::length(center);//+maxHeight
+	m_SurfaceMultLUT.push_back(1 / etm::dot( etm::normalize(a), etm::normalize(center)));
+	m_HeightMultLUT.push_back(m_SurfaceMultLUT.back());
+	float normMaxHeight = m_MaxHeight / m_Radius;
 	for (int32 i = 1; i <= m_MaxLevel; i++)
 	{
 		vec3 A = b + ((c - b)*0.5f);
 		vec3 B = c + ((a - c)*0.5f);
 		c = a + ((b - a)*0.5f);
-		a = A * m_pPlanet->GetRadius() / etm::length(A);
-		b = B * m_pPlanet->GetRadius() / etm::length(B);
-		c = c * m_pPlanet->GetRadius() / etm::length(c);
-		m_HeightMultLUT.push_back(1 / etm::dot( etm::normalize(a), etm::normalize(center)) + normMaxHeight);
+		a = A * m_Radius / etm::length(A);
+		b = B * m_Radius / etm::length(B);
+		c = c * m_Radius / etm::length(c);
+		m_SurfaceMultLUT.push_back(1 / etm::dot( etm::normalize(a), etm::normalize(center)));
+		m_HeightMultLUT.push_back(m_SurfaceMultLUT.back() + normMaxHeight);
 	}
+
+	//the persistent triangles were evaluated with the old tables
+	m_ForceUpdate = true;
 }
 
-void Triangulator::GenerateGeometry()
+void Triangulator::PrecalculateDistanceLUT()
 {
-	//Precalculate Distance LUT
 	//The distances generated should keep the triangles smaller than m_AllowedTriPx at any level
-	//In future only recalculate on FOV or triangle density change
-	m_DistanceLUT.clear();
+	//Only changes with the FOV or triangle density, in which case all triangles need to be reevaluated
+	std::vector<float> distanceLUT;
 	float sizeL = etm::length(m_Icosahedron[0].a - m_Icosahedron[0].b);
-	float frac = tanf((m_AllowedTriPx * etm::radians(m_pFrustum->GetFOV())) / WINDOW.Width);
+	float frac = tanf((m_AllowedTriPx * etm::radians(m_GenerationFrustum.GetFOV())) / m_GenerationViewportWidth);
 	for (int32 level = 0; level < m_MaxLevel+5; level++)
 	{
-		m_DistanceLUT.push_back(sizeL / frac);
+		distanceLUT.push_back(sizeL / frac);
 		sizeL *= 0.5f;
 	}
 
-	//Recursion start
-	m_Positions.clear();
+	m_Build.isDistanceLUTChanged = distanceLUT != m_DistanceLUT;
+	if (m_Build.isDistanceLUTChanged)
+	{
+		m_DistanceLUT = distanceLUT;
+		m_ForceUpdate = true;
+	}
+}
+
+void Triangulator::GenerateGeometry()
+{
+	std::unique_lock<std::mutex> lock(m_AsyncMutex);
+	m_Result.isGeometryChanged = false;
+	m_Result.isDistanceLUTChanged = false;
+	if (m_IsGenerating) return;
+	//a result generated in async mode has to be published before the tree moves on, it is what the next result is compared against
+	if (m_IsBuildPending) PublishGeometry();
 
-	for (auto t : m_Icosahedron)
+	m_GenerationFrustum = *m_pFrustum;
+	m_GenerationViewportWidth = m_ViewportWidth;
+	if (m_Async)
 	{
-		RecursiveTriangle(t.a, t.b, t.c, t.level, true);
+		m_IsGenerating = true;
+		lock.unlock();
+		m_AsyncCondition.notify_all();
+		return;
 	}
+	Generate();
+	PublishGeometry();
 }
 
-TriNext Triangulator::SplitHeuristic(vec3 &a, vec3 &b, vec3 &c, int16 level, bool frustumCull)
+void Triangulator::WaitForGeneration()
 {
-	vec3 center = (a + b + c) / 3.f;
+	std::unique_lock<std::mutex> lock(m_AsyncMutex);
+	m_AsyncCondition.wait(lock, [this]() { return !m_IsGenerating; });
+}
+
+void Triangulator::SetIncremental(bool incremental)
+{
+	WaitForGeneration();
+	m_Incremental = incremental;
+	m_ForceUpdate = true;
+}
+
+void Triangulator::SetMultithreaded(bool multithreaded)
+{
+	WaitForGeneration();
+	m_Multithreaded = multithreaded;
+}
+
+void Triangulator::SetAsync(bool async)
+{
+	WaitForGeneration();
+	m_Async = async;
+	if (m_Async && !m_AsyncThread.joinable())
+	{
+		m_AsyncThread = std::thread(&Triangulator::AsyncThread, this);
+	}
+}
+
+void Triangulator::AsyncThread()
+{
+	std::unique_lock<std::mutex> lock(m_AsyncMutex);
+	for (;;)
+	{
+		m_AsyncCondition.wait(lock, [this]() { return m_IsGenerating || m_IsShuttingDown; });
+		if (m_IsShuttingDown) return;
+		lock.unlock();
+		Generate();
+		lock.lock();
+		m_IsGenerating = false;
+		m_IsBuildPending = true;
+		m_AsyncCondition.notify_all();
+	}
+}
+
+//Swaps the generated result in, if the previous one was never seen by the caller their changes are combined
+void Triangulator::PublishGeometry()
+{
+	bool isGeometryChanged = m_Result.isGeometryChanged;
+	bool isDistanceLUTChanged = m_Result.isDistanceLUTChanged;
+	size_t firstChangedInstance = m_Result.firstChangedInstance;
+	std::swap(m_Result, m_Build);
+	if (isGeometryChanged)
+	{
+		m_Result.isGeometryChanged = true;
+		m_Result.firstChangedInstance = std::min(m_Result.firstChangedInstance, firstChangedInstance);
+	}
+	m_Result.isDistanceLUTChanged |= isDistanceLUTChanged;
+	m_IsBuildPending = false;
+}
+
+//Triangulates for the generation frustum into m_Build, only touches state the main thread doesn't use while generating
+void Triangulator::Generate()
+{
+	if (m_GenerationHook) m_GenerationHook();
+	PrecalculateDistanceLUT();
+
+	m_Build.heuristicCount = 0;
+	m_Build.positions.clear();
+	m_Build.distanceLUT = m_DistanceLUT;
+	m_Build.cameraPosition = m_GenerationFrustum.GetPositionOS();
+
+	if (!m_Incremental)
+	{
+		//Recursion start
+		for (const Tri &t : m_Icosahedron)
+		{
+			RecursiveTriangle(t.a, t.b, t.c, t.level, t.instance, true);
+		}
+		m_Build.firstChangedInstance = 0;
+		m_Build.isGeometryChanged = true;
+		//the persistent tree didn't follow the camera
+		m_ForceUpdate = true;
+		return;
+	}
+
+	//Walk the persistent tree, only triangles the camera got too close to for their last result are reevaluated
+	//triangles that need frustum culling are also reevaluated whenever the frustum moved
+	FrustumCorners corners = m_GenerationFrustum.GetCorners();
+	m_FrustumChanged = !IsSameFrustum(corners, m_LastFrustumCorners) || !IsSameVector(m_GenerationFrustum.GetPositionOS(), m_LastFrustumPosition);
+	m_SlackScale = m_Radius + m_MaxHeight + etm::length(m_GenerationFrustum.GetPositionOS());
+	UpdateFrustumDrift();
+	m_LastFrustumCorners = corners;
+	m_LastFrustumPosition = m_GenerationFrustum.GetPositionOS();
+	for (TriangulationContext &context : m_Contexts)
+	{
+		context.positions.clear();
+		context.heuristicCount = 0;
+	}
+	//every face starts as a task, large subtrees get split up into more tasks while they are updated
+	for (Tri &root : m_Icosahedron)
+	{
+		Tri* pRoot = &root;
+		if (m_Multithreaded)
+		{
+			m_pScheduler->Push(0, [this, pRoot](uint32 worker) { UpdateTask(worker, pRoot, true, 0); });
+		}
+		else
+		{
+			UpdateTask(0, pRoot, true, 0);
+		}
+	}
+	if (m_Multithreaded) m_pScheduler->Run();
+
+	//Tasks write to their own workers buffer in whatever order they ran, putting them back in tree order keeps the result deterministic
+	for (Tri &root : m_Icosahedron)
+	{
+		GatherTriangle(&root, 0);
+	}
+	for (const TriangulationContext &context : m_Contexts)
+	{
+		m_Build.heuristicCount += context.heuristicCount;
+	}
+	std::vector<PatchInstance> &positions = m_Build.positions;
+	const std::vector<PatchInstance> &previous = m_Result.positions;
+	auto mismatch = std::mismatch(positions.begin(), positions.begin() + std::min(positions.size(), previous.size()), previous.begin());
+	m_Build.firstChangedInstance = mismatch.first - positions.begin();
+	m_Build.isGeometryChanged = m_Build.firstChangedInstance < positions.size() || positions.size() != previous.size();
+	m_ForceUpdate = false;
+}
+
+//Accumulates how far every plane moved since the last frame, in double precision so small movements aren't lost over time
+//moving a plane changes the distance of a point p to it by at most |delta normal| * |p - camera| + |delta camera| + |delta camera distance to the plane|
+void Triangulator::UpdateFrustumDrift()
+{
+	const std::vector<Plane> &planes = m_GenerationFrustum.GetPlanes();
+	dvec3 camPos = etm::vecCast<double>(m_GenerationFrustum.GetPositionOS());
+	dvec3 lastCamPos = etm::vecCast<double>(m_LastFrustumPosition);
+
+	FrustumDrift drift = m_FrustumDrift[m_Frame % DRIFT_HISTORY];
+	++m_Frame;
+	if (m_LastFrustumPlanes.size() == planes.size())
+	{
+		double moved = etm::distance(camPos, lastCamPos);
+		drift.cameraPath += moved;
+		for (size_t i = 0; i < planes.size(); ++i)
+		{
+			dvec3 normal = etm::vecCast<double>(planes[i].n);
+			dvec3 lastNormal = etm::vecCast<double>(m_LastFrustumPlanes[i].n);
+			double camDist = etm::dot(normal, camPos - etm::vecCast<double>(planes[i].d));
+			double lastCamDist = etm::dot(lastNormal, lastCamPos - etm::vecCast<double>(m_LastFrustumPlanes[i].d));
+			drift.normal[i] += etm::length(normal - lastNormal);
+			drift.offset[i] += std::abs(camDist - lastCamDist) + moved;
+		}
+	}
+	else
+	{
+		m_ForceUpdate = true;
+	}
+	m_FrustumDrift[m_Frame % DRIFT_HISTORY] = drift;
+	m_LastFrustumPlanes = planes;
+}
+
+bool Triangulator::IsFrustumResultValid(const Tri* pTri) const
+{
+	if (m_Frame - pTri->evalFrame >= DRIFT_HISTORY) return false;
+	const FrustumDrift &current = m_FrustumDrift[m_Frame % DRIFT_HISTORY];
+	const FrustumDrift &evaluated = m_FrustumDrift[pTri->evalFrame % DRIFT_HISTORY];
+	double range = pTri->frustumRange + (current.cameraPath - evaluated.cameraPath);
+	for (uint8 i = 0; i < Frustum::PLANE_COUNT; ++i)
+	{
+		double moved = (current.normal[i] - evaluated.normal[i]) * range + (current.offset[i] - evaluated.offset[i]);
+		if (moved >= pTri->frustumMargins[i]) return false;
+	}
+	return true;
+}
+
+//Bounding volume and culling threshold of a triangle, from the height bounds if there are any or the planets max height otherwise
+void Triangulator::CalculateVolume(Tri &tri) const
+{
+	if (!m_pHeightBounds)
+	{
+		tri.baseMult = 1.f;
+		tri.topMult = m_HeightMultLUT[tri.level];
+		tri.cullDot = m_TriLevelDotLUT[tri.level];
+		return;
+	}
+	float minHeight, maxHeight;
+	m_pHeightBounds->GetTriangleBounds(tri.a, tri.b, tri.c, minHeight, maxHeight);
+	minHeight *= m_MaxHeight;
+	maxHeight = maxHeight * m_MaxHeight * (1 + DETAIL_HEIGHT_SCALE) + DETAIL_HEIGHT_OFFSET;
+
+	//the corners lie on the sphere, so the plane through them stays below the surface
+	tri.baseMult = 1.f + minHeight / m_Radius;
+	tri.topMult = m_SurfaceMultLUT[tri.level] + maxHeight / m_Radius;
+	//same as the dot product LUT, with the culling angle of the highest point instead of the planets
+	float cullingAngle = acosf(m_Radius / (m_Radius + maxHeight));
+	if (tri.level == 0) tri.cullDot = 0.5f + sinf(cullingAngle);
+	else tri.cullDot = sinf(TRI_LEVEL_ANGLES.angles[tri.level] + cullingAngle);
+}
+
+//Sets the triangles slack to how far the camera can move before the result could change, ignoring the frustum
+//and the frustum margins for how far the frustum planes can move
+TriNext Triangulator::SplitHeuristic(Tri &tri, bool frustumCull)
+{
+	const vec3 &camPos = m_GenerationFrustum.GetPositionOS();
+	vec3 center = (tri.a + tri.b + tri.c) / 3.f;
 	//Perform backface culling
-	float dotNV = etm::dot( etm::normalize(center), etm::normalize(center - m_pFrustum->GetPositionOS()));
-	if (dotNV >= m_TriLevelDotLUT[level])
+	vec3 toCenter = center - camPos;
+	float dotNV = etm::dot( etm::normalize(center), etm::normalize(toCenter));
+	//moving the camera by d changes the view direction by at most 2d/|toCenter|
+	float centerDist = etm::length(toCenter);
+	tri.slack = 0.5f * std::abs(dotNV - tri.cullDot) * centerDist - SLACK_EPSILON * (centerDist + m_SlackScale);
+	if (dotNV >= tri.cullDot)
 	{
 		return TriNext::CULL;
 	}
 
+	float aDist = etm::length(tri.a - camPos);
+	float bDist = etm::length(tri.b - camPos);
+	float cDist = etm::length(tri.c - camPos);
+
 	//Perform Frustum culling
+	bool childFrustumCull = frustumCull;
 	if (frustumCull)
 	{
-		auto intersect = m_pFrustum->ContainsTriVolume(a, b, c, m_HeightMultLUT[level]);
-		//auto intersect = m_pFrustum->ContainsTriangle(a, b, c);
-		if (intersect == VolumeCheck::OUTSIDE) return TriNext::CULL;
-		if (intersect == VolumeCheck::CONTAINS)//stop frustum culling -> all children are also inside the frustum
+		auto intersect = m_GenerationFrustum.ContainsTriVolume(tri.a, tri.b, tri.c, tri.baseMult, tri.topMult, tri.frustumMargins);
+		//auto intersect = m_GenerationFrustum.ContainsTriangle(a, b, c);
+		for (uint8 i = 0; i < Frustum::PLANE_COUNT; ++i)
 		{
-			//check if new splits are allowed
-			if (level >= m_MaxLevel)return TriNext::LEAF;
-			//split according to distance
-			float aDist = etm::length(a - m_pFrustum->GetPositionOS());
-			float bDist = etm::length(b - m_pFrustum->GetPositionOS());
-			float cDist = etm::length(c - m_pFrustum->GetPositionOS());
-			if (std::fminf(aDist, std::fminf(bDist, cDist)) < m_DistanceLUT[level])return TriNext::SPLIT;
-			return TriNext::LEAF;
+			tri.frustumMargins[i] -= 2 * SLACK_EPSILON * m_SlackScale;
 		}
+		//the raised corners are at most radius * (height - 1) further away
+		tri.frustumRange = std::fmaxf(aDist, std::fmaxf(bDist, cDist)) + m_Radius * (tri.topMult - 1);
+		tri.evalFrame = m_Frame;
+
+		if (intersect == VolumeCheck::OUTSIDE) return TriNext::CULL;
+		//stop frustum culling -> all children are also inside the frustum
+		if (intersect == VolumeCheck::CONTAINS) childFrustumCull = false;
 	}
 	//check if new splits are allowed
-	if (level >= m_MaxLevel)return TriNext::LEAF;
+	if (tri.level >= m_MaxLevel)return TriNext::LEAF;
 	//split according to distance
-	float aDist = etm::length(a - m_pFrustum->GetPositionOS());
-	float bDist = etm::length(b - m_pFrustum->GetPositionOS());
-	float cDist = etm::length(c - m_pFrustum->GetPositionOS());
-	if (std::fminf(aDist, std::fminf(bDist, cDist)) < m_DistanceLUT[level])return TriNext::SPLITCULL;
+	float minDist = std::fminf(aDist, std::fminf(bDist, cDist));
+	tri.slack = std::fminf(tri.slack, std::abs(minDist - m_DistanceLUT[tri.level]) - 2 * SLACK_EPSILON * m_SlackScale);
+	if (minDist < m_DistanceLUT[tri.level])return childFrustumCull ? TriNext::SPLITCULL : TriNext::SPLIT;
 	return TriNext::LEAF;
 }
 
-void Triangulator::RecursiveTriangle(vec3 a, vec3 b, vec3 c, int16 level, bool frustumCull)
+void Triangulator::RecursiveTriangle(vec3 a, vec3 b, vec3 c, int16 level, PatchInstance instance, bool frustumCull)
 {
-	TriNext next = SplitHeuristic(a, b, c, level, frustumCull);
+	Tri tri(a, b, c, nullptr, level, instance);
+	CalculateVolume(tri);
+	++m_Build.heuristicCount;
+	TriNext next = SplitHeuristic(tri, frustumCull);
 	if (next == CULL) return;
 	//check if subdivision is needed based on camera distance
 	else if (next == SPLIT || next == SPLITCULL)
 	{
-		//find midpoints
-		vec3 A = b + ((c - b)*0.5f);
-		vec3 B = c + ((a - c)*0.5f);
-		vec3 C = a + ((b - a)*0.5f);
-		//make the distance from center larger according to planet radius
-		A = A * m_pPlanet->GetRadius() / etm::length(A);
-		B = B * m_pPlanet->GetRadius() / etm::length(B);
-		C = C * m_pPlanet->GetRadius() / etm::length(C);
+		//find midpoints on the sphere
+		vec3 A, B, C;
+		GetPatchMidpoints(a, b, c, m_Radius, A, B, C);
 		//Make 4 new triangles
 		int16 nLevel = level + 1;
-		RecursiveTriangle(a, B, C, nLevel, next == SPLITCULL);//Winding is inverted
-		RecursiveTriangle(A, b, C, nLevel, next == SPLITCULL);//Winding is inverted
-		RecursiveTriangle(A, B, c, nLevel, next == SPLITCULL);//Winding is inverted
-		RecursiveTriangle(A, B, C, nLevel, next == SPLITCULL);
+		RecursiveTriangle(a, B, C, nLevel, instance.GetChildInstance(0), next == SPLITCULL);//Winding is inverted
+		RecursiveTriangle(A, b, C, nLevel, instance.GetChildInstance(1), next == SPLITCULL);//Winding is inverted
+		RecursiveTriangle(A, B, c, nLevel, instance.GetChildInstance(2), next == SPLITCULL);//Winding is inverted
+		RecursiveTriangle(A, B, C, nLevel, instance.GetChildInstance(3), next == SPLITCULL);
 	}
 	else //put the triangle in the buffer
 	{
-		m_Positions.push_back(PatchInstance((BYTE)level, a, b-a, c-a));
+		m_Build.positions.push_back(instance);
 	}
-}
\ No newline at end of file
+}
+
+//Entry point of a task, the instances of the triangle end up in the buffer of the worker running it
+void Triangulator::UpdateTask(uint32 worker, Tri* pTri, bool frustumCull, size_t previousParentOffset)
+{
+	TriangulationContext &context = m_Contexts[worker];
+	pTri->isSpawned = false;
+	pTri->taskWorker = worker;
+	pTri->taskOffset = (uint32)context.positions.size();
+	UpdateTriangle(context, pTri, frustumCull, pTri->taskOffset, previousParentOffset, true);
+}
+
+//Offsets within a task are relative to the workers buffer, which doesn't matter for the instanceOffset as the instances of a task stay together
+//previous offsets are always in the previous frames final buffer
+void Triangulator::UpdateTriangle(TriangulationContext &context, Tri* pTri, bool frustumCull, size_t parentOffset, size_t previousParentOffset, bool isTask)
+{
+	const vec3 &camPos = m_GenerationFrustum.GetPositionOS();
+	std::vector<PatchInstance> &positions = context.positions;
+	size_t offset = positions.size();
+	size_t previousOffset = previousParentOffset + pTri->instanceOffset;
+
+	//Triangles that don't need frustum culling only depend on the camera position, so if the camera stayed within their slack the result is the same
+	//triangles that do need it also have to check if the frustum planes moved too far
+	bool reevaluate = true;
+	if (!m_ForceUpdate && frustumCull == pTri->frustumCull)
+	{
+		bool isFrustumUnchanged = !frustumCull || !m_FrustumChanged;
+		float moved = etm::distance(camPos, pTri->evalPosition);
+		if (isFrustumUnchanged && moved <= pTri->subtreeSlack)
+		{
+			//the whole subtree is unchanged, so last frames instances can be copied
+			auto previousBegin = m_Result.positions.begin() + previousOffset;
+			positions.insert(positions.end(), previousBegin, previousBegin + pTri->instanceCount);
+			pTri->instanceOffset = (uint32)(offset - parentOffset);
+			//keep the slack relative to the current camera position so the parent can combine it with its other children
+			pTri->slack -= moved;
+			pTri->subtreeSlack -= moved;
+			pTri->evalPosition = camPos;
+			return;
+		}
+		if (moved <= pTri->slack && (isFrustumUnchanged || IsFrustumResultValid(pTri)))
+		{
+			//this triangle splits the same way, but some of its children need to be checked
+			pTri->slack -= moved;
+			reevaluate = false;
+		}
+	}
+
+	if (reevaluate)
+	{
+		++context.heuristicCount;
+		pTri->state = SplitHeuristic(*pTri, frustumCull);
+		pTri->frustumCull = frustumCull;
+	}
+	pTri->evalPosition = camPos;
+	float subtreeSlack = pTri->slack;
+	if (pTri->state == SPLIT || pTri->state == SPLITCULL)
+	{
+		if (!pTri->c1) Split(pTri);
+		//hand the children to new tasks if the subtree was large last frame, GatherTriangle completes this triangle once they are done
+		if (isTask && m_Multithreaded && pTri->instanceCount >= TASK_MIN_INSTANCES)
+		{
+			pTri->isSpawned = true;
+			bool childFrustumCull = pTri->state == SPLITCULL;
+			for (Tri* pChild = pTri->c1; pChild != pTri->c1 + 4; ++pChild)
+			{
+				m_pScheduler->Push(context.worker, [this, pChild, childFrustumCull, previousOffset](uint32 worker)
+				{
+					UpdateTask(worker, pChild, childFrustumCull, previousOffset);
+				});
+			}
+			return;
+		}
+		for (Tri* pChild = pTri->c1; pChild != pTri->c1 + 4; ++pChild)
+		{
+			UpdateTriangle(context, pChild, pTri->state == SPLITCULL, offset, previousOffset, false);
+			subtreeSlack = std::fminf(subtreeSlack, pChild->subtreeSlack);
+		}
+	}
+	else
+	{
+		if (pTri->c1) Merge(pTri);
+		if (pTri->state == LEAF)
+		{
+			positions.push_back(pTri->instance);
+		}
+	}
+	pTri->subtreeSlack = subtreeSlack;
+	pTri->instanceOffset = (uint32)(offset - parentOffset);
+	pTri->instanceCount = (uint32)(positions.size() - offset);
+}
+
+//Copies the output of a task into the final buffer, or finishes a triangle that spawned tasks for its children
+void Triangulator::GatherTriangle(Tri* pTri, size_t parentOffset)
+{
+	size_t offset = m_Build.positions.size();
+	if (pTri->isSpawned)
+	{
+		float subtreeSlack = pTri->slack;
+		for (Tri* pChild = pTri->c1; pChild != pTri->c1 + 4; ++pChild)
+		{
+			GatherTriangle(pChild, offset);
+			subtreeSlack = std::fminf(subtreeSlack, pChild->subtreeSlack);
+		}
+		pTri->subtreeSlack = subtreeSlack;
+		pTri->instanceCount = (uint32)(m_Build.positions.size() - offset);
+	}
+	else
+	{
+		auto taskBegin = m_Contexts[pTri->taskWorker].positions.begin() + pTri->taskOffset;
+		m_Build.positions.insert(m_Build.positions.end(), taskBegin, taskBegin + pTri->instanceCount);
+	}
+	pTri->instanceOffset = (uint32)(offset - parentOffset);
+}
+
+void Triangulator::Split(Tri* pTri)
+{
+	vec3 &a = pTri->a;
+	vec3 &b = pTri->b;
+	vec3 &c = pTri->c;
+	//find midpoints, same as RecursiveTriangle and the patch decoder so all of them produce identical vertices
+	vec3 A, B, C;
+	GetPatchMidpoints(a, b, c, m_Radius, A, B, C);
+	//Make 4 new triangles
+	int16 nLevel = pTri->level + 1;
+	const PatchInstance &instance = pTri->instance;
+	Tri* pBlock = m_Pool.Allocate();
+	pBlock[0] = Tri(a, B, C, pTri, nLevel, instance.GetChildInstance(0));//Winding is inverted
+	pBlock[1] = Tri(A, b, C, pTri, nLevel, instance.GetChildInstance(1));//Winding is inverted
+	pBlock[2] = Tri(A, B, c, pTri, nLevel, instance.GetChildInstance(2));//Winding is inverted
+	pBlock[3] = Tri(A, B, C, pTri, nLevel, instance.GetChildInstance(3));
+	pTri->c1 = pBlock;
+	pTri->c2 = pBlock + 1;
+	pTri->c3 = pBlock + 2;
+	pTri->c4 = pBlock + 3;
+	for (Tri* pChild = pBlock; pChild != pBlock + 4; ++pChild)
+	{
+		CalculateVolume(*pChild);
+	}
+}
+
+void Triangulator::Merge(Tri* pTri)
+{
+	for (Tri* pChild = pTri->c1; pChild != pTri->c1 + 4; ++pChild)
+	{
+		if (pChild->c1) Merge(pChild);
+	}
+	m_Pool.Release(pTri->c1);
+	pTri->c1 = nullptr;
+	pTri->c2 = nullptr;
+	pTri->c3 = nullptr;
+	pTri->c4 = nullptr;
+}
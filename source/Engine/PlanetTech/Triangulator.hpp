@@ -1,8 +1,15 @@
 #pragma once
-#include "Patch.hpp"
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+#include "PatchInstance.hpp"
+#include "../Graphics/Frustum.hpp"
 
-class Frustum;
 class Planet;
+class TaskScheduler;
+class HeightBounds;
 
 enum TriNext
 {
@@ -14,64 +21,238 @@ enum TriNext
 
 struct Tri
 {
-	Tri(vec3 A, vec3 B, vec3 C, Tri* Parent, int16 Level)
-		:a(A), b(B), c(C), parent(Parent), level(Level)
+	Tri() {}
+	Tri(vec3 A, vec3 B, vec3 C, Tri* Parent, int16 Level, PatchInstance Instance)
+		:a(A), b(B), c(C), parent(Parent), level(Level), instance(Instance)
 	{
 	}
 
 	Tri* parent = nullptr;
 
+	//children are allocated as one block of 4 consecutive triangles, c1 points to the start of the block
 	Tri* c1 = nullptr;
 	Tri* c2 = nullptr;
 	Tri* c3 = nullptr;
 	Tri* c4 = nullptr;
 
-	TriNext state;
+	TriNext state = CULL;
+	bool frustumCull = true;
 
-	int16 level;
+	int16 level = 0;
 
 	vec3 a;
 	vec3 b;
 	vec3 c;
+	//path through the subdivision, which is what gets rendered for leaves
+	PatchInstance instance;
+
+	//the terrain above the triangle stays between the corners scaled by baseMult and topMult
+	//cullDot is the backface culling threshold for the highest point of it
+	float baseMult = 1.f;
+	float topMult = 1.f;
+	float cullDot = 0.f;
+
+	//the state of this triangle can't change while the camera stays within slack of the last evaluated position, 
+	//and its entire subtree can't change within subtreeSlack, ignoring the frustum
+	//negative until the triangle is evaluated for the first time
+	float slack = -1.f;
+	float subtreeSlack = -1.f;
+	vec3 evalPosition;
+
+	//frustum culling result can't change while no plane moved further than its margin since evalFrame, 
+	//frustumRange is the largest distance between the camera and the tested points
+	float frustumMargins[Frustum::PLANE_COUNT];
+	float frustumRange = 0.f;
+	uint32 evalFrame = 0;
+
+	//range of the subtrees patch instances in the last generated buffer, the offset is relative to the parents range
+	uint32 instanceOffset = 0;
+	uint32 instanceCount = 0;
+
+	//if the triangle started a task, whether it handed its children to new tasks or where the task put its instances
+	bool isSpawned = false;
+	uint32 taskWorker = 0;
+	uint32 taskOffset = 0;
+};
+
+//How far the frustum planes moved in total up to a frame, for checking triangles against multiple frames of movement at once
+struct FrustumDrift
+{
+	double normal[Frustum::PLANE_COUNT] = {};
+	double offset[Frustum::PLANE_COUNT] = {};
+	double cameraPath = 0.0;
+};
+
+//Output of one worker thread while generating geometry, workers never write to shared buffers
+struct TriangulationContext
+{
+	uint32 worker = 0;
+	std::vector<PatchInstance> positions;
+	uint32 heuristicCount = 0;
+	//keep the contexts of different workers on separate cache lines
+	char padding[64];
+};
+
+//Everything a triangulation produces, generated into one and swapped with the other once it is complete
+struct TriangulationResult
+{
+	std::vector<PatchInstance> positions;
+	//instances before this index are the same as in the previously published result
+	size_t firstChangedInstance = 0;
+	bool isGeometryChanged = true;
+	std::vector<float> distanceLUT;
+	bool isDistanceLUTChanged = true;
+	//camera position in the planets object space the result was generated for
+	vec3 cameraPosition;
+	uint32 heuristicCount = 0;
+};
+
+//Hands out blocks of 4 triangles from larger chunks, so splitting and merging doesn't hit the heap every frame
+//thread safe, so workers can split and merge triangles concurrently
+class TriPool
+{
+public:
+	TriPool() {}
+	~TriPool();
+
+	Tri* Allocate();
+	void Release(Tri* pBlock);
+
+	size_t GetBlocksInUse() const { return m_Chunks.size() * BLOCKS_PER_CHUNK - m_FreeBlocks.size(); }
+
+private:
+	static const size_t BLOCKS_PER_CHUNK = 1024;
+
+	std::vector<Tri*> m_Chunks;
+	std::vector<Tri*> m_FreeBlocks;
+	std::mutex m_Mutex;
+
+private:
+	TriPool(const TriPool& obj);
+	TriPool& operator=(const TriPool& obj);
 };
 
 class Triangulator
 {
 public:
 	Triangulator(Planet* pPlanet);
+	//For running the triangulation without a planet entity, the frustum needs to be set manually
+	Triangulator(float radius, float maxHeight);
 	~Triangulator();
 
 	//Member functions
 	void Init();
-	bool Update();
+	//In async mode this only publishes the geometry the worker finished since the last call and hands it the current frustum,
+	//if the worker is still busy the previous geometry stays in use
 	void GenerateGeometry();
+	void WaitForGeneration();
 
-	bool IsFrustumLocked() { return m_LockFrustum; }
+	//the frustum and viewport width are set by the owner every frame, the triangulator itself doesn't know about cameras or windows
 	Frustum* GetFrustum() { return m_pFrustum; }
-	int32 GetVertexCount() { return (int32)m_Positions.size(); }
+	int32 GetVertexCount() { return (int32)m_Result.positions.size(); }
+	const std::vector<PatchInstance>& GetPositions() const { return m_Result.positions; }
+	const std::vector<float>& GetDistanceLUT() const { return m_Result.distanceLUT; }
+	const vec3 &GetGeneratedCameraPosition() const { return m_Result.cameraPosition; }
+
+	void SetViewportWidth(int32 width) { m_ViewportWidth = width; }
+	//Culling with the real height range of every triangle instead of the planets max height, needs to be set before Init
+	void SetHeightBounds(const HeightBounds* pBounds) { m_pHeightBounds = pBounds; }
+	//Rebuilding the entire tree every frame instead of only reevaluating triangles the camera moved too close to
+	void SetIncremental(bool incremental);
+	//Spreading the triangles over worker threads, the result is the same either way
+	void SetMultithreaded(bool multithreaded);
+	//Generating the geometry on a worker thread while the previous result is rendered, one frame behind the camera
+	void SetAsync(bool async);
+	bool IsAsync() const { return m_Async; }
+	//Called on the generating thread before every triangulation, lets tests hold a generation back
+	void SetGenerationHook(const std::function<void()> &hook) { WaitForGeneration(); m_GenerationHook = hook; }
+
+	//Describe the geometry published by the last GenerateGeometry call
+	bool IsGeometryChanged() const { return m_Result.isGeometryChanged; }
+	size_t GetFirstChangedInstance() const { return m_Result.firstChangedInstance; }
+	bool IsDistanceLUTChanged() const { return m_Result.isDistanceLUTChanged; }
+
+	uint32 GetHeuristicCount() const { return m_Result.heuristicCount; }
 
 private:
 	friend class Planet;
 
 	void Precalculate();
-	TriNext SplitHeuristic(vec3 &a, vec3 &b, vec3 &c, int16 level, bool frustumCull);
-	void RecursiveTriangle(vec3 a, vec3 b, vec3 c, int16 level, bool frustumCull);
+	void PrecalculateDistanceLUT();
+	void Generate();
+	void PublishGeometry();
+	void AsyncThread();
+	void CalculateVolume(Tri &tri) const;
+	TriNext SplitHeuristic(Tri &tri, bool frustumCull);
+	void RecursiveTriangle(vec3 a, vec3 b, vec3 c, int16 level, PatchInstance instance, bool frustumCull);
+	void UpdateTask(uint32 worker, Tri* pTri, bool frustumCull, size_t previousParentOffset);
+	void UpdateTriangle(TriangulationContext &context, Tri* pTri, bool frustumCull, size_t parentOffset, size_t previousParentOffset, bool isTask);
+	void GatherTriangle(Tri* pTri, size_t parentOffset);
+
+	void UpdateFrustumDrift();
+	bool IsFrustumResultValid(const Tri* pTri) const;
+
+	void Split(Tri* pTri);
+	void Merge(Tri* pTri);
 
 	//Triangulation paramenters
 	float m_AllowedTriPx = 300.f;
-	int32 m_MaxLevel = 15;
+	int32 m_MaxLevel = 22;
+	int32 m_ViewportWidth = 0;
+
+	float m_Radius = 0.f;
+	float m_MaxHeight = 0.f;
 
 	std::vector<Tri> m_Icosahedron;
 	std::vector<float> m_DistanceLUT;
 	std::vector<float> m_TriLevelDotLUT;
 	std::vector<float> m_HeightMultLUT;
+	std::vector<float> m_SurfaceMultLUT;
+	const HeightBounds* m_pHeightBounds = nullptr;
 
-	std::vector<Tri*> m_Leafs;
+	TriPool m_Pool;
+	//the engine wide scheduler, the contexts are indexed by its workers
+	TaskScheduler* m_pScheduler = nullptr;
+	std::vector<TriangulationContext> m_Contexts;
+	//subtrees that had fewer instances last frame aren't worth splitting into more tasks
+	static const uint32 TASK_MIN_INSTANCES = 1024;
+	bool m_Multithreaded = true;
+	bool m_Incremental = true;
+	bool m_ForceUpdate = true;
+	float m_SlackScale = 0.f;
+	bool m_FrustumChanged = true;
+	FrustumCorners m_LastFrustumCorners;
+	vec3 m_LastFrustumPosition;
+	std::vector<Plane> m_LastFrustumPlanes;
+	static const uint32 DRIFT_HISTORY = 64;
+	FrustumDrift m_FrustumDrift[DRIFT_HISTORY];
+	uint32 m_Frame = 0;
 
 	Planet* m_pPlanet = nullptr;
 	Frustum* m_pFrustum = nullptr;
-	bool m_LockFrustum = false;
 
-	std::vector<PatchInstance> m_Positions;
-};
+	//copy of the frustum and viewport the geometry is generated for, so the main thread can keep updating its frustum in async mode
+	Frustum m_GenerationFrustum;
+	int32 m_GenerationViewportWidth = 0;
 
+	//the generated result, the published one is also what the next generation compares against
+	TriangulationResult m_Build;
+	TriangulationResult m_Result;
+
+	bool m_Async = false;
+	std::thread m_AsyncThread;
+	std::mutex m_AsyncMutex;
+	std::condition_variable m_AsyncCondition;
+	bool m_IsGenerating = false;
+	bool m_IsBuildPending = false;
+	bool m_IsShuttingDown = false;
+	std::function<void()> m_GenerationHook;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	Triangulator(const Triangulator& obj);
+	Triangulator& operator=(const Triangulator& obj);
+};
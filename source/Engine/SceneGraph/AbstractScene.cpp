@@ -13,6 +13,10 @@
 #include "../GraphicsHelper/TextRenderer.hpp"
 #include "../GraphicsHelper/RenderPipeline.hpp"
 #include "Physics/PhysicsWorld.h"
+#include "BoundingVolumeTree.hpp"
+#include "TransformHierarchy.hpp"
+#include "../Helper/TaskScheduler.hpp"
+#include "../Components/TransformComponent.hpp"
 
 #define CONTEXT Context::GetInstance()
 
@@ -20,6 +24,9 @@ AbstractScene::AbstractScene(std::string name)
 	: m_Name(name)
 	, m_IsInitialized(false)
 {
+	m_pEntityTree = new BoundingVolumeTree();
+	//disjoint subtrees that moved are recomputed in parallel on the engine wide scheduler
+	m_pTransformHierarchy = new TransformHierarchy(TaskScheduler::GetInstance());
 }
 
 AbstractScene::~AbstractScene()
@@ -32,6 +39,8 @@ AbstractScene::~AbstractScene()
 	if (m_pSkybox)SafeDelete(m_pSkybox);
 
 	SafeDelete(m_pPhysicsWorld);
+	SafeDelete(m_pEntityTree);
+	SafeDelete(m_pTransformHierarchy);
 	SafeDelete(m_pConObj);
 	SafeDelete(m_pTime);
 }
@@ -52,7 +61,11 @@ void AbstractScene::RemoveEntity(Entity* pEntity, bool deleteEntity)
 		delete pEntity;
 		pEntity = nullptr;
 	}
-	else pEntity->m_pParentScene = nullptr;
+	else
+	{
+		pEntity->RootRemoveFromScene();
+		pEntity->m_pParentScene = nullptr;
+	}
 }
 
 void AbstractScene::RootInitialize()
@@ -96,6 +109,9 @@ void AbstractScene::RootUpdate()
 
 	PERFORMANCE->StartFrameTimer();
 
+	//Keep the area around the camera close to the origin so it doesn't lose precision in large scenes
+	UpdateFloatingOrigin(m_pConObj->pCamera->GetTransform()->GetAbsolutePosition());
+
 	m_pConObj->pCamera->Update();
 
 	Update();
@@ -137,9 +153,37 @@ void AbstractScene::RootUpdate()
 		m_pSkybox->RootUpdate();
 	}
 
+	//transforms that were read during the entity updates are already up to date, this catches the rest before drawing
+	UpdateTransforms();
+
 	m_pPhysicsWorld->Update();
 }
 
+void AbstractScene::UpdateTransforms()
+{
+	if (!m_pTransformHierarchy->IsUpdatePending()) return;
+
+	//only the entities that moved and the ones attached to them
+	m_pTransformHierarchy->Update();
+	for (int32 node : m_pTransformHierarchy->GetChangedNodes())
+	{
+		static_cast<TransformComponent*>(m_pTransformHierarchy->GetUserData(node))->OnWorldChanged();
+	}
+}
+
+bool AbstractScene::UpdateFloatingOrigin(const dvec3& cameraPosition)
+{
+	dvec3 originShift;
+	if (!m_FloatingOrigin.Update(cameraPosition, originShift)) return false;
+
+	for (Entity* pEntity : m_pEntityVec)
+	{
+		pEntity->RootShiftOrigin(originShift);
+	}
+	m_pEntityTree->ShiftOrigin(etm::vecCast<float>(originShift));
+	return true;
+}
+
 void AbstractScene::RootOnActivated()
 {
 	RootInitialize();
@@ -161,7 +205,7 @@ std::vector<LightComponent*> AbstractScene::GetLights()
 	std::vector<LightComponent*> ret;
 	for (auto *pEntity : m_pEntityVec)
 	{
-		auto entityLights = pEntity->GetComponents<LightComponent>();
+		auto entityLights = pEntity->GetComponents<LightComponent>(true);
 		ret.insert(ret.end(), entityLights.begin(), entityLights.end());
 	}
 	return ret;
@@ -1,5 +1,6 @@
 #pragma once
 #include "../Graphics/PostProcessingSettings.hpp"
+#include "FloatingOrigin.hpp"
 //forward declaration
 class Entity;
 class CameraComponent;
@@ -14,6 +15,8 @@ class Skybox;
 class CubeMap;
 class HDRMap;
 class PhysicsWorld;
+class BoundingVolumeTree;
+class TransformHierarchy;
 
 class AbstractScene
 {
@@ -27,12 +30,25 @@ public:
 	void SetSkybox(std::string assetFile);
 	HDRMap* GetEnvironmentMap();
 	Skybox* GetSkybox() { return m_pSkybox; }
+	//including the ones on child entities
 	std::vector<LightComponent*> GetLights();
 	const PostProcessingSettings& GetPostProcessingSettings() const;
 
 	bool SkyboxEnabled() { return m_UseSkyBox; }
 
 	PhysicsWorld* GetPhysicsWorld() const { return m_pPhysicsWorld; }
+	//bounds of every entity in the scene, the user data of each proxy is its Entity
+	BoundingVolumeTree* GetEntityTree() const { return m_pEntityTree; }
+	//local and world transforms of every entity in the scene, the user data of each node is its TransformComponent
+	TransformHierarchy* GetTransformHierarchy() const { return m_pTransformHierarchy; }
+	//Recomputes the world transforms of entities whose transform changed since the last call and of everything attached to them
+	//runs after the entity updates every frame, and whenever a transform is read while its world state is out of date
+	void UpdateTransforms();
+
+	FloatingOrigin& GetFloatingOrigin() { return m_FloatingOrigin; }
+	const FloatingOrigin& GetFloatingOrigin() const { return m_FloatingOrigin; }
+	//Moves the floating origin to the camera once it is far enough away and rebases every entity on it, true if the origin moved
+	bool UpdateFloatingOrigin(const dvec3& cameraPosition);
 
 	AudioListenerComponent* GetAudioListener() const { return m_AudioListener; }
 	void SetAudioListener(AudioListenerComponent* val) { m_AudioListener = val; }
@@ -51,6 +67,7 @@ protected:
 private:
 	friend class SceneManager;
 	friend class RenderPipeline;
+	friend class SceneVisibility;
 
 	void RootInitialize();
 	void RootUpdate();
@@ -67,6 +84,10 @@ private:
 	AudioListenerComponent* m_AudioListener = nullptr;
 
 	PhysicsWorld* m_pPhysicsWorld = nullptr;
+	BoundingVolumeTree* m_pEntityTree = nullptr;
+	TransformHierarchy* m_pTransformHierarchy = nullptr;
+
+	FloatingOrigin m_FloatingOrigin;
 
 	bool m_UseSkyBox = false;
 	Skybox* m_pSkybox = nullptr;
@@ -0,0 +1,452 @@
+#include "stdafx.hpp"
+#include "BoundingVolumeTree.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <limits>
+
+namespace
+{
+	vec3 Min(const vec3 &a, const vec3 &b)
+	{
+		return vec3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+	}
+	vec3 Max(const vec3 &a, const vec3 &b)
+	{
+		return vec3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+	}
+	AABB Union(const AABB &a, const AABB &b)
+	{
+		return AABB(Min(a.min, b.min), Max(a.max, b.max));
+	}
+	//half the surface area, only used to compare costs
+	float Area(const AABB &box)
+	{
+		vec3 size = box.max - box.min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+	bool Contains(const AABB &outer, const AABB &inner)
+	{
+		return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+			&& inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+	}
+	bool Overlaps(const AABB &a, const AABB &b)
+	{
+		return a.min.x <= b.max.x && a.min.y <= b.max.y && a.min.z <= b.max.z
+			&& b.min.x <= a.max.x && b.min.y <= a.max.y && b.min.z <= a.max.z;
+	}
+	float DistanceSquared(const AABB &box, const vec3 &point)
+	{
+		vec3 delta = Max(Max(box.min - point, point - box.max), vec3(0.f));
+		return etm::dot(delta, delta);
+	}
+	//slab test, returns the distance at which the ray enters the box or a negative value if it misses it
+	float RayEntry(const AABB &box, const vec3 &origin, const vec3 &invDirection, float maxDistance)
+	{
+		float entry = 0.f;
+		float exit = maxDistance;
+		for (uint8 axis = 0; axis < 3; ++axis)
+		{
+			float t1 = (box.min[axis] - origin[axis]) * invDirection[axis];
+			float t2 = (box.max[axis] - origin[axis]) * invDirection[axis];
+			entry = std::max(entry, std::min(t1, t2));
+			exit = std::min(exit, std::max(t1, t2));
+		}
+		return entry <= exit ? entry : -1.f;
+	}
+}
+
+BoundingVolumeTree::BoundingVolumeTree(float margin)
+	: m_Margin(margin)
+{
+}
+
+int32 BoundingVolumeTree::CreateProxy(const AABB &bounds, void* pUserData)
+{
+	int32 proxy = AllocateNode();
+	Node &node = m_Nodes[proxy];
+	node.bounds = bounds;
+	node.box = AABB(bounds.min - vec3(m_Margin), bounds.max + vec3(m_Margin));
+	node.pUserData = pUserData;
+	node.height = 0;
+	InsertLeaf(proxy);
+	++m_ProxyCount;
+	return proxy;
+}
+void BoundingVolumeTree::DestroyProxy(int32 proxy)
+{
+	assert(proxy >= 0 && proxy < (int32)m_Nodes.size() && m_Nodes[proxy].IsLeaf() && m_Nodes[proxy].height == 0);
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	--m_ProxyCount;
+}
+bool BoundingVolumeTree::MoveProxy(int32 proxy, const AABB &bounds, const vec3 &displacement)
+{
+	assert(proxy >= 0 && proxy < (int32)m_Nodes.size() && m_Nodes[proxy].IsLeaf() && m_Nodes[proxy].height == 0);
+	m_Nodes[proxy].bounds = bounds;
+	if (Contains(m_Nodes[proxy].box, bounds))
+	{
+		return false;
+	}
+	RemoveLeaf(proxy);
+	AABB box(bounds.min - vec3(m_Margin), bounds.max + vec3(m_Margin));
+	vec3 reach = displacement * DISPLACEMENT_MULTIPLIER;
+	box.min = box.min + vec3(std::min(reach.x, 0.f), std::min(reach.y, 0.f), std::min(reach.z, 0.f));
+	box.max = box.max + vec3(std::max(reach.x, 0.f), std::max(reach.y, 0.f), std::max(reach.z, 0.f));
+	m_Nodes[proxy].box = box;
+	InsertLeaf(proxy);
+	return true;
+}
+
+void BoundingVolumeTree::ShiftOrigin(const vec3 &shift)
+{
+	for (Node &node : m_Nodes)
+	{
+		node.box = AABB(node.box.min - shift, node.box.max - shift);
+		node.bounds = AABB(node.bounds.min - shift, node.bounds.max - shift);
+	}
+}
+
+int32 BoundingVolumeTree::AllocateNode()
+{
+	if (m_FreeList == NULL_NODE)
+	{
+		m_Nodes.push_back(Node());
+		return (int32)m_Nodes.size() - 1;
+	}
+	int32 node = m_FreeList;
+	m_FreeList = m_Nodes[node].parent;
+	m_Nodes[node] = Node();
+	return node;
+}
+void BoundingVolumeTree::FreeNode(int32 node)
+{
+	m_Nodes[node] = Node();
+	m_Nodes[node].parent = m_FreeList;
+	m_FreeList = node;
+}
+
+//Descends towards the child that grows the least, stopping where making the leaf a sibling costs less than going further down
+void BoundingVolumeTree::InsertLeaf(int32 leaf)
+{
+	if (m_Root == NULL_NODE)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	AABB leafBox = m_Nodes[leaf].box;
+	int32 index = m_Root;
+	while (!m_Nodes[index].IsLeaf())
+	{
+		const Node &node = m_Nodes[index];
+		float area = Area(node.box);
+		float combinedArea = Area(Union(node.box, leafBox));
+		//a new parent here, and the growth every node below pays for the leaf
+		float cost = 2.f * combinedArea;
+		float inheritanceCost = 2.f * (combinedArea - area);
+
+		float childCost[2];
+		int32 children[2] = { node.child1, node.child2 };
+		for (uint8 i = 0; i < 2; ++i)
+		{
+			const Node &child = m_Nodes[children[i]];
+			float unionArea = Area(Union(child.box, leafBox));
+			childCost[i] = (child.IsLeaf() ? unionArea : unionArea - Area(child.box)) + inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1]) break;
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	int32 sibling = index;
+	int32 oldParent = m_Nodes[sibling].parent;
+	int32 newParent = AllocateNode();
+	m_Nodes[newParent].parent = oldParent;
+	m_Nodes[newParent].box = Union(leafBox, m_Nodes[sibling].box);
+	m_Nodes[newParent].height = m_Nodes[sibling].height + 1;
+	m_Nodes[newParent].child1 = sibling;
+	m_Nodes[newParent].child2 = leaf;
+	m_Nodes[sibling].parent = newParent;
+	m_Nodes[leaf].parent = newParent;
+	if (oldParent != NULL_NODE)
+	{
+		if (m_Nodes[oldParent].child1 == sibling) m_Nodes[oldParent].child1 = newParent;
+		else m_Nodes[oldParent].child2 = newParent;
+	}
+	else
+	{
+		m_Root = newParent;
+	}
+
+	//fix boxes and heights up to the root
+	index = m_Nodes[leaf].parent;
+	while (index != NULL_NODE)
+	{
+		index = Balance(index);
+		Node &node = m_Nodes[index];
+		node.height = 1 + std::max(m_Nodes[node.child1].height, m_Nodes[node.child2].height);
+		node.box = Union(m_Nodes[node.child1].box, m_Nodes[node.child2].box);
+		index = node.parent;
+	}
+}
+//The sibling of the leaf takes the place of their parent
+void BoundingVolumeTree::RemoveLeaf(int32 leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root = NULL_NODE;
+		return;
+	}
+
+	int32 parent = m_Nodes[leaf].parent;
+	int32 grandParent = m_Nodes[parent].parent;
+	int32 sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+	FreeNode(parent);
+
+	if (grandParent == NULL_NODE)
+	{
+		m_Root = sibling;
+		m_Nodes[sibling].parent = NULL_NODE;
+		return;
+	}
+
+	if (m_Nodes[grandParent].child1 == parent) m_Nodes[grandParent].child1 = sibling;
+	else m_Nodes[grandParent].child2 = sibling;
+	m_Nodes[sibling].parent = grandParent;
+
+	int32 index = grandParent;
+	while (index != NULL_NODE)
+	{
+		index = Balance(index);
+		Node &node = m_Nodes[index];
+		node.height = 1 + std::max(m_Nodes[node.child1].height, m_Nodes[node.child2].height);
+		node.box = Union(m_Nodes[node.child1].box, m_Nodes[node.child2].box);
+		index = node.parent;
+	}
+}
+
+//If one child of A is more than one level higher than the other, that child (C) is rotated up to take the place of A,
+//A keeps the lower child of C and C keeps the higher one. Returns the node that is now in the place of A
+int32 BoundingVolumeTree::Balance(int32 iA)
+{
+	Node &A = m_Nodes[iA];
+	if (A.IsLeaf() || A.height < 2) return iA;
+
+	int32 iB = A.child1;
+	int32 iC = A.child2;
+	int32 balance = m_Nodes[iC].height - m_Nodes[iB].height;
+	if (balance >= -1 && balance <= 1) return iA;
+
+	//the higher child is rotated up, the other one stays with A
+	bool rotateSecond = balance > 1;
+	int32 iUp = rotateSecond ? iC : iB;
+	int32 iStay = rotateSecond ? iB : iC;
+	Node &up = m_Nodes[iUp];
+	int32 iF = up.child1;
+	int32 iG = up.child2;
+
+	up.child1 = iA;
+	up.parent = A.parent;
+	A.parent = iUp;
+	if (up.parent != NULL_NODE)
+	{
+		if (m_Nodes[up.parent].child1 == iA) m_Nodes[up.parent].child1 = iUp;
+		else m_Nodes[up.parent].child2 = iUp;
+	}
+	else
+	{
+		m_Root = iUp;
+	}
+
+	int32 iHigh = m_Nodes[iF].height > m_Nodes[iG].height ? iF : iG;
+	int32 iLow = iHigh == iF ? iG : iF;
+	up.child2 = iHigh;
+	if (rotateSecond) A.child2 = iLow;
+	else A.child1 = iLow;
+	m_Nodes[iLow].parent = iA;
+
+	A.box = Union(m_Nodes[iStay].box, m_Nodes[iLow].box);
+	A.height = 1 + std::max(m_Nodes[iStay].height, m_Nodes[iLow].height);
+	up.box = Union(A.box, m_Nodes[iHigh].box);
+	up.height = 1 + std::max(A.height, m_Nodes[iHigh].height);
+	return iUp;
+}
+
+void BoundingVolumeTree::QueryAABB(const AABB &box, std::vector<int32> &proxies) const
+{
+	proxies.clear();
+	if (m_Root == NULL_NODE) return;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int32 index = m_Stack.back();
+		m_Stack.pop_back();
+		const Node &node = m_Nodes[index];
+		if (!Overlaps(node.box, box)) continue;
+		if (node.IsLeaf())
+		{
+			if (Overlaps(node.bounds, box)) proxies.push_back(index);
+			continue;
+		}
+		m_Stack.push_back(node.child1);
+		m_Stack.push_back(node.child2);
+	}
+}
+void BoundingVolumeTree::QuerySphere(const Sphere &sphere, std::vector<int32> &proxies) const
+{
+	proxies.clear();
+	if (m_Root == NULL_NODE) return;
+	float radiusSquared = sphere.radius * sphere.radius;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int32 index = m_Stack.back();
+		m_Stack.pop_back();
+		const Node &node = m_Nodes[index];
+		if (DistanceSquared(node.box, sphere.pos) > radiusSquared) continue;
+		if (node.IsLeaf())
+		{
+			if (DistanceSquared(node.bounds, sphere.pos) <= radiusSquared) proxies.push_back(index);
+			continue;
+		}
+		m_Stack.push_back(node.child1);
+		m_Stack.push_back(node.child2);
+	}
+}
+//Subtrees that are completely inside are added without testing the nodes below
+void BoundingVolumeTree::QueryFrustum(const BatchFrustum &frustum, std::vector<int32> &proxies) const
+{
+	proxies.clear();
+	if (m_Root == NULL_NODE) return;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int32 index = m_Stack.back();
+		m_Stack.pop_back();
+		const Node &node = m_Nodes[index];
+		if (node.IsLeaf())
+		{
+			if (frustum.ContainsAABB(node.bounds.min, node.bounds.max) != VolumeCheck::OUTSIDE) proxies.push_back(index);
+			continue;
+		}
+		switch (frustum.ContainsAABB(node.box.min, node.box.max))
+		{
+		case VolumeCheck::OUTSIDE:
+			break;
+		case VolumeCheck::CONTAINS:
+			AddSubtree(index, proxies);
+			break;
+		default:
+			m_Stack.push_back(node.child1);
+			m_Stack.push_back(node.child2);
+			break;
+		}
+	}
+}
+void BoundingVolumeTree::AddSubtree(int32 node, std::vector<int32> &proxies) const
+{
+	//the subtree is walked recursively so the outer traversal stack stays untouched
+	if (m_Nodes[node].IsLeaf())
+	{
+		proxies.push_back(node);
+		return;
+	}
+	AddSubtree(m_Nodes[node].child1, proxies);
+	AddSubtree(m_Nodes[node].child2, proxies);
+}
+void BoundingVolumeTree::RayCast(const vec3 &origin, const vec3 &direction, float maxDistance, std::vector<int32> &proxies) const
+{
+	proxies.clear();
+	if (m_Root == NULL_NODE) return;
+	//infinite for axes the ray is parallel to, so only the other slabs limit it
+	vec3 invDirection = vec3(1.f / direction.x, 1.f / direction.y, 1.f / direction.z);
+
+	std::vector<std::pair<float, int32>> hits;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int32 index = m_Stack.back();
+		m_Stack.pop_back();
+		const Node &node = m_Nodes[index];
+		if (RayEntry(node.box, origin, invDirection, maxDistance) < 0.f) continue;
+		if (node.IsLeaf())
+		{
+			float entry = RayEntry(node.bounds, origin, invDirection, maxDistance);
+			if (entry >= 0.f) hits.push_back(std::make_pair(entry, index));
+			continue;
+		}
+		m_Stack.push_back(node.child1);
+		m_Stack.push_back(node.child2);
+	}
+
+	std::sort(hits.begin(), hits.end());
+	for (const auto &hit : hits)
+	{
+		proxies.push_back(hit.second);
+	}
+}
+//Best first search: nodes are visited in order of the distance to their boxes, which is never more than the distance to anything
+//below them, and leaves are queued with the distance to their exact bounds, so they come out of the queue in order
+void BoundingVolumeTree::QueryNearest(const vec3 &point, size_t count, std::vector<int32> &proxies) const
+{
+	proxies.clear();
+	if (m_Root == NULL_NODE || count == 0) return;
+
+	struct Candidate
+	{
+		float distanceSquared;
+		int32 node;
+		bool isExact;
+		bool operator<(const Candidate &other) const { return distanceSquared > other.distanceSquared; }
+	};
+	std::priority_queue<Candidate> queue;
+	queue.push(Candidate{ DistanceSquared(m_Nodes[m_Root].box, point), m_Root, false });
+	while (!queue.empty() && proxies.size() < count)
+	{
+		Candidate candidate = queue.top();
+		queue.pop();
+		const Node &node = m_Nodes[candidate.node];
+		if (candidate.isExact)
+		{
+			proxies.push_back(candidate.node);
+		}
+		else if (node.IsLeaf())
+		{
+			queue.push(Candidate{ DistanceSquared(node.bounds, point), candidate.node, true });
+		}
+		else
+		{
+			queue.push(Candidate{ DistanceSquared(m_Nodes[node.child1].box, point), node.child1, false });
+			queue.push(Candidate{ DistanceSquared(m_Nodes[node.child2].box, point), node.child2, false });
+		}
+	}
+}
+
+bool BoundingVolumeTree::Validate() const
+{
+	if (m_Root == NULL_NODE) return m_ProxyCount == 0;
+	if (m_Nodes[m_Root].parent != NULL_NODE) return false;
+	size_t leafCount = 0;
+	return ValidateNode(m_Root, leafCount) && leafCount == m_ProxyCount;
+}
+bool BoundingVolumeTree::ValidateNode(int32 index, size_t &leafCount) const
+{
+	const Node &node = m_Nodes[index];
+	if (node.IsLeaf())
+	{
+		++leafCount;
+		return node.height == 0 && Contains(node.box, node.bounds);
+	}
+	const Node &child1 = m_Nodes[node.child1];
+	const Node &child2 = m_Nodes[node.child2];
+	if (child1.parent != index || child2.parent != index) return false;
+	if (node.height != 1 + std::max(child1.height, child2.height)) return false;
+	if (!Contains(node.box, child1.box) || !Contains(node.box, child2.box)) return false;
+	return ValidateNode(node.child1, leafCount) && ValidateNode(node.child2, leafCount);
+}
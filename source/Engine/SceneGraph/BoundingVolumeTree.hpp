@@ -0,0 +1,80 @@
+#pragma once
+#include "../Graphics/BatchFrustum.hpp"
+
+//Bounding Volume Tree
+//********************
+
+// Dynamic AABB tree for spatial queries over objects that move.
+// Leaves keep a box enlarged by a margin, so small movements only update the proxy and objects are reinserted once they leave it.
+// Inserting picks the sibling with the lowest surface area cost and rotations keep the tree balanced, so queries skip whole subtrees
+// and run in logarithmic time for small query volumes.
+
+class BoundingVolumeTree
+{
+public:
+	static const int32 NULL_NODE = -1;
+	//how many moves ahead the enlarged box of a moving proxy reaches
+	static constexpr float DISPLACEMENT_MULTIPLIER = 4.f;
+
+	explicit BoundingVolumeTree(float margin = 0.1f);
+
+	//proxy ids stay valid until the proxy is destroyed
+	int32 CreateProxy(const AABB &bounds, void* pUserData);
+	void DestroyProxy(int32 proxy);
+	//returns true if the proxy left its enlarged box and was reinserted
+	//the new box is stretched along the displacement since the last move, so objects moving steadily are reinserted less often
+	bool MoveProxy(int32 proxy, const AABB &bounds, const vec3 &displacement = vec3(0.f));
+
+	void* GetUserData(int32 proxy) const { return m_Nodes[proxy].pUserData; }
+	const AABB& GetBounds(int32 proxy) const { return m_Nodes[proxy].bounds; }
+	const AABB& GetEnlargedBounds(int32 proxy) const { return m_Nodes[proxy].box; }
+	size_t GetProxyCount() const { return m_ProxyCount; }
+	int32 GetHeight() const { return m_Root == NULL_NODE ? 0 : m_Nodes[m_Root].height; }
+
+	//moves every box by -shift, for when the floating origin moves
+	void ShiftOrigin(const vec3 &shift);
+
+	//Queries test the exact bounds of the proxies and replace the content of the output
+	void QueryAABB(const AABB &box, std::vector<int32> &proxies) const;
+	void QuerySphere(const Sphere &sphere, std::vector<int32> &proxies) const;
+	void QueryFrustum(const BatchFrustum &frustum, std::vector<int32> &proxies) const;
+	//proxies hit within maxDistance, ordered by the distance along the ray at which their bounds are entered
+	void RayCast(const vec3 &origin, const vec3 &direction, float maxDistance, std::vector<int32> &proxies) const;
+	//the count proxies with bounds closest to the point, nearest first
+	void QueryNearest(const vec3 &point, size_t count, std::vector<int32> &proxies) const;
+
+	//checks the links, heights and boxes of every node
+	bool Validate() const;
+
+private:
+	struct Node
+	{
+		bool IsLeaf() const { return child1 == NULL_NODE; }
+
+		AABB box;//enlarged for leaves, union of the children otherwise
+		AABB bounds;//exact bounds of leaves
+		void* pUserData = nullptr;
+		int32 parent = NULL_NODE;//next free node when the node is unused
+		int32 child1 = NULL_NODE;
+		int32 child2 = NULL_NODE;
+		int32 height = -1;//0 for leaves, -1 when unused
+	};
+
+	int32 AllocateNode();
+	void FreeNode(int32 node);
+
+	void InsertLeaf(int32 leaf);
+	void RemoveLeaf(int32 leaf);
+	int32 Balance(int32 node);
+	void AddSubtree(int32 node, std::vector<int32> &proxies) const;
+	bool ValidateNode(int32 node, size_t &leafCount) const;
+
+	std::vector<Node> m_Nodes;
+	int32 m_Root = NULL_NODE;
+	int32 m_FreeList = NULL_NODE;
+	size_t m_ProxyCount = 0;
+	float m_Margin;
+
+	//traversal stack reused by the queries
+	mutable std::vector<int32> m_Stack;
+};
@@ -62,6 +62,22 @@ void Entity::RootUpdate()
 		pChild->RootUpdate();
 	}
 }
+void Entity::RootShiftOrigin(const dvec3& shift)
+{
+	m_pTransform->OnOriginShifted(shift);
+	for (Entity* pChild : m_pChildVec)
+	{
+		pChild->RootShiftOrigin(shift);
+	}
+}
+void Entity::RootRemoveFromScene()
+{
+	m_pTransform->RemoveFromScene();
+	for (Entity* pChild : m_pChildVec)
+	{
+		pChild->RootRemoveFromScene();
+	}
+}
 void Entity::RootDraw()
 {
 	Draw();
@@ -147,6 +163,7 @@ void Entity::RemoveChild(Entity* pEntity)
 #endif
 
 	m_pChildVec.erase(it);
+	pEntity->RootRemoveFromScene();
 	pEntity->m_pParentEntity = nullptr;
 }
 
@@ -174,6 +191,7 @@ void Entity::AddComponent(AbstractComponent* pComp)
 		pComp->RootInitialize();
 
 	m_pComponentVec.push_back(pComp);
+	m_pTransform->OnComponentsChanged();
 }
 
 void Entity::RemoveComponent(AbstractComponent* pComp)
@@ -196,6 +214,7 @@ void Entity::RemoveComponent(AbstractComponent* pComp)
 
 	m_pComponentVec.erase(it);
 	pComp->m_pEntity = nullptr;
+	m_pTransform->OnComponentsChanged();
 }
 
 AbstractScene* Entity::GetScene()
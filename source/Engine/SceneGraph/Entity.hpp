@@ -26,6 +26,9 @@ public:
 	AbstractScene* GetScene();
 	Entity* GetParent() const { return m_pParentEntity; }
 
+	//Large spheres that hide what is behind them, such as planets, return their world space sphere to the render pipeline
+	virtual bool GetOccluderSphere(Sphere &sphere) const { UNUSED(sphere); return false; }
+
 	template<class T> 
 	bool HasComponent(bool searchChildren = false)
 	{
@@ -114,6 +117,7 @@ protected:
 private:
 	friend class AbstractScene;
 	friend class RenderPipeline;
+	friend class SceneVisibility;
 
 	void RootInitialize();
 	void RootStart();
@@ -121,6 +125,8 @@ private:
 	void RootDrawForward();
 	void RootDrawShadow();
 	void RootUpdate();
+	void RootShiftOrigin(const dvec3& shift);
+	void RootRemoveFromScene();
 
 	std::vector<Entity*> m_pChildVec;
 	std::vector<AbstractComponent*> m_pComponentVec;
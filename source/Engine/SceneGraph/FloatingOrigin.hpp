@@ -0,0 +1,54 @@
+#pragma once
+#include "../Math/Math.hpp"
+
+//Floating origin for large scenes
+//********************************
+
+// Entities keep single precision positions relative to the scene origin, while the origin itself is stored in double precision.
+// Once the camera moves further than the rebase threshold from the origin, the origin is moved to the camera,
+// so everything close to the camera always has small relative coordinates and keeps sub millimetre precision.
+
+class FloatingOrigin
+{
+public:
+	bool IsEnabled() const { return m_IsEnabled; }
+	void SetEnabled(bool enabled) { m_IsEnabled = enabled; }
+
+	double GetRebaseThreshold() const { return m_RebaseThreshold; }
+	void SetRebaseThreshold(double threshold) { m_RebaseThreshold = threshold; }
+
+	const dvec3& GetOrigin() const { return m_Origin; }
+
+	vec3 ToRelative(const dvec3& absolute) const { return etm::vecCast<float>(absolute - m_Origin); }
+	dvec3 ToAbsolute(const vec3& relative) const { return m_Origin + etm::vecCast<double>(relative); }
+
+	//Moves the origin to the camera if it is further away than the threshold
+	//returns true if the origin moved, outShift needs to be subtracted from all relative positions
+	bool Update(const dvec3& cameraPosition, dvec3& outShift)
+	{
+		if (!m_IsEnabled)
+		{
+			return false;
+		}
+		dvec3 offset = cameraPosition - m_Origin;
+		if (etm::lengthSquared(offset) <= m_RebaseThreshold * m_RebaseThreshold)
+		{
+			return false;
+		}
+		outShift = offset;
+		m_Origin = cameraPosition;
+		return true;
+	}
+
+	//World matrix of a root transform with the camera at the origin
+	//the translation is resolved in double precision, so the result only loses precision with the distance to the camera
+	static mat4 GetCameraRelativeWorld(const vec3& scale, const quat& rotation, const dvec3& position, const dvec3& cameraPosition)
+	{
+		return etm::scale(scale) * etm::rotate(rotation) * etm::translate(etm::vecCast<float>(position - cameraPosition));
+	}
+
+private:
+	dvec3 m_Origin;
+	double m_RebaseThreshold = 1000.0;
+	bool m_IsEnabled = false;
+};
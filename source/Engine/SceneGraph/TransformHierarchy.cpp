@@ -0,0 +1,313 @@
+#include "stdafx.hpp"
+#include "TransformHierarchy.hpp"
+
+#include <algorithm>
+
+#include "../Helper/TaskScheduler.hpp"
+
+namespace
+{
+	//dirty subtrees are grouped into tasks of at least this many nodes
+	const uint32 MIN_TASK_NODES = 512;
+	//index of nodes that are destroyed or not created yet
+	const uint32 INVALID_INDEX = 0xFFFFFFFF;
+
+	template<typename T>
+	void Reorder(std::vector<T> &values, const std::vector<uint32> &order)
+	{
+		std::vector<T> reordered;
+		reordered.reserve(order.size());
+		for (uint32 index : order)
+		{
+			reordered.push_back(values[index]);
+		}
+		values.swap(reordered);
+	}
+}
+
+TransformHierarchy::TransformHierarchy(TaskScheduler* pScheduler)
+	: m_pScheduler(pScheduler)
+{
+}
+TransformHierarchy::~TransformHierarchy()
+{
+}
+
+int32 TransformHierarchy::CreateNode(int32 parent, void* pUserData)
+{
+	int32 node;
+	if (m_FreeNodes.empty())
+	{
+		node = (int32)m_NodeParents.size();
+		m_NodeParents.push_back(parent);
+		m_NodeIndices.push_back(INVALID_INDEX);
+	}
+	else
+	{
+		node = m_FreeNodes.back();
+		m_FreeNodes.pop_back();
+	}
+
+	//appended at the end, which keeps the order intact for new roots
+	uint32 index = (uint32)m_Handles.size();
+	m_NodeParents[node] = parent;
+	m_NodeIndices[node] = index;
+	m_Handles.push_back(node);
+	m_Parents.push_back(parent);
+	if (parent != NULL_NODE)
+	{
+		m_Parents.back() = (int32)m_NodeIndices[parent];
+		m_IsOrderChanged = true;
+	}
+	m_SubtreeEnds.push_back(index + 1);
+	m_IsDirty.push_back(0);
+	m_UserData.push_back(pUserData);
+	m_LocalPositions.push_back(vec3());
+	m_LocalRotations.push_back(quat());
+	m_LocalScales.push_back(vec3(1.f));
+	m_Worlds.push_back(mat4());
+	m_WorldInverses.push_back(mat4());
+	m_WorldRotations.push_back(quat());
+	m_WorldScales.push_back(vec3(1.f));
+
+	SetDirty(node);
+	return node;
+}
+
+void TransformHierarchy::DestroyNode(int32 node)
+{
+	//left in the arrays until they are rebuilt
+	uint32 index = m_NodeIndices[node];
+	m_Handles[index] = NULL_NODE;
+	m_UserData[index] = nullptr;
+	m_NodeIndices[node] = INVALID_INDEX;
+	m_DestroyedNodes.push_back(node);
+	m_IsOrderChanged = true;
+}
+
+void TransformHierarchy::SetLocal(int32 node, const vec3 &position, const quat &rotation, const vec3 &scale)
+{
+	uint32 index = m_NodeIndices[node];
+	m_LocalPositions[index] = position;
+	m_LocalRotations[index] = rotation;
+	m_LocalScales[index] = scale;
+	SetDirty(node);
+}
+
+void TransformHierarchy::SetDirty(int32 node)
+{
+	uint32 index = m_NodeIndices[node];
+	if (m_IsDirty[index]) return;
+	m_IsDirty[index] = 1;
+	m_DirtyNodes.push_back(node);
+}
+
+void TransformHierarchy::Update()
+{
+	if (m_IsOrderChanged)
+	{
+		Rebuild();
+	}
+
+	//a dirty node inside the subtree of another one is updated with it
+	m_DirtyIndices.clear();
+	for (int32 node : m_DirtyNodes)
+	{
+		if (m_NodeIndices[node] != INVALID_INDEX) m_DirtyIndices.push_back(m_NodeIndices[node]);
+	}
+	m_DirtyNodes.clear();
+	std::sort(m_DirtyIndices.begin(), m_DirtyIndices.end());
+	m_DirtyRanges.clear();
+	uint32 updatedEnd = 0;
+	for (uint32 index : m_DirtyIndices)
+	{
+		if (index < updatedEnd) continue;
+		Range range;
+		range.begin = index;
+		range.end = m_SubtreeEnds[index];
+		m_DirtyRanges.push_back(range);
+		updatedEnd = range.end;
+	}
+
+	if (m_pScheduler && m_DirtyRanges.size() > 1)
+	{
+		size_t first = 0;
+		uint32 nodeCount = 0;
+		for (size_t last = 0; last < m_DirtyRanges.size(); ++last)
+		{
+			nodeCount += m_DirtyRanges[last].end - m_DirtyRanges[last].begin;
+			if (nodeCount < MIN_TASK_NODES && last + 1 < m_DirtyRanges.size()) continue;
+			m_pScheduler->Push(0, [this, first, last](uint32)
+			{
+				for (size_t range = first; range <= last; ++range)
+				{
+					UpdateRange(m_DirtyRanges[range]);
+				}
+			});
+			first = last + 1;
+			nodeCount = 0;
+		}
+		m_pScheduler->Run();
+	}
+	else
+	{
+		for (const Range &range : m_DirtyRanges)
+		{
+			UpdateRange(range);
+		}
+	}
+
+	m_ChangedNodes.clear();
+	for (const Range &range : m_DirtyRanges)
+	{
+		m_ChangedNodes.insert(m_ChangedNodes.end(), m_Handles.begin() + range.begin, m_Handles.begin() + range.end);
+	}
+}
+
+//Only reads the world transforms of nodes before the range, which are up to date already
+void TransformHierarchy::UpdateRange(const Range &range)
+{
+	mat4 local;
+	mat4 localInverse;
+	for (uint32 index = range.begin; index < range.end; ++index)
+	{
+		ComposeWorld(m_LocalPositions[index], m_LocalRotations[index], m_LocalScales[index], local, localInverse);
+		int32 parent = m_Parents[index];
+		if (parent == NULL_NODE)
+		{
+			m_Worlds[index] = local;
+			m_WorldInverses[index] = localInverse;
+			m_WorldRotations[index] = m_LocalRotations[index];
+			m_WorldScales[index] = m_LocalScales[index];
+		}
+		else
+		{
+			m_Worlds[index] = local * m_Worlds[parent];
+			m_WorldInverses[index] = m_WorldInverses[parent] * localInverse;
+			m_WorldRotations[index] = m_WorldRotations[parent] * m_LocalRotations[index];
+			m_WorldScales[index] = m_LocalScales[index] * m_WorldScales[parent];
+		}
+		m_IsDirty[index] = 0;
+	}
+}
+
+//Sorts the nodes depth first again, keeping the order of siblings, and drops destroyed nodes
+void TransformHierarchy::Rebuild()
+{
+	const uint32 oldCount = (uint32)m_Handles.size();
+
+	//children of destroyed nodes are attached to the closest ancestor that still exists
+	std::vector<uint32> childCounts(m_NodeParents.size() + 1, 0);
+	for (uint32 index = 0; index < oldCount; ++index)
+	{
+		int32 node = m_Handles[index];
+		if (node == NULL_NODE) continue;
+		int32 parent = m_NodeParents[node];
+		if (parent != NULL_NODE && m_NodeIndices[parent] == INVALID_INDEX)
+		{
+			while (parent != NULL_NODE && m_NodeIndices[parent] == INVALID_INDEX)
+			{
+				parent = m_NodeParents[parent];
+			}
+			m_NodeParents[node] = parent;
+			SetDirty(node);
+		}
+		++childCounts[parent + 1];
+	}
+	for (int32 node : m_DestroyedNodes)
+	{
+		m_NodeParents[node] = NULL_NODE;
+		m_FreeNodes.push_back(node);
+	}
+	m_DestroyedNodes.clear();
+
+	//children of every node in their current order, slot 0 holds the roots
+	std::vector<uint32> childOffsets(childCounts.size() + 1, 0);
+	for (size_t slot = 0; slot < childCounts.size(); ++slot)
+	{
+		childOffsets[slot + 1] = childOffsets[slot] + childCounts[slot];
+	}
+	std::vector<uint32> children(childOffsets.back());
+	std::vector<uint32> nextChild(childOffsets.begin(), childOffsets.end() - 1);
+	for (uint32 index = 0; index < oldCount; ++index)
+	{
+		int32 node = m_Handles[index];
+		if (node == NULL_NODE) continue;
+		children[nextChild[m_NodeParents[node] + 1]++] = index;
+	}
+
+	//depth first, the stack holds old indices and children are pushed in reverse so they come out in order
+	std::vector<uint32> order;
+	order.reserve(children.size());
+	std::vector<uint32> stack;
+	for (uint32 root = childOffsets[1]; root > childOffsets[0]; --root)
+	{
+		stack.push_back(children[root - 1]);
+	}
+	while (!stack.empty())
+	{
+		uint32 index = stack.back();
+		stack.pop_back();
+		order.push_back(index);
+		uint32 slot = (uint32)m_Handles[index] + 1;
+		for (uint32 child = childOffsets[slot + 1]; child > childOffsets[slot]; --child)
+		{
+			stack.push_back(children[child - 1]);
+		}
+	}
+
+	Reorder(m_Handles, order);
+	Reorder(m_IsDirty, order);
+	Reorder(m_UserData, order);
+	Reorder(m_LocalPositions, order);
+	Reorder(m_LocalRotations, order);
+	Reorder(m_LocalScales, order);
+	Reorder(m_Worlds, order);
+	Reorder(m_WorldInverses, order);
+	Reorder(m_WorldRotations, order);
+	Reorder(m_WorldScales, order);
+
+	const uint32 count = (uint32)m_Handles.size();
+	for (uint32 index = 0; index < count; ++index)
+	{
+		m_NodeIndices[m_Handles[index]] = index;
+	}
+	m_Parents.resize(count);
+	m_SubtreeEnds.resize(count);
+	for (uint32 index = 0; index < count; ++index)
+	{
+		int32 parent = m_NodeParents[m_Handles[index]];
+		m_Parents[index] = parent;
+		if (parent != NULL_NODE) m_Parents[index] = (int32)m_NodeIndices[parent];
+		m_SubtreeEnds[index] = index + 1;
+	}
+	//children come after their parents, so going backwards every subtree is complete before it extends its parent
+	for (uint32 index = count; index > 0; --index)
+	{
+		int32 parent = m_Parents[index - 1];
+		if (parent != NULL_NODE)
+		{
+			m_SubtreeEnds[parent] = std::max(m_SubtreeEnds[parent], m_SubtreeEnds[index - 1]);
+		}
+	}
+
+	m_IsOrderChanged = false;
+}
+
+void TransformHierarchy::ComposeWorld(const vec3 &position, const quat &rotation, const vec3 &scale, mat4 &world, mat4 &worldInverse)
+{
+	mat4 rotationMatrix = etm::rotate(rotation);
+	world = rotationMatrix;
+	world[0] = world[0] * scale.x;
+	world[1] = world[1] * scale.y;
+	world[2] = world[2] * scale.z;
+	world[3] = vec4(position, 1.f);
+
+	//the rotation is orthonormal, so its inverse is the transpose
+	for (uint8 row = 0; row < 3; ++row)
+	{
+		worldInverse[row] = vec4(rotationMatrix[0][row] / scale.x, rotationMatrix[1][row] / scale.y, rotationMatrix[2][row] / scale.z, 0.f);
+	}
+	vec4 translation = worldInverse[0] * position.x + worldInverse[1] * position.y + worldInverse[2] * position.z;
+	worldInverse[3] = vec4(-translation.x, -translation.y, -translation.z, 1.f);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+class TaskScheduler;
+
+//Transform Hierarchy
+//*******************
+
+// Local and world transforms of every entity in a scene, kept in contiguous arrays in depth first order,
+// so every parent comes before its children and the subtree of a node is the range of nodes that directly follows it.
+// Changing a local transform marks the node dirty, and an update recomputes only the subtrees below dirty nodes in one linear pass each.
+// Dirty subtrees don't overlap, so with more than one worker they are recomputed in parallel.
+// Nodes are referred to by ids that stay valid until the node is destroyed, creating and destroying nodes reorders the arrays on the next update.
+
+class TransformHierarchy
+{
+public:
+	static const int32 NULL_NODE = -1;
+
+	//without a scheduler the update runs on the calling thread only
+	explicit TransformHierarchy(TaskScheduler* pScheduler = nullptr);
+	~TransformHierarchy();
+
+	//new nodes are dirty, their parent has to be created before them
+	int32 CreateNode(int32 parent, void* pUserData);
+	//the children of a destroyed node move up to its parent
+	void DestroyNode(int32 node);
+
+	void SetLocal(int32 node, const vec3 &position, const quat &rotation, const vec3 &scale);
+	void SetDirty(int32 node);
+
+	//recomputes the world transforms of the dirty nodes and everything below them
+	void Update();
+	//true if an update would recompute anything
+	bool IsUpdatePending() const { return !m_DirtyNodes.empty() || m_IsOrderChanged; }
+
+	//scale, then rotation, then translation, built directly instead of multiplying three matrices
+	static void ComposeWorld(const vec3 &position, const quat &rotation, const vec3 &scale, mat4 &world, mat4 &worldInverse);
+
+	int32 GetParent(int32 node) const { return m_NodeParents[node]; }
+	void* GetUserData(int32 node) const { return m_UserData[m_NodeIndices[node]]; }
+	const vec3& GetLocalPosition(int32 node) const { return m_LocalPositions[m_NodeIndices[node]]; }
+	const mat4& GetWorld(int32 node) const { return m_Worlds[m_NodeIndices[node]]; }
+	const mat4& GetWorldInverse(int32 node) const { return m_WorldInverses[m_NodeIndices[node]]; }
+	const quat& GetWorldRotation(int32 node) const { return m_WorldRotations[m_NodeIndices[node]]; }
+	const vec3& GetWorldScale(int32 node) const { return m_WorldScales[m_NodeIndices[node]]; }
+	bool IsDirty(int32 node) const { return m_IsDirty[m_NodeIndices[node]] != 0; }
+
+	//position in the depth first order, only meaningful after an update
+	uint32 GetOrder(int32 node) const { return m_NodeIndices[node]; }
+	size_t GetNodeCount() const { return m_Handles.size(); }
+	//nodes whose world transform was recomputed in the last update, parents before children
+	const std::vector<int32>& GetChangedNodes() const { return m_ChangedNodes; }
+
+private:
+	//a node and its subtree are [begin, end)
+	struct Range
+	{
+		uint32 begin;
+		uint32 end;
+	};
+
+	void Rebuild();
+	void UpdateRange(const Range &range);
+
+	//indexed by node id
+	std::vector<int32> m_NodeParents;
+	std::vector<uint32> m_NodeIndices;
+	std::vector<int32> m_FreeNodes;
+	//destroyed since the last rebuild, their children still point to them until then
+	std::vector<int32> m_DestroyedNodes;
+
+	//indexed by depth first order
+	std::vector<int32> m_Handles;
+	std::vector<int32> m_Parents;
+	std::vector<uint32> m_SubtreeEnds;
+	std::vector<uint8> m_IsDirty;
+	std::vector<void*> m_UserData;
+	std::vector<vec3> m_LocalPositions;
+	std::vector<quat> m_LocalRotations;
+	std::vector<vec3> m_LocalScales;
+	std::vector<mat4> m_Worlds;
+	std::vector<mat4> m_WorldInverses;
+	std::vector<quat> m_WorldRotations;
+	std::vector<vec3> m_WorldScales;
+	bool m_IsOrderChanged = false;
+
+	std::vector<int32> m_DirtyNodes;
+	std::vector<uint32> m_DirtyIndices;
+	std::vector<Range> m_DirtyRanges;
+	std::vector<int32> m_ChangedNodes;
+
+	TaskScheduler* m_pScheduler = nullptr;
+
+private:
+	// -------------------------
+	// Disabling default copy constructor and default
+	// assignment operator.
+	// -------------------------
+	TransformHierarchy(const TransformHierarchy& obj);
+	TransformHierarchy& operator=(const TransformHierarchy& obj);
+};
@@ -0,0 +1,105 @@
+<VERTEX>
+	#version 330 core
+	layout (location = 0) in vec3 pos;
+	layout (location = 1) in vec2 texCoords;
+
+	out vec2 TexCoords;
+	out vec3 ViewRay;
+	uniform mat4 viewProjInv;
+
+	void main()
+	{
+		TexCoords = texCoords;
+		ViewRay = (viewProjInv * vec4(pos.xy, 1, 1)).xyz;
+		gl_Position = vec4(pos, 1.0);
+	}
+</VERTEX>
+<FRAGMENT>
+	#version 330 core
+
+	#include "Common.glsl"
+	#include "CommonDeferred.glsl"
+	#include "CommonPBR.glsl"
+
+	in vec2 TexCoords;
+	in vec3 ViewRay;
+
+	//out
+	layout (location = 0) out vec4 outColor;
+
+	GBUFFER_SAMPLER
+
+	//Lights, see LightClusters
+	uniform samplerBuffer lightData;		//| Pos.x   Pos.y   Pos.z | Radius | , | Col.r   Col.g   Col.b | xxxxx |
+	uniform usamplerBuffer clusterData;		//| Offset  Count |
+	uniform usamplerBuffer lightIndices;
+	uniform ivec3 clusterCount;
+	uniform float sliceScale;
+	uniform float sliceBias;
+
+	//Lighting function
+	vec3 PointLighting(vec3 baseCol, float rough, float metal, vec3 F0, vec3 pos, vec3 norm, vec3 viewDir, vec3 lightPos, float radius, vec3 color)
+	{
+		vec3 lightDir = lightPos - pos;
+		float dist = length(lightDir);
+		dist = min(dist, radius); //Clamp instead of branching
+
+		lightDir = normalize(lightDir);		//L
+		vec3 H = normalize(lightDir+viewDir);
+
+		//Calc attenuation with inv square
+		float dividend = 1.0 - pow(dist/radius, 4);
+		dividend = clamp(dividend, 0.0, 1.0);
+		float attenuation = (dividend*dividend)/((dist*dist)+1);
+
+		//radiance
+		vec3 radiance = color * attenuation;
+
+		vec3 F  = FresnelSchlick(max(dot(H, viewDir), 0.0), F0);	//Fresnel
+		float NDF = DistributionGGX(norm, H, rough); 				//Normalized distribution funciton
+		float G   = GeometrySmith(norm, viewDir, lightDir, rough);  //Geometry shadowing
+
+		//Calculate how much the light contributes
+		vec3 kS = F;
+		vec3 kD = vec3(1.0) - kS;
+		kD *= 1.0 - metal;
+
+		//Cook torrance BRDF
+		vec3 nominator 	  = NDF * G * F;
+		float denominator = 4 * max(dot(norm, viewDir), 0.0) * max(dot(norm, lightDir), 0.0) + 0.001;
+		vec3 brdf		  = nominator / denominator;
+
+		// add to outgoing radiance Lo
+		float NdotL = max(dot(norm, lightDir), 0.0);
+		return (kD * baseCol / PI + brdf) * radiance * NdotL;
+	}
+
+	void main()
+	{
+		UNPACK_GBUFFER(TexCoords, ViewRay)
+
+		//cluster of the pixel
+		float linearDepth = LINEAR_DEPTH(depth);
+		ivec3 cluster = ivec3(ivec2(TexCoords * vec2(clusterCount.xy)), int(floor(log(linearDepth) * sliceScale - sliceBias)));
+		cluster = clamp(cluster, ivec3(0), clusterCount - ivec3(1));
+		uvec2 range = texelFetch(clusterData, (cluster.z * clusterCount.y + cluster.y) * clusterCount.x + cluster.x).rg;
+
+		//precalculations
+		vec3 F0 = vec3(0.04);//for dielectric materials use this simplified constant
+		F0 		= mix(F0, baseCol, metal);//for metal we should use the albedo value
+		//View dir and reflection
+		vec3 viewDir = -normalize(ViewRay);
+
+		vec3 finalCol = vec3(0);
+		for (uint i = range.x; i < range.x + range.y; ++i)
+		{
+			int light = int(texelFetch(lightIndices, int(i)).r);
+			vec4 positionRadius = texelFetch(lightData, light * 2);
+			vec3 color = texelFetch(lightData, light * 2 + 1).rgb;
+			finalCol += PointLighting(baseCol, rough, metal, F0, pos, norm, viewDir, positionRadius.xyz, positionRadius.w, color);
+		}
+
+		//output
+		outColor = vec4(clamp(finalCol, 0.0, maxExposure), 1.0);
+	}
+</FRAGMENT>
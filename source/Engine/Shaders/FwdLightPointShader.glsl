@@ -1,16 +1,28 @@
 <VERTEX>
 	#version 330 core
 
-	in vec3 position;
+	layout (location = 0) in vec3 position;
 
 	out vec4 Texcoord;
+	flat out vec3 Position;
+	flat out float Radius;
+	flat out vec3 Color;
 
 	uniform mat4 model;
 	uniform mat4 worldViewProj;
 
+	//Lights, see PointLightInstances
+	uniform samplerBuffer lightData;	//| Pos.x   Pos.y   Pos.z | Radius | , | Col.r   Col.g   Col.b | xxxxx |
+
 	void main()
 	{
-		vec4 pos = model*vec4(position, 1.0);
+		vec4 positionRadius = texelFetch(lightData, gl_InstanceID * 2);
+		Position = positionRadius.xyz;
+		Radius = positionRadius.w;
+		Color = texelFetch(lightData, gl_InstanceID * 2 + 1).rgb;
+
+		//the unit sphere scaled to the radius around the light
+		vec4 pos = model*vec4(position * Radius + Position, 1.0);
 		pos = worldViewProj*pos;
 		gl_Position = pos;
 		Texcoord = pos;//((pos.xy/pos.w)+vec2(1))*0.5f;
@@ -24,6 +36,9 @@
 	#include "CommonPBR.glsl"
 
 	in vec4 Texcoord;
+	flat in vec3 Position;
+	flat in float Radius;
+	flat in vec3 Color;
 
 	//out
 	layout (location = 0) out vec4 outColor;
@@ -31,11 +46,6 @@
 	GBUFFER_SAMPLER
 	uniform mat4 viewProjInv;
 
-	//Light
-	uniform vec3 Position;
-	uniform vec3 Color = vec3(10);
-	uniform float Radius;
-
 	//Lighting function
 	vec3 PointLighting(vec3 baseCol, float rough, float metal, vec3 F0, vec3 pos, vec3 norm, vec3 viewDir)
 	{
@@ -3,15 +3,14 @@
 	//Patch
 	layout (location = 0) in vec2 pos;
 	layout (location = 1) in vec2 morph;
-	//Instance
-	layout (location = 2) in int level;
-	layout (location = 3) in vec3 a;
-	layout (location = 4) in vec3 r;
-	layout (location = 5) in vec3 s;
+	//Instance, face level and subdivision path as in PatchInstance.hpp
+	layout (location = 2) in uvec2 instance;
+	uniform vec3 faceCorners[60];
 	//Morph calculation
 	uniform vec3 camPos;
 	uniform float radius;
 	uniform float morphRange;
+	uniform float morphLatency = 0;
 	uniform float distanceLUT[32];
 	//Transformation
 	uniform mat4 model;
@@ -27,6 +26,37 @@
 	out vec3 Tex3;
 	out vec3 Normal;
 	out vec3 TriPos;
+	//decoded instance
+	int level;
+	vec3 a;
+	vec3 r;
+	vec3 s;
+	
+	//repeat the triangulators subdivision along the path of the instance
+	void DecodeInstance()
+	{
+		uint face = instance.x & 31u;
+		level = int((instance.x >> 5u) & 31u);
+		vec3 ca = faceCorners[face*3u];
+		vec3 cb = faceCorners[face*3u+1u];
+		vec3 cc = faceCorners[face*3u+2u];
+		for (int i = 1; i <= level; ++i)
+		{
+			uint child = i < 12 ? (instance.x >> uint(10 + 2*(i-1))) & 3u : (instance.y >> uint(2*(i-12))) & 3u;
+			vec3 mA = cb + ((cc - cb)*0.5f);
+			vec3 mB = cc + ((ca - cc)*0.5f);
+			vec3 mC = ca + ((cb - ca)*0.5f);
+			mA = mA * radius / length(mA);
+			mB = mB * radius / length(mB);
+			mC = mC * radius / length(mC);
+			if (child != 0u) ca = mA;
+			if (child != 1u) cb = mB;
+			if (child != 2u) cc = mC;
+		}
+		a = ca;
+		r = cb - ca;
+		s = cc - ca;
+	}
 	
 	float height(vec3 Tex3)
 	{
@@ -61,12 +91,14 @@
 		float high = distanceLUT[lev];
 		
 		float delta = high-low;
-		float a = (dist-low)/delta;
+		//only start morphing once the camera is further than the latency of the instances past the split distance
+		float a = min(dist-low+morphLatency, 0)/delta;
 		
 		return 1 - clamp(a/morphRange, 0, 1);
 	}
 	void main()
 	{
+		DecodeInstance();
 		//initial position
 		vec3 TriPos = a + r*pos.x + s*pos.y;
 		//morph factor
@@ -0,0 +1,201 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+
+#include "../../../Engine/Graphics/BatchFrustum.hpp"
+
+namespace
+{
+	//odd counts so the scalar tail after the SIMD loops is covered
+	const size_t testCounts[] = { 0, 5, 4099 };
+
+	struct TestVolumes
+	{
+		vec3soa centers;
+		std::vector<float> radii;
+		vec3soa mins;
+		vec3soa maxs;
+	};
+	//scattered around a camera at the origin, a lot of them near the planes
+	TestVolumes GenerateVolumes(size_t count, float range)
+	{
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> position(-range, range);
+		std::uniform_real_distribution<float> size(0.f, range * 0.1f);
+		TestVolumes volumes;
+		volumes.centers.resize(count);
+		volumes.mins.resize(count);
+		volumes.maxs.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			vec3 center(position(random), position(random), position(random));
+			vec3 extents(size(random), size(random), size(random));
+			volumes.centers.set(i, center);
+			volumes.radii.push_back(size(random));
+			volumes.mins.set(i, center - extents);
+			volumes.maxs.set(i, center + extents);
+		}
+		return volumes;
+	}
+
+	//in the clip volume of the matrix
+	bool IsInClipSpace(const mat4 &viewProjection, const vec3 &point)
+	{
+		vec4 clip = viewProjection * vec4(point, 1.f);
+		return std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && std::abs(clip.z) <= clip.w;
+	}
+	//distance to the closest plane of the clip volume, used to skip points where rounding decides
+	float GetClipMargin(const mat4 &viewProjection, const vec3 &point)
+	{
+		vec4 clip = viewProjection * vec4(point, 1.f);
+		return std::min(std::min(std::abs(clip.w - std::abs(clip.x)), std::abs(clip.w - std::abs(clip.y))), std::abs(clip.w - std::abs(clip.z)));
+	}
+}
+
+TEST_CASE("batch frustum planes", "[frustum]")
+{
+	mat4 view = etm::lookAt(vec3(1.f, 2.f, -3.f), vec3(0.5f, 2.2f, 5.f), vec3(0.f, 1.f, 0.f));
+	mat4 projection = etm::perspective(etm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+	mat4 viewProjection = view * projection;
+	BatchFrustum frustum(viewProjection);
+
+	for (uint8 i = 0; i < BatchFrustum::PLANE_COUNT; ++i)
+	{
+		REQUIRE(etm::length(frustum.GetPlane(i).xyz) == Approx(1.f));
+	}
+
+	//points are inside exactly when they are in clip space
+	TestVolumes volumes = GenerateVolumes(4099, 60.f);
+	std::vector<float> noRadius(volumes.radii.size(), 0.f);
+	std::vector<uint32> visibleMask;
+	frustum.CullSpheres(volumes.centers, noRadius, visibleMask);
+	size_t insideCount = 0;
+	for (size_t i = 0; i < volumes.radii.size(); ++i)
+	{
+		vec3 point = volumes.centers.get(i);
+		if (GetClipMargin(viewProjection, point) < 0.001f) continue;
+		bool isInside = IsInClipSpace(viewProjection, point);
+		REQUIRE(BatchFrustum::IsVisible(visibleMask, i) == isInside);
+		REQUIRE((frustum.ContainsSphere(Sphere(point, 0.f)) != VolumeCheck::OUTSIDE) == isInside);
+		insideCount += isInside ? 1 : 0;
+	}
+	REQUIRE(insideCount > 0);
+	REQUIRE(insideCount < volumes.radii.size() / 2);
+
+	//the plane order follows Frustum
+	vec3 forward = etm::normalize(vec3(0.5f, 2.2f, 5.f) - vec3(1.f, 2.f, -3.f));
+	REQUIRE(etm::dot(frustum.GetPlane(0).xyz, forward) == Approx(1.f));
+	REQUIRE(etm::dot(frustum.GetPlane(1).xyz, forward) == Approx(-1.f));
+}
+
+TEST_CASE("batch frustum matches frustum", "[frustum]")
+{
+	Frustum frustum;
+	frustum.SetCullTransform(mat4(), mat4());
+	frustum.SetCamera(vec3(3.f, -1.f, 2.f), etm::normalize(vec3(0.2f, 0.1f, 1.f)), vec3(0.f, 1.f, 0.f), 45.f, 0.5f, 120.f, 16.f / 9.f);
+	frustum.Update();
+	BatchFrustum batch(frustum.GetPlanes());
+
+	for (size_t count : testCounts)
+	{
+		TestVolumes volumes = GenerateVolumes(count, 80.f);
+		std::vector<uint32> visibleMask;
+		batch.CullSpheres(volumes.centers, volumes.radii, visibleMask);
+		REQUIRE(visibleMask.size() == (count + 31) / 32);
+
+		std::vector<uint32> expectedIndices;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Sphere sphere(volumes.centers.get(i), volumes.radii[i]);
+			bool isVisible = frustum.ContainsSphere(sphere) != VolumeCheck::OUTSIDE;
+
+			//the same planes in the other form only differ by rounding, so spheres touching a plane are left out
+			float margin = std::numeric_limits<float>::max();
+			for (const Plane &plane : frustum.GetPlanes())
+			{
+				margin = std::min(margin, std::abs(etm::dot(plane.n, sphere.pos - plane.d) + sphere.radius));
+			}
+			if (margin > 0.0001f)
+			{
+				REQUIRE(BatchFrustum::IsVisible(visibleMask, i) == isVisible);
+			}
+
+			//the batched paths give exactly what testing one by one does
+			REQUIRE(BatchFrustum::IsVisible(visibleMask, i) == (batch.ContainsSphere(sphere) != VolumeCheck::OUTSIDE));
+			if (BatchFrustum::IsVisible(visibleMask, i)) expectedIndices.push_back((uint32)i);
+		}
+
+		std::vector<uint32> visibleIndices;
+		batch.CollectVisibleSpheres(volumes.centers, volumes.radii, visibleIndices);
+		REQUIRE(visibleIndices == expectedIndices);
+	}
+}
+
+TEST_CASE("batch frustum boxes", "[frustum]")
+{
+	mat4 viewProjection = etm::lookAt(vec3(0.f), vec3(0.f, 0.f, 1.f), vec3(0.f, 1.f, 0.f)) * etm::perspective(etm::radians(70.f), 1.5f, 1.f, 50.f);
+	BatchFrustum frustum(viewProjection);
+
+	for (size_t count : testCounts)
+	{
+		TestVolumes volumes = GenerateVolumes(count, 40.f);
+		std::vector<uint32> visibleMask;
+		frustum.CullAABBs(volumes.mins, volumes.maxs, visibleMask);
+
+		std::vector<uint32> expectedIndices;
+		for (size_t i = 0; i < count; ++i)
+		{
+			vec3 min = volumes.mins.get(i);
+			vec3 max = volumes.maxs.get(i);
+			bool isVisible = BatchFrustum::IsVisible(visibleMask, i);
+			REQUIRE(isVisible == (frustum.ContainsAABB(min, max) != VolumeCheck::OUTSIDE));
+			if (isVisible) expectedIndices.push_back((uint32)i);
+
+			//a box is outside when all corners are outside of the same plane
+			bool isOutside = false;
+			float margin = std::numeric_limits<float>::max();
+			for (uint8 planeIdx = 0; planeIdx < BatchFrustum::PLANE_COUNT; ++planeIdx)
+			{
+				vec4 plane = frustum.GetPlane(planeIdx);
+				float furthest = std::numeric_limits<float>::lowest();
+				for (uint8 corner = 0; corner < 8; ++corner)
+				{
+					vec3 point((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+					furthest = std::max(furthest, etm::dot(plane.xyz, point) + plane.w);
+				}
+				isOutside |= furthest < 0.f;
+				margin = std::min(margin, std::abs(furthest));
+			}
+			if (margin > 0.0001f)
+			{
+				REQUIRE(isVisible == !isOutside);
+			}
+		}
+
+		std::vector<uint32> visibleIndices;
+		frustum.CollectVisibleAABBs(volumes.mins, volumes.maxs, visibleIndices);
+		REQUIRE(visibleIndices == expectedIndices);
+	}
+
+	//boxes around the camera intersect, boxes in front of it are contained, boxes behind it are outside
+	REQUIRE(frustum.ContainsAABB(vec3(-1.f), vec3(1.f)) == VolumeCheck::INTERSECT);
+	REQUIRE(frustum.ContainsAABB(vec3(-0.5f, -0.5f, 10.f), vec3(0.5f, 0.5f, 11.f)) == VolumeCheck::CONTAINS);
+	REQUIRE(frustum.ContainsAABB(vec3(-0.5f, -0.5f, -11.f), vec3(0.5f, 0.5f, -10.f)) == VolumeCheck::OUTSIDE);
+}
+
+TEST_CASE("batch frustum shadow caster volume", "[frustum]")
+{
+	//a cascade in front of a directional light looking along z
+	mat4 lightViewProjection = etm::lookAt(vec3(0.f), vec3(0.f, 0.f, 1.f), vec3(0.f, 1.f, 0.f)) * etm::orthographic(-10.f, 10.f, -10.f, 10.f, 1.f, 20.f);
+	BatchFrustum frustum(lightViewProjection);
+	REQUIRE(frustum.ContainsSphere(Sphere(vec3(0.f, 0.f, 10.f), 1.f)) == VolumeCheck::CONTAINS);
+	REQUIRE(frustum.ContainsSphere(Sphere(vec3(0.f, 0.f, -5.f), 1.f)) == VolumeCheck::OUTSIDE);
+
+	//casters between the light and the cascade are kept once the near plane is extended, others stay culled
+	frustum.ExtendPlane(BatchFrustum::NEAR_PLANE, 10.f);
+	REQUIRE(frustum.ContainsSphere(Sphere(vec3(0.f, 0.f, -5.f), 1.f)) != VolumeCheck::OUTSIDE);
+	REQUIRE(frustum.ContainsSphere(Sphere(vec3(0.f, 0.f, -12.f), 1.f)) == VolumeCheck::OUTSIDE);
+	REQUIRE(frustum.ContainsSphere(Sphere(vec3(0.f, 0.f, 25.f), 1.f)) == VolumeCheck::OUTSIDE);
+	REQUIRE(frustum.ContainsSphere(Sphere(vec3(15.f, 0.f, -5.f), 1.f)) == VolumeCheck::OUTSIDE);
+}
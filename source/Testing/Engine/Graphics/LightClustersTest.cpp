@@ -0,0 +1,173 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+#include <algorithm>
+
+#include "../../../Engine/Graphics/LightClusters.hpp"
+#include "../../../Engine/Helper/TaskScheduler.hpp"
+
+namespace
+{
+	const float nearPlane = 1.f;
+	const float farPlane = 100.f;
+
+	mat4 TestProjection()
+	{
+		return etm::perspective(etm::radians(60.f), 16.f / 9.f, nearPlane, farPlane);
+	}
+
+	//view space point in the middle of a cluster
+	vec3 ClusterCenter(const LightClusters &clusters, const ivec3 &cluster)
+	{
+		const ivec3 &dimensions = clusters.GetDimensions();
+		float ndcX = ((float)cluster.x + 0.5f) / (float)dimensions.x * 2.f - 1.f;
+		float ndcY = ((float)cluster.y + 0.5f) / (float)dimensions.y * 2.f - 1.f;
+		float depth = expf(((float)cluster.z + 0.5f + clusters.GetSliceBias()) / clusters.GetSliceScale());
+		vec4 nearPoint = etm::inverse(TestProjection()) * vec4(ndcX, ndcY, -1.f, 1.f);
+		vec3 direction = nearPoint.xyz / nearPoint.w;
+		return direction * (depth / direction.z);
+	}
+
+	std::vector<uint32> ClusterLights(const LightClusters &clusters, uint32 cluster)
+	{
+		const LightClusters::Cluster &range = clusters.GetClusters()[cluster];
+		return std::vector<uint32>(clusters.GetLightIndices().begin() + range.offset, clusters.GetLightIndices().begin() + range.offset + range.count);
+	}
+
+	bool IsInside(const vec3 &point, const AABB &box)
+	{
+		return point.x >= box.min.x && point.y >= box.min.y && point.z >= box.min.z
+			&& point.x <= box.max.x && point.y <= box.max.y && point.z <= box.max.z;
+	}
+}
+
+TEST_CASE("light cluster slices", "[lights]")
+{
+	LightClusters clusters(ivec3(16, 9, 24));
+	clusters.SetProjection(TestProjection(), nearPlane, farPlane);
+
+	REQUIRE(clusters.GetSlice(0.5f) == 0);
+	REQUIRE(clusters.GetSlice(nearPlane * 1.01f) == 0);
+	REQUIRE(clusters.GetSlice(farPlane * 0.99f) == 23);
+	REQUIRE(clusters.GetSlice(farPlane * 2.f) == 23);
+	int32 previous = 0;
+	bool isMonotonic = true;
+	for (float depth = nearPlane; depth < farPlane; depth *= 1.05f)
+	{
+		isMonotonic &= clusters.GetSlice(depth) >= previous;
+		previous = clusters.GetSlice(depth);
+	}
+	REQUIRE(isMonotonic);
+
+	//the bounds of a cluster contain its center, and slices get deeper further away
+	uint32 index = clusters.GetClusterIndex(ivec3(3, 7, 12));
+	REQUIRE(IsInside(ClusterCenter(clusters, ivec3(3, 7, 12)), clusters.GetClusterBounds(index)));
+	const AABB &nearBounds = clusters.GetClusterBounds(clusters.GetClusterIndex(ivec3(0, 0, 1)));
+	const AABB &farBounds = clusters.GetClusterBounds(clusters.GetClusterIndex(ivec3(0, 0, 20)));
+	REQUIRE(nearBounds.max.z - nearBounds.min.z < farBounds.max.z - farBounds.min.z);
+}
+
+TEST_CASE("light cluster assignment", "[lights]")
+{
+	TaskScheduler scheduler(2);
+	LightClusters clusters(ivec3(16, 9, 24), &scheduler);
+	clusters.SetProjection(TestProjection(), nearPlane, farPlane);
+
+	const ivec3 target(5, 2, 10);
+	const ivec3 other(12, 6, 18);
+	std::vector<LightClusters::PointLight> lights;
+	//small lights in the middle of a cluster only reach that cluster
+	lights.push_back(LightClusters::PointLight(ClusterCenter(clusters, target), 0.01f, vec3(1.f)));
+	lights.push_back(LightClusters::PointLight(ClusterCenter(clusters, other), 0.01f, vec3(2.f)));
+	//behind the camera, beyond the far plane and next to the frustum
+	lights.push_back(LightClusters::PointLight(vec3(0.f, 0.f, -10.f), 2.f, vec3(1.f)));
+	lights.push_back(LightClusters::PointLight(vec3(0.f, 0.f, 150.f), 2.f, vec3(1.f)));
+	lights.push_back(LightClusters::PointLight(vec3(100.f, 0.f, 10.f), 2.f, vec3(1.f)));
+	clusters.Build(mat4(), lights);
+
+	REQUIRE(clusters.GetLights().size() == 2);
+	REQUIRE(clusters.GetLights()[1].color == vec3(2.f));
+	REQUIRE(clusters.GetLightIndices().size() == 2);
+	REQUIRE(ClusterLights(clusters, clusters.GetClusterIndex(target)) == std::vector<uint32>({ 0 }));
+	REQUIRE(ClusterLights(clusters, clusters.GetClusterIndex(other)) == std::vector<uint32>({ 1 }));
+
+	//the view matrix moves the lights into view space
+	clusters.Build(etm::translate(vec3(0.f, 0.f, 1000.f)), std::vector<LightClusters::PointLight>(
+		{ LightClusters::PointLight(ClusterCenter(clusters, target) - vec3(0.f, 0.f, 1000.f), 0.01f, vec3(1.f)) }));
+	REQUIRE(clusters.GetLightIndices().size() == 1);
+	REQUIRE(clusters.GetClusters()[clusters.GetClusterIndex(target)].count == 1);
+
+	//a light around the camera is tested against every cluster in its depth range
+	const float radius = 5.f;
+	clusters.Build(mat4(), std::vector<LightClusters::PointLight>({ LightClusters::PointLight(vec3(0.f), radius, vec3(1.f)) }));
+	bool matches = true;
+	uint32 assignedCount = 0;
+	for (uint32 cluster = 0; cluster < (uint32)clusters.GetClusters().size(); ++cluster)
+	{
+		const AABB &bounds = clusters.GetClusterBounds(cluster);
+		vec3 closest(etm::Clamp(0.f, bounds.max.x, bounds.min.x), etm::Clamp(0.f, bounds.max.y, bounds.min.y), etm::Clamp(0.f, bounds.max.z, bounds.min.z));
+		bool expected = etm::length(closest) <= radius;
+		matches &= (clusters.GetClusters()[cluster].count == 1) == expected;
+		if (expected) ++assignedCount;
+	}
+	REQUIRE(matches);
+	REQUIRE(assignedCount > 16 * 9);
+}
+
+TEST_CASE("light cluster lists", "[lights]")
+{
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> lateral(-60.f, 60.f);
+	std::uniform_real_distribution<float> depth(-10.f, 120.f);
+	std::uniform_real_distribution<float> size(0.5f, 15.f);
+	std::vector<LightClusters::PointLight> lights;
+	for (uint32 i = 0; i < 2000; ++i)
+	{
+		lights.push_back(LightClusters::PointLight(vec3(lateral(random), lateral(random), depth(random)), size(random), vec3(1.f)));
+	}
+
+	LightClusters serial(ivec3(16, 9, 24));
+	serial.SetProjection(TestProjection(), nearPlane, farPlane);
+	serial.Build(mat4(), lights);
+	TaskScheduler scheduler(4);
+	LightClusters parallel(ivec3(16, 9, 24), &scheduler);
+	parallel.SetProjection(TestProjection(), nearPlane, farPlane);
+	parallel.Build(mat4(), lights);
+
+	REQUIRE(serial.GetLights().size() < lights.size());
+	REQUIRE(serial.GetLightIndices() == parallel.GetLightIndices());
+
+	//clusters are laid out back to back, every light index is valid, and every light reaches the cluster of its center
+	bool isPacked = true;
+	bool isValid = true;
+	bool hasCenter = true;
+	uint32 nextOffset = 0;
+	for (uint32 cluster = 0; cluster < (uint32)serial.GetClusters().size(); ++cluster)
+	{
+		const LightClusters::Cluster &range = serial.GetClusters()[cluster];
+		isPacked &= range.offset == nextOffset && parallel.GetClusters()[cluster].offset == range.offset
+			&& parallel.GetClusters()[cluster].count == range.count;
+		nextOffset += range.count;
+	}
+	for (uint32 light : serial.GetLightIndices())
+	{
+		isValid &= light < serial.GetLights().size();
+	}
+	const ivec3 &dimensions = serial.GetDimensions();
+	for (uint32 light = 0; light < (uint32)serial.GetLights().size(); ++light)
+	{
+		const vec3 &position = serial.GetLights()[light].position;
+		if (position.z <= nearPlane || position.z >= farPlane) continue;
+		vec4 clip = TestProjection() * vec4(position, 1.f);
+		vec2 ndc = clip.xy / clip.w;
+		if (std::abs(ndc.x) >= 1.f || std::abs(ndc.y) >= 1.f) continue;
+		ivec3 cluster((int32)((ndc.x * 0.5f + 0.5f) * dimensions.x), (int32)((ndc.y * 0.5f + 0.5f) * dimensions.y), serial.GetSlice(position.z));
+		std::vector<uint32> clusterLights = ClusterLights(serial, serial.GetClusterIndex(cluster));
+		hasCenter &= std::find(clusterLights.begin(), clusterLights.end(), light) != clusterLights.end();
+	}
+	REQUIRE(nextOffset == serial.GetLightIndices().size());
+	REQUIRE(isPacked);
+	REQUIRE(isValid);
+	REQUIRE(hasCenter);
+}
@@ -0,0 +1,98 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/Graphics/OcclusionBuffer.hpp"
+#include "../../../Engine/Helper/TaskScheduler.hpp"
+
+namespace
+{
+	//camera at the origin looking along z
+	mat4 TestViewProjection()
+	{
+		return etm::lookAt(vec3(0.f), vec3(0.f, 0.f, 1.f), vec3(0.f, 1.f, 0.f)) * etm::perspective(etm::radians(60.f), 2.f, 1.f, 100.f);
+	}
+
+	//square facing the camera, covering about half of the screen height
+	const std::vector<vec3> wallPositions = { vec3(-5.f, -5.f, 10.f), vec3(5.f, -5.f, 10.f), vec3(5.f, 5.f, 10.f), vec3(-5.f, 5.f, 10.f) };
+	const std::vector<uint32> wallIndices = { 0, 1, 2, 0, 2, 3 };
+
+	AABB Box(const vec3 &center, const vec3 &extents)
+	{
+		return AABB(center - extents, center + extents);
+	}
+}
+
+TEST_CASE("occlusion buffer without occluders", "[occlusion]")
+{
+	OcclusionBuffer buffer(ivec2(100, 50));
+	//rounded up to whole tiles
+	REQUIRE(buffer.GetResolution() == ivec2(128, 64));
+
+	buffer.Begin(TestViewProjection());
+	buffer.Rasterize();
+	REQUIRE(buffer.GetTriangleCount() == 0);
+	REQUIRE(buffer.GetDepth(64, 32) == 1.f);
+	REQUIRE_FALSE(buffer.IsOccluded(Box(vec3(0.f, 0.f, 50.f), vec3(1.f))));
+}
+
+TEST_CASE("occlusion buffer wall", "[occlusion]")
+{
+	TaskScheduler scheduler(4);
+	OcclusionBuffer buffer(ivec2(256, 128), &scheduler);
+	buffer.Begin(TestViewProjection());
+	buffer.AddOccluder(wallPositions, wallIndices, mat4());
+	buffer.Rasterize();
+	REQUIRE(buffer.GetTriangleCount() == 2);
+
+	//the center is covered, the corners of the screen are not
+	REQUIRE(buffer.GetDepth(128, 64) < 1.f);
+	REQUIRE(buffer.GetDepth(0, 0) == 1.f);
+	REQUIRE(buffer.GetDepth(255, 127) == 1.f);
+
+	REQUIRE(buffer.IsOccluded(Box(vec3(0.f, 0.f, 20.f), vec3(1.f))));
+	REQUIRE(buffer.IsOccluded(Box(vec3(2.f, -2.f, 50.f), vec3(5.f))));
+	//in front of the wall, reaching past its edge, and around the camera
+	REQUIRE_FALSE(buffer.IsOccluded(Box(vec3(0.f, 0.f, 5.f), vec3(1.f))));
+	REQUIRE_FALSE(buffer.IsOccluded(Box(vec3(6.f, 0.f, 15.f), vec3(2.f))));
+	REQUIRE_FALSE(buffer.IsOccluded(Box(vec3(0.f), vec3(2.f))));
+	//intersecting the wall
+	REQUIRE_FALSE(buffer.IsOccluded(Box(vec3(0.f, 0.f, 10.f), vec3(1.f))));
+
+	//moving the wall with its world matrix uncovers the box
+	buffer.Begin(TestViewProjection());
+	buffer.AddOccluder(wallPositions, wallIndices, etm::translate(vec3(20.f, 0.f, 0.f)));
+	buffer.Rasterize();
+	REQUIRE_FALSE(buffer.IsOccluded(Box(vec3(0.f, 0.f, 20.f), vec3(1.f))));
+}
+
+TEST_CASE("occlusion buffer is independent of winding and workers", "[occlusion]")
+{
+	//the same triangles facing away
+	const std::vector<uint32> reversedIndices = { 0, 2, 1, 0, 3, 2 };
+	//rotated so the edges are not axis aligned, and close enough to be clipped by the screen
+	mat4 world = etm::rotate(etm::normalize(vec3(0.3f, 0.4f, 0.2f)), 0.5f) * etm::translate(vec3(1.f, 0.f, -4.f));
+
+	OcclusionBuffer serial(ivec2(256, 128));
+	serial.Begin(TestViewProjection());
+	serial.AddOccluder(wallPositions, wallIndices, world);
+	serial.Rasterize();
+
+	TaskScheduler scheduler(4);
+	OcclusionBuffer parallel(ivec2(256, 128), &scheduler);
+	parallel.Begin(TestViewProjection());
+	parallel.AddOccluder(wallPositions, reversedIndices, world);
+	parallel.Rasterize();
+
+	bool matches = true;
+	uint32 coveredCount = 0;
+	for (int32 y = 0; y < 128; ++y)
+	{
+		for (int32 x = 0; x < 256; ++x)
+		{
+			matches &= serial.GetDepth(x, y) == parallel.GetDepth(x, y);
+			if (serial.GetDepth(x, y) < 1.f) ++coveredCount;
+		}
+	}
+	REQUIRE(matches);
+	REQUIRE(coveredCount > 0);
+}
@@ -0,0 +1,63 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/Graphics/PointLightInstances.hpp"
+#include "../../../Engine/Graphics/BatchFrustum.hpp"
+#include "../../../Engine/Graphics/SphereOccluders.hpp"
+
+namespace
+{
+	//camera at the origin looking along z
+	BatchFrustum TestFrustum()
+	{
+		return BatchFrustum(etm::lookAt(vec3(0.f), vec3(0.f, 0.f, 1.f), vec3(0.f, 1.f, 0.f)) * etm::perspective(etm::radians(60.f), 2.f, 1.f, 100.f));
+	}
+}
+
+TEST_CASE("point light instance layout", "[lights]")
+{
+	//two RGBA texels per instance
+	REQUIRE(sizeof(PointLightInstances::Instance) == 8 * sizeof(float));
+
+	PointLightInstances::Instance instance(vec3(1.f, 2.f, 3.f), 4.f, vec3(5.f, 6.f, 7.f));
+	const float* pTexels = reinterpret_cast<const float*>(&instance);
+	REQUIRE(pTexels[0] == 1.f);
+	REQUIRE(pTexels[2] == 3.f);
+	REQUIRE(pTexels[3] == 4.f);
+	REQUIRE(pTexels[4] == 5.f);
+	REQUIRE(pTexels[6] == 7.f);
+}
+
+TEST_CASE("point light instances", "[lights]")
+{
+	std::vector<PointLightInstances::Instance> lights;
+	lights.push_back(PointLightInstances::Instance(vec3(0.f, 0.f, 20.f), 2.f, vec3(1.f)));
+	//behind the camera and beyond the far plane
+	lights.push_back(PointLightInstances::Instance(vec3(0.f, 0.f, -10.f), 2.f, vec3(1.f)));
+	lights.push_back(PointLightInstances::Instance(vec3(0.f, 0.f, 150.f), 2.f, vec3(1.f)));
+	//outside of the frustum but reaching into it, and around the camera
+	lights.push_back(PointLightInstances::Instance(vec3(0.f, 30.f, 20.f), 25.f, vec3(2.f)));
+	lights.push_back(PointLightInstances::Instance(vec3(0.f), 5.f, vec3(3.f)));
+	//behind the occluder
+	lights.push_back(PointLightInstances::Instance(vec3(0.f, 0.f, 80.f), 2.f, vec3(1.f)));
+
+	PointLightInstances instances;
+	SphereOccluders occluders;
+	instances.Build(lights, TestFrustum(), occluders);
+	REQUIRE(instances.GetCount() == 4);
+	//in the order of the lights
+	REQUIRE(instances.GetInstances()[0].position == lights[0].position);
+	REQUIRE(instances.GetInstances()[1].color == vec3(2.f));
+	REQUIRE(instances.GetInstances()[2].color == vec3(3.f));
+	REQUIRE(instances.GetInstances()[3].position == lights[5].position);
+
+	occluders.AddOccluder(Sphere(vec3(0.f, 0.f, 50.f), 10.f));
+	occluders.SetViewPosition(vec3(0.f));
+	instances.Build(lights, TestFrustum(), occluders);
+	REQUIRE(instances.GetCount() == 3);
+	REQUIRE(instances.GetInstances()[2].color == vec3(3.f));
+
+	//building again replaces the instances
+	instances.Build(std::vector<PointLightInstances::Instance>(), TestFrustum(), occluders);
+	REQUIRE(instances.GetCount() == 0);
+}
@@ -0,0 +1,83 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/Graphics/Spectrum.hpp"
+
+namespace
+{
+	//the linear search CIE used to interpolate with
+	double InterpolateBySearch(const std::vector<double> &wavelengths, const std::vector<double> &values, double wavelength)
+	{
+		if (wavelength < wavelengths[0]) return values[0];
+		for (size_t i = 0; i < wavelengths.size() - 1; ++i)
+		{
+			if (wavelength < wavelengths[i + 1])
+			{
+				double u = (wavelength - wavelengths[i]) / (wavelengths[i + 1] - wavelengths[i]);
+				return values[i] * (1.0 - u) + values[i + 1] * u;
+			}
+		}
+		return values.back();
+	}
+}
+
+TEST_CASE("spectrum sampling", "[spectrum]")
+{
+	Spectrum spectrum(360.0, 830.0, 10.0);
+	REQUIRE(spectrum.Size() == 48);
+	REQUIRE(spectrum.GetLambdaMax() == Approx(830.0));
+	REQUIRE(Spectrum(360.0, 830.0, 1.0).Size() == 471);
+
+	std::vector<double> wavelengths = { 380.0, 400.0, 405.0, 460.0, 610.0, 700.0 };
+	std::vector<double> values = { 0.5, 2.0, 1.0, 3.0, -1.0, 0.25 };
+	Spectrum resampled = Spectrum::Resample(wavelengths, values, 360.0, 720.0, 2.5);
+	for (size_t i = 0; i < resampled.Size(); ++i)
+	{
+		REQUIRE(resampled.GetValues()[i] == Approx(InterpolateBySearch(wavelengths, values, resampled.GetWavelength(i))));
+	}
+	//between steps the uniform spectrum is interpolated again, on the step it's exact
+	for (double wavelength = 350.0; wavelength < 740.0; wavelength += 0.7)
+	{
+		double expected = InterpolateBySearch(wavelengths, values, wavelength);
+		REQUIRE(resampled.Sample(wavelength) == Approx(expected).epsilon(0.01).margin(0.05));
+	}
+	REQUIRE(resampled.Sample(405.0) == Approx(1.0));
+	REQUIRE(resampled.Sample(100.0) == Approx(0.5));
+	REQUIRE(resampled.Sample(1000.0) == Approx(0.25));
+	REQUIRE(resampled.Sample(dvec3(460.0, 610.0, 380.0)) == dvec3(3.0, -1.0, 0.5));
+
+	//resampling to the same wavelengths keeps everything
+	Spectrum same = resampled.Resample(360.0, 720.0, 2.5);
+	REQUIRE(same.HasSameWavelengths(resampled));
+	REQUIRE(same.GetValues() == resampled.GetValues());
+	Spectrum finer = resampled.Resample(360.0, 720.0, 1.25);
+	REQUIRE(finer.Size() == resampled.Size() * 2 - 1);
+	REQUIRE_FALSE(finer.HasSameWavelengths(resampled));
+	REQUIRE(finer.Sample(505.0) == Approx(resampled.Sample(505.0)));
+}
+
+TEST_CASE("spectrum operations", "[spectrum]")
+{
+	Spectrum constant(400.0, 700.0, 1.0, 2.0);
+	REQUIRE(constant.Integrate() == Approx(2.0 * 301.0));
+
+	Spectrum linear = Spectrum::Generate(400.0, 700.0, 1.0, [](double lambda) { return lambda / 100.0; });
+	REQUIRE(linear.GetValues().front() == Approx(4.0));
+	REQUIRE(linear.GetValues().back() == Approx(7.0));
+
+	Spectrum product = constant * linear;
+	REQUIRE(product.HasSameWavelengths(linear));
+	REQUIRE(product.Integrate() == Approx(constant.Integrate(linear)));
+	REQUIRE(linear.Integrate(constant) == Approx(constant.Integrate(linear)));
+	Spectrum sum = linear + constant * 0.5;
+	Spectrum scaled = 3.0 * linear;
+	for (size_t i = 0; i < linear.Size(); ++i)
+	{
+		REQUIRE(product.GetValues()[i] == Approx(2.0 * linear.GetValues()[i]));
+		REQUIRE(sum.GetValues()[i] == Approx(linear.GetValues()[i] + 1.0));
+		REQUIRE(scaled.GetValues()[i] == Approx(3.0 * linear.GetValues()[i]));
+	}
+
+	//a riemann sum over 1nm steps of x/100 from 400 to 700
+	REQUIRE(linear.Integrate() == Approx((400.0 + 700.0) / 2.0 * 301.0 / 100.0));
+}
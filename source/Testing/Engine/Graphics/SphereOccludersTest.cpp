@@ -0,0 +1,79 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+
+#include "../../../Engine/Graphics/SphereOccluders.hpp"
+
+namespace
+{
+	//true if the segment from the viewpoint to the point passes through the sphere
+	bool IsBlocked(const vec3 &viewPosition, const vec3 &point, const Sphere &occluder)
+	{
+		vec3 segment = point - viewPosition;
+		float t = etm::Clamp(etm::dot(occluder.pos - viewPosition, segment) / etm::dot(segment, segment), 1.f, 0.f);
+		vec3 closest = viewPosition + segment * t;
+		return etm::length(closest - occluder.pos) <= occluder.radius;
+	}
+}
+
+TEST_CASE("sphere occluder horizon", "[occlusion]")
+{
+	const vec3 viewPosition(0.f);
+	const Sphere planet(vec3(0.f, 0.f, 10.f), 5.f);
+
+	REQUIRE(SphereOccluders::IsOccluded(viewPosition, planet, Sphere(vec3(0.f, 0.f, 20.f), 1.f)));
+	REQUIRE(SphereOccluders::IsOccluded(viewPosition, planet, Sphere(vec3(8.f, 0.f, 20.f), 1.f)));
+	//inside the planet is hidden as well
+	REQUIRE(SphereOccluders::IsOccluded(viewPosition, planet, Sphere(vec3(0.f, 0.f, 12.f), 1.f)));
+	//in front, next to the cone, reaching out of the cone, reaching in front of the horizon
+	REQUIRE_FALSE(SphereOccluders::IsOccluded(viewPosition, planet, Sphere(vec3(0.f, 0.f, 3.f), 1.f)));
+	REQUIRE_FALSE(SphereOccluders::IsOccluded(viewPosition, planet, Sphere(vec3(14.f, 0.f, 20.f), 1.f)));
+	REQUIRE_FALSE(SphereOccluders::IsOccluded(viewPosition, planet, Sphere(vec3(10.f, 0.f, 20.f), 2.f)));
+	REQUIRE_FALSE(SphereOccluders::IsOccluded(viewPosition, planet, Sphere(vec3(4.f, 0.f, 8.f), 1.f)));
+	//the planets own bounds are never hidden by itself
+	REQUIRE_FALSE(SphereOccluders::IsOccluded(viewPosition, planet, planet));
+	//a viewpoint inside the occluder
+	REQUIRE_FALSE(SphereOccluders::IsOccluded(vec3(0.f, 0.f, 9.f), planet, Sphere(vec3(0.f, 0.f, 20.f), 1.f)));
+
+	SphereOccluders occluders;
+	occluders.AddOccluder(planet);
+	occluders.AddOccluder(Sphere(vec3(0.f, 0.f, -10.f), 5.f));
+	occluders.SetViewPosition(viewPosition);
+	REQUIRE(occluders.GetOccluderCount() == 2);
+	REQUIRE(occluders.IsOccluded(Sphere(vec3(0.f, 0.f, 20.f), 1.f)));
+	REQUIRE(occluders.IsOccluded(Sphere(vec3(0.f, 0.f, -20.f), 1.f)));
+	REQUIRE_FALSE(occluders.IsOccluded(Sphere(vec3(20.f, 0.f, 0.f), 1.f)));
+	occluders.Clear();
+	occluders.SetViewPosition(viewPosition);
+	REQUIRE_FALSE(occluders.IsOccluded(Sphere(vec3(0.f, 0.f, 20.f), 1.f)));
+}
+
+TEST_CASE("sphere occluder is conservative", "[occlusion]")
+{
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> position(-30.f, 30.f);
+	std::uniform_real_distribution<float> size(0.1f, 4.f);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	const Sphere planet(vec3(0.f), 8.f);
+
+	uint32 occludedCount = 0;
+	bool isConservative = true;
+	for (uint32 i = 0; i < 2000; ++i)
+	{
+		vec3 viewPosition(position(random), position(random), position(random));
+		Sphere bounds(vec3(position(random), position(random), position(random)), size(random));
+		if (!SphereOccluders::IsOccluded(viewPosition, planet, bounds)) continue;
+		++occludedCount;
+
+		//every point on the surface of hidden bounds has to be behind the planet
+		for (uint32 sample = 0; sample < 32; ++sample)
+		{
+			vec3 direction(unit(random), unit(random), unit(random));
+			if (etm::dot(direction, direction) < 0.0001f) continue;
+			isConservative &= IsBlocked(viewPosition, bounds.pos + etm::normalize(direction) * bounds.radius, planet);
+		}
+	}
+	REQUIRE(isConservative);
+	REQUIRE(occludedCount > 0);
+}
@@ -0,0 +1,47 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/Helper/CameraPath.hpp"
+
+TEST_CASE("text round trip", "[camera path]")
+{
+	CameraPath path;
+	for (uint32 i = 0; i < 10; ++i)
+	{
+		CameraPathFrame frame;
+		frame.position = vec3(1737.1f + i * 0.123456789f, -0.000123f * i, 1.f / (i + 3));
+		frame.forward = etm::normalize(vec3(0.3f, -1.f, 0.1f * i));
+		frame.fov = 45.f + i;
+		frame.aspectRatio = 16.f / 9.f;
+		path.AddFrame(frame);
+	}
+
+	CameraPath loaded;
+	REQUIRE(loaded.FromText(path.ToText()));
+	REQUIRE(loaded.GetFrames().size() == path.GetFrames().size());
+	for (size_t i = 0; i < path.GetFrames().size(); ++i)
+	{
+		const CameraPathFrame &lhs = path.GetFrames()[i];
+		const CameraPathFrame &rhs = loaded.GetFrames()[i];
+		//the floats have to come back bit exact, otherwise replays drift from the recording
+		REQUIRE(lhs.position.x == rhs.position.x);
+		REQUIRE(lhs.position.y == rhs.position.y);
+		REQUIRE(lhs.position.z == rhs.position.z);
+		REQUIRE(lhs.forward.x == rhs.forward.x);
+		REQUIRE(lhs.forward.y == rhs.forward.y);
+		REQUIRE(lhs.forward.z == rhs.forward.z);
+		REQUIRE(lhs.fov == rhs.fov);
+		REQUIRE(lhs.aspectRatio == rhs.aspectRatio);
+	}
+}
+
+TEST_CASE("comments and invalid lines", "[camera path]")
+{
+	CameraPath path;
+	REQUIRE(path.FromText("# comment\n\n1 2 3 0 0 1 60 1.5\r\n4 5 6 0 1 0 45 2\n"));
+	REQUIRE(path.GetFrames().size() == 2);
+	REQUIRE(path.GetFrames()[1].position.z == 6.f);
+	REQUIRE(path.GetFrames()[1].aspectRatio == 2.f);
+
+	REQUIRE_FALSE(path.FromText("1 2 3 0 0 1 60\n"));
+}
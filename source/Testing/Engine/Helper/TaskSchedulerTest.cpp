@@ -0,0 +1,122 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/Helper/TaskScheduler.hpp"
+
+namespace
+{
+	//adds up all numbers in the range by splitting it in half until a task only has one number left,
+	//so nearly all tasks are pushed by other tasks while the scheduler is running
+	void PushRange(TaskScheduler &scheduler, uint32 worker, uint64 first, uint64 count, std::atomic<uint64> &sum)
+	{
+		scheduler.Push(worker, [&scheduler, first, count, &sum](uint32 taskWorker)
+		{
+			if (count == 1)
+			{
+				sum += first;
+				return;
+			}
+			uint64 half = count / 2;
+			PushRange(scheduler, taskWorker, first, half, sum);
+			PushRange(scheduler, taskWorker, first + half, count - half, sum);
+		});
+	}
+}
+
+TEST_CASE("work stealing", "[task scheduler]")
+{
+	TaskScheduler scheduler(4);
+	REQUIRE(scheduler.GetWorkerCount() == 4);
+
+	std::atomic<uint64> sum(0);
+	scheduler.Run(); //nothing to do
+	REQUIRE(sum.load() == 0);
+
+	const uint64 count = 10000;
+	PushRange(scheduler, 0, 0, count, sum);
+	scheduler.Run();
+	REQUIRE(sum.load() == count * (count - 1) / 2);
+
+	//the worker threads are reused for the next run
+	sum = 0;
+	for (uint32 worker = 0; worker < scheduler.GetWorkerCount(); ++worker)
+	{
+		PushRange(scheduler, worker, 0, count, sum);
+	}
+	scheduler.Run();
+	REQUIRE(sum.load() == count * (count - 1) / 2 * scheduler.GetWorkerCount());
+}
+
+TEST_CASE("tasks wait for run", "[task scheduler]")
+{
+	TaskScheduler scheduler(4);
+	std::atomic<uint32> count(0);
+	for (uint32 task = 0; task < 16; ++task)
+	{
+		scheduler.Push(task % scheduler.GetWorkerCount(), [&count](uint32) { ++count; });
+	}
+
+	scheduler.Run();
+	REQUIRE(count.load() == 16);
+
+	//the workers just finished a run, but must not pick up a task before the next one starts
+	scheduler.Push(1, [&count](uint32) { ++count; });
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	REQUIRE(count.load() == 16);
+
+	scheduler.Run();
+	REQUIRE(count.load() == 17);
+}
+
+TEST_CASE("busy scheduler runs tasks on the calling thread", "[task scheduler]")
+{
+	TaskScheduler scheduler(2);
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool isBlocking = false;
+	bool isReleased = false;
+	//submits first and keeps its run going until it is released
+	std::thread other([&]()
+	{
+		scheduler.Push(0, [&](uint32)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			isBlocking = true;
+			condition.notify_all();
+			condition.wait(lock, [&]() { return isReleased; });
+		});
+		scheduler.Run();
+	});
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [&]() { return isBlocking; });
+	}
+
+	const std::thread::id callingThread = std::this_thread::get_id();
+	std::atomic<uint32> count(0);
+	std::atomic<bool> isOnCallingThread(true);
+	for (uint32 task = 0; task < 8; ++task)
+	{
+		scheduler.Push(task % scheduler.GetWorkerCount(), [&](uint32 worker)
+		{
+			++count;
+			if (worker != 0 || std::this_thread::get_id() != callingThread) isOnCallingThread = false;
+		});
+	}
+	scheduler.Run();
+	REQUIRE(count.load() == 8);
+	REQUIRE(isOnCallingThread.load());
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isReleased = true;
+	}
+	condition.notify_all();
+	other.join();
+
+	//the workers take tasks from this thread again once the other run is over
+	scheduler.Push(1, [&count](uint32) { ++count; });
+	scheduler.Run();
+	REQUIRE(count.load() == 9);
+}
@@ -0,0 +1,195 @@
+#include <catch.hpp>
+
+#include "../../../Engine/Math/Transform.hpp"
+#include "../../../Engine/Math/Batch.hpp"
+
+#include <thread>
+
+namespace
+{
+	//odd counts so the scalar tail after the SIMD loop is covered, the large count is split into parallel ranges
+	const size_t testCounts[] = { 0, 3, 1023, 100003 };
+
+	//runs every range on its own thread, enough to check the batches are split and merged correctly
+	class ThreadExecutor final : public etm::batch_executor
+	{
+	public:
+		size_t concurrency() const override { return 4; }
+		void execute(const size_t numRanges, const std::function<void(size_t rangeIdx)> &run) override
+		{
+			std::vector<std::thread> threads;
+			for (size_t rangeIdx = 0; rangeIdx < numRanges; ++rangeIdx)
+			{
+				threads.emplace_back(run, rangeIdx);
+			}
+			for (std::thread &thread : threads)
+			{
+				thread.join();
+			}
+		}
+	};
+	ThreadExecutor threadExecutor;
+	etm::batch_executor* const testExecutors[] = { nullptr, &threadExecutor };
+
+	std::vector<vec3> GenerateVectors(size_t count)
+	{
+		std::vector<vec3> ret;
+		for (size_t i = 0; i < count; ++i)
+		{
+			float f = static_cast<float>(i);
+			ret.push_back(vec3(sinf(f) * 10.f + 0.5f, cosf(f * 0.7f) * 3.f - 1.f, f * 0.01f + 1.f));
+		}
+		return ret;
+	}
+
+	//the streams reach magnitudes in the thousands, and the compiler is free to contract the scalar reference into fused multiply adds,
+	//so results are compared relative to the size of the expected value
+	const float relativeEpsilon = 0.00001f;
+	bool NearEqualsRelative(float result, float expected)
+	{
+		return etm::nearEquals(result, expected, relativeEpsilon * std::max(std::abs(expected), 1.f));
+	}
+	template <uint8 n>
+	bool NearEqualsRelative(const etm::vector<n, float> &result, const etm::vector<n, float> &expected)
+	{
+		return etm::nearEqualsV(result, expected, relativeEpsilon * std::max(etm::length(expected), 1.f));
+	}
+
+	mat4 GetTestMatrix()
+	{
+		return etm::scale(vec3(2.f, 0.5f, 1.f)) * etm::rotate(etm::normalize(vec3(1, 2, 3)), 0.7f) * etm::translate(vec3(4.f, -2.f, 9.f));
+	}
+}
+
+TEST_CASE("soa", "[batch]")
+{
+	std::vector<vec3> vectors = GenerateVectors(7);
+	vec3soa stream(vectors);
+	REQUIRE(stream.size() == 7);
+	for (size_t i = 0; i < vectors.size(); ++i)
+	{
+		REQUIRE(etm::nearEqualsV(stream.get(i), vectors[i]));
+		REQUIRE(stream[0][i] == vectors[i].x);
+		REQUIRE(stream[1][i] == vectors[i].y);
+		REQUIRE(stream[2][i] == vectors[i].z);
+	}
+}
+
+TEST_CASE("batch transform", "[batch]")
+{
+	mat4 mat = GetTestMatrix();
+	for (etm::batch_executor* executor : testExecutors)
+	{
+		for (size_t count : testCounts)
+		{
+			std::vector<vec3> vectors = GenerateVectors(count);
+			vec3soa stream(vectors);
+
+			vec3soa points, directions;
+			etm::transformPoints(mat, stream, points, executor);
+			etm::transformVectors(mat, stream, directions, executor);
+
+			vec4soa stream4(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				stream4.set(i, vec4(vectors[i], 0.5f));
+			}
+			vec4soa result4;
+			etm::transform(mat, stream4, result4, executor);
+
+			REQUIRE(points.size() == count);
+			REQUIRE(directions.size() == count);
+			REQUIRE(result4.size() == count);
+			bool matches = true;
+			for (size_t i = 0; i < count; ++i)
+			{
+				matches &= NearEqualsRelative(points.get(i), (mat * vec4(vectors[i], 1)).xyz);
+				matches &= NearEqualsRelative(directions.get(i), (mat * vec4(vectors[i], 0)).xyz);
+				matches &= NearEqualsRelative(result4.get(i), mat * vec4(vectors[i], 0.5f));
+			}
+			REQUIRE(matches);
+		}
+	}
+}
+
+TEST_CASE("batch normalize", "[batch]")
+{
+	for (etm::batch_executor* executor : testExecutors)
+	{
+		for (size_t count : testCounts)
+		{
+			std::vector<vec3> vectors = GenerateVectors(count);
+			vec3soa stream(vectors);
+			etm::normalize(stream, stream, executor); //in place
+
+			bool matches = true;
+			for (size_t i = 0; i < count; ++i)
+			{
+				matches &= NearEqualsRelative(stream.get(i), etm::normalize(vectors[i]));
+			}
+			REQUIRE(matches);
+		}
+	}
+}
+
+TEST_CASE("batch dot and length", "[batch]")
+{
+	for (etm::batch_executor* executor : testExecutors)
+	{
+		for (size_t count : testCounts)
+		{
+			std::vector<vec3> vectors = GenerateVectors(count);
+			vec3soa stream(vectors);
+			vec3soa other(GenerateVectors(count + 5));
+			other.resize(count);
+
+			std::vector<float> dots, lengths, lengthsSq;
+			etm::dot(stream, other, dots, executor);
+			etm::length(stream, lengths, executor);
+			etm::lengthSquared(stream, lengthsSq, executor);
+			REQUIRE(dots.size() == count);
+
+			bool matches = true;
+			for (size_t i = 0; i < count; ++i)
+			{
+				matches &= NearEqualsRelative(dots[i], etm::dot(vectors[i], other.get(i)));
+				matches &= NearEqualsRelative(lengths[i], etm::length(vectors[i]));
+				matches &= NearEqualsRelative(lengthsSq[i], etm::lengthSquared(vectors[i]));
+			}
+			REQUIRE(matches);
+		}
+	}
+}
+
+TEST_CASE("batch min max", "[batch]")
+{
+	for (etm::batch_executor* executor : testExecutors)
+	{
+		for (size_t count : testCounts)
+		{
+			std::vector<vec3> vectors = GenerateVectors(count);
+			vec3soa stream(vectors);
+
+			vec3 minVec, maxVec;
+			bool result = etm::minMax(stream, minVec, maxVec, executor);
+			REQUIRE(result == (count > 0));
+			if (count == 0)
+			{
+				continue;
+			}
+
+			vec3 expectedMin = vectors[0];
+			vec3 expectedMax = vectors[0];
+			for (const vec3 &vec : vectors)
+			{
+				for (uint8 c = 0; c < 3; ++c)
+				{
+					expectedMin[c] = std::min(expectedMin[c], vec[c]);
+					expectedMax[c] = std::max(expectedMax[c], vec[c]);
+				}
+			}
+			REQUIRE(etm::nearEqualsV(minVec, expectedMin));
+			REQUIRE(etm::nearEqualsV(maxVec, expectedMax));
+		}
+	}
+}
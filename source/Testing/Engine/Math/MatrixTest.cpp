@@ -231,4 +231,21 @@ TEST_CASE( "Specialized matrix functionality", "[matrix]" )
 
 		REQUIRE( etm::nearEquals( det, manualDet, 0.00001f ) );
 	}
-}
\ No newline at end of file
+}
+TEST_CASE("constexpr matrix", "[matrix]")
+{
+	using imat3 = etm::matrix<3, 3, int32>;
+	constexpr imat3 matA = {	1, 2, 3,
+								4, 5, 6,
+								7, 8, 9 };
+	constexpr imat3 identity;
+
+	static_assert((matA * identity).data[1][2] == 6, "constexpr identity product failed");
+	static_assert((matA * matA).data[0][0] == 30, "constexpr matrix product failed");
+	static_assert(etm::transpose(matA).data[0][2] == 7, "constexpr transpose failed");
+	static_assert((matA * ivec3(1, 0, 0))[1] == 2, "constexpr matrix vector product failed");
+
+	constexpr dmat4 scaled = dmat4() * 2.0;
+	static_assert(scaled.data[3][3] == 2.0 && scaled.data[3][0] == 0.0, "constexpr scalar product failed");
+	REQUIRE(etm::nearEqualsM(scaled, dmat4() + dmat4()));
+}
@@ -0,0 +1,108 @@
+#include <catch.hpp>
+
+#include "../../../Engine/Math/Transform.hpp"
+
+//The SIMD specializations for float are compared against the generic double precision implementation
+
+namespace
+{
+	dmat4 ToDouble(const mat4 &mat)
+	{
+		dmat4 ret;
+		for (uint8 row = 0; row < 4; ++row)
+		{
+			ret[row] = etm::vecCast<double>(mat[row]);
+		}
+		return ret;
+	}
+	mat4 ToFloat(const dmat4 &mat)
+	{
+		mat4 ret;
+		for (uint8 row = 0; row < 4; ++row)
+		{
+			ret[row] = etm::vecCast<float>(mat[row]);
+		}
+		return ret;
+	}
+}
+
+TEST_CASE("vec4 simd", "[simd]")
+{
+	vec4 a(5.3f, -1.2f, 3.0f, 2.3f);
+	vec4 b(-5.8f, 7.3f, 3.2f, 4.9f);
+	dvec4 da = etm::vecCast<double>(a);
+	dvec4 db = etm::vecCast<double>(b);
+
+	REQUIRE(etm::nearEqualsV(a + b, etm::vecCast<float>(da + db), 0.00001f));
+	REQUIRE(etm::nearEqualsV(a - b, etm::vecCast<float>(da - db), 0.00001f));
+	REQUIRE(etm::nearEqualsV(a * b, etm::vecCast<float>(da * db), 0.00001f));
+	REQUIRE(etm::nearEqualsV(a / b, etm::vecCast<float>(da / db), 0.00001f));
+	REQUIRE(etm::nearEqualsV(a * 2.5f, etm::vecCast<float>(da * 2.5), 0.00001f));
+	REQUIRE(etm::nearEqualsV(-a, vec4(-5.3f, 1.2f, -3.0f, -2.3f)));
+	REQUIRE(etm::nearEquals(etm::dot(a, b), static_cast<float>(etm::dot(da, db)), 0.00001f));
+}
+
+TEST_CASE("mat4 simd", "[simd]")
+{
+	mat4 a( {	5.3f, 1.2f, 3.0f, 0.f,
+				2.3f, 5.8f, 7.3f, 0.f,
+				3.2f, 4.9f, 6.3f, 0.f,
+				3.2f, 1.2f, 2.3f, 1.f } );
+	mat4 b = etm::rotate(etm::normalize(vec3(1, 2, 3)), 0.7f) * etm::translate(vec3(4.f, -2.f, 9.f));
+
+	SECTION("product")
+	{
+		REQUIRE(etm::nearEqualsM(a * b, ToFloat(ToDouble(a) * ToDouble(b)), 0.0001f));
+		REQUIRE(etm::nearEqualsM(a * mat4(), a));
+	}
+	SECTION("vector product")
+	{
+		vec4 v(1.5f, -2.f, 0.25f, 1.f);
+		REQUIRE(etm::nearEqualsV(a * v, etm::vecCast<float>(ToDouble(a) * etm::vecCast<double>(v)), 0.0001f));
+	}
+	SECTION("transpose")
+	{
+		mat4 t = etm::transpose(a);
+		for (uint8 row = 0; row < 4; ++row)
+		{
+			for (uint8 col = 0; col < 4; ++col)
+			{
+				REQUIRE(t[row][col] == a[col][row]);
+			}
+		}
+	}
+	SECTION("inverse")
+	{
+		REQUIRE(etm::nearEqualsM(etm::inverse(a), ToFloat(etm::inverse(ToDouble(a))), 0.00001f));
+		REQUIRE(etm::nearEqualsM(b * etm::inverse(b), mat4(), 0.00001f));
+	}
+	SECTION("look at")
+	{
+		vec3 pos(3.f, 1.f, -5.f);
+		vec3 target(0.5f, 2.f, 7.f);
+		dmat4 expected = etm::lookAt(etm::vecCast<double>(pos), etm::vecCast<double>(target), dvec3(0, 1, 0));
+		REQUIRE(etm::nearEqualsM(etm::lookAt(pos, target, vec3::UP), ToFloat(expected), 0.00001f));
+	}
+}
+
+TEST_CASE("quat simd", "[simd]")
+{
+	quat q1(etm::normalize(vec3(0.3f, 1.f, -0.2f)), 1.1f);
+	quat q2(etm::normalize(vec3(-1.f, 0.5f, 0.5f)), -0.4f);
+	quatd dq1(q1.x, q1.y, q1.z, q1.w);
+	quatd dq2(q2.x, q2.y, q2.z, q2.w);
+
+	SECTION("product")
+	{
+		quat q = q1 * q2;
+		quatd dq = dq1 * dq2;
+		REQUIRE(etm::nearEqualsV(q.v4, etm::vecCast<float>(dq.v4), 0.00001f));
+	}
+	SECTION("rotate")
+	{
+		vec3 v(2.f, -3.f, 0.5f);
+		vec3 rotated = q1 * v;
+		REQUIRE(etm::nearEqualsV(rotated, etm::vecCast<float>(dq1 * etm::vecCast<double>(v)), 0.00001f));
+		REQUIRE(etm::nearEqualsV(etm::inverse(q1) * rotated, v, 0.0001f));
+	}
+}
@@ -578,4 +578,24 @@ TEST_CASE("vector math", "[vector]")
 		REQUIRE(etm::nearEquals(etm::length(etm::normalize(vecC)), 1.f));
 	}
 	//angles already tested by extension of specific vec 3 solution
-}
\ No newline at end of file
+}
+TEST_CASE("constexpr vector", "[vector]")
+{
+	constexpr vec3 vecA(1.f, 2.f, 3.f);
+	constexpr vec3 vecB = { 4.f, -5.f, 6.f };
+
+	static_assert(vecA[1] == 2.f, "constexpr element access failed");
+	static_assert(etm::dot(vecA, vecB) == 12.f, "constexpr dot product failed");
+	static_assert((vecA + vecB)[2] == 9.f, "constexpr addition failed");
+	static_assert((-vecA)[0] == -1.f, "constexpr negation failed");
+
+	constexpr vec3 crossed = etm::cross(vecA, vecB);
+	static_assert(crossed[0] == 27.f && crossed[1] == 6.f && crossed[2] == -13.f, "constexpr cross product failed");
+	REQUIRE(etm::nearEqualsV(crossed, vec3(27.f, 6.f, -13.f)));
+
+	constexpr ivec4 ivecA(ivec2(1, 2), 3, 4);
+	constexpr etm::vector<5, int32> vec5 = { 1, 2, 3, 4, 5 };
+	static_assert(etm::dot(ivecA, ivecA) == 30, "constexpr vec4 dot product failed");
+	static_assert(etm::dot(vec5, vec5 * 2) == 110, "constexpr generic dot product failed");
+	REQUIRE(ivecA.z == 3);
+}
@@ -0,0 +1,312 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/PlanetTech/AtmosphereModel.hpp"
+
+namespace
+{
+	//the earth from the reference implementation of the model, in kilometers
+	AtmosphereParameters GetEarthParameters()
+	{
+		AtmosphereParameters params;
+		params.solarIrradiance = vec3(1.474f, 1.8504f, 1.91198f);
+		params.sun_angular_radius = 0.004675f;
+		params.bottom_radius = 6360.f;
+		params.top_radius = 6420.f;
+		params.rayleigh_density = DensityProfile({ DensityProfileLayer(0.0, 1.0, -1.0 / 8.0, 0.0, 0.0) }, 1.f);
+		params.rayleighScattering = vec3(0.005802f, 0.013558f, 0.0331f);
+		params.mie_density = DensityProfile({ DensityProfileLayer(0.0, 1.0, -1.0 / 1.2, 0.0, 0.0) }, 1.f);
+		params.mieScattering = vec3(0.003996f);
+		params.mieExtinction = vec3(0.00444f);
+		params.mie_phase_function_g = 0.8f;
+		//ozone rising from 10 to 25 kilometers and falling off again at 40
+		params.absorption_density = DensityProfile({ DensityProfileLayer(25.0, 0.0, 0.0, 1.0 / 15.0, -2.0 / 3.0),
+			DensityProfileLayer(0.0, 0.0, 0.0, -1.0 / 15.0, 8.0 / 3.0) }, 1.f);
+		params.absorptionExtinction = vec3(0.00065f, 0.001881f, 0.000085f);
+		params.groundAlbedo = vec3(0.1f);
+		params.mu_s_min = cosf(etm::radians(102.f));
+		return params;
+	}
+
+	//small tables keep the tests fast
+	AtmosphereSettings GetSmallSettings()
+	{
+		AtmosphereSettings settings;
+		settings.TRANSMITTANCE_W = 32;
+		settings.TRANSMITTANCE_H = 8;
+		settings.IRRADIANCE_W = 16;
+		settings.IRRADIANCE_H = 4;
+		settings.INSCATTER_R = 4;
+		settings.INSCATTER_MU = 16;
+		settings.INSCATTER_MU_S = 8;
+		settings.INSCATTER_NU = 4;
+		return settings;
+	}
+
+	bool IsSameTable(const std::vector<vec4> &lhs, const std::vector<vec4> &rhs)
+	{
+		if (lhs.size() != rhs.size()) return false;
+		for (size_t i = 0; i < lhs.size(); ++i)
+		{
+			if (lhs[i].x != rhs[i].x || lhs[i].y != rhs[i].y || lhs[i].z != rhs[i].z || lhs[i].w != rhs[i].w) return false;
+		}
+		return true;
+	}
+}
+
+TEST_CASE("atmosphere transmittance", "[atmosphere]")
+{
+	AtmosphereParameters params = GetEarthParameters();
+	AtmosphereModel model(params, GetSmallSettings());
+
+	//straight up every profile integrates in closed form
+	float height = params.top_radius - params.bottom_radius;
+	float rayleighLength = 8.f * (1.f - expf(-height / 8.f));
+	float mieLength = 1.2f * (1.f - expf(-height / 1.2f));
+	float ozoneLength = 15.f;
+	vec3 transmittance = model.ComputeTransmittanceToTopAtmosphereBoundary(params.bottom_radius, 1.f);
+	for (uint8 channel = 0; channel < 3; ++channel)
+	{
+		float opticalDepth = params.rayleighScattering[channel] * rayleighLength + params.mieExtinction[channel] * mieLength
+			+ params.absorptionExtinction[channel] * ozoneLength;
+		REQUIRE(-logf(transmittance[channel]) == Approx(opticalDepth).epsilon(0.001));
+	}
+
+	//nothing is in the way at the top looking up, and more is towards the horizon
+	vec3 top = model.ComputeTransmittanceToTopAtmosphereBoundary(params.top_radius, 1.f);
+	vec3 horizon = model.ComputeTransmittanceToTopAtmosphereBoundary(params.bottom_radius, 0.f);
+	for (uint8 channel = 0; channel < 3; ++channel)
+	{
+		REQUIRE(top[channel] == Approx(1.f));
+		REQUIRE(horizon[channel] < transmittance[channel]);
+	}
+	//blue light is scattered the most
+	REQUIRE(horizon.z < horizon.x);
+
+	//the table holds the integrated values at its texel centers, the ground looking up is the first one
+	model.Precalculate();
+	vec3 lookedUp = model.GetTransmittanceToTopAtmosphereBoundary(params.bottom_radius, 1.f);
+	for (uint8 channel = 0; channel < 3; ++channel)
+	{
+		REQUIRE(lookedUp[channel] == Approx(transmittance[channel]).epsilon(0.0001));
+	}
+}
+
+TEST_CASE("atmosphere transmittance queries", "[atmosphere]")
+{
+	AtmosphereParameters params = GetEarthParameters();
+	AtmosphereSettings settings = GetSmallSettings();
+	settings.TRANSMITTANCE_W = 128;
+	settings.TRANSMITTANCE_H = 32;
+	settings.SCATTERING_ORDERS = 1;
+	AtmosphereModel model(params, settings);
+	model.Precalculate();
+	const AtmosphereTables &tables = model.GetTables();
+
+	//at texel centers the look up returns exactly what the GPU texture holds, r and mu computed like the precomputation shader does
+	float H = sqrtf(params.top_radius * params.top_radius - params.bottom_radius * params.bottom_radius);
+	for (int32 y = 0; y < tables.transmittanceSize.y; y += 5)
+	{
+		for (int32 x = 0; x < tables.transmittanceSize.x; x += 7)
+		{
+			float rho = H * (float)y / (float)(tables.transmittanceSize.y - 1);
+			float r = sqrtf(rho * rho + params.bottom_radius * params.bottom_radius);
+			float dMin = params.top_radius - r;
+			float d = dMin + (float)x / (float)(tables.transmittanceSize.x - 1) * (rho + H - dMin);
+			float mu = d == 0.f ? 1.f : etm::Clamp((H * H - rho * rho - d * d) / (2.f * r * d), 1.f, -1.f);
+
+			const vec4 &texel = tables.transmittance[y * tables.transmittanceSize.x + x];
+			vec3 lookedUp = tables.GetTransmittanceToTopAtmosphereBoundary(params, r, mu);
+			for (uint8 channel = 0; channel < 3; ++channel)
+			{
+				REQUIRE(lookedUp[channel] == Approx(texel[channel]).epsilon(0.001));
+			}
+		}
+	}
+
+	//in between texels filtering stays close to the integrated value above the horizon
+	for (float altitude : { 0.f, 1.f, 7.5f, 30.f, 59.f })
+	{
+		for (float mu : { 0.15f, 0.4f, 0.77f, 1.f })
+		{
+			float r = params.bottom_radius + altitude;
+			vec3 lookedUp = tables.GetTransmittanceToTopAtmosphereBoundary(params, r, mu);
+			vec3 integrated = model.ComputeTransmittanceToTopAtmosphereBoundary(r, mu);
+			for (uint8 channel = 0; channel < 3; ++channel)
+			{
+				REQUIRE(lookedUp[channel] == Approx(integrated[channel]).epsilon(0.01));
+			}
+		}
+	}
+
+	SECTION("space")
+	{
+		//rays that miss the atmosphere keep all light, the others lose as much as if they started where they enter it
+		float r = params.top_radius * 2.f;
+		REQUIRE(tables.GetTransmittanceToSpace(params, r, 0.5f) == vec3(1.f));
+		REQUIRE(tables.GetTransmittanceToSpace(params, r, -0.5f) == vec3(1.f));
+		float mu = -0.95f;
+		float distanceToTop = -r * mu - sqrtf(r * r * (mu * mu - 1.f) + params.top_radius * params.top_radius);
+		float muTop = (r * mu + distanceToTop) / params.top_radius;
+		REQUIRE(tables.GetTransmittanceToSpace(params, r, mu) == tables.GetTransmittanceToTopAtmosphereBoundary(params, params.top_radius, muTop));
+		REQUIRE(tables.GetTransmittanceToSpace(params, params.bottom_radius + 2.f, 0.5f)
+			== tables.GetTransmittanceToTopAtmosphereBoundary(params, params.bottom_radius + 2.f, 0.5f));
+	}
+	SECTION("sun irradiance")
+	{
+		vec3 up(0.f, 1.f, 0.f);
+		vec3 ground = up * params.bottom_radius;
+		REQUIRE(tables.GetSunIrradiance(params, ground, up) == params.solarIrradiance * tables.GetTransmittanceToTopAtmosphereBoundary(params, params.bottom_radius, 1.f));
+		//the sun is below the horizon
+		REQUIRE(tables.GetSunIrradiance(params, ground, etm::normalize(vec3(0.f, -0.2f, 1.f))) == vec3(0.f));
+		//in space on the day side nothing is in the way
+		REQUIRE(tables.GetSunIrradiance(params, up * params.top_radius * 2.f, up) == params.solarIrradiance);
+		//and on the night side the planet is
+		REQUIRE(tables.GetSunIrradiance(params, -up * params.top_radius * 2.f, up) == vec3(0.f));
+
+		//lower suns are redder
+		vec3 noon = tables.GetSunIrradiance(params, ground, up);
+		vec3 evening = tables.GetSunIrradiance(params, ground, etm::normalize(vec3(0.f, 0.1f, 1.f)));
+		REQUIRE(evening.z / evening.x < noon.z / noon.x);
+
+		//many positions at once give the same values
+		std::vector<vec3> positions;
+		for (float altitude : { -1.f, 0.f, 3.f, 20.f, 100.f, 5000.f })
+		{
+			for (float angle : { 0.f, 45.f, 85.f, 90.f, 95.f, 180.f })
+			{
+				float theta = etm::radians(angle);
+				positions.push_back(vec3(0.f, cosf(theta), sinf(theta)) * (params.bottom_radius + altitude));
+			}
+		}
+		etm::soa<3, float> irradiance;
+		tables.GetSunIrradiance(params, etm::soa<3, float>(positions), up, irradiance);
+		REQUIRE(irradiance.size() == positions.size());
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			vec3 single = tables.GetSunIrradiance(params, positions[i], up);
+			for (uint8 channel = 0; channel < 3; ++channel)
+			{
+				REQUIRE(irradiance.get(i)[channel] == Approx(single[channel]));
+			}
+		}
+	}
+}
+
+TEST_CASE("atmosphere tables", "[atmosphere]")
+{
+	AtmosphereParameters params = GetEarthParameters();
+	AtmosphereSettings settings = GetSmallSettings();
+
+	settings.SCATTERING_ORDERS = 1;
+	AtmosphereModel singleModel(params, settings);
+	singleModel.Precalculate();
+	const AtmosphereTables &single = singleModel.GetTables();
+
+	settings.SCATTERING_ORDERS = 4;
+	AtmosphereModel multipleModel(params, settings);
+	multipleModel.Precalculate(4);
+	const AtmosphereTables &multiple = multipleModel.GetTables();
+
+	REQUIRE(multiple.scatteringSize == ivec3(settings.INSCATTER_NU * settings.INSCATTER_MU_S, settings.INSCATTER_MU, settings.INSCATTER_R));
+	REQUIRE(multiple.scattering.size() == (size_t)(multiple.scatteringSize.x * multiple.scatteringSize.y * multiple.scatteringSize.z));
+
+	SECTION("orders of scattering")
+	{
+		//only light scattered at least twice reaches the ground indirectly
+		bool isLit = false;
+		for (size_t texel = 0; texel < multiple.irradiance.size(); ++texel)
+		{
+			REQUIRE(single.irradiance[texel] == vec4(0.f));
+			for (uint8 channel = 0; channel < 3; ++channel)
+			{
+				REQUIRE(std::isfinite(multiple.irradiance[texel][channel]));
+				REQUIRE(multiple.irradiance[texel][channel] >= 0.f);
+				isLit |= multiple.irradiance[texel][channel] > 0.f;
+			}
+		}
+		REQUIRE(isLit);
+
+		//more orders only add light, the single mie scattering stays the same
+		for (size_t texel = 0; texel < multiple.scattering.size(); ++texel)
+		{
+			for (uint8 channel = 0; channel < 3; ++channel)
+			{
+				REQUIRE(std::isfinite(multiple.scattering[texel][channel]));
+				REQUIRE(single.scattering[texel][channel] >= 0.f);
+				REQUIRE(multiple.scattering[texel][channel] >= single.scattering[texel][channel]);
+			}
+			REQUIRE(multiple.scattering[texel].w == single.scattering[texel].w);
+		}
+	}
+	SECTION("blue sky")
+	{
+		//looking straight up from the ground with the sun overhead, the last row of the first layer and the last muS of every nu
+		const ivec3 &size = multiple.scatteringSize;
+		int32 y = size.y - 1;
+		for (int32 nu = 0; nu < settings.INSCATTER_NU; ++nu)
+		{
+			const vec4 &scattering = multiple.scattering[y * size.x + nu * settings.INSCATTER_MU_S + settings.INSCATTER_MU_S - 1];
+			REQUIRE(scattering.z > scattering.y);
+			REQUIRE(scattering.y > scattering.x);
+		}
+	}
+	SECTION("threads")
+	{
+		//every texel is computed on its own, so the worker count doesn't change the result
+		AtmosphereModel serialModel(params, settings);
+		serialModel.Precalculate(1);
+		REQUIRE(IsSameTable(serialModel.GetTables().transmittance, multiple.transmittance));
+		REQUIRE(IsSameTable(serialModel.GetTables().irradiance, multiple.irradiance));
+		REQUIRE(IsSameTable(serialModel.GetTables().scattering, multiple.scattering));
+	}
+}
+
+TEST_CASE("atmosphere cache", "[atmosphere]")
+{
+	AtmosphereParameters params = GetEarthParameters();
+	AtmosphereSettings settings = GetSmallSettings();
+	uint32 hash = AtmosphereTables::GetHash(params, settings);
+	REQUIRE(AtmosphereTables::GetHash(GetEarthParameters(), GetSmallSettings()) == hash);
+
+	//anything the tables depend on changes the hash
+	AtmosphereParameters otherParams = params;
+	otherParams.mie_phase_function_g = 0.7f;
+	REQUIRE(AtmosphereTables::GetHash(otherParams, settings) != hash);
+	otherParams = params;
+	otherParams.absorption_density.layers[1].constant_term *= 2.f;
+	REQUIRE(AtmosphereTables::GetHash(otherParams, settings) != hash);
+	AtmosphereSettings otherSettings = settings;
+	otherSettings.INSCATTER_R *= 2;
+	REQUIRE(AtmosphereTables::GetHash(params, otherSettings) != hash);
+	otherSettings = settings;
+	otherSettings.SCATTERING_ORDERS = 2;
+	REQUIRE(AtmosphereTables::GetHash(params, otherSettings) != hash);
+
+	REQUIRE(AtmosphereTables::GetCacheFileName("Resources/atmo_earth.json") == "Resources/atmo_earth.atmocache");
+
+	AtmosphereModel model(params, settings);
+	model.Precalculate();
+	std::vector<uint8> data = model.GetTables().Serialize(hash);
+
+	AtmosphereTables loaded;
+	REQUIRE(loaded.Deserialize(data.data(), data.size(), hash));
+	REQUIRE(loaded.transmittanceSize == model.GetTables().transmittanceSize);
+	REQUIRE(loaded.irradianceSize == model.GetTables().irradianceSize);
+	REQUIRE(loaded.scatteringSize == model.GetTables().scatteringSize);
+	REQUIRE(IsSameTable(loaded.transmittance, model.GetTables().transmittance));
+	REQUIRE(IsSameTable(loaded.irradiance, model.GetTables().irradiance));
+	REQUIRE(IsSameTable(loaded.scattering, model.GetTables().scattering));
+
+	SECTION("stale or broken data")
+	{
+		AtmosphereTables other;
+		REQUIRE_FALSE(other.Deserialize(data.data(), data.size(), hash + 1));
+		REQUIRE_FALSE(other.Deserialize(data.data(), data.size() - 1, hash));
+		REQUIRE_FALSE(other.Deserialize(data.data(), 16, hash));
+		std::vector<uint8> wrongMagic = data;
+		wrongMagic[0] = 'X';
+		REQUIRE_FALSE(other.Deserialize(wrongMagic.data(), wrongMagic.size(), hash));
+		REQUIRE(other.transmittance.empty());
+	}
+}
@@ -0,0 +1,101 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/PlanetTech/HeightBounds.hpp"
+
+namespace
+{
+	const int32 width = 200;
+	const int32 height = 99;
+
+	//deterministic bumpy terrain
+	std::vector<float> GetHeightMap()
+	{
+		std::vector<float> heights(width * height);
+		uint32 seed = 12345;
+		for (float &value : heights)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			value = (seed >> 8) / (float)(1 << 24);
+		}
+		return heights;
+	}
+
+	//what linear filtering with a repeating texture returns, like the patch shader
+	float SampleHeight(const std::vector<float> &heights, const vec3 &direction)
+	{
+		vec3 dir = etm::normalize(direction);
+		float u = atan2f(dir.z, dir.x) / (etm::PI * 2);
+		float v = acosf(etm::Clamp(dir.y, 1.f, -1.f)) / etm::PI;
+		float x = u * width - 0.5f;
+		float y = v * height - 0.5f;
+		int32 x0 = (int32)floorf(x);
+		int32 y0 = (int32)floorf(y);
+		float fx = x - x0;
+		float fy = y - y0;
+		auto texel = [&heights](int32 tx, int32 ty)
+		{
+			tx = ((tx % width) + width) % width;
+			ty = ((ty % height) + height) % height;
+			return heights[ty * width + tx];
+		};
+		float top = texel(x0, y0) * (1 - fx) + texel(x0 + 1, y0) * fx;
+		float bottom = texel(x0, y0 + 1) * (1 - fx) + texel(x0 + 1, y0 + 1) * fx;
+		return top * (1 - fy) + bottom * fy;
+	}
+}
+
+TEST_CASE("pyramid", "[height bounds]")
+{
+	std::vector<float> heights = GetHeightMap();
+	HeightBounds bounds(heights, width, height);
+	//200x99 down to 1x1
+	REQUIRE(bounds.GetLevelCount() == 9);
+
+	//the whole sphere has the range of the entire map
+	float minHeight, maxHeight;
+	bounds.GetCapBounds(vec3(0, 1, 0), etm::PI, minHeight, maxHeight);
+	REQUIRE(minHeight == *std::min_element(heights.begin(), heights.end()));
+	REQUIRE(maxHeight == *std::max_element(heights.begin(), heights.end()));
+}
+
+TEST_CASE("triangle bounds", "[height bounds]")
+{
+	std::vector<float> heights = GetHeightMap();
+	HeightBounds bounds(heights, width, height);
+
+	uint32 seed = 777;
+	auto random = [&seed]()
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return (seed >> 8) / (float)(1 << 24);
+	};
+
+	//triangles of every size all over the sphere, including the poles and the seam of the map
+	for (uint32 triangle = 0; triangle < 2000; ++triangle)
+	{
+		vec3 center = etm::normalize(vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f));
+		if (triangle % 10 == 0) center = etm::normalize(vec3(random() * 0.02f, triangle % 20 ? 1.f : -1.f, random() * 0.02f));
+		if (triangle % 10 == 1) center = etm::normalize(vec3(-1.f, random() - 0.5f, (random() - 0.5f) * 0.01f));
+		float size = powf(0.5f, random() * 12.f);
+		vec3 a = etm::normalize(center + etm::normalize(vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f)) * size);
+		vec3 b = etm::normalize(center + etm::normalize(vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f)) * size);
+		vec3 c = etm::normalize(center + etm::normalize(vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f)) * size);
+
+		float minHeight, maxHeight;
+		bounds.GetTriangleBounds(a, b, c, minHeight, maxHeight);
+		for (uint32 sample = 0; sample < 50; ++sample)
+		{
+			float s = random();
+			float t = random();
+			if (s + t > 1)
+			{
+				s = 1 - s;
+				t = 1 - t;
+			}
+			float value = SampleHeight(heights, a + (b - a) * s + (c - a) * t);
+			REQUIRE(value >= minHeight);
+			REQUIRE(value <= maxHeight);
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+
+#include "../../../Engine/PlanetTech/PatchInstance.hpp"
+#include "../../../Engine/Math/Geometry.hpp"
+
+namespace
+{
+	const float radius = 1737.1f;
+
+	//the instance layout patches had before they were quantized, the corner and the two edges as full floats
+	struct FullPatchInstance
+	{
+		int32 level;
+		vec3 a;
+		vec3 r;
+		vec3 s;
+	};
+
+	//the subdivision as the triangulator did it before instances were encoded
+	struct ReferenceTri
+	{
+		vec3 a, b, c;
+		int32 level;
+	};
+	ReferenceTri GetReferenceChild(const ReferenceTri &tri, uint32 child)
+	{
+		vec3 A = tri.b + ((tri.c - tri.b)*0.5f);
+		vec3 B = tri.c + ((tri.a - tri.c)*0.5f);
+		vec3 C = tri.a + ((tri.b - tri.a)*0.5f);
+		A = A * radius / etm::length(A);
+		B = B * radius / etm::length(B);
+		C = C * radius / etm::length(C);
+		switch (child)
+		{
+		case 0: return ReferenceTri{ tri.a, B, C, tri.level + 1 };
+		case 1: return ReferenceTri{ A, tri.b, C, tri.level + 1 };
+		case 2: return ReferenceTri{ A, B, tri.c, tri.level + 1 };
+		default: return ReferenceTri{ A, B, C, tri.level + 1 };
+		}
+	}
+
+	bool IsExactlyEqual(const vec3 &lhs, const vec3 &rhs)
+	{
+		return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+	}
+
+	//decodes into the old layout and compares it bit for bit, then encodes the old layout again
+	bool IsRoundTrip(const PatchDecoder &decoder, const PatchInstance &instance, const ReferenceTri &reference)
+	{
+		FullPatchInstance full{ reference.level, reference.a, reference.b - reference.a, reference.c - reference.a };
+
+		vec3 a, b, c;
+		decoder.Decode(instance, a, b, c);
+		FullPatchInstance decoded{ instance.GetLevel(), a, b - a, c - a };
+		if (decoded.level != full.level || !IsExactlyEqual(decoded.a, full.a) || !IsExactlyEqual(decoded.r, full.r) || !IsExactlyEqual(decoded.s, full.s))
+		{
+			return false;
+		}
+
+		PatchInstance encoded;
+		return decoder.Encode(full.level, full.a, full.r, full.s, encoded) && encoded == instance;
+	}
+}
+
+TEST_CASE("layout", "[patch instance]")
+{
+	REQUIRE(sizeof(PatchInstance) == 8);
+
+	PatchInstance instance(13);
+	std::vector<uint32> children;
+	for (int32 level = 1; level <= PatchInstance::MAX_LEVEL; ++level)
+	{
+		children.push_back((uint32)(level * 7 + 3) % 4);
+		instance = instance.GetChildInstance(children.back());
+		REQUIRE(instance.GetLevel() == level);
+	}
+	REQUIRE(instance.GetFace() == 13);
+	for (int32 level = 1; level <= PatchInstance::MAX_LEVEL; ++level)
+	{
+		REQUIRE(instance.GetChild(level) == children[level - 1]);
+	}
+}
+
+TEST_CASE("round trip", "[patch instance]")
+{
+	PatchDecoder decoder(radius);
+	auto ico = GetIcosahedronPositions(radius);
+	auto indices = GetIcosahedronIndices();
+
+	SECTION("every triangle of the first levels")
+	{
+		std::vector<std::pair<PatchInstance, ReferenceTri>> tris;
+		for (uint32 face = 0; face < 20; ++face)
+		{
+			tris.push_back(std::make_pair(PatchInstance(face), ReferenceTri{ ico[indices[face * 3]], ico[indices[face * 3 + 1]], ico[indices[face * 3 + 2]], 0 }));
+		}
+		for (size_t i = 0; i < tris.size(); ++i)
+		{
+			std::pair<PatchInstance, ReferenceTri> tri = tris[i];
+			REQUIRE(IsRoundTrip(decoder, tri.first, tri.second));
+			if (tri.second.level == 4) continue;
+			for (uint32 child = 0; child < 4; ++child)
+			{
+				tris.push_back(std::make_pair(tri.first.GetChildInstance(child), GetReferenceChild(tri.second, child)));
+			}
+		}
+	}
+	SECTION("random paths down to the deepest level the triangulator generates")
+	{
+		//further down the corners are so close that neighbouring triangles round to the same floats
+		const int32 maxLevel = 22;
+		std::mt19937 random(1234);
+		for (uint32 path = 0; path < 200; ++path)
+		{
+			uint32 face = random() % 20;
+			PatchInstance instance(face);
+			ReferenceTri tri{ ico[indices[face * 3]], ico[indices[face * 3 + 1]], ico[indices[face * 3 + 2]], 0 };
+			for (int32 level = 1; level <= maxLevel; ++level)
+			{
+				uint32 child = random() % 4;
+				instance = instance.GetChildInstance(child);
+				tri = GetReferenceChild(tri, child);
+				REQUIRE(IsRoundTrip(decoder, instance, tri));
+			}
+		}
+	}
+	SECTION("corners that aren't a triangle of the subdivision")
+	{
+		PatchInstance instance(3);
+		instance = instance.GetChildInstance(2).GetChildInstance(1);
+		vec3 a, b, c;
+		decoder.Decode(instance, a, b, c);
+		PatchInstance encoded;
+		REQUIRE(decoder.Encode(2, a, b - a, c - a, encoded));
+		REQUIRE(encoded == instance);
+		REQUIRE_FALSE(decoder.Encode(2, a * 1.001f, b - a, c - a, encoded));
+		REQUIRE_FALSE(decoder.Encode(3, a, b - a, c - a, encoded));
+	}
+}
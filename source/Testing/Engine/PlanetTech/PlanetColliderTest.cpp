@@ -0,0 +1,171 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+
+#include <btBulletDynamicsCommon.h>
+#include "../../../Engine/Physics/BulletETM.h"
+#include "../../../Engine/PlanetTech/PlanetSurface.hpp"
+#include "../../../Engine/PlanetTech/PlanetCollider.hpp"
+
+namespace
+{
+	const float radius = 1737.1f;
+	const float maxHeight = 10.7f;
+	const int32 width = 512;
+	const int32 height = 256;
+	const float bodyRadius = 0.5f;
+
+	std::vector<float> GetHeightMap()
+	{
+		std::vector<float> heights(width * height);
+		for (int32 y = 0; y < height; ++y)
+		{
+			for (int32 x = 0; x < width; ++x)
+			{
+				heights[y * width + x] = 0.3f + 0.1f * sinf(x * 0.3f) * cosf(y * 0.2f);
+			}
+		}
+		return heights;
+	}
+
+	//a bullet world without gravity of its own, the collider pulls bodies towards the planet
+	struct TestWorld
+	{
+		TestWorld()
+		{
+			pWorld = new btDiscreteDynamicsWorld(&dispatcher, &broadphase, &solver, &configuration);
+			pWorld->setGravity(btVector3(0, 0, 0));
+		}
+		~TestWorld()
+		{
+			for (btRigidBody* pBody : bodies)
+			{
+				pWorld->removeRigidBody(pBody);
+				delete pBody->getMotionState();
+				delete pBody;
+			}
+			delete pWorld;
+		}
+
+		btRigidBody* AddBody(const btVector3 &position)
+		{
+			btVector3 inertia;
+			sphere.calculateLocalInertia(1.f, inertia);
+			btDefaultMotionState* pMotionState = new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), position));
+			btRigidBody* pBody = new btRigidBody(btRigidBody::btRigidBodyConstructionInfo(1.f, pMotionState, &sphere, inertia));
+			pWorld->addRigidBody(pBody);
+			bodies.push_back(pBody);
+			return pBody;
+		}
+
+		btDefaultCollisionConfiguration configuration;
+		btCollisionDispatcher dispatcher = btCollisionDispatcher(&configuration);
+		btDbvtBroadphase broadphase;
+		btSequentialImpulseConstraintSolver solver;
+		btDiscreteDynamicsWorld* pWorld = nullptr;
+		btSphereShape sphere = btSphereShape(bodyRadius);
+		std::vector<btRigidBody*> bodies;
+	};
+}
+
+TEST_CASE("dropping bodies", "[planet collider]")
+{
+	PlanetSurface surface(GetHeightMap(), width, height, radius, maxHeight);
+	TestWorld world;
+	PlanetCollider collider(&surface, world.pWorld);
+	collider.SetGravity(1.62f);
+
+	//somewhere off the origin, so tiles have to follow the planets transform
+	btTransform planet(btQuaternion(btVector3(1, 2, 3).normalized(), 0.7f), btVector3(100.f, -50.f, 20.f));
+	collider.SetTransform(ToEtmVec3(planet.getOrigin()), ToEtmQuat(planet.getRotation()));
+
+	//a thousand bodies all over the planet, a little above the ground
+	std::mt19937 random(3);
+	std::normal_distribution<float> distribution;
+	std::vector<vec3> directions;
+	for (uint32 i = 0; i < 1000; ++i)
+	{
+		vec3 direction = etm::normalize(vec3(distribution(random), distribution(random), distribution(random)));
+		directions.push_back(direction);
+		float altitude = radius + surface.SampleHeight(direction) + bodyRadius + 2.f;
+		world.AddBody(planet * ToBtVec3(direction * altitude));
+	}
+
+	size_t maxActiveTiles = 0;
+	for (uint32 step = 0; step < 240; ++step)
+	{
+		collider.Update();
+		maxActiveTiles = std::max(maxActiveTiles, collider.GetActiveTileCount());
+		world.pWorld->stepSimulation(1.f / 60.f, 0);
+	}
+
+	for (size_t i = 0; i < world.bodies.size(); ++i)
+	{
+		vec3 position = ToEtmVec3(planet.invXform(world.bodies[i]->getWorldTransform().getOrigin()));
+		float altitude = etm::length(position) - radius - surface.SampleHeight(position);
+		//resting on the terrain instead of falling through or floating
+		REQUIRE(altitude > 0.f);
+		REQUIRE(altitude < bodyRadius * 2.f);
+		//and close to where it was dropped, the hills are gentle
+		REQUIRE(etm::dot(etm::normalize(position), directions[i]) > 0.9999f);
+	}
+
+	//a few tiles around every body, out of the tens of thousands the planet has
+	size_t planetTiles = 20;
+	for (int32 level = 0; level < collider.GetTileLevel(); ++level) planetTiles *= 4;
+	REQUIRE(maxActiveTiles <= world.bodies.size() * 6);
+	REQUIRE(collider.GetTileCount() * 10 < planetTiles);
+}
+
+TEST_CASE("streaming tiles", "[planet collider]")
+{
+	PlanetSurface surface(GetHeightMap(), width, height, radius, maxHeight);
+	TestWorld world;
+	PlanetCollider collider(&surface, world.pWorld);
+
+	vec3 direction = etm::normalize(vec3(0.3f, 0.8f, -0.2f));
+	float ground = radius + surface.SampleHeight(direction);
+	btRigidBody* pBody = world.AddBody(ToBtVec3(direction * (ground + 1.f)));
+
+	SECTION("following a body")
+	{
+		collider.Update();
+		size_t activeTiles = collider.GetActiveTileCount();
+		REQUIRE(activeTiles > 0);
+		REQUIRE(activeTiles <= 6);
+		REQUIRE(collider.GetCachedTileCount() == 0);
+
+		//moving to the other side of the planet leaves the old tiles cached
+		pBody->setWorldTransform(btTransform(btQuaternion::getIdentity(), ToBtVec3(-direction * (radius + surface.SampleHeight(-direction) + 1.f))));
+		collider.Update();
+		REQUIRE(collider.GetActiveTileCount() > 0);
+		REQUIRE(collider.GetCachedTileCount() == activeTiles);
+
+		collider.SetCacheSize(0);
+		collider.Update();
+		REQUIRE(collider.GetCachedTileCount() == 0);
+		REQUIRE(collider.GetTileCount() == collider.GetActiveTileCount());
+	}
+	SECTION("bodies out of reach")
+	{
+		pBody->setWorldTransform(btTransform(btQuaternion::getIdentity(), ToBtVec3(direction * (ground + 100.f))));
+		collider.Update();
+		REQUIRE(collider.GetTileCount() == 0);
+
+		//unless they are fast enough to get there soon
+		pBody->setLinearVelocity(ToBtVec3(-direction * 400.f));
+		collider.Update();
+		REQUIRE(collider.GetActiveTileCount() > 0);
+	}
+	SECTION("async builds")
+	{
+		collider.SetAsync(true);
+		collider.Update();
+		REQUIRE(collider.GetActiveTileCount() == 0);
+		collider.WaitForBuilds();
+		collider.Update();
+		REQUIRE(collider.GetActiveTileCount() > 0);
+		REQUIRE(collider.GetTileCount() == collider.GetActiveTileCount());
+	}
+}
@@ -0,0 +1,201 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+
+#include "../../../Engine/PlanetTech/PlanetSurface.hpp"
+#include "../../../Engine/Helper/TaskScheduler.hpp"
+
+namespace
+{
+	const float radius = 1737.1f;
+	const float maxHeight = 10.7f;
+	const int32 width = 512;
+	const int32 height = 256;
+
+	//rolling hills, with a tall block in the middle of the map
+	std::vector<float> GetHeightMap()
+	{
+		std::vector<float> heights(width * height);
+		for (int32 y = 0; y < height; ++y)
+		{
+			for (int32 x = 0; x < width; ++x)
+			{
+				float value = 0.3f + 0.1f * sinf(x * 0.3f) * cosf(y * 0.2f);
+				if (x >= 240 && x < 260 && y >= 120 && y < 130) value = 1.f;
+				heights[y * width + x] = value;
+			}
+		}
+		return heights;
+	}
+
+	//what linear filtering with a repeating texture returns, like the patch shader
+	float ReferenceHeight(const std::vector<float> &heights, const vec3 &direction)
+	{
+		vec3 dir = etm::normalize(direction);
+		float u = atan2f(dir.z, dir.x) / (etm::PI * 2);
+		float v = acosf(etm::Clamp(dir.y, 1.f, -1.f)) / etm::PI;
+		float x = u * width - 0.5f;
+		float y = v * height - 0.5f;
+		int32 x0 = (int32)floorf(x);
+		int32 y0 = (int32)floorf(y);
+		float fx = x - x0;
+		float fy = y - y0;
+		auto texel = [&heights](int32 tx, int32 ty)
+		{
+			tx = ((tx % width) + width) % width;
+			ty = ((ty % height) + height) % height;
+			return heights[ty * width + tx];
+		};
+		float top = texel(x0, y0) * (1 - fx) + texel(x0 + 1, y0) * fx;
+		float bottom = texel(x0, y0 + 1) * (1 - fx) + texel(x0 + 1, y0 + 1) * fx;
+		return (top * (1 - fy) + bottom * fy) * maxHeight;
+	}
+
+	//direction to the center of a texel
+	vec3 GetTexelDirection(int32 x, int32 y)
+	{
+		float azimuth = (x + 0.5f) / width * etm::PI * 2;
+		float polar = (y + 0.5f) / height * etm::PI;
+		return vec3(sinf(polar) * cosf(azimuth), cosf(polar), sinf(polar) * sinf(azimuth));
+	}
+
+	//first sample below the surface with tiny steps
+	bool ReferenceRaycast(const PlanetSurface &surface, const vec3 &origin, const vec3 &direction, float maxDistance, float step, float &distance)
+	{
+		for (float t = 0.f; t <= maxDistance; t += step)
+		{
+			vec3 position = origin + direction * t;
+			if (etm::length(position) - radius <= surface.SampleHeight(position))
+			{
+				distance = t;
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+TEST_CASE("sample height", "[planet surface]")
+{
+	std::vector<float> heights = GetHeightMap();
+	PlanetSurface surface(heights, width, height, radius, maxHeight);
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+	vec3soa directions(1000);
+	for (size_t i = 0; i < directions.size(); ++i)
+	{
+		vec3 direction(distribution(random), distribution(random), distribution(random));
+		directions.set(i, direction * (radius + 20.f * distribution(random)));
+	}
+
+	SECTION("same as the shaders filtering")
+	{
+		//the polynomial angles are a tiny fraction of a texel off, which can't move the result by more than the steepest slope allows
+		for (size_t i = 0; i < directions.size(); ++i)
+		{
+			vec3 direction = directions.get(i);
+			REQUIRE(surface.SampleHeight(direction) == Approx(ReferenceHeight(heights, direction)).epsilon(1e-3));
+		}
+		REQUIRE(surface.SampleHeight(GetTexelDirection(250, 125)) == Approx(maxHeight));
+		REQUIRE(surface.SampleHeight(GetTexelDirection(10, 10)) == Approx(heights[10 * width + 10] * maxHeight));
+	}
+	SECTION("batches give the same result as single queries")
+	{
+		std::vector<float> batch;
+		surface.SampleHeights(directions, batch);
+		std::vector<float> parallelBatch;
+		TaskScheduler scheduler(4);
+		surface.SampleHeights(directions, parallelBatch, &scheduler);
+		REQUIRE(batch.size() == directions.size());
+		for (size_t i = 0; i < directions.size(); ++i)
+		{
+			REQUIRE(batch[i] == surface.SampleHeight(directions.get(i)));
+			REQUIRE(parallelBatch[i] == batch[i]);
+		}
+	}
+	SECTION("detail layers")
+	{
+		//a constant layer and one that alternates between 0 and 1 every texel
+		surface.AddDetailLayer(std::vector<float>(16, 1.f), 4, 4, vec2(2, 1), -0.01f, 0.01f);
+		std::vector<float> checker(4 * 4);
+		for (int32 texel = 0; texel < 16; ++texel)
+		{
+			checker[texel] = (float)((texel + texel / 4) % 2);
+		}
+		//tiled so a detail texel lines up with a texel of the height map
+		surface.AddDetailLayer(checker, 4, 4, vec2(width / 4, height / 4), 0.5f, 0.f);
+		REQUIRE(surface.SampleHeight(GetTexelDirection(10, 10)) == Approx(heights[10 * width + 10] * maxHeight));
+		REQUIRE(surface.SampleHeight(GetTexelDirection(11, 10)) == Approx(heights[10 * width + 11] * maxHeight + 0.5f));
+	}
+}
+
+TEST_CASE("raycast", "[planet surface]")
+{
+	std::vector<float> heights = GetHeightMap();
+	PlanetSurface surface(heights, width, height, radius, maxHeight);
+
+	vec3 mountain = GetTexelDirection(250, 125);
+	float distance = 0.f;
+
+	SECTION("straight down")
+	{
+		REQUIRE(surface.Raycast(mountain * (radius + 100.f), -mountain, 1000.f, distance));
+		REQUIRE(distance == Approx(100.f - maxHeight).margin(1e-3));
+
+		vec3 valley = GetTexelDirection(100, 40);
+		float ground = surface.SampleHeight(valley);
+		REQUIRE(surface.Raycast(valley * (radius + 50.f), -valley, 1000.f, distance));
+		REQUIRE(distance == Approx(50.f - ground).margin(1e-3));
+		//not far enough
+		REQUIRE_FALSE(surface.Raycast(valley * (radius + 50.f), -valley, 40.f, distance));
+	}
+	SECTION("missing the planet")
+	{
+		REQUIRE_FALSE(surface.Raycast(mountain * (radius + 100.f), mountain, 10000.f, distance));
+		vec3 tangent = etm::normalize(etm::cross(mountain, vec3::UP));
+		REQUIRE_FALSE(surface.Raycast(mountain * (radius + 100.f), tangent, 10000.f, distance));
+	}
+	SECTION("starting underground")
+	{
+		REQUIRE(surface.Raycast(mountain * (radius + 5.f), mountain, 1000.f, distance));
+		REQUIRE(distance == 0.f);
+	}
+	SECTION("low rays over the terrain")
+	{
+		//flying just above the hills, towards and past the mountain, compared against marching in tiny steps
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+		vec3soa origins(200);
+		vec3soa directions(200);
+		for (size_t i = 0; i < origins.size(); ++i)
+		{
+			vec3 up = etm::normalize(mountain + vec3(distribution(random), distribution(random), distribution(random)) * 0.05f);
+			vec3 target = etm::normalize(mountain + vec3(distribution(random), distribution(random), distribution(random)) * 0.02f) * radius;
+			vec3 origin = up * (radius + maxHeight * (0.5f + distribution(random) * 0.3f));
+			origins.set(i, origin);
+			directions.set(i, etm::normalize(target - origin));
+		}
+		std::vector<float> distances;
+		TaskScheduler scheduler(4);
+		surface.Raycast(origins, directions, 300.f, distances, &scheduler);
+		uint32 hits = 0;
+		for (size_t i = 0; i < origins.size(); ++i)
+		{
+			float reference = 0.f;
+			bool isHit = ReferenceRaycast(surface, origins.get(i), directions.get(i), 300.f, 0.01f, reference);
+			REQUIRE(surface.Raycast(origins.get(i), directions.get(i), 300.f, distance) == isHit);
+			if (!isHit)
+			{
+				REQUIRE(distances[i] == -1.f);
+				continue;
+			}
+			REQUIRE(distances[i] == distance);
+			//the march steps are larger, so it can only miss features that are thinner than the reference step
+			REQUIRE(distance == Approx(reference).margin(0.02f));
+			++hits;
+		}
+		REQUIRE(hits > 100);
+	}
+}
@@ -0,0 +1,140 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+
+#include "../../../Engine/PlanetTech/StarCatalog.hpp"
+
+namespace
+{
+	//stars in random directions and distances, with magnitudes in steps of 0.01 like the HYG data so some of them are equal
+	std::vector<vec4> GetStars(uint32 count)
+	{
+		std::mt19937 random(11);
+		std::normal_distribution<float> direction;
+		std::uniform_real_distribution<float> distance(1.f, 500.f);
+		std::uniform_int_distribution<int32> magnitude(-144, 1100);
+		std::vector<vec4> stars;
+		for (uint32 i = 0; i < count; ++i)
+		{
+			vec3 position = etm::normalize(vec3(direction(random), direction(random), direction(random))) * distance(random);
+			stars.push_back(vec4(position, magnitude(random) * 0.01f));
+		}
+		return stars;
+	}
+
+	bool IsSameStar(const vec4 &lhs, const vec4 &rhs)
+	{
+		return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z && lhs.w == rhs.w;
+	}
+}
+
+TEST_CASE("catalog layout", "[star catalog]")
+{
+	std::vector<vec4> stars = GetStars(5000);
+	std::vector<uint8> data = StarCatalog::Build(stars, 4);
+	StarCatalog catalog;
+	REQUIRE(catalog.Open(data.data(), data.size()));
+	REQUIRE(catalog.GetStarCount() == stars.size());
+	REQUIRE(catalog.GetCellCount() == 6 * 4 * 4);
+
+	//every star is kept once, in its cell, from bright to faint
+	std::vector<bool> isFound(stars.size(), false);
+	uint32 next = 0;
+	for (uint32 cell = 0; cell < catalog.GetCellCount(); ++cell)
+	{
+		const StarCatalog::Cell &cellRange = catalog.GetCell(cell);
+		REQUIRE(cellRange.first == next);
+		next += cellRange.count;
+		for (uint32 i = 0; i < cellRange.count; ++i)
+		{
+			const vec4 &star = catalog.GetStars()[cellRange.first + i];
+			REQUIRE(StarCatalog::GetCellIndex(star.xyz, 4) == cell);
+			if (i > 0) REQUIRE(catalog.GetStars()[cellRange.first + i - 1].w <= star.w);
+			auto found = std::find_if(stars.begin(), stars.end(), [&star](const vec4 &other) { return IsSameStar(star, other); });
+			REQUIRE(found != stars.end());
+			REQUIRE_FALSE(isFound[found - stars.begin()]);
+			isFound[found - stars.begin()] = true;
+		}
+	}
+	REQUIRE(next == stars.size());
+
+	SECTION("broken data")
+	{
+		REQUIRE_FALSE(catalog.Open(data.data(), data.size() - 1));
+		REQUIRE_FALSE(catalog.IsOpen());
+		std::vector<uint8> wrongMagic = data;
+		wrongMagic[0] = 'X';
+		REQUIRE_FALSE(catalog.Open(wrongMagic.data(), wrongMagic.size()));
+		REQUIRE_FALSE(catalog.Open(data.data(), 8));
+	}
+}
+
+TEST_CASE("magnitude limits", "[star catalog]")
+{
+	std::vector<vec4> stars = GetStars(5000);
+	std::vector<uint8> data = StarCatalog::Build(stars);
+	StarCatalog catalog;
+	REQUIRE(catalog.Open(data.data(), data.size()));
+
+	std::vector<float> magnitudes;
+	for (const vec4 &star : stars) magnitudes.push_back(star.w);
+	std::sort(magnitudes.begin(), magnitudes.end());
+
+	for (uint32 drawn : { 0u, 1u, 10u, 1000u, 2500u, 4999u, 5000u, 10000u })
+	{
+		float limit = catalog.GetMagnitudeLimit(drawn);
+		uint32 count = catalog.GetStarCount(limit);
+		REQUIRE(count <= drawn);
+		//the same stars drawing the brightest ones first would have, up to stars of equal magnitude
+		REQUIRE(count == (uint32)(std::upper_bound(magnitudes.begin(), magnitudes.end(), limit) - magnitudes.begin()));
+		if (drawn > 0 && drawn < stars.size()) REQUIRE(magnitudes[count] == magnitudes[drawn]);
+	}
+	REQUIRE(catalog.GetStarCount(catalog.GetMagnitudeLimit(10000)) == stars.size());
+}
+
+TEST_CASE("visible ranges", "[star catalog]")
+{
+	std::vector<vec4> stars = GetStars(20000);
+	std::vector<uint8> data = StarCatalog::Build(stars);
+	StarCatalog catalog;
+	REQUIRE(catalog.Open(data.data(), data.size()));
+
+	//looking along a tilted direction, without the camera position like the star field draws
+	mat4 view = etm::DiscardW(etm::lookAt(vec3(0, 0, 0), vec3(0.4f, 0.3f, 1.f), vec3(0, 1, 0)));
+	mat4 viewProj = view * etm::perspective(etm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+	float limit = 8.f;
+
+	std::vector<int32> firsts;
+	std::vector<int32> counts;
+	catalog.GetVisibleRanges(viewProj, limit, 0.f, firsts, counts);
+	REQUIRE(firsts.size() == counts.size());
+	std::vector<bool> isDrawn(catalog.GetStarCount(), false);
+	uint32 drawnCount = 0;
+	for (size_t range = 0; range < firsts.size(); ++range)
+	{
+		for (int32 star = firsts[range]; star < firsts[range] + counts[range]; ++star)
+		{
+			REQUIRE(catalog.GetStars()[star].w <= limit);
+			isDrawn[star] = true;
+			++drawnCount;
+		}
+	}
+
+	//every bright enough star that lands on screen is drawn, and most of the sky isn't
+	for (uint32 star = 0; star < catalog.GetStarCount(); ++star)
+	{
+		const vec4 &starData = catalog.GetStars()[star];
+		vec4 clip = viewProj * vec4(etm::normalize(starData.xyz), 0.f);
+		bool isOnScreen = clip.w > 0.f && std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w;
+		if (isOnScreen && starData.w <= limit) REQUIRE(isDrawn[star]);
+	}
+	REQUIRE(drawnCount > 0);
+	REQUIRE(drawnCount * 3 < catalog.GetStarCount(limit));
+
+	//a margin as large as the sky draws everything
+	catalog.GetVisibleRanges(viewProj, limit, etm::PI, firsts, counts);
+	uint32 allCount = 0;
+	for (int32 count : counts) allCount += (uint32)count;
+	REQUIRE(allCount == catalog.GetStarCount(limit));
+}
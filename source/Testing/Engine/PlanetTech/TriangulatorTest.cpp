@@ -0,0 +1,290 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include "../../../Engine/PlanetTech/Triangulator.hpp"
+#include "../../../Engine/PlanetTech/HeightBounds.hpp"
+#include "../../../Engine/Graphics/Frustum.hpp"
+
+namespace
+{
+	//moon sized planet, same as the demo
+	const float radius = 1737.1f;
+	const float maxHeight = 10.7f;
+
+	//camera descending from 200 to 2 units above the surface while flying around the planet and turning its head
+	void SetScriptedCamera(Triangulator &triangulator, uint32 frame, uint32 frameCount)
+	{
+		float t = frame / (float)frameCount;
+		float altitude = 200.f * powf(0.01f, t);
+		float orbitAngle = t * 0.05f;
+		float headAngle = sinf(t * etm::PI * 2.f) * 0.2f;
+
+		vec3 radial = etm::normalize(vec3(sinf(orbitAngle), 0.2f, cosf(orbitAngle)));
+		vec3 position = radial * (radius + altitude);
+
+		vec3 tangent = etm::normalize(etm::cross(radial, vec3::UP));
+		vec3 bitangent = etm::cross(tangent, radial);
+		//look somewhere between the horizon and straight down
+		vec3 forward = etm::normalize(tangent * cosf(headAngle) + bitangent * sinf(headAngle) - radial * 0.5f);
+		vec3 right = etm::normalize(etm::cross(radial, forward));
+		vec3 up = etm::cross(forward, right);
+
+		//far plane like the planet test scene
+		float farPlane = (sqrtf(powf(radius + altitude, 2) - powf(radius, 2)) + sqrtf(powf(radius + maxHeight, 2) - powf(radius, 2))) * 10;
+
+		Frustum* pFrustum = triangulator.GetFrustum();
+		pFrustum->SetCullTransform(mat4(), mat4());
+		pFrustum->SetCamera(position, forward, up, 45.f, farPlane * 0.000003f, farPlane, 16.f / 9.f);
+		pFrustum->Update();
+		triangulator.SetViewportWidth(1920);
+	}
+
+	//instances identify their triangle exactly, so equal instances mean bit exact geometry
+	bool IsSameGeometry(const std::vector<PatchInstance> &lhs, const std::vector<PatchInstance> &rhs)
+	{
+		return lhs == rhs;
+	}
+}
+
+TEST_CASE("incremental triangulation", "[triangulator]")
+{
+	Triangulator incremental(radius, maxHeight);
+	incremental.Init();
+
+	Triangulator rebuild(radius, maxHeight);
+	rebuild.SetIncremental(false);
+	rebuild.Init();
+
+	const uint32 frameCount = 1000;
+	uint64 incrementalHeuristics = 0;
+	uint64 rebuildHeuristics = 0;
+	for (uint32 frame = 0; frame < frameCount; ++frame)
+	{
+		SetScriptedCamera(incremental, frame, frameCount);
+		SetScriptedCamera(rebuild, frame, frameCount);
+		incremental.GenerateGeometry();
+		rebuild.GenerateGeometry();
+
+		REQUIRE(incremental.GetPositions().size() > 0);
+		REQUIRE(IsSameGeometry(incremental.GetPositions(), rebuild.GetPositions()));
+
+		incrementalHeuristics += incremental.GetHeuristicCount();
+		rebuildHeuristics += rebuild.GetHeuristicCount();
+	}
+
+	REQUIRE(incrementalHeuristics * 4 < rebuildHeuristics);
+}
+
+TEST_CASE("static camera", "[triangulator]")
+{
+	Triangulator triangulator(radius, maxHeight);
+	triangulator.Init();
+
+	SetScriptedCamera(triangulator, 700, 1000);
+	triangulator.GenerateGeometry();
+	REQUIRE(triangulator.IsGeometryChanged());
+	REQUIRE(triangulator.GetFirstChangedInstance() == 0);
+	std::vector<PatchInstance> positions = triangulator.GetPositions();
+	uint32 fullCount = triangulator.GetHeuristicCount();
+
+	//nothing moved, only triangles on the border of the frustum are checked again
+	SetScriptedCamera(triangulator, 700, 1000);
+	triangulator.GenerateGeometry();
+	REQUIRE_FALSE(triangulator.IsGeometryChanged());
+	REQUIRE(IsSameGeometry(positions, triangulator.GetPositions()));
+	REQUIRE(triangulator.GetHeuristicCount() < fullCount);
+}
+
+TEST_CASE("multithreaded triangulation", "[triangulator]")
+{
+	Triangulator multithreaded(radius, maxHeight);
+	multithreaded.Init();
+
+	Triangulator serial(radius, maxHeight);
+	serial.SetMultithreaded(false);
+	serial.Init();
+
+	//a second run has to come out the same no matter how the tasks were scheduled
+	Triangulator repeated(radius, maxHeight);
+	repeated.Init();
+
+	const uint32 frameCount = 300;
+	for (uint32 frame = 0; frame < frameCount; ++frame)
+	{
+		SetScriptedCamera(multithreaded, frame, frameCount);
+		SetScriptedCamera(serial, frame, frameCount);
+		SetScriptedCamera(repeated, frame, frameCount);
+		multithreaded.GenerateGeometry();
+		serial.GenerateGeometry();
+		repeated.GenerateGeometry();
+
+		REQUIRE(IsSameGeometry(multithreaded.GetPositions(), serial.GetPositions()));
+		REQUIRE(IsSameGeometry(multithreaded.GetPositions(), repeated.GetPositions()));
+		REQUIRE(multithreaded.GetFirstChangedInstance() == serial.GetFirstChangedInstance());
+		REQUIRE(multithreaded.GetHeuristicCount() == serial.GetHeuristicCount());
+	}
+}
+
+TEST_CASE("async triangulation", "[triangulator]")
+{
+	Triangulator synchronous(radius, maxHeight);
+	synchronous.Init();
+
+	Triangulator async(radius, maxHeight);
+	async.Init();
+	async.SetAsync(true);
+
+	const uint32 frameCount = 300;
+	std::vector<PatchInstance> previousPositions;
+	for (uint32 frame = 0; frame < frameCount; ++frame)
+	{
+		SetScriptedCamera(synchronous, frame, frameCount);
+		SetScriptedCamera(async, frame, frameCount);
+		synchronous.GenerateGeometry();
+		async.GenerateGeometry();
+
+		//one frame behind the synchronous result
+		REQUIRE(IsSameGeometry(async.GetPositions(), previousPositions));
+		previousPositions = synchronous.GetPositions();
+
+		//stand in for rendering the frame, which gives the worker time to finish
+		async.WaitForGeneration();
+	}
+}
+
+TEST_CASE("async triangulation doesn't block", "[triangulator]")
+{
+	Triangulator synchronous(radius, maxHeight);
+	synchronous.Init();
+
+	//latch that holds the worker at the start of a generation until the test releases it
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool isHolding = false;
+	bool isWorkerHeld = false;
+	std::thread::id generationThread;
+
+	Triangulator async(radius, maxHeight);
+	async.Init();
+	async.SetAsync(true);
+	async.SetGenerationHook([&]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		generationThread = std::this_thread::get_id();
+		isWorkerHeld = isHolding;
+		condition.notify_all();
+		condition.wait(lock, [&]() { return !isHolding; });
+		isWorkerHeld = false;
+	});
+
+	const uint32 frameCount = 10;
+	SetScriptedCamera(synchronous, 0, frameCount);
+	SetScriptedCamera(async, 0, frameCount);
+	//the first generation triangulates the whole planet, which is the most an update can cost the calling thread in sync mode
+	auto generationStart = std::chrono::steady_clock::now();
+	synchronous.GenerateGeometry();
+	const std::chrono::steady_clock::duration generationTime = std::chrono::steady_clock::now() - generationStart;
+	async.GenerateGeometry();
+	async.WaitForGeneration();
+
+	//publishes the first result and starts generating the next frame, which can't finish until it is released
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isHolding = true;
+	}
+	SetScriptedCamera(synchronous, 1, frameCount);
+	SetScriptedCamera(async, 1, frameCount);
+	async.GenerateGeometry();
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [&]() { return isWorkerHeld; });
+	}
+	REQUIRE(async.IsGeometryChanged());
+	REQUIRE(IsSameGeometry(async.GetPositions(), synchronous.GetPositions()));
+	std::vector<PatchInstance> firstPositions = synchronous.GetPositions();
+	synchronous.GenerateGeometry();
+
+	//while the worker is busy the previous result stays readable and unchanged
+	//and updates only hand over the frustum, the fastest of a few calls keeps the check from failing on a preempted one
+	std::chrono::steady_clock::duration updateTime = std::chrono::steady_clock::duration::max();
+	for (uint32 frame = 2; frame < 6; ++frame)
+	{
+		SetScriptedCamera(async, frame, frameCount);
+		auto updateStart = std::chrono::steady_clock::now();
+		async.GenerateGeometry();
+		updateTime = std::min(updateTime, std::chrono::steady_clock::now() - updateStart);
+		REQUIRE_FALSE(async.IsGeometryChanged());
+		REQUIRE(IsSameGeometry(async.GetPositions(), firstPositions));
+	}
+	REQUIRE(updateTime * 10 < generationTime);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		REQUIRE(generationThread != std::this_thread::get_id());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isHolding = false;
+	}
+	condition.notify_all();
+	async.WaitForGeneration();
+
+	//the finished result is only swapped in by the next call
+	REQUIRE(IsSameGeometry(async.GetPositions(), firstPositions));
+	async.GenerateGeometry();
+	REQUIRE(IsSameGeometry(async.GetPositions(), synchronous.GetPositions()));
+	async.WaitForGeneration();
+}
+
+TEST_CASE("height bounds", "[triangulator]")
+{
+	//mostly flat terrain with a single mountain range away from the camera path
+	const int32 width = 512;
+	const int32 height = 256;
+	std::vector<float> heights(width * height, 0.05f);
+	for (int32 y = 100; y < 140; ++y)
+	{
+		for (int32 x = 240; x < 300; ++x)
+		{
+			heights[y * width + x] = 1.f;
+		}
+	}
+	HeightBounds bounds(heights, width, height);
+
+	Triangulator planetWide(radius, maxHeight);
+	planetWide.Init();
+
+	Triangulator bounded(radius, maxHeight);
+	bounded.SetHeightBounds(&bounds);
+	bounded.Init();
+
+	Triangulator boundedRebuild(radius, maxHeight);
+	boundedRebuild.SetHeightBounds(&bounds);
+	boundedRebuild.SetIncremental(false);
+	boundedRebuild.Init();
+
+	const uint32 frameCount = 300;
+	size_t planetWideInstances = 0;
+	size_t boundedInstances = 0;
+	for (uint32 frame = 0; frame < frameCount; ++frame)
+	{
+		SetScriptedCamera(planetWide, frame, frameCount);
+		SetScriptedCamera(bounded, frame, frameCount);
+		SetScriptedCamera(boundedRebuild, frame, frameCount);
+		planetWide.GenerateGeometry();
+		bounded.GenerateGeometry();
+		boundedRebuild.GenerateGeometry();
+
+		//the tighter volumes don't change how the incremental update works
+		REQUIRE(IsSameGeometry(bounded.GetPositions(), boundedRebuild.GetPositions()));
+
+		planetWideInstances += planetWide.GetPositions().size();
+		boundedInstances += bounded.GetPositions().size();
+	}
+
+	//flat terrain gets culled by its real height
+	REQUIRE(boundedInstances < planetWideInstances);
+}
@@ -0,0 +1,186 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+#include <algorithm>
+
+#include "../../../Engine/SceneGraph/BoundingVolumeTree.hpp"
+
+namespace
+{
+	AABB RandomBox(std::mt19937 &random, float range)
+	{
+		std::uniform_real_distribution<float> position(-range, range);
+		std::uniform_real_distribution<float> size(0.f, range * 0.02f);
+		vec3 center(position(random), position(random), position(random));
+		vec3 extents(size(random), size(random), size(random));
+		return AABB(center - extents, center + extents);
+	}
+
+	//flat scan over the proxies that are alive, which the tree has to agree with
+	struct Reference
+	{
+		std::vector<int32> proxies;
+		std::vector<AABB> boxes;
+
+		template<typename TFunc>
+		std::vector<int32> Scan(TFunc isInside) const
+		{
+			std::vector<int32> ret;
+			for (size_t i = 0; i < proxies.size(); ++i)
+			{
+				if (isInside(boxes[i])) ret.push_back(proxies[i]);
+			}
+			std::sort(ret.begin(), ret.end());
+			return ret;
+		}
+	};
+
+	std::vector<int32> Sorted(std::vector<int32> proxies)
+	{
+		std::sort(proxies.begin(), proxies.end());
+		return proxies;
+	}
+
+	float DistanceSquared(const AABB &box, const vec3 &point)
+	{
+		vec3 delta(std::max(std::max(box.min.x - point.x, point.x - box.max.x), 0.f),
+			std::max(std::max(box.min.y - point.y, point.y - box.max.y), 0.f),
+			std::max(std::max(box.min.z - point.z, point.z - box.max.z), 0.f));
+		return etm::dot(delta, delta);
+	}
+}
+
+TEST_CASE("bounding volume tree structure", "[bvh]")
+{
+	BoundingVolumeTree tree(0.5f);
+	REQUIRE(tree.Validate());
+	REQUIRE(tree.GetHeight() == 0);
+
+	std::mt19937 random(3);
+	std::vector<int32> proxies;
+	const size_t count = 2000;
+	for (size_t i = 0; i < count; ++i)
+	{
+		proxies.push_back(tree.CreateProxy(RandomBox(random, 100.f), reinterpret_cast<void*>(i + 1)));
+	}
+	REQUIRE(tree.Validate());
+	REQUIRE(tree.GetProxyCount() == count);
+	//balanced: far below the height of a list
+	REQUIRE(tree.GetHeight() < 30);
+	REQUIRE(tree.GetUserData(proxies[10]) == reinterpret_cast<void*>(11));
+
+	//small movements stay inside the enlarged box
+	AABB bounds = tree.GetBounds(proxies[0]);
+	REQUIRE_FALSE(tree.MoveProxy(proxies[0], AABB(bounds.min + vec3(0.1f), bounds.max + vec3(0.1f))));
+	REQUIRE(tree.MoveProxy(proxies[0], AABB(bounds.min + vec3(10.f), bounds.max + vec3(10.f))));
+	REQUIRE(tree.Validate());
+
+	for (size_t i = 0; i < count; i += 2)
+	{
+		tree.DestroyProxy(proxies[i]);
+	}
+	REQUIRE(tree.Validate());
+	REQUIRE(tree.GetProxyCount() == count / 2);
+
+	//freed nodes are reused
+	int32 reused = tree.CreateProxy(RandomBox(random, 100.f), nullptr);
+	REQUIRE(reused >= 0);
+	REQUIRE(tree.Validate());
+}
+
+TEST_CASE("bounding volume tree queries match a flat scan", "[bvh]")
+{
+	BoundingVolumeTree tree(1.f);
+	Reference reference;
+	std::mt19937 random(11);
+	for (size_t i = 0; i < 3000; ++i)
+	{
+		AABB box = RandomBox(random, 200.f);
+		reference.proxies.push_back(tree.CreateProxy(box, nullptr));
+		reference.boxes.push_back(box);
+	}
+	//move some a little and some far, and remove a few
+	std::uniform_real_distribution<float> small(-0.5f, 0.5f);
+	for (size_t i = 0; i < reference.proxies.size(); i += 3)
+	{
+		vec3 offset = (i % 2 == 0) ? vec3(small(random), small(random), small(random)) : vec3(50.f, -20.f, 5.f);
+		reference.boxes[i] = AABB(reference.boxes[i].min + offset, reference.boxes[i].max + offset);
+		tree.MoveProxy(reference.proxies[i], reference.boxes[i]);
+	}
+	for (size_t i = 0; i < 100; ++i)
+	{
+		tree.DestroyProxy(reference.proxies.back());
+		reference.proxies.pop_back();
+		reference.boxes.pop_back();
+	}
+	REQUIRE(tree.Validate());
+
+	std::vector<int32> result;
+	std::uniform_real_distribution<float> position(-200.f, 200.f);
+	for (uint32 query = 0; query < 20; ++query)
+	{
+		vec3 center(position(random), position(random), position(random));
+
+		AABB box(center - vec3(30.f), center + vec3(20.f));
+		tree.QueryAABB(box, result);
+		REQUIRE(Sorted(result) == reference.Scan([&box](const AABB &other)
+		{
+			return box.min.x <= other.max.x && box.min.y <= other.max.y && box.min.z <= other.max.z
+				&& other.min.x <= box.max.x && other.min.y <= box.max.y && other.min.z <= box.max.z;
+		}));
+
+		Sphere sphere(center, 40.f);
+		tree.QuerySphere(sphere, result);
+		REQUIRE(Sorted(result) == reference.Scan([&sphere](const AABB &other)
+		{
+			return DistanceSquared(other, sphere.pos) <= sphere.radius * sphere.radius;
+		}));
+
+		BatchFrustum frustum(etm::lookAt(center, vec3(0.f), vec3(0.f, 1.f, 0.f)) * etm::perspective(etm::radians(60.f), 1.5f, 1.f, 150.f));
+		tree.QueryFrustum(frustum, result);
+		REQUIRE(Sorted(result) == reference.Scan([&frustum](const AABB &other)
+		{
+			return frustum.ContainsAABB(other.min, other.max) != VolumeCheck::OUTSIDE;
+		}));
+
+		//nearest first, and nothing left out is closer than the last one
+		tree.QueryNearest(center, 10, result);
+		REQUIRE(result.size() == 10);
+		std::vector<float> distances;
+		for (size_t i = 0; i < reference.proxies.size(); ++i)
+		{
+			distances.push_back(DistanceSquared(reference.boxes[i], center));
+		}
+		std::sort(distances.begin(), distances.end());
+		for (size_t i = 0; i < result.size(); ++i)
+		{
+			REQUIRE(DistanceSquared(tree.GetBounds(result[i]), center) == distances[i]);
+		}
+	}
+
+	//a ray along x through boxes placed on it, and one box next to it
+	BoundingVolumeTree rayTree;
+	int32 farBox = rayTree.CreateProxy(AABB(vec3(20.f, -1.f, -1.f), vec3(22.f, 1.f, 1.f)), nullptr);
+	int32 nearBox = rayTree.CreateProxy(AABB(vec3(5.f, -1.f, -1.f), vec3(6.f, 1.f, 1.f)), nullptr);
+	rayTree.CreateProxy(AABB(vec3(10.f, 3.f, -1.f), vec3(12.f, 5.f, 1.f)), nullptr);
+	int32 beyond = rayTree.CreateProxy(AABB(vec3(40.f, -1.f, -1.f), vec3(42.f, 1.f, 1.f)), nullptr);
+	rayTree.RayCast(vec3(0.f), vec3(1.f, 0.f, 0.f), 30.f, result);
+	REQUIRE(result == std::vector<int32>({ nearBox, farBox }));
+	rayTree.RayCast(vec3(0.f), vec3(1.f, 0.f, 0.f), 100.f, result);
+	REQUIRE(result == std::vector<int32>({ nearBox, farBox, beyond }));
+	rayTree.RayCast(vec3(0.f), vec3(-1.f, 0.f, 0.f), 100.f, result);
+	REQUIRE(result.empty());
+}
+
+TEST_CASE("bounding volume tree origin shift", "[bvh]")
+{
+	BoundingVolumeTree tree;
+	int32 proxy = tree.CreateProxy(AABB(vec3(100.f), vec3(101.f)), nullptr);
+	tree.ShiftOrigin(vec3(100.f));
+	REQUIRE(etm::nearEqualsV(tree.GetBounds(proxy).min, vec3(0.f)));
+	std::vector<int32> result;
+	tree.QuerySphere(Sphere(vec3(0.5f), 0.1f), result);
+	REQUIRE(result.size() == 1);
+	REQUIRE(tree.Validate());
+}
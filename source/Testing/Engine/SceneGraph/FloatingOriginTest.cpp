@@ -0,0 +1,156 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include "../../../Engine/SceneGraph/FloatingOrigin.hpp"
+#include "../../../Engine/SceneGraph/AbstractScene.hpp"
+#include "../../../Engine/SceneGraph/Entity.hpp"
+#include "../../../Engine/Components/TransformComponent.hpp"
+
+namespace
+{
+	//one millimeter, assuming the engine uses meters
+	const double precision = 0.001;
+	//far enough that single precision floats can't represent millimeters anymore
+	const dvec3 farAway = dvec3(1.0e7, -2.5e6, 1.0e7);
+
+	//a scene that is never activated, so it has no camera, physics or context
+	class OriginTestScene : public AbstractScene
+	{
+	public:
+		OriginTestScene() : AbstractScene("OriginTestScene") {}
+	protected:
+		void Initialize() override {}
+		void Update() override {}
+		void Draw() override {}
+		void DrawForward() override {}
+		void PostDraw() override {}
+	};
+
+	bool IsNear(const vec3 &lhs, const dvec3 &rhs)
+	{
+		return etm::length(etm::vecCast<double>(lhs) - rhs) < precision;
+	}
+}
+
+TEST_CASE("rebase", "[floating origin]")
+{
+	FloatingOrigin origin;
+	origin.SetRebaseThreshold(100.0);
+	dvec3 shift;
+
+	REQUIRE_FALSE(origin.Update(farAway, shift)); //disabled by default
+
+	origin.SetEnabled(true);
+	REQUIRE_FALSE(origin.Update(dvec3(50.0, 0.0, 0.0), shift));
+	REQUIRE(origin.Update(dvec3(150.0, 0.0, 0.0), shift));
+	REQUIRE(etm::nearEqualsV(shift, dvec3(150.0, 0.0, 0.0)));
+	REQUIRE(etm::nearEqualsV(origin.GetOrigin(), dvec3(150.0, 0.0, 0.0)));
+
+	REQUIRE(origin.Update(farAway, shift));
+	REQUIRE(etm::nearEqualsV(shift, farAway - dvec3(150.0, 0.0, 0.0)));
+	REQUIRE(etm::nearEqualsV(origin.ToRelative(farAway), vec3(0.f)));
+}
+
+TEST_CASE("precision far from the origin", "[floating origin]")
+{
+	FloatingOrigin origin;
+	origin.SetEnabled(true);
+	origin.SetRebaseThreshold(1000.0);
+
+	//an object resting next to the camera path
+	dvec3 object = farAway + dvec3(3.0001, -0.5002, 7.0003);
+
+	//fly the camera far enough to trigger a couple of rebases
+	dvec3 camera = farAway;
+	dvec3 shift;
+
+	const dvec3 velocity = dvec3(0.7317, 0.0213, -0.3111);
+	double maxError = 0.0;
+	double maxSinglePrecisionError = 0.0;
+	uint32 rebaseCount = 0;
+	for (uint32 frame = 0; frame < 10000; ++frame)
+	{
+		camera = camera + velocity;
+		if (origin.Update(camera, shift))
+		{
+			++rebaseCount;
+		}
+		vec3 cameraRelative = origin.ToRelative(camera);
+
+		//the offset between the camera and the object as seen by culling and rendering
+		vec3 offset = origin.ToRelative(object) - cameraRelative;
+		maxError = std::max(maxError, etm::length(etm::vecCast<double>(offset) - (object - camera)));
+
+		//the same offset if positions were stored in single precision
+		vec3 singleOffset = etm::vecCast<float>(object) - etm::vecCast<float>(camera);
+		maxSinglePrecisionError = std::max(maxSinglePrecisionError, etm::length(etm::vecCast<double>(singleOffset) - (object - camera)));
+	}
+
+	REQUIRE(rebaseCount > 0);
+	REQUIRE(maxError < precision);
+	REQUIRE(maxSinglePrecisionError > precision);
+}
+
+TEST_CASE("camera relative world", "[floating origin]")
+{
+	vec3 scale(2.f, 2.f, 2.f);
+	quat rotation(etm::normalize(vec3(0.2f, 1.f, 0.1f)), 0.8f);
+	dvec3 position = farAway + dvec3(0.25, 12.5, -3.125);
+	dvec3 camera = farAway + dvec3(-4.0, 1.0, 2.0);
+
+	mat4 world = FloatingOrigin::GetCameraRelativeWorld(scale, rotation, position, camera);
+
+	//a point on the object in its local space
+	vec3 local(0.1234f, -0.5f, 0.75f);
+	vec3 relative = (world * vec4(local, 1)).xyz;
+
+	dvec3 expected = etm::vecCast<double>(rotation * (local * scale)) + position - camera;
+	REQUIRE(etm::length(etm::vecCast<double>(relative) + camera - (expected + camera)) < precision);
+}
+
+TEST_CASE("rebase scene", "[floating origin]")
+{
+	OriginTestScene scene;
+	scene.GetFloatingOrigin().SetEnabled(true);
+	scene.GetFloatingOrigin().SetRebaseThreshold(1000.0);
+
+	//a root entity far from the origin with a child attached to it
+	const dvec3 rootPosition = farAway + dvec3(3.0001, -0.5002, 7.0003);
+	const vec3 childOffset(0.25f, 2.f, -0.125f);
+	Entity* pRoot = new Entity();
+	pRoot->GetTransform()->SetAbsolutePosition(rootPosition);
+	Entity* pChild = new Entity();
+	pChild->GetTransform()->SetPosition(childOffset);
+	pRoot->AddChild(pChild);
+	scene.AddEntity(pRoot);
+	scene.UpdateTransforms();
+
+	TransformComponent* pRootTransform = pRoot->GetTransform();
+	TransformComponent* pChildTransform = pChild->GetTransform();
+	REQUIRE(pRootTransform->GetAbsolutePosition() == rootPosition);
+
+	//the camera next to the entities is far enough to move the origin
+	const dvec3 camera = farAway;
+	REQUIRE(scene.UpdateFloatingOrigin(camera));
+	REQUIRE(etm::nearEqualsV(scene.GetFloatingOrigin().GetOrigin(), camera));
+
+	//the double precision position is kept, the single precision world is rebased onto the new origin
+	REQUIRE(pRootTransform->GetAbsolutePosition() == rootPosition);
+	REQUIRE(IsNear(pRootTransform->GetWorldPosition(), rootPosition - camera));
+	REQUIRE(IsNear(pRootTransform->GetWorld()[3].xyz, rootPosition - camera));
+	REQUIRE(IsNear((pRootTransform->GetWorldInverse() * vec4(pRootTransform->GetWorldPosition(), 1)).xyz, dvec3(0.0)));
+
+	//children follow, and now have millimetre precision again
+	const dvec3 childPosition = rootPosition + etm::vecCast<double>(childOffset);
+	REQUIRE(IsNear(pChildTransform->GetWorldPosition(), childPosition - camera));
+	REQUIRE(etm::length(pChildTransform->GetAbsolutePosition() - childPosition) < precision);
+
+	//what rendering uses, relative to a camera that moved on a bit
+	const dvec3 renderCamera = camera + dvec3(-4.0, 1.0, 2.0);
+	REQUIRE(IsNear(pRootTransform->GetCameraRelativeWorld(renderCamera)[3].xyz, rootPosition - renderCamera));
+	REQUIRE(IsNear(pChildTransform->GetCameraRelativeWorld(renderCamera)[3].xyz, childPosition - renderCamera));
+
+	//moving the camera a little doesn't rebase
+	REQUIRE_FALSE(scene.UpdateFloatingOrigin(camera + dvec3(10.0, 0.0, 0.0)));
+	REQUIRE(pRootTransform->GetAbsolutePosition() == rootPosition);
+}
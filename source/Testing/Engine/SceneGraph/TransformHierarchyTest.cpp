@@ -0,0 +1,184 @@
+#include "../../../Engine/stdafx.hpp"
+#include <catch.hpp>
+
+#include <random>
+#include <algorithm>
+
+#include "../../../Engine/SceneGraph/TransformHierarchy.hpp"
+#include "../../../Engine/Helper/TaskScheduler.hpp"
+
+namespace
+{
+	bool IsNear(const mat4 &lhs, const mat4 &rhs, float tolerance = 0.0001f)
+	{
+		for (uint8 row = 0; row < 4; ++row)
+		{
+			for (uint8 column = 0; column < 4; ++column)
+			{
+				if (std::abs(lhs[row][column] - rhs[row][column]) > tolerance) return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<int32> Sorted(std::vector<int32> nodes)
+	{
+		std::sort(nodes.begin(), nodes.end());
+		return nodes;
+	}
+}
+
+TEST_CASE("transform hierarchy composition", "[transform]")
+{
+	vec3 position(1.f, -2.f, 3.f);
+	quat rotation(vec3(0.3f, 0.5f, 0.7f));
+	vec3 scale(2.f, 3.f, 0.5f);
+	mat4 world;
+	mat4 worldInverse;
+	TransformHierarchy::ComposeWorld(position, rotation, scale, world, worldInverse);
+	REQUIRE(IsNear(world, etm::scale(scale) * etm::rotate(rotation) * etm::translate(position)));
+	REQUIRE(IsNear(worldInverse, etm::translate(-position) * etm::rotate(etm::inverse(rotation)) * etm::scale(1.f / scale)));
+	REQUIRE(IsNear(world * worldInverse, mat4()));
+
+	//a child follows its parent, and moving the parent moves the child
+	TransformHierarchy hierarchy;
+	int32 parent = hierarchy.CreateNode(TransformHierarchy::NULL_NODE, nullptr);
+	int32 child = hierarchy.CreateNode(parent, nullptr);
+	quat childRotation(vec3(-0.2f, 0.9f, 0.1f));
+	hierarchy.SetLocal(parent, position, rotation, scale);
+	hierarchy.SetLocal(child, vec3(0.f, 1.f, 0.f), childRotation, vec3(1.f));
+	hierarchy.Update();
+	mat4 childLocal = etm::rotate(childRotation) * etm::translate(vec3(0.f, 1.f, 0.f));
+	REQUIRE(IsNear(hierarchy.GetWorld(child), childLocal * world));
+	REQUIRE(IsNear(hierarchy.GetWorld(child) * hierarchy.GetWorldInverse(child), mat4()));
+	REQUIRE(IsNear(etm::rotate(hierarchy.GetWorldRotation(child)), etm::rotate(childRotation) * etm::rotate(rotation)));
+	REQUIRE(hierarchy.GetWorldScale(child) == scale);
+
+	hierarchy.SetLocal(parent, vec3(10.f, 0.f, 0.f), quat(), vec3(1.f));
+	hierarchy.Update();
+	REQUIRE(IsNear(hierarchy.GetWorld(child), childLocal * etm::translate(vec3(10.f, 0.f, 0.f))));
+}
+
+TEST_CASE("transform hierarchy dirty subtrees", "[transform]")
+{
+	//root - a - b
+	//     \ c - d
+	TransformHierarchy hierarchy;
+	int32 root = hierarchy.CreateNode(TransformHierarchy::NULL_NODE, nullptr);
+	int32 a = hierarchy.CreateNode(root, nullptr);
+	int32 c = hierarchy.CreateNode(root, nullptr);
+	int32 b = hierarchy.CreateNode(a, nullptr);
+	int32 d = hierarchy.CreateNode(c, nullptr);
+	hierarchy.Update();
+	REQUIRE(hierarchy.GetChangedNodes().size() == 5);
+	//depth first, parents before children and siblings in the order they were created
+	REQUIRE(hierarchy.GetOrder(root) == 0);
+	REQUIRE(hierarchy.GetOrder(a) == 1);
+	REQUIRE(hierarchy.GetOrder(b) == 2);
+	REQUIRE(hierarchy.GetOrder(c) == 3);
+	REQUIRE(hierarchy.GetOrder(d) == 4);
+
+	//nothing changed, nothing is updated
+	hierarchy.Update();
+	REQUIRE(hierarchy.GetChangedNodes().empty());
+
+	//only the subtree below the changed node
+	hierarchy.SetLocal(c, vec3(1.f, 0.f, 0.f), quat(), vec3(1.f));
+	REQUIRE(hierarchy.IsDirty(c));
+	hierarchy.Update();
+	REQUIRE_FALSE(hierarchy.IsDirty(c));
+	REQUIRE(Sorted(hierarchy.GetChangedNodes()) == Sorted({ c, d }));
+	REQUIRE(hierarchy.GetWorld(d)[3].xyz == vec3(1.f, 0.f, 0.f));
+	REQUIRE(hierarchy.GetWorld(b)[3].xyz == vec3(0.f));
+
+	//a dirty child of a dirty parent is updated once
+	hierarchy.SetDirty(b);
+	hierarchy.SetDirty(root);
+	hierarchy.SetDirty(b);
+	hierarchy.Update();
+	REQUIRE(hierarchy.GetChangedNodes().size() == 5);
+	REQUIRE(hierarchy.GetChangedNodes()[0] == root);
+
+	//children of a destroyed node move up to its parent and keep their ids
+	hierarchy.SetLocal(root, vec3(0.f, 5.f, 0.f), quat(), vec3(1.f));
+	hierarchy.DestroyNode(c);
+	hierarchy.Update();
+	REQUIRE(hierarchy.GetNodeCount() == 4);
+	REQUIRE(hierarchy.GetParent(d) == root);
+	REQUIRE(hierarchy.GetWorld(d)[3].xyz == vec3(0.f, 5.f, 0.f));
+	REQUIRE(hierarchy.GetOrder(d) == 3);
+
+	//ids are reused once the destroyed node is gone
+	int32 e = hierarchy.CreateNode(b, &hierarchy);
+	REQUIRE(e == c);
+	REQUIRE(hierarchy.GetUserData(e) == &hierarchy);
+	hierarchy.Update();
+	REQUIRE(hierarchy.GetChangedNodes() == std::vector<int32>({ e }));
+	REQUIRE(hierarchy.GetOrder(e) == 3);
+	REQUIRE(hierarchy.GetWorld(e)[3].xyz == vec3(0.f, 5.f, 0.f));
+}
+
+TEST_CASE("transform hierarchy is independent of workers", "[transform]")
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> offset(-1.f, 1.f);
+	TransformHierarchy serial;
+	TaskScheduler scheduler(4);
+	TransformHierarchy parallel(&scheduler);
+	//many small trees and one deep chain, created in random order of parents
+	std::vector<int32> nodes;
+	for (uint32 i = 0; i < 4000; ++i)
+	{
+		int32 parent = TransformHierarchy::NULL_NODE;
+		if (i % 50 != 0)
+		{
+			parent = i < 1000 ? (int32)i - 1 : nodes[std::uniform_int_distribution<uint32>(0, i - 1)(random)];
+		}
+		int32 node = serial.CreateNode(parent, nullptr);
+		REQUIRE(parallel.CreateNode(parent, nullptr) == node);
+		nodes.push_back(node);
+	}
+	std::vector<mat4> locals(nodes.size());
+	auto move = [&](int32 node)
+	{
+		vec3 position(offset(random), offset(random), offset(random));
+		quat rotation(vec3(offset(random), offset(random), offset(random)));
+		vec3 scale(1.f + offset(random) * 0.1f);
+		serial.SetLocal(node, position, rotation, scale);
+		parallel.SetLocal(node, position, rotation, scale);
+		locals[node] = etm::scale(scale) * etm::rotate(rotation) * etm::translate(position);
+	};
+	for (int32 node : nodes)
+	{
+		move(node);
+	}
+	serial.Update();
+	parallel.Update();
+	for (uint32 i = 0; i < 300; ++i)
+	{
+		move(nodes[std::uniform_int_distribution<uint32>(0, 3999)(random)]);
+	}
+	serial.Update();
+	parallel.Update();
+
+	REQUIRE(Sorted(serial.GetChangedNodes()) == Sorted(parallel.GetChangedNodes()));
+	REQUIRE(serial.GetChangedNodes().size() < nodes.size());
+	//the same as multiplying the local matrices up the chain of parents
+	bool matches = true;
+	bool isCorrect = true;
+	bool isSorted = true;
+	for (int32 node : nodes)
+	{
+		matches &= serial.GetWorld(node) == parallel.GetWorld(node);
+		mat4 world = locals[node];
+		for (int32 parent = serial.GetParent(node); parent != TransformHierarchy::NULL_NODE; parent = serial.GetParent(parent))
+		{
+			isSorted &= serial.GetOrder(parent) < serial.GetOrder(node);
+			world = world * locals[parent];
+		}
+		isCorrect &= IsNear(world, serial.GetWorld(node), 0.01f);
+	}
+	REQUIRE(matches);
+	REQUIRE(isCorrect);
+	REQUIRE(isSorted);
+}